@@ -18,6 +18,7 @@
  *              Marco Trevisan (Treviño) <3v1n0@ubuntu.com>
  */
 
+#include <deque>
 #include <NuxCore/Logger.h>
 
 #include "config.h"
@@ -38,6 +39,9 @@ namespace
 {
 DECLARE_LOGGER(logger, "unity.indicator.dbus");
 
+const int IMAGE_TYPE_PIXBUF = 1; // GTK_IMAGE_PIXBUF
+const std::size_t IMAGE_HASH_LENGTH = 16;
+
 inline bool verify_variant_type(GVariant* value, const gchar* type)
 {
   if (!g_variant_is_of_type (value, G_VARIANT_TYPE(type)))
@@ -63,6 +67,8 @@ struct DBusIndicators::Impl
   void RequestSyncAll();
   void RequestSyncIndicator(std::string const& name);
   void Sync(GVariant* args, glib::Error const&);
+  void SyncAll(GVariant* args, glib::Error const&);
+  std::string ResolveImageData(int type, std::string const& data);
   void SyncGeometries(std::string const& name, EntryLocationMap const& locations);
   void ShowEntriesDropdown(Indicator::Entries const&, Entry::Ptr const&, unsigned xid, int x, int y);
   void CloseActiveEntry();
@@ -71,6 +77,7 @@ struct DBusIndicators::Impl
   void OnDisconnected();
 
   void OnReSync(GVariant* parameters);
+  void OnEntryChanged(GVariant* parameters);
   void OnIconsPathChanged(GVariant* parameters);
   void OnEntryActivated(GVariant* parameters);
   void OnEntryActivatedRequest(GVariant* parameters);
@@ -88,6 +95,10 @@ struct DBusIndicators::Impl
   glib::Source::UniquePtr show_appmenu_idle_;
   std::vector<std::string> icon_paths_;
   std::unordered_map<std::string, EntryLocationMap> cached_locations_;
+  uint32_t delta_sequence_;
+  std::unordered_map<std::string, std::string> images_;
+  std::deque<std::string> images_queue_;
+  bool missing_images_;
 };
 
 
@@ -96,8 +107,11 @@ DBusIndicators::Impl::Impl(std::string const& dbus_name, DBusIndicators* owner)
   : owner_(owner)
   , gproxy_(dbus_name, UPS_PATH, UPS_IFACE, G_BUS_TYPE_SESSION,
             G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES)
+  , delta_sequence_(0)
+  , missing_images_(false)
 {
   gproxy_.Connect("ReSync", sigc::mem_fun(this, &DBusIndicators::Impl::OnReSync));
+  gproxy_.Connect("EntryChanged", sigc::mem_fun(this, &DBusIndicators::Impl::OnEntryChanged));
   gproxy_.Connect("IconPathsChanged", sigc::mem_fun(this, &DBusIndicators::Impl::OnIconsPathChanged));
   gproxy_.Connect("EntryActivated", sigc::mem_fun(this, &DBusIndicators::Impl::OnEntryActivated));
   gproxy_.Connect("EntryActivateRequest", sigc::mem_fun(this, &DBusIndicators::Impl::OnEntryActivatedRequest));
@@ -151,6 +165,9 @@ void DBusIndicators::Impl::OnDisconnected()
   }
 
   cached_locations_.clear();
+  images_.clear();
+  images_queue_.clear();
+  delta_sequence_ = 0;
 
   CheckLocalService();
 }
@@ -170,6 +187,82 @@ void DBusIndicators::Impl::OnReSync(GVariant* parameters)
   }
 }
 
+void DBusIndicators::Impl::OnEntryChanged(GVariant* parameters)
+{
+  if (!verify_variant_type(parameters, ENTRY_DELTA_SIGNATURE))
+    return;
+
+  guint32 sequence;
+  glib::String indicator_name;
+  glib::String entry_id;
+  GVariant* changes;
+  g_variant_get(parameters, ENTRY_DELTA_SIGNATURE, &sequence, &indicator_name, &entry_id, &changes);
+  glib::Variant changes_variant(changes, glib::StealRef());
+
+  // Deltas are only meaningful on top of a known state, if we missed some we
+  // can't trust what we have anymore, so just fetch everything again.
+  bool missed_deltas = (delta_sequence_ && sequence != delta_sequence_ + 1);
+  delta_sequence_ = sequence;
+
+  if (missed_deltas)
+  {
+    LOG_DEBUG(logger) << "Missed entry changes (got " << sequence << "), syncing all";
+    RequestSyncAll();
+    return;
+  }
+
+  glib::HintsMap hints;
+  changes_variant.ASVToHints(hints);
+
+  auto image_type_it = hints.find("image_type");
+  auto image_data_it = hints.find("image_data");
+  auto image_sensitive_it = hints.find("image_sensitive");
+  auto image_visible_it = hints.find("image_visible");
+  std::string image_data;
+
+  // Images must be always resolved, so that new ones are added to the cache
+  if (image_type_it != hints.end() && image_data_it != hints.end())
+  {
+    image_data = ResolveImageData(image_type_it->second.GetUInt32(), image_data_it->second.GetString());
+
+    if (missing_images_)
+    {
+      missing_images_ = false;
+      RequestSyncAll();
+      return;
+    }
+  }
+
+  Indicator::Ptr indicator = owner_->GetIndicator(indicator_name.Str());
+  Entry::Ptr entry = indicator ? indicator->GetEntry(entry_id.Str()) : Entry::Ptr();
+
+  if (!entry)
+  {
+    RequestSyncIndicator(indicator_name.Str());
+    return;
+  }
+
+  auto label_it = hints.find("label");
+  auto label_sensitive_it = hints.find("label_sensitive");
+  auto label_visible_it = hints.find("label_visible");
+
+  if (label_it != hints.end() || label_sensitive_it != hints.end() || label_visible_it != hints.end())
+  {
+    entry->set_label(label_it != hints.end() ? label_it->second.GetString() : entry->label(),
+                     label_sensitive_it != hints.end() ? label_sensitive_it->second.GetBool() : entry->label_sensitive(),
+                     label_visible_it != hints.end() ? label_visible_it->second.GetBool() : entry->label_visible());
+  }
+
+  if (image_type_it != hints.end() || image_data_it != hints.end() ||
+      image_sensitive_it != hints.end() || image_visible_it != hints.end())
+  {
+    entry->set_image(image_type_it != hints.end() ? image_type_it->second.GetUInt32() : entry->image_type(),
+                     image_data_it != hints.end() ? image_data : entry->image_data(),
+                     image_sensitive_it != hints.end() ? image_sensitive_it->second.GetBool() : entry->image_sensitive(),
+                     image_visible_it != hints.end() ? image_visible_it->second.GetBool() : entry->image_visible());
+  }
+}
+
 void DBusIndicators::Impl::OnIconsPathChanged(GVariant*)
 {
   gproxy_.CallBegin("GetIconPaths", nullptr, [this] (GVariant* paths, glib::Error const& e) {
@@ -242,7 +335,7 @@ void DBusIndicators::Impl::OnEntryActivatedRequest(GVariant* parameters)
 
 void DBusIndicators::Impl::RequestSyncAll()
 {
-  gproxy_.CallBegin("Sync", nullptr, sigc::mem_fun(this, &DBusIndicators::Impl::Sync));
+  gproxy_.CallBegin("Sync", nullptr, sigc::mem_fun(this, &DBusIndicators::Impl::SyncAll));
 }
 
 void DBusIndicators::Impl::RequestSyncIndicator(std::string const& name)
@@ -323,6 +416,59 @@ void DBusIndicators::Impl::CloseActiveEntry()
   gproxy_.Call("CloseActiveEntry");
 }
 
+std::string DBusIndicators::Impl::ResolveImageData(int type, std::string const& data)
+{
+  if (type != IMAGE_TYPE_PIXBUF || data.empty())
+    return data;
+
+  auto separator = data.find(IMAGE_HASH_SEPARATOR);
+
+  if (separator == std::string::npos)
+  {
+    // Not an hash reference, this is from a service not caching images
+    if (data.size() != IMAGE_HASH_LENGTH)
+      return data;
+
+    auto it = images_.find(data);
+
+    if (it != images_.end())
+      return it->second;
+
+    LOG_DEBUG(logger) << "Got a reference to an unknown image: " << data;
+    missing_images_ = true;
+    return std::string();
+  }
+
+  // Mirror the panel service cache, so that we know the same images
+  auto const& hash = data.substr(0, separator);
+
+  if (images_.find(hash) == images_.end())
+  {
+    images_queue_.push_back(hash);
+
+    if (images_queue_.size() > IMAGE_CACHE_SIZE)
+    {
+      images_.erase(images_queue_.front());
+      images_queue_.pop_front();
+    }
+  }
+
+  images_[hash] = data;
+  return data;
+}
+
+void DBusIndicators::Impl::SyncAll(GVariant* args, glib::Error const& error)
+{
+  if (!args || error)
+    return;
+
+  // The service sends again all the images on full syncs
+  images_.clear();
+  images_queue_.clear();
+
+  Sync(args, error);
+}
+
 void DBusIndicators::Impl::Sync(GVariant* args, glib::Error const& error)
 {
   if (!args || error)
@@ -372,6 +518,7 @@ void DBusIndicators::Impl::Sync(GVariant* args, glib::Error const& error)
     }
 
     Indicator::Entries& entries = indicators[indicator];
+    std::string const& image = ResolveImageData(image_type, G_LIKELY(image_data) ? image_data : "");
 
     // Empty entries are empty indicators.
     if (!entry.empty())
@@ -388,13 +535,13 @@ void DBusIndicators::Impl::Sync(GVariant* args, glib::Error const& error)
       {
         e = std::make_shared<Entry>(entry, name_hint, parent_window,
                                     label, label_sensitive, label_visible,
-                                    image_type, image_data, image_sensitive, image_visible,
+                                    image_type, image, image_sensitive, image_visible,
                                     priority);
       }
       else
       {
         e->set_label(label, label_sensitive, label_visible);
-        e->set_image(image_type, image_data, image_sensitive, image_visible);
+        e->set_image(image_type, image, image_sensitive, image_visible);
         e->set_priority(priority);
       }
 
@@ -405,6 +552,12 @@ void DBusIndicators::Impl::Sync(GVariant* args, glib::Error const& error)
 
   for (auto const& i : indicators)
     i.first->Sync(i.second);
+
+  if (missing_images_)
+  {
+    missing_images_ = false;
+    RequestSyncAll();
+  }
 }
 
 void DBusIndicators::Impl::SyncGeometries(std::string const& name,
@@ -20,6 +20,7 @@
 #ifndef UNITY_MODEL_INL_H
 #define UNITY_MODEL_INL_H
 
+#include <utility>
 #include <NuxCore/Logger.h>
 
 namespace unity
@@ -30,6 +31,7 @@ namespace dash
 template<class RowAdaptor>
 Model<RowAdaptor>::Model (ModelType model_type)
   : model_type_(model_type)
+  , batching_rows_(false)
   , cached_adaptor1_(nullptr, nullptr, nullptr)
   , cached_adaptor2_(nullptr, nullptr, nullptr)
   , cached_adaptor3_(nullptr, nullptr, nullptr)
@@ -105,6 +107,11 @@ void Model<RowAdaptor>::SetModel(glib::Object<DeeModel> const& new_model, GetDee
     sig_manager_.Disconnect(model_);
     model_.Release();
   }
+
+  // Deliver the changes of the previous model, even if in a transaction
+  batching_rows_ = false;
+  FlushRowChanges();
+
   model_ = new_model;
 
   if (!model_)
@@ -146,6 +153,7 @@ void Model<RowAdaptor>::SetModel(glib::Object<DeeModel> const& new_model, GetDee
   model.EmitChanged(model_);
 
   // if the model wasn't empty emit row-added signals for all the rows
+  batching_rows_ = true;
   DeeModelIter* iter = dee_model_get_first_iter(model_);
   DeeModelIter* end_iter = dee_model_get_last_iter(model_);
   while (iter != end_iter)
@@ -153,6 +161,15 @@ void Model<RowAdaptor>::SetModel(glib::Object<DeeModel> const& new_model, GetDee
     OnRowAdded(model_, iter);
     iter = dee_model_next(model_, iter);
   }
+  batching_rows_ = false;
+  FlushRowChanges();
+}
+
+template<class RowAdaptor>
+void Model<RowAdaptor>::FollowTransactions(Model& other)
+{
+  other.begin_transaction.connect(sigc::mem_fun(this, &Model<RowAdaptor>::BeginTransaction));
+  other.end_transaction.connect(sigc::mem_fun(this, &Model<RowAdaptor>::EndTransaction));
 }
 
 template<class RowAdaptor>
@@ -167,6 +184,7 @@ void Model<RowAdaptor>::OnRowAdded(DeeModel* model, DeeModelIter* iter)
   // This needs to be used as a listener only!
   cached_adaptor1_.SetTarget(model, iter, renderer_tag_);
   row_added.emit(cached_adaptor1_);
+  AddRowChange(ModelDiff::Change::ADDED, model, iter);
 }
 
 template<class RowAdaptor>
@@ -177,6 +195,7 @@ void Model<RowAdaptor>::OnRowChanged(DeeModel* model, DeeModelIter* iter)
   // This needs to be used as a listener only!
   cached_adaptor2_.SetTarget(model, iter, renderer_tag_);
   row_changed.emit(cached_adaptor2_);
+  AddRowChange(ModelDiff::Change::CHANGED, model, iter);
 }
 
 template<class RowAdaptor>
@@ -187,6 +206,29 @@ void Model<RowAdaptor>::OnRowRemoved(DeeModel* model, DeeModelIter* iter)
   // This needs to be used as a listener only!
   cached_adaptor3_.SetTarget(model, iter, renderer_tag_);
   row_removed.emit(cached_adaptor3_);
+  // The row is removed only after this signal, so its position is still valid
+  AddRowChange(ModelDiff::Change::REMOVED, model, iter);
+}
+
+template<class RowAdaptor>
+void Model<RowAdaptor>::AddRowChange(ModelDiff::Change change, DeeModel* model, DeeModelIter* iter)
+{
+  diff_.Add(change, dee_model_get_position(model, iter));
+
+  if (!batching_rows_)
+    FlushRowChanges();
+}
+
+template<class RowAdaptor>
+void Model<RowAdaptor>::FlushRowChanges()
+{
+  if (diff_.empty())
+    return;
+
+  // Listeners might change the model again
+  ModelDiff diff;
+  std::swap(diff, diff_);
+  rows_changed.emit(diff);
 }
 
 template<class RowAdaptor>
@@ -196,7 +238,7 @@ void Model<RowAdaptor>::OnTransactionBegin(DeeModel* model, guint64 begin_seqnum
 
   begin_seqnum = static_cast<uint64_t> (begin_seqnum64);
   end_seqnum = static_cast<uint64_t> (end_seqnum64);
-  begin_transaction.emit(begin_seqnum, end_seqnum);
+  BeginTransaction(begin_seqnum, end_seqnum);
 }
 
 template<class RowAdaptor>
@@ -206,7 +248,22 @@ void Model<RowAdaptor>::OnTransactionEnd(DeeModel* model, guint64 begin_seqnum64
 
   begin_seqnum = static_cast<uint64_t> (begin_seqnum64);
   end_seqnum = static_cast<uint64_t> (end_seqnum64);
+  EndTransaction(begin_seqnum, end_seqnum);
+}
+
+template<class RowAdaptor>
+void Model<RowAdaptor>::BeginTransaction(uint64_t begin_seqnum, uint64_t end_seqnum)
+{
+  batching_rows_ = true;
+  begin_transaction.emit(begin_seqnum, end_seqnum);
+}
+
+template<class RowAdaptor>
+void Model<RowAdaptor>::EndTransaction(uint64_t begin_seqnum, uint64_t end_seqnum)
+{
+  batching_rows_ = false;
   end_transaction.emit(begin_seqnum, end_seqnum);
+  FlushRowChanges();
 }
 
 template<class RowAdaptor>
@@ -28,6 +28,7 @@
 
 #include "GLibSignal.h"
 #include "GLibWrapper.h"
+#include "ModelDiff.h"
 #include "ModelRowAdaptor.h"
 
 namespace unity
@@ -73,11 +74,19 @@ public:
   sigc::signal<void, uint64_t, uint64_t> begin_transaction;
   sigc::signal<void, uint64_t, uint64_t> end_transaction;
 
+  /* Emitted once per transaction, after end_transaction, with all the rows
+   * changed by it. Models without transactions emit it for each row. */
+  sigc::signal<void, ModelDiff const&> rows_changed;
+
   typedef std::function<DeeModelTag*(glib::Object<DeeModel> const& model)> GetDeeTagFunc;
 
   void SetModel(glib::Object<DeeModel> const& model);
   void SetModel(glib::Object<DeeModel> const& model, GetDeeTagFunc const& func);
 
+  // Batch the row changes following the transactions of another model (i.e.
+  // for a filter model of a shared model, that has no transactions on its own)
+  void FollowTransactions(Model& other);
+
 private:
   void Init();
   void OnRowAdded(DeeModel* model, DeeModelIter* iter);
@@ -85,6 +94,10 @@ private:
   void OnRowRemoved(DeeModel* model, DeeModelIter* iter);
   void OnTransactionBegin(DeeModel* model, guint64 begin_seq, guint64 end_seq);
   void OnTransactionEnd(DeeModel* model, guint64 begin_seq, guint64 end_seq);
+  void BeginTransaction(uint64_t begin_seqnum, uint64_t end_seqnum);
+  void EndTransaction(uint64_t begin_seqnum, uint64_t end_seqnum);
+  void AddRowChange(ModelDiff::Change change, DeeModel* model, DeeModelIter* iter);
+  void FlushRowChanges();
   void OnSwarmNameChanged(std::string const& swarm_name);
   std::size_t get_count() const;
   uint64_t get_seqnum() const;
@@ -95,6 +108,8 @@ private:
   glib::SignalManager sig_manager_;
   DeeModelTag* renderer_tag_;
   ModelType model_type_;
+  ModelDiff diff_;
+  bool batching_rows_;
 
   RowAdaptor cached_adaptor1_;
   RowAdaptor cached_adaptor2_;
@@ -0,0 +1,105 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "ModelDiff.h"
+
+namespace unity
+{
+namespace dash
+{
+
+ModelDiff::ModelDiff()
+  : added(0)
+  , changed(0)
+  , removed(0)
+{}
+
+void ModelDiff::Add(Change change, std::size_t position)
+{
+  Range* last = ranges.empty() ? nullptr : &ranges.back();
+
+  if (last && last->change != change)
+    last = nullptr;
+
+  switch (change)
+  {
+    case Change::ADDED:
+      ++added;
+
+      // A row inserted anywhere in an added range keeps it contiguous
+      if (last && position >= last->position && position <= last->position + last->count)
+      {
+        ++last->count;
+        return;
+      }
+      break;
+
+    case Change::CHANGED:
+      if (last && position >= last->position && position < last->position + last->count)
+        return;
+
+      ++changed;
+
+      if (last && position == last->position + last->count)
+      {
+        ++last->count;
+        return;
+      }
+      else if (last && position + 1 == last->position)
+      {
+        --last->position;
+        ++last->count;
+        return;
+      }
+      break;
+
+    case Change::REMOVED:
+      ++removed;
+
+      // The next row takes the position of the removed one
+      if (last && position == last->position)
+      {
+        ++last->count;
+        return;
+      }
+      else if (last && position + 1 == last->position)
+      {
+        --last->position;
+        ++last->count;
+        return;
+      }
+      break;
+  }
+
+  ranges.push_back({change, position, 1});
+}
+
+void ModelDiff::Clear()
+{
+  ranges.clear();
+  added = changed = removed = 0;
+}
+
+bool ModelDiff::empty() const
+{
+  return ranges.empty();
+}
+
+}
+}
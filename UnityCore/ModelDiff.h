@@ -0,0 +1,70 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_MODEL_DIFF_H
+#define UNITY_MODEL_DIFF_H
+
+#include <cstddef>
+#include <vector>
+
+namespace unity
+{
+namespace dash
+{
+
+/* The rows changed by a model transaction, as an ordered list of ranges.
+ *
+ * Each range position refers to the model as it was when the range has been
+ * applied, so ranges are meant to be replayed in order. Consecutive changes of
+ * the same kind on adjacent rows are merged in the same range.
+ */
+struct ModelDiff
+{
+  enum class Change
+  {
+    ADDED,
+    CHANGED,
+    REMOVED
+  };
+
+  struct Range
+  {
+    Change change;
+    std::size_t position;
+    std::size_t count;
+  };
+
+  ModelDiff();
+
+  void Add(Change change, std::size_t position);
+  void Clear();
+  bool empty() const;
+
+  std::vector<Range> ranges;
+
+  // Number of rows for each kind of change
+  std::size_t added;
+  std::size_t changed;
+  std::size_t removed;
+};
+
+}
+}
+
+#endif
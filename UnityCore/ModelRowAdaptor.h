@@ -71,6 +71,7 @@ public:
   T renderer() const;
 
   DeeModel* model() { return model_; }
+  DeeModelIter* iter() const { return iter_; }
 
 protected:
   virtual void set_model_tag(gpointer value);
@@ -0,0 +1,243 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "ModelSnapshot.h"
+
+#include <cstring>
+
+namespace unity
+{
+namespace dash
+{
+namespace
+{
+template <typename T>
+void Store(std::vector<T>& values, std::size_t position, T const& value, bool replace)
+{
+  if (replace)
+    values[position] = value;
+  else
+    values.insert(values.begin() + position, value);
+}
+
+template <typename T>
+void Erase(std::vector<T>& values, std::size_t position)
+{
+  values.erase(values.begin() + position);
+}
+}
+
+void ModelSnapshot::OnModelChanged(glib::Object<DeeModel> const& model)
+{
+  // The rows of the new model are added back through the row-added signal
+  model_ = model;
+  Reset();
+}
+
+void ModelSnapshot::OnRowAdded(RowAdaptorBase& row)
+{
+  std::size_t position = dee_model_get_position(model_, row.iter());
+
+  if (position > size_)
+    return;
+
+  SetupColumns();
+  ReadRow(row.iter(), position, false);
+}
+
+void ModelSnapshot::OnRowChanged(RowAdaptorBase& row)
+{
+  std::size_t position = dee_model_get_position(model_, row.iter());
+
+  if (position < size_)
+    ReadRow(row.iter(), position, true);
+}
+
+void ModelSnapshot::OnRowRemoved(RowAdaptorBase& row)
+{
+  // The row-removed signal is emitted before the row is actually removed
+  std::size_t position = dee_model_get_position(model_, row.iter());
+
+  if (position >= size_)
+    return;
+
+  for (auto& column : columns_)
+  {
+    switch (column.type)
+    {
+      case 's':
+        Release(column.strings[position]);
+        Erase(column.strings, position);
+        break;
+      case 'u':
+      case 'b':
+        Erase(column.uints, position);
+        break;
+      case 'i':
+        Erase(column.ints, position);
+        break;
+      case 'd':
+        Erase(column.doubles, position);
+        break;
+      default:
+        Erase(column.variants, position);
+        break;
+    }
+  }
+
+  --size_;
+}
+
+void ModelSnapshot::Reset()
+{
+  columns_.clear();
+  strings_.clear();
+  size_ = 0;
+}
+
+void ModelSnapshot::SetupColumns()
+{
+  if (!columns_.empty() || !model_)
+    return;
+
+  unsigned n_columns = dee_model_get_n_columns(model_);
+
+  for (unsigned i = 0; i < n_columns; ++i)
+  {
+    const gchar* schema = dee_model_get_column_schema(model_, i);
+    char type = (schema && strlen(schema) == 1 && strchr("subid", schema[0])) ? schema[0] : 'v';
+    columns_.push_back(Column(type));
+  }
+}
+
+void ModelSnapshot::ReadRow(DeeModelIter* iter, std::size_t position, bool replace)
+{
+  for (unsigned i = 0; i < columns_.size(); ++i)
+  {
+    Column& column = columns_[i];
+
+    switch (column.type)
+    {
+      case 's':
+      {
+        std::string const* value = Intern(dee_model_get_string(model_, iter, i));
+
+        if (replace)
+          Release(column.strings[position]);
+
+        Store(column.strings, position, value, replace);
+        break;
+      }
+      case 'u':
+        Store(column.uints, position, static_cast<unsigned>(dee_model_get_uint32(model_, iter, i)), replace);
+        break;
+      case 'b':
+        Store(column.uints, position, dee_model_get_bool(model_, iter, i) ? 1u : 0u, replace);
+        break;
+      case 'i':
+        Store(column.ints, position, static_cast<int>(dee_model_get_int32(model_, iter, i)), replace);
+        break;
+      case 'd':
+        Store(column.doubles, position, dee_model_get_double(model_, iter, i), replace);
+        break;
+      default:
+        Store(column.variants, position, glib::Variant(dee_model_get_value(model_, iter, i), glib::StealRef()), replace);
+        break;
+    }
+  }
+
+  if (!replace)
+    ++size_;
+}
+
+std::size_t ModelSnapshot::size() const
+{
+  return size_;
+}
+
+bool ModelSnapshot::empty() const
+{
+  return size_ == 0;
+}
+
+ModelSnapshot::Column const* ModelSnapshot::GetColumn(unsigned column, char type) const
+{
+  if (column >= columns_.size() || columns_[column].type != type)
+    return nullptr;
+
+  return &columns_[column];
+}
+
+std::vector<std::string const*> const& ModelSnapshot::GetStringColumn(unsigned column) const
+{
+  static const std::vector<std::string const*> empty;
+  auto const* col = GetColumn(column, 's');
+  return col ? col->strings : empty;
+}
+
+std::vector<unsigned> const& ModelSnapshot::GetUIntColumn(unsigned column) const
+{
+  static const std::vector<unsigned> empty;
+  auto const* col = GetColumn(column, 'u');
+
+  if (!col)
+    col = GetColumn(column, 'b');
+
+  return col ? col->uints : empty;
+}
+
+std::vector<int> const& ModelSnapshot::GetIntColumn(unsigned column) const
+{
+  static const std::vector<int> empty;
+  auto const* col = GetColumn(column, 'i');
+  return col ? col->ints : empty;
+}
+
+std::vector<double> const& ModelSnapshot::GetDoubleColumn(unsigned column) const
+{
+  static const std::vector<double> empty;
+  auto const* col = GetColumn(column, 'd');
+  return col ? col->doubles : empty;
+}
+
+std::vector<glib::Variant> const& ModelSnapshot::GetVariantColumn(unsigned column) const
+{
+  static const std::vector<glib::Variant> empty;
+  auto const* col = GetColumn(column, 'v');
+  return col ? col->variants : empty;
+}
+
+std::string const* ModelSnapshot::Intern(const gchar* value)
+{
+  // Elements of an unordered_map are never moved, even when rehashing
+  auto it = strings_.insert({glib::gchar_to_string(value), 0}).first;
+  ++it->second;
+  return &it->first;
+}
+
+void ModelSnapshot::Release(std::string const* value)
+{
+  auto it = strings_.find(*value);
+
+  if (it != strings_.end() && --it->second == 0)
+    strings_.erase(it);
+}
+
+}
+}
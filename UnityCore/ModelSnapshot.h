@@ -0,0 +1,128 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_MODEL_SNAPSHOT_H
+#define UNITY_MODEL_SNAPSHOT_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <dee.h>
+#include <sigc++/trackable.h>
+
+#include "GLibWrapper.h"
+#include "Model.h"
+#include "Variant.h"
+
+namespace unity
+{
+namespace dash
+{
+
+/* A read-only, column oriented copy of the content of a Model.
+ *
+ * Going through a RowAdaptor means calling into dee for every value, and
+ * copying the strings; this is fine for a single row, but it's costly for code
+ * that needs to look at a column of all the rows of the model.
+ *
+ * The snapshot is updated from the model row signals, so that adding,
+ * changing or removing a row only touches that row, and it's always in sync
+ * with the model, even while a transaction is in progress. Each column is
+ * stored in a vector typed after the schema. Strings are interned, so rows
+ * sharing the same value point to the same string.
+ *
+ * The returned columns and strings are valid until the model changes.
+ */
+class ModelSnapshot : public sigc::trackable, boost::noncopyable
+{
+public:
+  template <class RowAdaptor>
+  explicit ModelSnapshot(Model<RowAdaptor>& model);
+
+  std::size_t size() const;
+  bool empty() const;
+
+  // Return an empty column if the schema type doesn't match
+  std::vector<std::string const*> const& GetStringColumn(unsigned column) const;    // "s"
+  std::vector<unsigned> const& GetUIntColumn(unsigned column) const;                // "u" and "b"
+  std::vector<int> const& GetIntColumn(unsigned column) const;                      // "i"
+  std::vector<double> const& GetDoubleColumn(unsigned column) const;                // "d"
+  std::vector<glib::Variant> const& GetVariantColumn(unsigned column) const;        // Any other
+
+private:
+  struct Column
+  {
+    Column(char type_ = 0) : type(type_) {}
+
+    char type;
+    std::vector<std::string const*> strings;
+    std::vector<unsigned> uints;
+    std::vector<int> ints;
+    std::vector<double> doubles;
+    std::vector<glib::Variant> variants;
+  };
+
+  void OnModelChanged(glib::Object<DeeModel> const& model);
+  void OnRowAdded(RowAdaptorBase& row);
+  void OnRowChanged(RowAdaptorBase& row);
+  void OnRowRemoved(RowAdaptorBase& row);
+  void Reset();
+  void SetupColumns();
+  void ReadRow(DeeModelIter* iter, std::size_t position, bool replace);
+  Column const* GetColumn(unsigned column, char type) const;
+  std::string const* Intern(const gchar* value);
+  void Release(std::string const* value);
+
+  glib::Object<DeeModel> model_;
+  std::vector<Column> columns_;
+  // Interned strings with the number of cells using them
+  std::unordered_map<std::string, unsigned> strings_;
+  std::size_t size_;
+};
+
+template <class RowAdaptor>
+ModelSnapshot::ModelSnapshot(Model<RowAdaptor>& model)
+  : model_(model.model())
+  , size_(0)
+{
+  model.model.changed.connect(sigc::mem_fun(this, &ModelSnapshot::OnModelChanged));
+  model.row_added.connect(sigc::mem_fun(this, &ModelSnapshot::OnRowAdded));
+  model.row_changed.connect(sigc::mem_fun(this, &ModelSnapshot::OnRowChanged));
+  model.row_removed.connect(sigc::mem_fun(this, &ModelSnapshot::OnRowRemoved));
+
+  if (!model_)
+    return;
+
+  // Rows added before we were connected
+  DeeModelIter* iter = dee_model_get_first_iter(model_);
+  DeeModelIter* end_iter = dee_model_get_last_iter(model_);
+
+  for (; iter != end_iter; iter = dee_model_next(model_, iter))
+  {
+    SetupColumns();
+    ReadRow(iter, size_, false);
+  }
+}
+
+}
+}
+
+#endif
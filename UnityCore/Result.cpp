@@ -28,18 +28,7 @@ namespace dash
 
 namespace
 {
-enum ResultColumn
-{
-  URI,
-  ICON_HINT,
-  CATEGORY,
-  RESULT_TYPE,
-  MIMETYPE,
-  TITLE,
-  COMMENT,
-  DND_URI,
-  METADATA
-};
+typedef Result::Column ResultColumn;
 }
 
 Result::Result(DeeModel* model,
@@ -191,31 +180,31 @@ LocalResult LocalResult::FromVariant(glib::Variant const& v)
     vars.push_back(value);
     switch (i)
     {
-      case URI:
+      case ResultColumn::URI:
         result.uri = glib::gchar_to_string(g_variant_get_string(value, NULL));
         break;
-      case ICON_HINT:
+      case ResultColumn::ICON_HINT:
         result.icon_hint = glib::gchar_to_string(g_variant_get_string(value, NULL));
         break;
-      case CATEGORY:
+      case ResultColumn::CATEGORY:
         result.category_index = g_variant_get_uint32(value);
         break;
-      case RESULT_TYPE:
+      case ResultColumn::RESULT_TYPE:
         result.result_type = g_variant_get_uint32(value);
         break;
-      case MIMETYPE:
+      case ResultColumn::MIMETYPE:
         result.mimetype = glib::gchar_to_string(g_variant_get_string(value, NULL));
         break;
-      case TITLE:
+      case ResultColumn::TITLE:
         result.name = glib::gchar_to_string(g_variant_get_string(value, NULL));
         break;
-      case COMMENT:
+      case ResultColumn::COMMENT:
         result.comment = glib::gchar_to_string(g_variant_get_string(value, NULL));
         break;
-      case DND_URI:
+      case ResultColumn::DND_URI:
         result.dnd_uri = glib::gchar_to_string(g_variant_get_string(value, NULL));
         break;
-      case METADATA:
+      case ResultColumn::METADATA:
         glib::HintsMap hints;
         if (glib::Variant(value).ASVToHints(hints))
         {
@@ -39,6 +39,20 @@ namespace dash
 class Result : public RowAdaptorBase
 {
 public:
+  // Columns of the results model schema
+  enum Column : unsigned
+  {
+    URI = 0,
+    ICON_HINT,
+    CATEGORY,
+    RESULT_TYPE,
+    MIMETYPE,
+    TITLE,
+    COMMENT,
+    DND_URI,
+    METADATA
+  };
+
   Result(DeeModel* model, DeeModelIter* iter, DeeModelTag* tag);
 
   Result(Result const& other);
@@ -31,6 +31,7 @@ Results::Results()
 
 Results::Results(ModelType model_type)
   : Model<Result>::Model(model_type)
+  , snapshot_(new ModelSnapshot(*this)) // Must be updated before result signals are emitted
 {
   row_added.connect(sigc::mem_fun(&result_added, &decltype(result_added)::emit));
   row_changed.connect(sigc::mem_fun(&result_changed, &decltype(result_changed)::emit));
@@ -47,5 +48,10 @@ ResultIterator Results::end()
   return ResultIterator(model(), dee_model_get_last_iter(model()), GetTag());
 }
 
+ModelSnapshot const& Results::GetSnapshot() const
+{
+  return *snapshot_;
+}
+
 }
 }
@@ -23,6 +23,7 @@
 #include <memory>
 
 #include "Model.h"
+#include "ModelSnapshot.h"
 #include "Result.h"
 #include "ModelIterator.h"
 
@@ -44,9 +45,15 @@ public:
   ResultIterator begin();
   ResultIterator end();
 
+  // Columnar view of the results, indexed by Result::Column
+  ModelSnapshot const& GetSnapshot() const;
+
   sigc::signal<void, Result const&> result_added;
   sigc::signal<void, Result const&> result_changed;
   sigc::signal<void, Result const&> result_removed;
+
+private:
+  std::unique_ptr<ModelSnapshot> snapshot_;
 };
 
 }
@@ -817,6 +817,7 @@ Results::Ptr ScopeProxy::GetResultsForCategory(unsigned category) const
   auto func = [all_results](glib::Object<DeeModel> const& model) { return all_results->GetTag(); };
   
   Results::Ptr results_category_model(new Results(ModelType::UNATTACHED));
+  results_category_model->FollowTransactions(*all_results);
   results_category_model->SetModel(filter_model, func);
   return results_category_model;
 }
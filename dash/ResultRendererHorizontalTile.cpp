@@ -358,9 +358,7 @@ void ResultRendererHorizontalTile::LoadText(Result const& row)
   pango_font_description_free(desc);
   g_object_unref(layout);
 
-  TextureContainer *container = row.renderer<TextureContainer*>();
-  if (container)
-    container->text = texture_ptr_from_cairo_graphics(_cairoGraphics);
+  SetTextTexture(row, _cairoGraphics);
 }
 
 nux::NBitmapData* ResultRendererHorizontalTile::GetDndImage(Result const& row) const
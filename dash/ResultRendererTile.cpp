@@ -22,8 +22,6 @@
 
 #include "ResultRendererTile.h"
 
-#include <pango/pangocairo.h>
-
 #include <NuxCore/Logger.h>
 #include <UnityCore/GLibWrapper.h>
 #include <NuxGraphics/GdkGraphics.h>
@@ -47,6 +45,7 @@ const int FONT_SIZE       = 10;
 const int FONT_MULTIPLIER = 1024;
 
 char const REPLACEMENT_CHAR = '?';
+const unsigned MAX_POOLED_CONTAINERS = 64;
 float const CORNER_HIGHTLIGHT_RADIUS = 2.0f;
 
 void RenderTexture(nux::GraphicsEngine& GfxContext,
@@ -96,6 +95,7 @@ ResultRendererTile::ResultRendererTile(NUX_FILE_LINE_DECL, bool neko_mode)
 {
   UpdateWidthHeight();
   scale.changed.connect([this] (double) { UpdateWidthHeight(); });
+  text_tiles_connection_ = TextTileRenderer::GetDefault().tiles_ready.connect([this] { NeedsRedraw.emit(); });
 }
 
 void ResultRendererTile::UpdateWidthHeight()
@@ -171,7 +171,29 @@ void ResultRendererTile::Render(nux::GraphicsEngine& GfxContext,
                   saturate);
   }
 
-  if (container->text)
+  if (container->text_tile && container->text_tile->ready())
+  {
+    nux::Geometry const& tile_geo = container->text_tile->geometry();
+
+    // The text is a sub-rect of the shared atlas texture
+    nux::TexCoordXForm text_texxform;
+    text_texxform.SetTexCoordType(nux::TexCoordXForm::UNNORMALIZED_COORD);
+    text_texxform.u0 = tile_geo.x;
+    text_texxform.v0 = tile_geo.y;
+    text_texxform.u1 = tile_geo.x + tile_geo.width;
+    text_texxform.v1 = tile_geo.y + tile_geo.height;
+
+    RenderTexture(GfxContext,
+                  geometry.x + PADDING.CP(scale),
+                  geometry.y + tile_icon_size + SPACING.CP(scale),
+                  tile_geo.width,
+                  tile_geo.height,
+                  container->text_tile->GetDeviceTexture(),
+                  text_texxform,
+                  color,
+                  saturate);
+  }
+  else if (container->text)
   {
     RenderTexture(GfxContext,
                   geometry.x + PADDING.CP(scale),
@@ -223,20 +245,22 @@ void ResultRendererTile::Preload(Result const& row)
   if (row.renderer<TextureContainer*>() == nullptr)
   {
     // Shouldn't really do this, but it's safe in this case and quicker than making a copy.
-    const_cast<Result&>(row).set_renderer(new TextureContainer());
-    LoadIcon(row);
+    const_cast<Result&>(row).set_renderer(AcquireContainer());
+    LoadIcon(row, IconLoader::Priority::PRELOAD);
     LoadText(row);
   }
 }
 
 void ResultRendererTile::ReloadResult(Result const& row)
 {
-  Unload(row);
-
+  // Results that aren't loaded will be loaded once they get close to be visible
   if (row.renderer<TextureContainer*>() == nullptr)
-    const_cast<Result&>(row).set_renderer(new TextureContainer());
+    return;
+
+  Unload(row);
+  const_cast<Result&>(row).set_renderer(AcquireContainer());
 
-  LoadIcon(row);
+  LoadIcon(row, IconLoader::Priority::VISIBLE);
   LoadText(row);
 }
 
@@ -245,12 +269,39 @@ void ResultRendererTile::Unload(Result const& row)
   TextureContainer *container = row.renderer<TextureContainer*>();
   if (container)
   {
-    delete container;
+    RecycleContainer(container);
     // Shouldn't really do this, but it's safe in this case and quicker than making a copy.
     const_cast<Result&>(row).set_renderer<TextureContainer*>(nullptr);
   }
 }
 
+TextureContainer* ResultRendererTile::AcquireContainer()
+{
+  auto it = containers_pool_.find(std::make_pair(width(), height()));
+
+  if (it == containers_pool_.end() || it->second.empty())
+    return new TextureContainer();
+
+  TextureContainer* container = it->second.back().release();
+  it->second.pop_back();
+
+  return container;
+}
+
+void ResultRendererTile::RecycleContainer(TextureContainer* container)
+{
+  auto& pool = containers_pool_[std::make_pair(width(), height())];
+
+  if (pool.size() >= MAX_POOLED_CONTAINERS)
+  {
+    delete container;
+    return;
+  }
+
+  container->Reset();
+  pool.emplace_back(container);
+}
+
 nux::NBitmapData* ResultRendererTile::GetDndImage(Result const& row) const
 {
   TextureContainer* container = row.renderer<TextureContainer*>();
@@ -265,7 +316,7 @@ nux::NBitmapData* ResultRendererTile::GetDndImage(Result const& row) const
   return bitmap ? bitmap : ResultRenderer::GetDndImage(row);
 }
 
-void ResultRendererTile::LoadIcon(Result const& row)
+void ResultRendererTile::LoadIcon(Result const& row, IconLoader::Priority priority)
 {
   Style const& style = Style::Instance();
   int tile_size   = style.GetTileImageSize().CP(scale);
@@ -308,11 +359,11 @@ void ResultRendererTile::LoadIcon(Result const& row)
     container->slot_handle = IconLoader::GetDefault().LoadFromGIconString(icon_name,
                                                                           tile_size,
                                                                           use_large_icon ?
-                                                                          tile_size : tile_gsize, slot);
+                                                                          tile_size : tile_gsize, slot, priority);
   }
   else
   {
-    container->slot_handle = IconLoader::GetDefault().LoadFromIconName(icon_name, -1, tile_gsize, slot);
+    container->slot_handle = IconLoader::GetDefault().LoadFromIconName(icon_name, -1, tile_gsize, slot, priority);
   }
 }
 
@@ -467,63 +518,40 @@ std::string ReplaceBlacklistedChars(std::string const& str)
 
 void ResultRendererTile::LoadText(Result const& row)
 {
-  Style const& style = Style::Instance();
-
-  nux::CairoGraphics _cairoGraphics(CAIRO_FORMAT_ARGB32,
-                                    style.GetTileWidth().CP(scale()) - (PADDING.CP(scale()) * 2),
-                                    style.GetTileHeight().CP(scale()) - style.GetTileImageSize().CP(scale()) - SPACING.CP(scale()));
-  cairo_surface_set_device_scale(_cairoGraphics.GetSurface(), scale(), scale());
-
-  cairo_t* cr = _cairoGraphics.GetInternalContext();
-
-  PangoLayout*          layout     = NULL;
-  PangoFontDescription* desc       = NULL;
-  PangoContext*         pango_context   = NULL;
-  GdkScreen*            screen     = gdk_screen_get_default();    // not ref'ed
-
-  cairo_set_font_options(cr, gdk_screen_get_font_options(screen));
-  layout = pango_cairo_create_layout(cr);
-  desc = pango_font_description_from_string(theme::Settings::Get()->font().c_str());
-  pango_font_description_set_size (desc, FONT_SIZE * FONT_MULTIPLIER);
+  TextureContainer* container = row.renderer<TextureContainer*>();
+  if (!container)
+    return;
 
-  pango_layout_set_font_description(layout, desc);
-  pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+  Style const& style = Style::Instance();
 
-  pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
-  pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_START);
-  pango_layout_set_width(layout, (style.GetTileWidth() - (PADDING * 2))* PANGO_SCALE);
-  pango_layout_set_height(layout, -2);
+  TextTileStyle text_style;
+  text_style.font = theme::Settings::Get()->font();
+  text_style.font_size = FONT_SIZE * FONT_MULTIPLIER;
+  text_style.width = style.GetTileWidth().CP(scale()) - (PADDING.CP(scale()) * 2);
+  text_style.height = style.GetTileHeight().CP(scale()) - style.GetTileImageSize().CP(scale()) - SPACING.CP(scale());
+  text_style.scale = scale();
+  text_style.dpi = 96.0 * Settings::Instance().font_scaling();
 
   // FIXME bug #1239381
-  std::string name = ReplaceBlacklistedChars(row.name());
-
-  char *escaped_text = g_markup_escape_text(name.c_str(), -1);
-
-  pango_layout_set_markup(layout, escaped_text, -1);
-
-  g_free (escaped_text);
-
-  pango_context = pango_layout_get_context(layout);  // is not ref'ed
-  pango_cairo_context_set_font_options(pango_context, gdk_screen_get_font_options(screen));
-  pango_cairo_context_set_resolution(pango_context, 96.0 * Settings::Instance().font_scaling());
-  pango_layout_context_changed(layout);
-
-  cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-  cairo_paint(cr);
-
-  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-  cairo_set_source_rgba(cr, 1.0f, 1.0f, 1.0f, 1.0f);
+  container->text_tile = TextTileRenderer::GetDefault().RenderText(ReplaceBlacklistedChars(row.name()), text_style);
+}
 
-  cairo_move_to(cr, 0.0f, 0.0f);
-  pango_cairo_show_layout(cr, layout);
+void ResultRendererTile::SetTextTexture(Result const& row, nux::CairoGraphics& cairo_graphics)
+{
+  TextureContainer *container = row.renderer<TextureContainer*>();
+  if (!container)
+    return;
 
-  // clean up
-  pango_font_description_free(desc);
-  g_object_unref(layout);
+  // Recycled containers already have a text texture we can refill
+  if (container->text && container->text->GetWidth() == cairo_graphics.GetWidth() &&
+      container->text->GetHeight() == cairo_graphics.GetHeight())
+  {
+    std::unique_ptr<nux::NBitmapData> bitmap(cairo_graphics.GetBitmap());
+    container->text->Update(bitmap.get());
+    return;
+  }
 
-  TextureContainer *container = row.renderer<TextureContainer*>();
-  if (container)
-    container->text = texture_ptr_from_cairo_graphics(_cairoGraphics);
+  container->text = texture_ptr_from_cairo_graphics(cairo_graphics);
 }
 
 
@@ -25,9 +25,21 @@
 #ifndef RESULTRENDERERTILE_H
 #define RESULTRENDERERTILE_H
 
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <UnityCore/ConnectionManager.h>
+
 #include "ResultRenderer.h"
+#include "TextTileRenderer.h"
 #include "unity-shared/IconLoader.h"
 
+namespace nux
+{
+class CairoGraphics;
+}
+
 namespace unity
 {
 namespace dash
@@ -39,6 +51,7 @@ namespace dash
     BaseTexturePtr icon;
     BaseTexturePtr prelight;
     glib::Object<GdkPixbuf> drag_icon;
+    TextTile::Ptr text_tile;
 
     int slot_handle;
 
@@ -47,9 +60,21 @@ namespace dash
     {}
 
     ~TextureContainer()
+    {
+      Reset();
+    }
+
+    // Drops the per-result data, but keeps the textures that can be refilled
+    void Reset()
     {
       if (slot_handle > 0)
         IconLoader::GetDefault().DisconnectHandle(slot_handle);
+
+      slot_handle = 0;
+      icon = nullptr;
+      prelight = nullptr;
+      drag_icon = nullptr;
+      text_tile.reset();
     }
   };
 
@@ -80,7 +105,12 @@ public:
 
 protected:
   virtual void LoadText(Result const& row);
-  void LoadIcon(Result const& row);
+  void LoadIcon(Result const& row, IconLoader::Priority priority);
+  void SetTextTexture(Result const& row, nux::CairoGraphics& cairo_graphics);
+
+  TextureContainer* AcquireContainer();
+  void RecycleContainer(TextureContainer* container);
+
   nux::ObjectPtr<nux::BaseTexture> prelight_cache_;
   nux::ObjectPtr<nux::BaseTexture> normal_cache_;
 private:
@@ -97,6 +127,10 @@ private:
   void UpdateWidthHeight();
 
   bool neko_mode_;
+  connection::Wrapper text_tiles_connection_;
+
+  // Containers of unloaded results, by renderer size, ready to be reused
+  std::map<std::pair<int, int>, std::vector<std::unique_ptr<TextureContainer>>> containers_pool_;
 };
 
 }
@@ -141,8 +141,6 @@ void ResultView::SetModelRenderer(ResultRenderer* renderer)
 void ResultView::AddResult(Result const& result)
 {
   renderer_->Preload(result);
-
-  NeedRedraw();
 }
 
 void ResultView::RemoveResult(Result const& result)
@@ -150,6 +148,11 @@ void ResultView::RemoveResult(Result const& result)
   renderer_->Unload(result);
 }
 
+void ResultView::ResultsChanged(ModelDiff const&)
+{
+  NeedRedraw();
+}
+
 void ResultView::SetResultsModel(Results::Ptr const& result_model)
 {
   // cleanup
@@ -167,6 +170,7 @@ void ResultView::SetResultsModel(Results::Ptr const& result_model)
   {
     result_connections_.Add(result_model_->result_added.connect(sigc::mem_fun(this, &ResultView::AddResult)));
     result_connections_.Add(result_model_->result_removed.connect(sigc::mem_fun(this, &ResultView::RemoveResult)));
+    result_connections_.Add(result_model_->rows_changed.connect(sigc::mem_fun(this, &ResultView::ResultsChanged)));
   }
 }
 
@@ -205,13 +209,16 @@ ResultIterator ResultView::GetIteratorAtRow(unsigned row)
 
 unsigned int ResultView::GetIndexForLocalResult(LocalResult const& local_result)
 {
+  if (!result_model_)
+    return 0;
+
+  auto const& uris = result_model_->GetSnapshot().GetStringColumn(Result::URI);
   unsigned int index = 0;
-  for (ResultIterator it(GetIteratorAtRow(0)); !it.IsLast(); ++it)
+
+  for (; index < uris.size(); ++index)
   {
-    if ((*it).uri == local_result.uri)
+    if (*uris[index] == local_result.uri)
       break;
-
-    index++;
   }
 
   return index;
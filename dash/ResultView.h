@@ -109,6 +109,8 @@ protected:
 
   virtual void AddResult(Result const& result);
   virtual void RemoveResult(Result const& result);
+  // Called once the results of a model transaction have been added or removed
+  virtual void ResultsChanged(ModelDiff const& diff);
 
   unsigned GetNumResults();
 
@@ -71,8 +71,10 @@ ResultViewGrid::ResultViewGrid(NUX_FILE_LINE_DECL)
   , mouse_over_index_(-1)
   , active_index_(-1)
   , selected_index_(-1)
-  , last_lazy_loaded_result_(0)
   , all_results_preloaded_(true)
+  , preloaded_bounds_(0, -1)
+  , loaded_begin_(0)
+  , loaded_end_(0)
   , last_mouse_down_x_(-1)
   , last_mouse_down_y_(-1)
   , drag_index_(~0)
@@ -240,9 +242,6 @@ void ResultViewGrid::QueueLazyLoad()
 
 void ResultViewGrid::QueueResultsChanged()
 {
-  // even if we're not going to run the lazy load, we need to reset the start in case it's running already.
-  last_lazy_loaded_result_ = 0;
-
   if (!results_changed_idle_)
   {
     // using glib::Source::Priority::HIGH because this needs to happen *before* next draw
@@ -253,10 +252,8 @@ void ResultViewGrid::QueueResultsChanged()
       lazy_load_source_.reset(); // no point doing this one as well.
 
       if (!all_results_preloaded_)
-      {
-        last_lazy_loaded_result_ = 0; // reset the lazy load index in case we got an insert
         DoLazyLoad(); // also calls QueueDraw
-      }
+
       return false;
     });
   }
@@ -267,32 +264,33 @@ bool ResultViewGrid::DoLazyLoad()
   util::Timer timer;
   bool queue_additional_load = false; // if this is set, we will return early and start loading more next frame
 
-  // instead we will just pre-load all the items if expanded or just one row if not
-  int index = 0;
-  int items_per_row = GetItemsPerRow();
-  for (ResultIterator it(GetIteratorAtRow(last_lazy_loaded_result_)); !it.IsLast(); ++it)
-  {
-    if ((!expanded && index < items_per_row) || expanded)
-    {
-      renderer_->Preload(*it);
-    }
+  // Only the results around the visible ones are loaded, the others are
+  // unloaded so that the renderer can recycle their resources.
+  ResultListBounds bounds = GetPreloadBounds(GetVisableResults());
+  unsigned start = std::get<0>(bounds);
+  unsigned end = std::max(std::get<1>(bounds) + 1, std::get<0>(bounds));
 
-    if (!expanded && index >= items_per_row)
-      break; //early exit
+  UnloadResults(loaded_begin_, std::min(loaded_end_, start));
+  UnloadResults(std::max(loaded_begin_, end), loaded_end_);
+  loaded_begin_ = start;
+  loaded_end_ = end;
+
+  unsigned index = start;
+  for (ResultIterator it(GetIteratorAtRow(start)); index < end && !it.IsLast(); ++it, ++index)
+  {
+    renderer_->Preload(*it);
 
     if (timer.ElapsedSeconds() > 0.008)
     {
       queue_additional_load = true;
       break;
     }
-
-    last_lazy_loaded_result_++;
-    index++;
   }
 
   if (!queue_additional_load)
   {
     all_results_preloaded_ = true;
+    preloaded_bounds_ = bounds;
     lazy_load_source_.reset();
   }
   else if (!lazy_load_source_)
@@ -305,6 +303,15 @@ bool ResultViewGrid::DoLazyLoad()
   return queue_additional_load;
 }
 
+void ResultViewGrid::UnloadResults(unsigned begin, unsigned end)
+{
+  if (begin >= end)
+    return;
+
+  unsigned index = begin;
+  for (ResultIterator it(GetIteratorAtRow(begin)); index < end && !it.IsLast(); ++it, ++index)
+    renderer_->Unload(*it);
+}
 
 int ResultViewGrid::GetItemsPerRow()
 {
@@ -326,14 +333,40 @@ void ResultViewGrid::SetModelRenderer(ResultRenderer* renderer)
 
 void ResultViewGrid::AddResult(Result const& result)
 {
-  all_results_preloaded_ = false;
-  QueueResultsChanged();
+  // Results are preloaded lazily, only when they get close to the viewport
 }
 
-void ResultViewGrid::RemoveResult(Result const& result)
+void ResultViewGrid::ResultsChanged(ModelDiff const& diff)
 {
-  ResultView::RemoveResult(result);
-  // removing a result might make a non-preloaded one visible
+  // Keep the loaded range on the same results, as the ones added or removed
+  // before it have shifted them.
+  for (auto const& range : diff.ranges)
+  {
+    if (range.change == ModelDiff::Change::ADDED)
+    {
+      if (range.position <= loaded_begin_)
+      {
+        loaded_begin_ += range.count;
+        loaded_end_ += range.count;
+      }
+      else if (range.position < loaded_end_)
+      {
+        loaded_end_ += range.count;
+      }
+    }
+    else if (range.change == ModelDiff::Change::REMOVED)
+    {
+      unsigned range_end = range.position + range.count;
+
+      if (range.position < loaded_begin_)
+        loaded_begin_ -= std::min(loaded_begin_, range_end) - range.position;
+
+      if (range.position < loaded_end_)
+        loaded_end_ -= std::min(loaded_end_, range_end) - range.position;
+    }
+  }
+
+  // adding or removing results might make a non-preloaded one visible
   all_results_preloaded_ = false;
   QueueResultsChanged();
 }
@@ -615,8 +648,10 @@ ResultListBounds ResultViewGrid::GetVisableResults()
   }
   else
   {
+    nux::Geometry const& viewport = GetViewport();
+
     //find the row we start at
-    int absolute_y = GetAbsoluteY() - GetToplevel()->GetAbsoluteY();
+    int absolute_y = GetAbsoluteY() - viewport.y;
     unsigned row_size = renderer_->height + vertical_spacing;
 
     if (absolute_y < 0)
@@ -630,10 +665,10 @@ ResultListBounds ResultViewGrid::GetVisableResults()
       start = 0;
     }
 
-    if (absolute_y + GetAbsoluteHeight() > GetToplevel()->GetAbsoluteHeight())
+    if (absolute_y + GetAbsoluteHeight() > viewport.height)
     {
       // our elements overflow the visable viewport
-      int visible_height = (GetToplevel()->GetAbsoluteHeight() - std::max(absolute_y, 0));
+      int visible_height = (viewport.height - std::max(absolute_y, 0));
       visible_height = std::min(visible_height, absolute_y + GetAbsoluteHeight());
 
       int visible_rows = std::ceil(visible_height / static_cast<float>(row_size));
@@ -651,20 +686,53 @@ ResultListBounds ResultViewGrid::GetVisableResults()
   return ResultListBounds(start, end);
 }
 
+ResultListBounds ResultViewGrid::GetPreloadBounds(ResultListBounds const& visible_bounds)
+{
+  int start = std::get<0>(visible_bounds);
+  int end = std::get<1>(visible_bounds);
+
+  if (!expanded || end < start)
+    return visible_bounds;
+
+  // Keep a page of results loaded above and below the visible ones, so that
+  // they are ready when scrolling.
+  int page = end - start + 1;
+  start = std::max(start - page, 0);
+  end = std::min(end + page, static_cast<int>(GetNumResults()) - 1);
+
+  return ResultListBounds(start, end);
+}
+
+nux::Geometry ResultViewGrid::GetViewport()
+{
+  return GetToplevel()->GetAbsoluteGeometry();
+}
+
 void ResultViewGrid::Draw(nux::GraphicsEngine& GfxContext, bool force_draw)
 {
+  ResultListBounds visible_bounds = GetVisableResults();
+
+  if (GetPreloadBounds(visible_bounds) != preloaded_bounds_)
+  {
+    // We've been scrolled, so other results needs to be loaded
+    all_results_preloaded_ = false;
+    QueueLazyLoad();
+  }
+
+  if (std::get<1>(visible_bounds) < std::get<0>(visible_bounds))
+    return;
+
+  // Only the visible rows are drawn
   int items_per_row = GetItemsPerRow();
-  unsigned num_results = GetNumResults();
-  int total_rows = (!expanded) ? 0 : (num_results / items_per_row) + 1;
+  int first_row = std::get<0>(visible_bounds) / items_per_row;
+  int last_row = std::get<1>(visible_bounds) / items_per_row;
 
   int row_size = renderer_->height + vertical_spacing;
-  int y_position = padding + GetGeometry().y;
-
-  ResultListBounds visible_bounds = GetVisableResults();
+  int y_position = padding + GetGeometry().y + first_row * row_size;
 
   nux::Geometry absolute_geometry(GetAbsoluteGeometry());
 
-  for (int row_index = 0; row_index <= total_rows; row_index++)
+  for (int row_index = first_row; row_index <= last_row; row_index++)
   {
     DrawRow(GfxContext, visible_bounds, row_index, y_position, absolute_geometry);
 
@@ -1037,51 +1105,40 @@ void
 ResultViewGrid::UpdateRenderTextures()
 {
   nux::Geometry root_geo(GetAbsoluteGeometry());
+  ResultListBounds visible_bounds = GetVisableResults();
 
   int items_per_row = GetItemsPerRow();
-  unsigned num_results = GetNumResults();
-
-  unsigned int total_rows = (!expanded) ? 1 : std::ceil(num_results / (double)items_per_row);
   int row_height = renderer_->height + vertical_spacing;
 
-  int cumulative_height = 0;
-  unsigned int row_index = 0;
-  for (; row_index < total_rows; row_index++)
+  // Textures are needed only for the visible rows (only one for non-expanded).
+  int first_row = std::get<0>(visible_bounds) / items_per_row;
+  int last_row = std::get<1>(visible_bounds) / items_per_row;
+  unsigned int total_rows = (std::get<1>(visible_bounds) < std::get<0>(visible_bounds)) ? 0 : last_row - first_row + 1;
+
+  if (!expanded)
+    total_rows = std::min(total_rows, 1u);
+
+  int cumulative_height = first_row * row_height;
+  unsigned int i = 0;
+  for (; i < total_rows; i++)
   {
-    // only one texture for non-expanded.
-    if (!expanded && row_index > 0)
-      break;
+    // Textures of rows that aren't visible anymore are reused
+    if (i >= result_textures_.size())
+      result_textures_.push_back(ResultViewTexture::Ptr(new ResultViewTexture));
 
-    if (row_index >= result_textures_.size())
-    {
-      ResultViewTexture::Ptr result_texture(new ResultViewTexture);
-      result_texture->abs_geo.x = root_geo.x;
-      result_texture->abs_geo.y = root_geo.y + cumulative_height;
-      result_texture->abs_geo.width = GetWidth();
-      result_texture->abs_geo.height = row_height;
-      result_texture->row_index = row_index;
-
-      result_textures_.push_back(result_texture);
-    }
-    else
-    {
-      ResultViewTexture::Ptr const& result_texture(result_textures_[row_index]);
+    ResultViewTexture::Ptr const& result_texture(result_textures_[i]);
 
-      result_texture->abs_geo.x = root_geo.x;
-      result_texture->abs_geo.y = root_geo.y + cumulative_height;
-      result_texture->abs_geo.width = GetWidth();
-      result_texture->abs_geo.height = row_height;
-      result_texture->row_index = row_index;
-    }
+    result_texture->abs_geo.x = root_geo.x;
+    result_texture->abs_geo.y = root_geo.y + cumulative_height;
+    result_texture->abs_geo.width = GetWidth();
+    result_texture->abs_geo.height = row_height;
+    result_texture->row_index = first_row + i;
 
     cumulative_height += row_height;
   }
 
   // get rid of old textures.
-  for (; row_index < result_textures_.size(); row_index++)
-  {
-    result_textures_.pop_back();
-  }
+  result_textures_.resize(i);
 }
 
 void ResultViewGrid::RenderResultTexture(ResultViewTexture::Ptr const& result_texture)
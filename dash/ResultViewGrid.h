@@ -84,21 +84,27 @@ protected:
   virtual void UpdateRenderTextures();
 
   virtual void AddResult(Result const& result);
-  virtual void RemoveResult(Result const& result);
+  virtual void ResultsChanged(ModelDiff const& diff);
 
   // This is overridden so we can include position of results.
   virtual debug::ResultWrapper* CreateResultWrapper(Result const& result, int index);
   virtual void UpdateResultWrapper(debug::ResultWrapper* wrapper, Result const& result, int index);
 
+  // Absolute geometry of the area where the results can be visible
+  virtual nux::Geometry GetViewport();
+
+  bool DoLazyLoad();
+
 private:
   typedef std::tuple <int, int> ResultListBounds;
   ResultListBounds GetVisableResults();
+  ResultListBounds GetPreloadBounds(ResultListBounds const& visible_bounds);
 
   void DrawRow(nux::GraphicsEngine& GfxContext, ResultListBounds const& visible_bounds, int row_index, int y_position, nux::Geometry const& absolute_position);
 
   void QueueLazyLoad();
   void QueueResultsChanged();
-  bool DoLazyLoad();
+  void UnloadResults(unsigned begin, unsigned end);
   void UpdateScale(double scale);
 
   int GetItemsPerRow();
@@ -113,8 +119,13 @@ private:
 
   LocalResult activated_result_;
 
-  unsigned last_lazy_loaded_result_;
   bool all_results_preloaded_;
+  ResultListBounds preloaded_bounds_;
+
+  // The results in this range might be loaded, the others are not.
+  unsigned loaded_begin_;
+  unsigned loaded_end_;
+
   int last_mouse_down_x_;
   int last_mouse_down_y_;
   LocalResult current_drag_result_;
@@ -371,6 +371,7 @@ void ScopeView::SetupResults(Results::Ptr const& results)
 {
   conn_manager_.RemoveAndClear(&result_added_connection_);
   conn_manager_.RemoveAndClear(&result_removed_connection_);
+  conn_manager_.RemoveAndClear(&results_changed_connection_);
 
   if (!results)
     return;
@@ -379,6 +380,8 @@ void ScopeView::SetupResults(Results::Ptr const& results)
   result_added_connection_ = conn_manager_.Add(conn);
   conn = results->result_removed.connect(sigc::mem_fun(this, &ScopeView::OnResultRemoved));
   result_removed_connection_ = conn_manager_.Add(conn);
+  conn = results->rows_changed.connect(sigc::hide(sigc::mem_fun(this, &ScopeView::OnResultsChanged)));
+  results_changed_connection_ = conn_manager_.Add(conn);
 
   results->model.changed.connect([this] (glib::Object<DeeModel> model)
   {
@@ -394,6 +397,9 @@ void ScopeView::SetupResults(Results::Ptr const& results)
 
   for (unsigned int i = 0; i < results->count(); ++i)
     OnResultAdded(results->RowAtIndex(i));
+
+  if (results->count())
+    OnResultsChanged();
 }
 
 void ScopeView::SetupFilters(Filters::Ptr const& filters)
@@ -711,10 +717,6 @@ void ScopeView::OnResultAdded(Result const& result)
   LOG_TRACE(logger) << "Result added '" << (scope_ ? scope_->name() : "unknown") << "': " << uri;
 
   counts_[category_views_[result.category_index]]++;
-  // make sure we don't display the no-results-hint if we do have results
-  CheckNoResults(glib::HintsMap());
-
-  QueueCategoryCountsCheck();
 }
 
 void ScopeView::OnResultRemoved(Result const& result)
@@ -727,6 +729,11 @@ void ScopeView::OnResultRemoved(Result const& result)
   LOG_TRACE(logger) << "Result removed '" << (scope_ ? scope_->name() : "unknown") << "': " << uri;
 
   counts_[category_views_[result.category_index]]--;
+}
+
+void ScopeView::OnResultsChanged()
+{
+  // Called once per results transaction, after all the rows have been updated.
   // make sure we don't display the no-results-hint if we do have results
   CheckNoResults(glib::HintsMap());
 
@@ -102,6 +102,7 @@ private:
 
   void OnResultAdded(Result const& result);
   void OnResultRemoved(Result const& result);
+  void OnResultsChanged();
 
   void OnSearchComplete(std::string const& search_string, glib::HintsMap const& hints, glib::Error const& err);
 
@@ -173,6 +174,7 @@ private:
 
   connection::handle result_added_connection_;
   connection::handle result_removed_connection_;
+  connection::handle results_changed_connection_;
 
   connection::handle category_added_connection_;
   connection::handle category_changed_connection_;
@@ -0,0 +1,659 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3, as
+ * published by the  Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the applicable version of the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of both the GNU Lesser General Public
+ * License version 3 along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ *
+ */
+
+#include "TextTileRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <gdk/gdk.h>
+#include <pango/pangocairo.h>
+
+#include <NuxCore/Logger.h>
+#include <UnityCore/GLibSource.h>
+#include <UnityCore/GLibWrapper.h>
+
+namespace unity
+{
+namespace dash
+{
+DECLARE_LOGGER(logger, "unity.dash.texttilerenderer");
+namespace
+{
+const int ATLAS_SIZE = 1024;
+const int BYTES_PER_PIXEL = 4;
+const unsigned MAX_BATCH_SIZE = 64;
+const unsigned MAX_CACHED_TILES = 512;
+
+typedef std::shared_ptr<cairo_font_options_t> FontOptionsPtr;
+typedef std::shared_ptr<cairo_surface_t> SurfacePtr;
+}
+
+//
+// TextAtlasPage
+//
+
+class TextAtlasPage
+{
+public:
+  TextAtlasPage(int tile_width, int tile_height);
+
+  nux::Geometry GetSlotGeometry(unsigned slot) const;
+  bool IsEmpty() const;
+  void Blit(nux::Geometry const& geo, unsigned char const* src, int src_stride);
+  nux::ObjectPtr<nux::IOpenGLBaseTexture> GetDeviceTexture();
+
+  const int tile_width;
+  const int tile_height;
+  const int columns;
+  const int rows;
+  const int width;
+  const int height;
+
+  std::vector<unsigned char> pixels;
+  std::vector<unsigned> free_slots;
+
+private:
+  // Area updated since the last upload
+  nux::Geometry dirty_;
+  nux::ObjectPtr<nux::IOpenGLTexture2D> texture_;
+};
+
+TextAtlasPage::TextAtlasPage(int tile_width_, int tile_height_)
+  : tile_width(tile_width_)
+  , tile_height(tile_height_)
+  , columns(std::max(1, ATLAS_SIZE / tile_width))
+  , rows(std::max(1, ATLAS_SIZE / tile_height))
+  , width(columns * tile_width)
+  , height(rows * tile_height)
+  , pixels(width * height * BYTES_PER_PIXEL, 0)
+{
+  // Reversed, so that the first slots are used first
+  for (unsigned slot = columns * rows; slot > 0; --slot)
+    free_slots.push_back(slot - 1);
+}
+
+nux::Geometry TextAtlasPage::GetSlotGeometry(unsigned slot) const
+{
+  return nux::Geometry((slot % columns) * tile_width, (slot / columns) * tile_height, tile_width, tile_height);
+}
+
+bool TextAtlasPage::IsEmpty() const
+{
+  return free_slots.size() == unsigned(columns * rows);
+}
+
+void TextAtlasPage::Blit(nux::Geometry const& geo, unsigned char const* src, int src_stride)
+{
+  for (int y = 0; y < geo.height; ++y)
+  {
+    auto* dest = &pixels[((geo.y + y) * width + geo.x) * BYTES_PER_PIXEL];
+    memcpy(dest, src + y * src_stride, geo.width * BYTES_PER_PIXEL);
+  }
+
+  if (dirty_.width <= 0 || dirty_.height <= 0)
+  {
+    dirty_ = geo;
+    return;
+  }
+
+  int x1 = std::min(dirty_.x, geo.x);
+  int y1 = std::min(dirty_.y, geo.y);
+  int x2 = std::max(dirty_.x + dirty_.width, geo.x + geo.width);
+  int y2 = std::max(dirty_.y + dirty_.height, geo.y + geo.height);
+  dirty_ = nux::Geometry(x1, y1, x2 - x1, y2 - y1);
+}
+
+nux::ObjectPtr<nux::IOpenGLBaseTexture> TextAtlasPage::GetDeviceTexture()
+{
+  if (!texture_)
+  {
+    texture_ = nux::GetGraphicsDisplay()->GetGpuDevice()->CreateSystemCapableDeviceTexture(width, height, 1, nux::BITFMT_B8G8R8A8);
+    dirty_ = nux::Geometry(0, 0, width, height);
+  }
+
+  if (dirty_.width > 0 && dirty_.height > 0)
+  {
+    // All the tiles rendered since the last frame are uploaded at once
+    nux::SURFACE_LOCKED_RECT lockrect;
+    nux::SURFACE_RECT rect;
+    rect.left = dirty_.x;
+    rect.top = dirty_.y;
+    rect.right = dirty_.x + dirty_.width;
+    rect.bottom = dirty_.y + dirty_.height;
+
+    if (texture_->LockRect(0, &lockrect, &rect) == OGL_OK)
+    {
+      auto* dest = static_cast<unsigned char*>(lockrect.pBits);
+
+      for (int y = 0; dest && y < dirty_.height; ++y)
+      {
+        auto const* src = &pixels[((dirty_.y + y) * width + dirty_.x) * BYTES_PER_PIXEL];
+        memcpy(dest + y * lockrect.Pitch, src, dirty_.width * BYTES_PER_PIXEL);
+      }
+
+      texture_->UnlockRect(0);
+    }
+    else
+    {
+      LOG_WARNING(logger) << "Impossible to lock the text atlas texture";
+    }
+
+    dirty_ = nux::Geometry();
+  }
+
+  return texture_;
+}
+
+//
+// TextTile
+//
+
+TextTile::TextTile(std::shared_ptr<TextAtlasPage> const& page, unsigned slot)
+  : page_(page)
+  , slot_(slot)
+  , geo_(page->GetSlotGeometry(slot))
+  , ready_(false)
+{}
+
+TextTile::~TextTile()
+{
+  page_->free_slots.push_back(slot_);
+}
+
+bool TextTile::ready() const
+{
+  return ready_;
+}
+
+nux::Geometry const& TextTile::geometry() const
+{
+  return geo_;
+}
+
+nux::ObjectPtr<nux::IOpenGLBaseTexture> TextTile::GetDeviceTexture() const
+{
+  return page_->GetDeviceTexture();
+}
+
+unsigned TextTile::GetPixel(int x, int y) const
+{
+  unsigned pixel = 0;
+
+  if (x >= 0 && y >= 0 && x < geo_.width && y < geo_.height)
+    memcpy(&pixel, &page_->pixels[((geo_.y + y) * page_->width + geo_.x + x) * BYTES_PER_PIXEL], sizeof(pixel));
+
+  return pixel;
+}
+
+//
+// TextTileStyle
+//
+
+TextTileStyle::TextTileStyle()
+  : font_size(0)
+  , width(0)
+  , height(0)
+  , scale(1.0)
+  , dpi(96.0)
+{}
+
+//
+// TextTileRenderer::Impl
+//
+
+class TextTileRenderer::Impl
+{
+public:
+  struct Request
+  {
+    TextTile::Ptr tile;
+    std::string text;
+    TextTileStyle style;
+    std::string layout_key;
+    FontOptionsPtr font_options;
+  };
+
+  struct Batch
+  {
+    std::vector<Request> requests;
+    SurfacePtr surface;
+  };
+
+  struct CacheEntry
+  {
+    std::string key;
+    TextTile::Ptr tile;
+  };
+
+  Impl(TextTileRenderer* parent);
+  ~Impl();
+
+  TextTile::Ptr RenderText(std::string const& text, TextTileStyle const& style);
+
+  void UpdateFontOptions();
+  std::string GetLayoutKey(TextTileStyle const& style) const;
+  TextTile::Ptr AllocateTile(int width, int height);
+  bool EvictTile(int width, int height);
+  void EvictTiles();
+
+  void RunWorker();
+  void RenderBatch(Batch& batch);
+  PangoLayout* GetLayout(Request const& request);
+  bool OnBatchesFinished();
+
+  TextTileRenderer* parent_;
+  FontOptionsPtr font_options_;
+
+  // Main thread only
+  std::list<CacheEntry> lru_;
+  std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache_;
+  std::map<std::pair<int, int>, std::vector<std::shared_ptr<TextAtlasPage>>> pages_;
+
+  // Worker thread only
+  std::unordered_map<std::string, glib::Object<PangoLayout>> layouts_;
+
+  // Protected by queue_mutex_
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::list<Request> queue_;
+  std::vector<Batch> finished_;
+  glib::Source::UniquePtr finished_idle_;
+  std::thread worker_;
+  bool stopping_;
+  Stats stats_;
+};
+
+TextTileRenderer::Impl::Impl(TextTileRenderer* parent)
+  : parent_(parent)
+  , stopping_(false)
+{}
+
+TextTileRenderer::Impl::~Impl()
+{
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stopping_ = true;
+    queue_.clear();
+  }
+
+  queue_cond_.notify_all();
+
+  if (worker_.joinable())
+    worker_.join();
+}
+
+void TextTileRenderer::Impl::UpdateFontOptions()
+{
+  GdkScreen* screen = gdk_screen_get_default();
+  cairo_font_options_t const* options = screen ? gdk_screen_get_font_options(screen) : nullptr;
+
+  if (!options)
+  {
+    font_options_.reset();
+    return;
+  }
+
+  if (font_options_ && cairo_font_options_equal(font_options_.get(), options))
+    return;
+
+  font_options_.reset(cairo_font_options_copy(options), cairo_font_options_destroy);
+}
+
+std::string TextTileRenderer::Impl::GetLayoutKey(TextTileStyle const& style) const
+{
+  unsigned long options_hash = font_options_ ? cairo_font_options_hash(font_options_.get()) : 0;
+
+  return style.font + ":" + std::to_string(style.font_size) + ":" + std::to_string(style.scale) +
+         ":" + std::to_string(style.dpi) + ":" + std::to_string(options_hash);
+}
+
+TextTile::Ptr TextTileRenderer::Impl::RenderText(std::string const& text, TextTileStyle const& style)
+{
+  if (style.width <= 0 || style.height <= 0 || style.scale <= 0)
+    return TextTile::Ptr();
+
+  UpdateFontOptions();
+
+  Request request;
+  request.text = text;
+  request.style = style;
+  request.layout_key = GetLayoutKey(style);
+  request.font_options = font_options_;
+
+  auto const& key = request.layout_key + ":" + std::to_string(style.width) + "x" + std::to_string(style.height) + ":" + text;
+  auto it = cache_.find(key);
+
+  if (it != cache_.end())
+  {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->tile;
+  }
+
+  request.tile = AllocateTile(style.width, style.height);
+  lru_.push_front({key, request.tile});
+  cache_[key] = lru_.begin();
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queue_.push_back(request);
+    ++stats_.pending_tiles;
+
+    if (!worker_.joinable())
+      worker_ = std::thread(&Impl::RunWorker, this);
+  }
+
+  queue_cond_.notify_one();
+  EvictTiles();
+
+  return request.tile;
+}
+
+TextTile::Ptr TextTileRenderer::Impl::AllocateTile(int width, int height)
+{
+  auto& pages = pages_[std::make_pair(width, height)];
+
+  for (unsigned attempt = 0; attempt < 2; ++attempt)
+  {
+    for (auto const& page : pages)
+    {
+      if (!page->free_slots.empty())
+      {
+        unsigned slot = page->free_slots.back();
+        page->free_slots.pop_back();
+        return TextTile::Ptr(new TextTile(page, slot));
+      }
+    }
+
+    // When the cache is full we prefer reusing the space of an unused tile
+    if (cache_.size() < MAX_CACHED_TILES || !EvictTile(width, height))
+      break;
+  }
+
+  auto page = std::make_shared<TextAtlasPage>(width, height);
+  pages.push_back(page);
+
+  unsigned slot = page->free_slots.back();
+  page->free_slots.pop_back();
+
+  return TextTile::Ptr(new TextTile(page, slot));
+}
+
+bool TextTileRenderer::Impl::EvictTile(int width, int height)
+{
+  for (auto it = lru_.rbegin(); it != lru_.rend(); ++it)
+  {
+    auto const& tile = it->tile;
+
+    // Tiles are kept alive by the results that use them, and by the worker
+    if (tile.use_count() > 1)
+      continue;
+
+    if (tile->geo_.width != width || tile->geo_.height != height)
+      continue;
+
+    cache_.erase(it->key);
+    lru_.erase(std::next(it).base());
+    return true;
+  }
+
+  return false;
+}
+
+void TextTileRenderer::Impl::EvictTiles()
+{
+  auto entry = lru_.end();
+
+  // Going backward from the least recently used entry
+  while (cache_.size() > MAX_CACHED_TILES && entry != lru_.begin())
+  {
+    --entry;
+
+    if (entry->tile.use_count() > 1)
+      continue;
+
+    cache_.erase(entry->key);
+    entry = lru_.erase(entry);
+  }
+
+  for (auto& pages : pages_)
+  {
+    auto& list = pages.second;
+    list.erase(std::remove_if(list.begin(), list.end(), [] (std::shared_ptr<TextAtlasPage> const& page) {
+      return page->IsEmpty() && page.use_count() == 1;
+    }), list.end());
+  }
+}
+
+void TextTileRenderer::Impl::RunWorker()
+{
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+
+  while (true)
+  {
+    queue_cond_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+
+    if (stopping_)
+      return;
+
+    // Labels sharing the layout and the size are rendered together
+    Batch batch;
+    std::string layout_key = queue_.front().layout_key;
+    int width = queue_.front().style.width;
+    int height = queue_.front().style.height;
+
+    for (auto it = queue_.begin(); it != queue_.end() && batch.requests.size() < MAX_BATCH_SIZE;)
+    {
+      if (it->layout_key == layout_key && it->style.width == width && it->style.height == height)
+      {
+        batch.requests.push_back(std::move(*it));
+        it = queue_.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+
+    lock.unlock();
+    /*********************************
+     * MUTEX UNLOCKED
+     *********************************/
+
+    RenderBatch(batch);
+
+    lock.lock();
+    /*********************************
+     * MUTEX LOCKED
+     *********************************/
+
+    stats_.pending_tiles -= batch.requests.size();
+    stats_.rendered_tiles += batch.requests.size();
+    ++stats_.batches;
+    stats_.layouts = layouts_.size();
+    finished_.push_back(std::move(batch));
+
+    if (!finished_idle_)
+      finished_idle_.reset(new glib::Idle(sigc::mem_fun(this, &Impl::OnBatchesFinished), glib::Source::Priority::DEFAULT));
+  }
+}
+
+PangoLayout* TextTileRenderer::Impl::GetLayout(Request const& request)
+{
+  auto it = layouts_.find(request.layout_key);
+
+  if (it != layouts_.end())
+    return it->second;
+
+  auto const& style = request.style;
+  glib::Object<PangoContext> context(pango_font_map_create_context(pango_cairo_font_map_get_default()));
+  pango_cairo_context_set_font_options(context, request.font_options.get());
+  pango_cairo_context_set_resolution(context, style.dpi);
+
+  glib::Object<PangoLayout> layout(pango_layout_new(context));
+  PangoFontDescription* desc = pango_font_description_from_string(style.font.c_str());
+
+  if (style.font_size > 0)
+    pango_font_description_set_size(desc, style.font_size);
+
+  pango_layout_set_font_description(layout, desc);
+  pango_font_description_free(desc);
+
+  pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+  pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+  pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_START);
+  pango_layout_set_height(layout, -2);
+
+  layouts_[request.layout_key] = layout;
+
+  return layout;
+}
+
+void TextTileRenderer::Impl::RenderBatch(Batch& batch)
+{
+  auto const& style = batch.requests.front().style;
+  int n_tiles = batch.requests.size();
+
+  batch.surface.reset(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, style.width, style.height * n_tiles), cairo_surface_destroy);
+
+  if (cairo_surface_status(batch.surface.get()) != CAIRO_STATUS_SUCCESS)
+    return;
+
+  cairo_surface_set_device_scale(batch.surface.get(), style.scale, style.scale);
+  cairo_t* cr = cairo_create(batch.surface.get());
+
+  PangoLayout* layout = GetLayout(batch.requests.front());
+  pango_layout_set_width(layout, std::round(style.width / style.scale) * PANGO_SCALE);
+
+  double tile_width = style.width / style.scale;
+  double tile_height = style.height / style.scale;
+
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+  cairo_set_source_rgba(cr, 1.0f, 1.0f, 1.0f, 1.0f);
+
+  for (int i = 0; i < n_tiles; ++i)
+  {
+    cairo_save(cr);
+    cairo_rectangle(cr, 0, i * tile_height, tile_width, tile_height);
+    cairo_clip(cr);
+
+    pango_layout_set_text(layout, batch.requests[i].text.c_str(), -1);
+    cairo_move_to(cr, 0, i * tile_height);
+    pango_cairo_show_layout(cr, layout);
+    cairo_restore(cr);
+  }
+
+  cairo_destroy(cr);
+  cairo_surface_flush(batch.surface.get());
+}
+
+bool TextTileRenderer::Impl::OnBatchesFinished()
+{
+  std::vector<Batch> finished;
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    finished.swap(finished_);
+    finished_idle_.reset();
+  }
+
+  for (auto const& batch : finished)
+  {
+    cairo_surface_t* surface = batch.surface.get();
+
+    if (!surface || cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    {
+      LOG_WARNING(logger) << "Impossible to render a batch of " << batch.requests.size() << " labels";
+
+      for (auto const& request : batch.requests)
+        request.tile->ready_ = true;
+
+      continue;
+    }
+
+    unsigned char const* data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    int tile_height = batch.requests.front().style.height;
+
+    for (unsigned i = 0; i < batch.requests.size(); ++i)
+    {
+      auto const& tile = batch.requests[i].tile;
+      tile->page_->Blit(tile->geo_, data + i * tile_height * stride, stride);
+      tile->ready_ = true;
+    }
+  }
+
+  parent_->tiles_ready.emit();
+
+  return false;
+}
+
+//
+// TextTileRenderer
+//
+
+TextTileRenderer& TextTileRenderer::GetDefault()
+{
+  static TextTileRenderer default_renderer;
+  return default_renderer;
+}
+
+TextTileRenderer::TextTileRenderer()
+  : pimpl(new Impl(this))
+{}
+
+TextTileRenderer::~TextTileRenderer()
+{}
+
+TextTile::Ptr TextTileRenderer::RenderText(std::string const& text, TextTileStyle const& style)
+{
+  return pimpl->RenderText(text, style);
+}
+
+TextTileRenderer::Stats TextTileRenderer::GetStats() const
+{
+  Stats stats;
+
+  {
+    std::lock_guard<std::mutex> lock(pimpl->queue_mutex_);
+    stats = pimpl->stats_;
+  }
+
+  stats.cached_tiles = pimpl->cache_.size();
+  stats.atlas_pages = 0;
+
+  for (auto const& pages : pimpl->pages_)
+    stats.atlas_pages += pages.second.size();
+
+  return stats;
+}
+
+} // namespace dash
+} // namespace unity
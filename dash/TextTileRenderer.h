@@ -0,0 +1,127 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3, as
+ * published by the  Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the applicable version of the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of both the GNU Lesser General Public
+ * License version 3 along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ *
+ */
+
+#ifndef UNITY_DASH_TEXT_TILE_RENDERER_H
+#define UNITY_DASH_TEXT_TILE_RENDERER_H
+
+#include <memory>
+#include <string>
+#include <sigc++/signal.h>
+#include <Nux/Nux.h>
+
+namespace unity
+{
+namespace dash
+{
+
+class TextAtlasPage;
+
+// Style of the labels of a result tile: centered, wrapped in at most two
+// lines and ellipsized at the start.
+struct TextTileStyle
+{
+  TextTileStyle();
+
+  std::string font;   // Pango font description string
+  int font_size;      // In pango units, 0 to use the one in font
+  int width;          // Tile size in device pixels
+  int height;
+  double scale;
+  double dpi;
+};
+
+class TextTile
+{
+public:
+  typedef std::shared_ptr<TextTile> Ptr;
+
+  ~TextTile();
+
+  // False until the text has been rasterized in the atlas
+  bool ready() const;
+
+  // Area of the tile inside the atlas texture
+  nux::Geometry const& geometry() const;
+
+  // Uploads the pending tiles of the atlas page, so it must be called with
+  // the GL context current, typically while drawing.
+  nux::ObjectPtr<nux::IOpenGLBaseTexture> GetDeviceTexture() const;
+
+  // Raw BGRA premultiplied pixel of the tile, mostly useful for testing
+  unsigned GetPixel(int x, int y) const;
+
+private:
+  friend class TextTileRenderer;
+  TextTile(std::shared_ptr<TextAtlasPage> const&, unsigned slot);
+
+  std::shared_ptr<TextAtlasPage> page_;
+  unsigned slot_;
+  nux::Geometry geo_;
+  bool ready_;
+};
+
+//
+// Renders the text of the result tiles in a worker thread, reusing the same
+// pango layout for all the labels sharing a font, scale and DPI.
+//
+// Labels are rasterized in batches and packed in atlas textures, each one
+// using a sub-rect of it, and kept in a cache so that the same text at the
+// same size is only rendered once.
+//
+class TextTileRenderer
+{
+public:
+  struct Stats
+  {
+    unsigned cached_tiles = 0;
+    unsigned pending_tiles = 0;
+    unsigned rendered_tiles = 0;
+    unsigned batches = 0;
+    unsigned layouts = 0;
+    unsigned atlas_pages = 0;
+  };
+
+  static TextTileRenderer& GetDefault();
+
+  TextTileRenderer();
+  ~TextTileRenderer();
+
+  // Returns a tile that will be ready once tiles_ready is emitted, or right
+  // away if the same text was already rendered with this style.
+  TextTile::Ptr RenderText(std::string const& text, TextTileStyle const&);
+
+  Stats GetStats() const;
+
+  sigc::signal<void> tiles_ready;
+
+private:
+  TextTileRenderer(TextTileRenderer const&) = delete;
+  TextTileRenderer& operator=(TextTileRenderer const&) = delete;
+
+  class Impl;
+  std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace dash
+} // namespace unity
+
+#endif // UNITY_DASH_TEXT_TILE_RENDERER_H
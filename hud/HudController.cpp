@@ -220,7 +220,7 @@ void Controller::SetIcon(std::string const& icon_name)
     view_->SetIcon(icon_name, tsize, icon_size().CP(scale), launcher_size - tsize);
   }
 
-  ubus.SendMessage(UBUS_HUD_ICON_CHANGED, g_variant_new_string(icon_name.c_str()));
+  ubus.SendCoalescedMessage(UBUS_HUD_ICON_CHANGED, g_variant_new_string(icon_name.c_str()));
 }
 
 nux::BaseWindow* Controller::window() const
@@ -19,6 +19,7 @@
 
 
 #include "HudIconTextureSource.h"
+#include "unity-shared/IconColor.h"
 #include "config.h"
 
 #include <glib.h>
@@ -46,46 +47,7 @@ void HudIconTextureSource::ColorForIcon(GdkPixbuf* pixbuf)
 {
   if (GDK_IS_PIXBUF(pixbuf))
   {
-    unsigned int width = gdk_pixbuf_get_width(pixbuf);
-    unsigned int height = gdk_pixbuf_get_height(pixbuf);
-    unsigned int row_bytes = gdk_pixbuf_get_rowstride(pixbuf);
-    
-    long int rtotal = 0, gtotal = 0, btotal = 0;
-    float total = 0.0f;
-    
-    guchar* img = gdk_pixbuf_get_pixels(pixbuf);
-    
-    for (unsigned int i = 0; i < width; i++)
-    {
-      for (unsigned int j = 0; j < height; j++)
-      {
-        guchar* pixels = img + (j * row_bytes + i * 4);
-        guchar r = *(pixels + 0);
-        guchar g = *(pixels + 1);
-        guchar b = *(pixels + 2);
-        guchar a = *(pixels + 3);
-        
-        float saturation = (MAX(r, MAX(g, b)) - MIN(r, MIN(g, b))) / 255.0f;
-        float relevance = .1 + .9 * (a / 255.0f) * saturation;
-        
-        rtotal += (guchar)(r * relevance);
-        gtotal += (guchar)(g * relevance);
-        btotal += (guchar)(b * relevance);
-        
-        total += relevance * 255;
-      }
-    }
-    
-    nux::color::RedGreenBlue rgb(rtotal / total,
-                                 gtotal / total,
-                                 btotal / total);
-    nux::color::HueSaturationValue hsv(rgb);
-    
-    if (hsv.saturation > 0.15f)
-      hsv.saturation = 0.65f;
-    
-    hsv.value = 0.90f;
-    bg_color = nux::Color(nux::color::RedGreenBlue(hsv));
+    bg_color = icon_color::ForPixbuf(pixbuf).background;
   }
   else
   {
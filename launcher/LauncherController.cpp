@@ -946,7 +946,9 @@ SoftwareCenterLauncherIcon::Ptr Controller::Impl::CreateSCLauncherIcon(std::stri
 
 void Controller::Impl::AddRunningApps()
 {
-  for (auto& app : ApplicationManager::Default().GetRunningApplications())
+  auto const& apps = ApplicationManager::Default().GetRunningApplications();
+
+  for (auto& app : *apps)
   {
     LOG_INFO(logger) << "Adding running app: " << app->title()
                      << ", seen already: "
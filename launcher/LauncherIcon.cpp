@@ -26,6 +26,7 @@
 #include "LauncherIcon.h"
 #include "unity-shared/AnimationUtils.h"
 #include "unity-shared/CairoTexture.h"
+#include "unity-shared/IconColor.h"
 #include "unity-shared/ThemeSettings.h"
 #include "unity-shared/UnitySettings.h"
 #include "unity-shared/UScreen.h"
@@ -278,49 +279,17 @@ nux::BaseTexture* LauncherIcon::TextureForSize(int size)
 
 void LauncherIcon::ColorForIcon(GdkPixbuf* pixbuf, nux::Color& background, nux::Color& glow)
 {
-  unsigned int width = gdk_pixbuf_get_width(pixbuf);
-  unsigned int height = gdk_pixbuf_get_height(pixbuf);
-  unsigned int row_bytes = gdk_pixbuf_get_rowstride(pixbuf);
-
-  long int rtotal = 0, gtotal = 0, btotal = 0;
-  float total = 0.0f;
-
-  guchar* img = gdk_pixbuf_get_pixels(pixbuf);
-
-  for (unsigned int i = 0; i < width; i++)
-  {
-    for (unsigned int j = 0; j < height; j++)
-    {
-      guchar* pixels = img + (j * row_bytes + i * 4);
-      guchar r = *(pixels + 0);
-      guchar g = *(pixels + 1);
-      guchar b = *(pixels + 2);
-      guchar a = *(pixels + 3);
-
-      float saturation = (MAX(r, MAX(g, b)) - MIN(r, MIN(g, b))) / 255.0f;
-      float relevance = .1 + .9 * (a / 255.0f) * saturation;
-
-      rtotal += (guchar)(r * relevance);
-      gtotal += (guchar)(g * relevance);
-      btotal += (guchar)(b * relevance);
-
-      total += relevance * 255;
-    }
-  }
-
-  nux::color::RedGreenBlue rgb(rtotal / total,
-                               gtotal / total,
-                               btotal / total);
-  nux::color::HueSaturationValue hsv(rgb);
-
-  if (hsv.saturation > 0.15f)
-    hsv.saturation = 0.65f;
-
-  hsv.value = 0.90f;
-  background = nux::Color(nux::color::RedGreenBlue(hsv));
+  auto const& colors = icon_color::ForPixbuf(pixbuf);
+  background = colors.background;
+  glow = colors.glow;
+}
 
-  hsv.value = 1.0f;
-  glow = nux::Color(nux::color::RedGreenBlue(hsv));
+void LauncherIcon::ColorForIcon(std::string const& icon, GtkIconTheme* theme, GdkPixbuf* pixbuf)
+{
+  auto const& theme_name = theme::Settings::Get()->IconThemeName(theme);
+  auto const& colors = icon_color::Cache::Get().ForPixbuf(icon, theme_name, pixbuf);
+  _background_color = colors.background;
+  _glow_color = colors.glow;
 }
 
 BaseTexturePtr LauncherIcon::TextureFromPixbuf(GdkPixbuf* pixbuf, int size, bool update_glow_colors)
@@ -401,7 +370,7 @@ BaseTexturePtr LauncherIcon::TextureFromSpecificGtkTheme(GtkIconTheme* theme,
   if (pbuf.IsType(GDK_TYPE_PIXBUF))
   {
     if (update_glow_colors)
-      ColorForIcon(pbuf, _background_color, _glow_color);
+      ColorForIcon(icon_name, theme, pbuf);
 
     BaseTexturePtr result;
     result.Adopt(nux::CreateTexture2DFromPixbuf(pbuf, true));
@@ -315,6 +315,7 @@ private:
   static void ChildRealized(DbusmenuMenuitem* newitem, QuicklistView* quicklist);
   static void RootChanged(DbusmenuClient* client, DbusmenuMenuitem* newroot, QuicklistView* quicklist);
   void ColorForIcon(GdkPixbuf* pixbuf, nux::Color& background, nux::Color& glow);
+  void ColorForIcon(std::string const& icon, GtkIconTheme* theme, GdkPixbuf* pixbuf);
   nux::Point GetTipPosition(int monitor) const;
 
   void LoadTooltip();
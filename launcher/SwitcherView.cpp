@@ -27,6 +27,7 @@
 #include "unity-shared/UScreen.h"
 #include "unity-shared/XKeyboardUtil.h"
 
+#include <unordered_map>
 #include <Nux/Nux.h>
 
 namespace unity
@@ -608,13 +609,34 @@ nux::Geometry SwitcherView::InterpolateBackground(nux::Geometry const& start, nu
 nux::Geometry SwitcherView::UpdateRenderTargets(float progress)
 {
   std::vector<Window> const& xids = model_->DetailXids();
+
+  // This is called at each animation frame, so we reuse the layout windows
+  // already in the detail view, just refreshing their geometry.
+  std::unordered_map<Window, LayoutWindow::Ptr> old_targets;
+  for (auto const& target : render_targets_)
+    old_targets[target->xid] = target;
+
   render_targets_.clear();
 
   for (Window window : xids)
   {
     bool selected = (window == model_->DetailSelectionWindow());
-    auto layout_window = std::make_shared<LayoutWindow>(window);
+    auto it = old_targets.find(window);
+    LayoutWindow::Ptr layout_window;
+
+    if (it != old_targets.end())
+    {
+      // The window might have been moved, resized or (un)maximized meanwhile
+      layout_window = it->second;
+      layout_window->RefreshGeometry();
+    }
+    else
+    {
+      layout_window = std::make_shared<LayoutWindow>(window);
+    }
+
     layout_window->ComputeDecorationHeight();
+
     layout_window->selected = selected;
     layout_window->alpha = (selected ? 1.0f : 0.9f) * progress;
 
@@ -25,6 +25,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gtk/gtk.h>
+#include <list>
 
 #include "PanelIndicatorEntryView.h"
 
@@ -36,6 +37,7 @@
 #include "unity-shared/UBusWrapper.h"
 #include "unity-shared/UBusMessages.h"
 #include "unity-shared/UnitySettings.h"
+#include "services/panel-service-private.h"
 
 namespace unity
 {
@@ -44,6 +46,53 @@ namespace
 DECLARE_LOGGER(logger, "unity.panel.indicator.entry");
 const int DEFAULT_SPACING = 3;
 const std::string IMAGE_MISSING = "image-missing";
+const unsigned PIXBUF_CACHE_SIZE = 32;
+
+glib::Object<GdkPixbuf> DecodePixbuf(std::string const& base64_data)
+{
+  gsize len = 0;
+  auto* decoded = g_base64_decode(base64_data.c_str(), &len);
+  glib::Object<GInputStream> stream(g_memory_input_stream_new_from_data(decoded, len, nullptr));
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new_from_stream(stream, nullptr, nullptr));
+  g_input_stream_close(stream, nullptr, nullptr);
+  g_free(decoded);
+
+  return pixbuf;
+}
+
+// Pixbuf images are prefixed by their content hash, so animated icons cycling
+// between few frames only need to be decoded once, and can be shared between views.
+glib::Object<GdkPixbuf> PixbufFromImageData(std::string const& data)
+{
+  static std::list<std::pair<std::string, glib::Object<GdkPixbuf>>> cache;
+  auto separator = data.find(IMAGE_HASH_SEPARATOR);
+
+  if (separator == std::string::npos)
+    return DecodePixbuf(data);
+
+  auto const& hash = data.substr(0, separator);
+
+  for (auto it = cache.begin(); it != cache.end(); ++it)
+  {
+    if (it->first == hash)
+    {
+      cache.splice(cache.begin(), cache, it);
+      return it->second;
+    }
+  }
+
+  auto const& pixbuf = DecodePixbuf(data.substr(separator + 1));
+
+  if (pixbuf)
+  {
+    cache.emplace_front(hash, pixbuf);
+
+    if (cache.size() > PIXBUF_CACHE_SIZE)
+      cache.pop_back();
+  }
+
+  return pixbuf;
+}
 }
 
 using namespace indicator;
@@ -221,12 +270,7 @@ glib::Object<GdkPixbuf> PanelIndicatorEntryView::MakePixbuf(int size)
   {
     case GTK_IMAGE_PIXBUF:
     {
-      gsize len = 0;
-      auto* decoded = g_base64_decode(proxy_->image_data().c_str(), &len);
-      glib::Object<GInputStream> stream(g_memory_input_stream_new_from_data(decoded, len, nullptr));
-      pixbuf = gdk_pixbuf_new_from_stream(stream, nullptr, nullptr);
-      g_input_stream_close(stream, nullptr, nullptr);
-      g_free(decoded);
+      pixbuf = PixbufFromImageData(proxy_->image_data());
       break;
     }
 
@@ -52,7 +52,6 @@ namespace
 
   const std::string NEW_APP_HIDE_TIMEOUT = "new-app-hide-timeout";
   const std::string NEW_APP_SHOW_TIMEOUT = "new-app-show-timeout";
-  const std::string WINDOW_MOVED_TIMEOUT = "window-moved-timeout";
   const std::string UPDATE_SHOW_NOW_TIMEOUT = "update-show-now-timeout";
   const std::string INTEGRATED_MENUS_DOUBLE_CLICK_TIMEOUT = "integrated-menus-double-click-timeout";
 
@@ -88,6 +87,7 @@ PanelMenuView::PanelMenuView(menu::Manager::Ptr const& menus)
   , maximized_window(0)
   , focused(true)
   , menu_manager_(menus)
+  , top_window_tracker_(TopWindowTracker::Get())
   , is_inside_(false)
   , is_grabbed_(false)
   , is_maximized_(false)
@@ -225,14 +225,15 @@ void PanelMenuView::SetupWindowManagerSignals()
   wm.window_unfullscreen.connect(sigc::mem_fun(this, &PanelMenuView::OnWindowUnFullscreen));
   wm.window_unmapped.connect(sigc::mem_fun(this, &PanelMenuView::OnWindowUnmapped));
   wm.window_mapped.connect(sigc::mem_fun(this, &PanelMenuView::OnWindowMapped));
-  wm.window_moved.connect(sigc::mem_fun(this, &PanelMenuView::OnWindowMoved));
-  wm.window_resized.connect(sigc::mem_fun(this, &PanelMenuView::OnWindowMoved));
   wm.initiate_spread.connect(sigc::mem_fun(this, &PanelMenuView::OnSpreadInitiate));
   wm.terminate_spread.connect(sigc::mem_fun(this, &PanelMenuView::OnSpreadTerminate));
   wm.initiate_expo.connect(sigc::mem_fun(this, &PanelMenuView::RefreshAndRedraw));
   wm.terminate_expo.connect(sigc::mem_fun(this, &PanelMenuView::RefreshAndRedraw));
   wm.screen_viewport_switch_ended.connect(sigc::mem_fun(this, &PanelMenuView::RefreshAndRedraw));
-  wm.show_desktop_changed.connect(sigc::mem_fun(this, &PanelMenuView::OnShowDesktopChanged));
+
+  // The tracker is connected to the window manager before us, so it's already updated in our handlers
+  top_window_tracker_->maximized_window_changed.connect(sigc::mem_fun(this, &PanelMenuView::OnMaximizedWindowChanged));
+  top_window_tracker_->window_monitors_changed.connect(sigc::mem_fun(this, &PanelMenuView::OnWindowMonitorsChanged));
 }
 
 void PanelMenuView::SetupUBusManagerInterests()
@@ -1095,8 +1096,6 @@ void PanelMenuView::OnActiveWindowChanged(ApplicationWindowPtr const& new_win)
   is_desktop_focused_ = false;
   Window active_xid = 0;
 
-  sources_.Remove(WINDOW_MOVED_TIMEOUT);
-
   if (new_win)
   {
     active_xid = new_win->window_id();
@@ -1111,13 +1110,6 @@ void PanelMenuView::OnActiveWindowChanged(ApplicationWindowPtr const& new_win)
     {
       we_control_active_ = IsWindowUnderOurControl(active_xid);
     }
-
-    if (is_maximized_)
-    {
-      maximized_wins_.erase(std::remove(maximized_wins_.begin(), maximized_wins_.end(), active_xid), maximized_wins_.end());
-      maximized_wins_.push_front(active_xid);
-      UpdateMaximizedWindow();
-    }
   }
 
   active_window = active_xid;
@@ -1138,9 +1130,6 @@ void PanelMenuView::OnSpreadTerminate()
 
 void PanelMenuView::OnWindowMinimized(Window xid)
 {
-  maximized_wins_.erase(std::remove(maximized_wins_.begin(), maximized_wins_.end(), xid), maximized_wins_.end());
-  UpdateMaximizedWindow();
-
   if (xid == active_window())
   {
     RefreshAndRedraw();
@@ -1155,22 +1144,10 @@ void PanelMenuView::OnWindowUnminimized(Window xid)
 {
   if (xid == active_window())
   {
-    if (WindowManager::Default().IsWindowMaximized(xid))
-    {
-      maximized_wins_.push_front(xid);
-      UpdateMaximizedWindow();
-    }
-
     RefreshAndRedraw();
   }
   else
   {
-    if (WindowManager::Default().IsWindowMaximized(xid))
-    {
-      maximized_wins_.push_back(xid);
-      UpdateMaximizedWindow();
-    }
-
     if (integrated_menus_ && IsWindowUnderOurControl(xid))
     {
       RefreshAndRedraw();
@@ -1180,11 +1157,6 @@ void PanelMenuView::OnWindowUnminimized(Window xid)
 
 void PanelMenuView::OnWindowUnmapped(Window xid)
 {
-  // FIXME: compiz doesn't give us a valid xid (is always 0 on unmap)
-  // we need to do this again on BamfView closed signal.
-  maximized_wins_.erase(std::remove(maximized_wins_.begin(), maximized_wins_.end(), xid), maximized_wins_.end());
-  UpdateMaximizedWindow();
-
   if (xid == active_window())
   {
     RefreshAndRedraw();
@@ -1197,30 +1169,14 @@ void PanelMenuView::OnWindowUnmapped(Window xid)
 
 void PanelMenuView::OnWindowMapped(Window xid)
 {
-  if (WindowManager::Default().IsWindowMaximized(xid))
-  {
-    if (xid == active_window())
-    {
-      maximized_wins_.push_front(xid);
-      UpdateMaximizedWindow();
-
-      RefreshAndRedraw();
-    }
-    else
-    {
-      maximized_wins_.push_back(xid);
-      UpdateMaximizedWindow();
-    }
-  }
+  if (xid == active_window() && WindowManager::Default().IsWindowMaximized(xid))
+    RefreshAndRedraw();
 }
 
 void PanelMenuView::OnWindowMaximized(Window xid)
 {
   if (xid == active_window())
   {
-    maximized_wins_.push_front(xid);
-    UpdateMaximizedWindow();
-
     // We need to update the is_inside_ state in the case of maximization by grab
     CheckMouseInside();
     is_maximized_ = true;
@@ -1229,9 +1185,6 @@ void PanelMenuView::OnWindowMaximized(Window xid)
   }
   else
   {
-    maximized_wins_.push_back(xid);
-    UpdateMaximizedWindow();
-
     if (integrated_menus_ && IsWindowUnderOurControl(xid))
     {
       RefreshAndRedraw();
@@ -1247,9 +1200,6 @@ void PanelMenuView::OnWindowUnFullscreen(Window xid)
 
 void PanelMenuView::OnWindowRestored(Window xid)
 {
-  maximized_wins_.erase(std::remove(maximized_wins_.begin(), maximized_wins_.end(), xid), maximized_wins_.end());
-  UpdateMaximizedWindow();
-
   if (active_window() == xid)
   {
     is_maximized_ = false;
@@ -1262,13 +1212,19 @@ void PanelMenuView::OnWindowRestored(Window xid)
   }
 }
 
-void PanelMenuView::OnShowDesktopChanged()
+void PanelMenuView::OnMaximizedWindowChanged(int monitor)
 {
-  UpdateMaximizedWindow();
+  if (monitor == monitor_)
+    UpdateMaximizedWindow();
 }
 
+void PanelMenuView::OnWindowMonitorsChanged(Window xid)
+{
+  if (!integrated_menus_ && xid == active_window())
+    UpdateActiveWindowPosition();
+}
 
-bool PanelMenuView::UpdateActiveWindowPosition()
+void PanelMenuView::UpdateActiveWindowPosition()
 {
   bool we_control_window = IsWindowUnderOurControl(active_window);
 
@@ -1281,101 +1237,21 @@ bool PanelMenuView::UpdateActiveWindowPosition()
 
     RefreshAndRedraw();
   }
-
-  return false;
-}
-
-void PanelMenuView::OnWindowMoved(Window xid)
-{
-  if (!integrated_menus_ && active_window() == xid && UScreen::GetDefault()->GetMonitors().size() > 1)
-  {
-    /* When moving the active window, if the current panel is controlling
-     * the active window, then we postpone the timeout function every movement
-     * that we have, setting a longer timeout.
-     * Otherwise, if the movedPanelMenuView::OnWindowMovedPanelMenuView::OnWindowMoved window is not controlled by the current panel
-     * every few millisecond we check the new window position */
-
-    unsigned int timeout_length = 250;
-
-    if (!we_control_active_)
-    {
-      if (sources_.GetSource(WINDOW_MOVED_TIMEOUT))
-        return;
-
-      timeout_length = 60;
-    }
-
-    auto cb_func = sigc::mem_fun(this, &PanelMenuView::UpdateActiveWindowPosition);
-    sources_.AddTimeout(timeout_length, cb_func, WINDOW_MOVED_TIMEOUT);
-  }
-
-  if (std::find(maximized_wins_.begin(), maximized_wins_.end(), xid) != maximized_wins_.end())
-    UpdateMaximizedWindow();
 }
 
 bool PanelMenuView::IsWindowUnderOurControl(Window xid) const
 {
-  if (UScreen::GetDefault()->GetMonitors().size() > 1)
-  {
-    WindowManager& wm = WindowManager::Default();
-    nux::Geometry const& window_geo = wm.GetWindowGeometry(xid);
-    nux::Geometry const& intersect = monitor_geo_.Intersect(window_geo);
-
-    /* We only care of the horizontal window portion */
-    return (intersect.width > window_geo.width/2 && intersect.height > 0);
-  }
-
-  return true;
+  return top_window_tracker_->IsWindowOnMonitor(xid, monitor_);
 }
 
 bool PanelMenuView::IsValidWindow(Window xid) const
 {
-  WindowManager& wm = WindowManager::Default();
-  std::vector<Window> const& our_xids = nux::XInputWindow::NativeHandleList();
-
-  if (wm.IsWindowOnCurrentDesktop(xid) && !wm.IsWindowObscured(xid) &&
-      wm.IsWindowVisible(xid) && IsWindowUnderOurControl(xid) &&
-      std::find(our_xids.begin(), our_xids.end(), xid) == our_xids.end())
-  {
-    return true;
-  }
-
-  return false;
+  return IsWindowUnderOurControl(xid) && top_window_tracker_->IsValidWindow(xid);
 }
 
 void PanelMenuView::UpdateMaximizedWindow()
 {
-  Window window_xid = 0;
-
-  // Find the front-most of the maximized windows we are controlling
-  for (auto xid : maximized_wins_)
-  {
-    // We can safely assume only the front-most is visible
-    if (IsValidWindow(xid))
-    {
-      window_xid = xid;
-      break;
-    }
-  }
-
-  maximized_window = window_xid;
-}
-
-Window PanelMenuView::GetTopWindow() const
-{
-  Window window_xid = 0;
-
-  for (auto const& win : ApplicationManager::Default().GetWindowsForMonitor(monitor_))
-  {
-    Window xid = win->window_id();
-
-    if (win->visible() && IsValidWindow(xid))
-    {
-      window_xid = xid;
-    }
-  }
-
-  return window_xid;
+  maximized_window = top_window_tracker_->GetMaximizedWindow(monitor_);
 }
 
 void PanelMenuView::ActivateIntegratedMenus(nux::Point const& click)
@@ -1740,23 +1616,14 @@ void PanelMenuView::SetMonitor(int monitor)
 {
   PanelIndicatorsView::SetMonitor(monitor);
 
-  maximized_wins_.clear();
   monitor_geo_ = UScreen::GetDefault()->GetMonitorGeometry(monitor_);
 
-  for (auto const& win : ApplicationManager::Default().GetWindowsForMonitor(monitor_))
-  {
-    auto xid = win->window_id();
+  auto const& windows = ApplicationManager::Default().GetWindowsForMonitor(monitor_);
 
+  for (auto const& win : *windows)
+  {
     if (win->active())
-      active_window = xid;
-
-    if (win->maximized() || WindowManager::Default().IsWindowFullscreen(xid))
-    {
-      if (win->active())
-        maximized_wins_.push_front(xid);
-      else
-        maximized_wins_.push_back(xid);
-    }
+      active_window = win->window_id();
   }
 
   window_buttons_->monitor = monitor_;
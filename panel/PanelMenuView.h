@@ -26,6 +26,7 @@
 
 #include "PanelIndicatorsView.h"
 #include "PanelTitlebarGrabAreaView.h"
+#include "PanelTopWindowTracker.h"
 #include "unity-shared/ApplicationManager.h"
 #include "unity-shared/MenuManager.h"
 #include "unity-shared/StaticCairoText.h"
@@ -50,7 +51,6 @@ public:
   void SetMousePosition(int x, int y);
   void SetMonitor(int monitor) override;
 
-  Window GetTopWindow() const;
   bool GetControlsActive() const;
   bool HasMenus() const;
   bool HasKeyActivableMenus() const;
@@ -106,8 +106,8 @@ private:
   void OnWindowMaximized(Window xid);
   void OnWindowRestored(Window xid);
   void OnWindowUnFullscreen(Window xid);
-  void OnWindowMoved(Window xid);
-  void OnShowDesktopChanged();
+  void OnMaximizedWindowChanged(int monitor);
+  void OnWindowMonitorsChanged(Window xid);
 
   void OnMaximizedActivate(int x, int y);
   void OnMaximizedDoubleClicked(int x, int y);
@@ -140,7 +140,7 @@ private:
   void UpdateShowNow(bool ignore);
   bool CheckMouseInside();
 
-  bool UpdateActiveWindowPosition();
+  void UpdateActiveWindowPosition();
   bool UpdateShowNowWithDelay();
   bool OnNewAppShow();
   bool OnNewAppHide();
@@ -162,6 +162,7 @@ private:
   void ActivateIntegratedMenus(nux::Point const&);
 
   menu::Manager::Ptr menu_manager_;
+  TopWindowTracker::Ptr top_window_tracker_;
 
   nux::TextureLayer* title_layer_;
   nux::ObjectPtr<WindowButtons> window_buttons_;
@@ -175,7 +176,6 @@ private:
   bool is_desktop_focused_;
 
   PanelIndicatorEntryView* last_active_view_;
-  std::deque<Window> maximized_wins_;
   ApplicationPtr new_application_;
   std::list<ApplicationPtr> new_apps_;
   std::string panel_title_;
@@ -0,0 +1,323 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <algorithm>
+
+#include "PanelTopWindowTracker.h"
+#include "unity-shared/UScreen.h"
+#include "unity-shared/WindowManager.h"
+
+namespace unity
+{
+namespace panel
+{
+
+TopWindowTracker::TopWindowTracker()
+{
+  auto& wm = WindowManager::Default();
+  wm.window_maximized.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowMaximized));
+  wm.window_fullscreen.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowMaximized));
+  wm.window_restored.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowRestored));
+  wm.window_unfullscreen.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowUnFullscreen));
+  wm.window_minimized.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowRestored));
+  wm.window_unminimized.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowMapped));
+  wm.window_mapped.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowMapped));
+  wm.window_unmapped.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowUnmapped));
+  wm.window_moved.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowMoved));
+  wm.window_resized.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowMoved));
+  wm.window_restacked.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowRestacked));
+  wm.show_desktop_changed.connect(sigc::mem_fun(this, &TopWindowTracker::UpdateMaximizedWindows));
+  wm.screen_viewport_switch_ended.connect(sigc::mem_fun(this, &TopWindowTracker::UpdateMaximizedWindows));
+
+  auto& am = ApplicationManager::Default();
+  am.active_window_changed.connect(sigc::mem_fun(this, &TopWindowTracker::OnActiveWindowChanged));
+  am.window_closed.connect(sigc::mem_fun(this, &TopWindowTracker::OnWindowClosed));
+
+  auto* uscreen = UScreen::GetDefault();
+  uscreen->changed.connect(sigc::mem_fun(this, &TopWindowTracker::OnMonitorsChanged));
+  monitors_ = uscreen->GetMonitors();
+  maximized_window_.resize(monitors_.size(), 0);
+
+  auto const& windows = am.GetWindowsForMonitor();
+
+  for (auto const& win : *windows)
+  {
+    auto xid = win->window_id();
+
+    if (win->maximized() || wm.IsWindowFullscreen(xid))
+    {
+      if (win->active())
+        maximized_wins_.push_front(xid);
+      else
+        maximized_wins_.push_back(xid);
+    }
+  }
+
+  UpdateMaximizedWindows();
+}
+
+TopWindowTracker::Ptr TopWindowTracker::Get()
+{
+  static std::weak_ptr<TopWindowTracker> instance;
+  auto tracker = instance.lock();
+
+  if (!tracker)
+  {
+    tracker = std::make_shared<TopWindowTracker>();
+    instance = tracker;
+  }
+
+  return tracker;
+}
+
+Window TopWindowTracker::GetMaximizedWindow(int monitor) const
+{
+  if (monitor < 0 || monitor >= static_cast<int>(maximized_window_.size()))
+    return 0;
+
+  return maximized_window_[monitor];
+}
+
+bool TopWindowTracker::IsWindowOnMonitor(Window xid, int monitor) const
+{
+  if (monitor < 0 || monitor >= static_cast<int>(monitors::MAX))
+    return false;
+
+  return GetWindowMonitors(xid)[monitor];
+}
+
+bool TopWindowTracker::IsValidWindow(Window xid) const
+{
+  WindowManager& wm = WindowManager::Default();
+  std::vector<Window> const& our_xids = nux::XInputWindow::NativeHandleList();
+
+  return (wm.IsWindowOnCurrentDesktop(xid) && !wm.IsWindowObscured(xid) &&
+          wm.IsWindowVisible(xid) &&
+          std::find(our_xids.begin(), our_xids.end(), xid) == our_xids.end());
+}
+
+TopWindowTracker::Monitors TopWindowTracker::GetWindowMonitors(Window xid) const
+{
+  auto it = window_monitors_.find(xid);
+
+  if (it != window_monitors_.end())
+    return it->second;
+
+  Monitors monitors = ComputeWindowMonitors(xid);
+  window_monitors_[xid] = monitors;
+  return monitors;
+}
+
+TopWindowTracker::Monitors TopWindowTracker::ComputeWindowMonitors(Window xid) const
+{
+  Monitors monitors;
+  unsigned n_monitors = std::min<unsigned>(monitors_.size(), monitors::MAX);
+
+  if (n_monitors <= 1)
+  {
+    monitors.set();
+    return monitors;
+  }
+
+  nux::Geometry const& window_geo = WindowManager::Default().GetWindowGeometry(xid);
+
+  for (unsigned i = 0; i < n_monitors; ++i)
+  {
+    nux::Geometry const& intersect = monitors_[i].Intersect(window_geo);
+
+    /* We only care of the horizontal window portion */
+    monitors[i] = (intersect.width > window_geo.width/2 && intersect.height > 0);
+  }
+
+  return monitors;
+}
+
+void TopWindowTracker::AddMaximizedWindow(Window xid)
+{
+  maximized_wins_.erase(std::remove(maximized_wins_.begin(), maximized_wins_.end(), xid), maximized_wins_.end());
+
+  if (xid == WindowManager::Default().GetActiveWindow())
+    maximized_wins_.push_front(xid);
+  else
+    maximized_wins_.push_back(xid);
+
+  UpdateMaximizedWindows();
+}
+
+bool TopWindowTracker::RemoveMaximizedWindow(Window xid)
+{
+  auto it = std::remove(maximized_wins_.begin(), maximized_wins_.end(), xid);
+
+  if (it == maximized_wins_.end())
+    return false;
+
+  maximized_wins_.erase(it, maximized_wins_.end());
+  UpdateMaximizedWindows();
+  return true;
+}
+
+void TopWindowTracker::UpdateMaximizedWindows()
+{
+  unsigned n_monitors = std::min<unsigned>(monitors_.size(), monitors::MAX);
+  std::vector<Window> maximized_window(maximized_window_.size(), 0);
+  Monitors pending;
+
+  for (unsigned i = 0; i < n_monitors; ++i)
+    pending[i] = true;
+
+  // Find the front-most of the valid maximized windows on each monitor
+  for (auto xid : maximized_wins_)
+  {
+    if (pending.none())
+      break;
+
+    Monitors const& monitors = GetWindowMonitors(xid) & pending;
+
+    if (monitors.none() || !IsValidWindow(xid))
+      continue;
+
+    for (unsigned i = 0; i < n_monitors; ++i)
+    {
+      if (monitors[i])
+        maximized_window[i] = xid;
+    }
+
+    pending &= ~monitors;
+  }
+
+  maximized_window_.swap(maximized_window);
+
+  for (unsigned i = 0; i < maximized_window_.size(); ++i)
+  {
+    if (i >= maximized_window.size() || maximized_window[i] != maximized_window_[i])
+      maximized_window_changed.emit(i);
+  }
+}
+
+void TopWindowTracker::OnMonitorsChanged(int /* primary */, std::vector<nux::Geometry> const& monitors)
+{
+  monitors_ = monitors;
+  maximized_window_.resize(monitors_.size(), 0);
+  window_monitors_.clear();
+  UpdateMaximizedWindows();
+}
+
+void TopWindowTracker::OnActiveWindowChanged(ApplicationWindowPtr const& win)
+{
+  if (!win)
+    return;
+
+  Window xid = win->window_id();
+
+  if (win->maximized() || WindowManager::Default().IsWindowFullscreen(xid))
+  {
+    maximized_wins_.erase(std::remove(maximized_wins_.begin(), maximized_wins_.end(), xid), maximized_wins_.end());
+    maximized_wins_.push_front(xid);
+    UpdateMaximizedWindows();
+  }
+}
+
+void TopWindowTracker::OnWindowClosed(ApplicationWindowPtr const& win)
+{
+  // Unmapped windows might not have a valid xid, so we check this again here
+  Window xid = win->window_id();
+  window_monitors_.erase(xid);
+  RemoveMaximizedWindow(xid);
+}
+
+void TopWindowTracker::OnWindowMaximized(Window xid)
+{
+  window_monitors_.erase(xid);
+  AddMaximizedWindow(xid);
+}
+
+void TopWindowTracker::OnWindowMapped(Window xid)
+{
+  window_monitors_.erase(xid);
+
+  if (WindowManager::Default().IsWindowMaximized(xid))
+    AddMaximizedWindow(xid);
+}
+
+void TopWindowTracker::OnWindowUnmapped(Window xid)
+{
+  window_monitors_.erase(xid);
+  RemoveMaximizedWindow(xid);
+}
+
+void TopWindowTracker::OnWindowRestored(Window xid)
+{
+  RemoveMaximizedWindow(xid);
+}
+
+void TopWindowTracker::OnWindowUnFullscreen(Window xid)
+{
+  if (!WindowManager::Default().IsWindowMaximized(xid))
+    RemoveMaximizedWindow(xid);
+}
+
+void TopWindowTracker::OnWindowMoved(Window xid)
+{
+  bool maximized = std::find(maximized_wins_.begin(), maximized_wins_.end(), xid) != maximized_wins_.end();
+  auto it = window_monitors_.find(xid);
+
+  // We don't need to track windows that nobody asked about yet
+  if (it == window_monitors_.end())
+  {
+    if (maximized)
+      UpdateMaximizedWindows();
+
+    return;
+  }
+
+  Monitors const& monitors = ComputeWindowMonitors(xid);
+
+  if (monitors == it->second)
+    return;
+
+  it->second = monitors;
+
+  if (maximized)
+    UpdateMaximizedWindows();
+
+  window_monitors_changed.emit(xid);
+}
+
+void TopWindowTracker::OnWindowRestacked(Window /* xid */)
+{
+  if (maximized_wins_.empty())
+    return;
+
+  // Keep the maximized windows sorted from the top-most, as they're stacked
+  auto const& stack = WindowManager::Default().GetWindowsInStackingOrder();
+  std::unordered_map<Window, unsigned> positions;
+
+  for (unsigned i = 0; i < stack.size(); ++i)
+    positions[stack[i]] = i;
+
+  std::stable_sort(maximized_wins_.begin(), maximized_wins_.end(), [&positions] (Window a, Window b) {
+    return positions[a] > positions[b];
+  });
+
+  // Any restack can change which windows are obscured
+  UpdateMaximizedWindows();
+}
+
+} // namespace panel
+} // namespace unity
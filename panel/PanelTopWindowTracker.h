@@ -0,0 +1,89 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef PANEL_TOP_WINDOW_TRACKER_H
+#define PANEL_TOP_WINDOW_TRACKER_H
+
+#include <bitset>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <Nux/Nux.h>
+#include <sigc++/sigc++.h>
+
+#include "MultiMonitor.h"
+#include "unity-shared/ApplicationManager.h"
+
+namespace unity
+{
+namespace panel
+{
+
+/* Keeps track of the front-most valid maximized window of each monitor and
+ * of the monitors each window is controlled by, so that all the panels can
+ * share the same state, updated only on windows changes. */
+class TopWindowTracker : public sigc::trackable
+{
+public:
+  typedef std::shared_ptr<TopWindowTracker> Ptr;
+  typedef std::bitset<monitors::MAX> Monitors;
+
+  TopWindowTracker();
+
+  // All the panels share the same tracker, as long as one is alive.
+  static Ptr Get();
+
+  Window GetMaximizedWindow(int monitor) const;
+  bool IsWindowOnMonitor(Window xid, int monitor) const;
+  bool IsValidWindow(Window xid) const;
+
+  sigc::signal<void, int> maximized_window_changed;
+  sigc::signal<void, Window> window_monitors_changed;
+
+private:
+  void OnMonitorsChanged(int primary, std::vector<nux::Geometry> const& monitors);
+  void OnActiveWindowChanged(ApplicationWindowPtr const&);
+  void OnWindowClosed(ApplicationWindowPtr const&);
+  void OnWindowMaximized(Window xid);
+  void OnWindowMapped(Window xid);
+  void OnWindowUnmapped(Window xid);
+  void OnWindowRestored(Window xid);
+  void OnWindowUnFullscreen(Window xid);
+  void OnWindowMoved(Window xid);
+  void OnWindowRestacked(Window xid);
+
+  void AddMaximizedWindow(Window xid);
+  bool RemoveMaximizedWindow(Window xid);
+  void UpdateMaximizedWindows();
+
+  Monitors GetWindowMonitors(Window xid) const;
+  Monitors ComputeWindowMonitors(Window xid) const;
+
+  std::vector<nux::Geometry> monitors_;
+  std::deque<Window> maximized_wins_;
+  std::vector<Window> maximized_window_;
+  mutable std::unordered_map<Window, Monitors> window_monitors_;
+};
+
+} // namespace panel
+} // namespace unity
+
+#endif // PANEL_TOP_WINDOW_TRACKER_H
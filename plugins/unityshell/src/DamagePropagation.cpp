@@ -0,0 +1,190 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "DamagePropagation.h"
+
+#include <algorithm>
+
+namespace unity
+{
+namespace impl
+{
+
+//
+// WindowIntervalIndex
+//
+
+WindowIntervalIndex::WindowIntervalIndex()
+  : max_width_(0)
+{}
+
+void WindowIntervalIndex::Clear()
+{
+  geometries_.clear();
+  sorted_.clear();
+  max_width_ = 0;
+}
+
+unsigned WindowIntervalIndex::Add(nux::Geometry const& geo)
+{
+  geometries_.push_back(geo);
+  return geometries_.size() - 1;
+}
+
+void WindowIntervalIndex::Build()
+{
+  sorted_.clear();
+  sorted_.reserve(geometries_.size());
+  max_width_ = 0;
+
+  for (unsigned i = 0; i < geometries_.size(); ++i)
+  {
+    auto const& geo = geometries_[i];
+
+    if (geo.width <= 0 || geo.height <= 0)
+      continue;
+
+    sorted_.push_back({geo.x, geo.x + geo.width, i});
+    max_width_ = std::max(max_width_, geo.width);
+  }
+
+  std::sort(sorted_.begin(), sorted_.end(), [] (Entry const& a, Entry const& b) {
+    return a.x1 < b.x1;
+  });
+}
+
+std::size_t WindowIntervalIndex::size() const
+{
+  return geometries_.size();
+}
+
+bool WindowIntervalIndex::empty() const
+{
+  return geometries_.empty();
+}
+
+nux::Geometry const& WindowIntervalIndex::geometry(unsigned id) const
+{
+  return geometries_[id];
+}
+
+void WindowIntervalIndex::ForEachIntersecting(nux::Geometry const& rect, std::function<void(unsigned)> const& cb) const
+{
+  if (sorted_.empty() || rect.width <= 0 || rect.height <= 0)
+    return;
+
+  int rect_x2 = rect.x + rect.width;
+  int rect_y2 = rect.y + rect.height;
+
+  // No window is wider than max_width_, so the ones starting before this can't reach the rect
+  auto begin = std::lower_bound(sorted_.begin(), sorted_.end(), rect.x - max_width_ + 1,
+                                [] (Entry const& e, int x) { return e.x1 < x; });
+
+  for (auto it = begin; it != sorted_.end() && it->x1 < rect_x2; ++it)
+  {
+    if (it->x2 <= rect.x)
+      continue;
+
+    auto const& geo = geometries_[it->id];
+
+    if (geo.y < rect_y2 && geo.y + geo.height > rect.y)
+      cb(it->id);
+  }
+}
+
+//
+// DamagePropagation
+//
+
+void DamagePropagation::AddDamage(nux::Geometry const& geo)
+{
+  if (geo.width > 0 && geo.height > 0)
+    pending_.push_back(geo);
+}
+
+unsigned DamagePropagation::Propagate()
+{
+  std::vector<bool> presented(windows.size(), false);
+  Geometries presented_geometries;
+  Geometries new_damage;
+  bool shadows_damaged = false;
+  unsigned passes = 0;
+
+  while (true)
+  {
+    ++passes;
+
+    Geometries processing;
+    processing.swap(pending_);
+
+    if (damage_processed && !processing.empty())
+      damage_processed(processing);
+
+    for (auto const& rect : processing)
+    {
+      windows.ForEachIntersecting(rect, [&] (unsigned id) {
+        if (presented[id])
+          return;
+
+        presented[id] = true;
+
+        if (present_windows)
+          present_windows(rect.Intersect(windows.geometry(id)));
+      });
+    }
+
+    new_damage.clear();
+
+    for (auto const& geo : presentation_list ? presentation_list() : Geometries())
+    {
+      if (std::find(presented_geometries.begin(), presented_geometries.end(), geo) != presented_geometries.end())
+        continue;
+
+      presented_geometries.push_back(geo);
+      new_damage.push_back(geo);
+
+      /* Special case, we need to redraw the panel shadow on panel updates */
+      if (shadows_damaged)
+        continue;
+
+      for (auto const& panel_geo : panels)
+      {
+        if (geo.IsIntersecting(panel_geo))
+        {
+          new_damage.insert(new_damage.end(), panel_shadows.begin(), panel_shadows.end());
+          shadows_damaged = true;
+          break;
+        }
+      }
+    }
+
+    if (new_damage.empty() && pending_.empty())
+      break;
+
+    if (damage && !new_damage.empty())
+      damage(new_damage);
+  }
+
+  pending_.clear();
+
+  return passes;
+}
+
+} // namespace impl
+} // namespace unity
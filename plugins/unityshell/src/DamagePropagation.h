@@ -0,0 +1,107 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITYSHELL_DAMAGE_PROPAGATION_H
+#define UNITYSHELL_DAMAGE_PROPAGATION_H
+
+#include <functional>
+#include <vector>
+#include <NuxCore/Rect.h>
+
+namespace unity
+{
+namespace impl
+{
+
+typedef std::vector<nux::Geometry> Geometries;
+
+//
+// Index of window geometries sorted by their horizontal position, so that
+// the windows intersecting a rect can be found without walking all of them.
+//
+class WindowIntervalIndex
+{
+public:
+  WindowIntervalIndex();
+
+  void Clear();
+  unsigned Add(nux::Geometry const&);
+  void Build();
+
+  std::size_t size() const;
+  bool empty() const;
+  nux::Geometry const& geometry(unsigned id) const;
+
+  void ForEachIntersecting(nux::Geometry const& rect, std::function<void(unsigned id)> const&) const;
+
+private:
+  struct Entry
+  {
+    int x1;
+    int x2;
+    unsigned id;
+  };
+
+  Geometries geometries_;
+  std::vector<Entry> sorted_;
+  int max_width_;
+};
+
+//
+// Computes the fixed point of the compiz <-> nux damage exchange:
+// nux windows intersecting the damage are presented, and the geometries of
+// the presented windows (plus the panel shadows, if a panel is involved)
+// become new compiz damage, until nothing new is presented.
+//
+// Each damage rect is only checked once against the windows index, and each
+// window is only asked to be presented once.
+//
+class DamagePropagation
+{
+public:
+  // Asks nux to present the windows intersecting the geometry
+  std::function<void(nux::Geometry const&)> present_windows;
+
+  // The geometries of the windows nux will present on this frame
+  std::function<Geometries()> presentation_list;
+
+  // Applies the new damage to compiz; anything that it causes to be damaged
+  // (including these rects) must be passed back through AddDamage.
+  std::function<void(Geometries const&)> damage;
+
+  // Called on each pass with the damage that has not been processed yet
+  std::function<void(Geometries const&)> damage_processed;
+
+  WindowIntervalIndex windows;
+  Geometries panels;
+  Geometries panel_shadows;
+
+  void AddDamage(nux::Geometry const&);
+
+  // Returns the number of passes needed to reach the fixed point
+  unsigned Propagate();
+
+private:
+  Geometries pending_;
+};
+
+} // namespace impl
+} // namespace unity
+
+#endif // UNITYSHELL_DAMAGE_PROPAGATION_H
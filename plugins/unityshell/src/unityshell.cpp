@@ -32,6 +32,7 @@
 
 #include "CompizUtils.h"
 #include "BaseWindowRaiserImp.h"
+#include "IconLoader.h"
 #include "IconRenderer.h"
 #include "Launcher.h"
 #include "LauncherIcon.h"
@@ -41,6 +42,8 @@
 #include "PanelView.h"
 #include "PluginAdapter.h"
 #include "QuicklistManager.h"
+#include "StaticCairoText.h"
+#include "TextureCache.h"
 #include "ThemeSettings.h"
 #include "Timer.h"
 #include "XKeyboardUtil.h"
@@ -176,6 +179,7 @@ const std::string RELAYOUT_TIMEOUT = "relayout-timeout";
 const std::string HUD_UNGRAB_WAIT = "hud-ungrab-wait";
 const std::string FIRST_RUN_STAMP = "first_run.stamp";
 const std::string LOCKED_STAMP = "locked.stamp";
+const std::size_t TEXTURE_CACHE_RETENTION_BYTES = 32 * 1024 * 1024;
 } // namespace local
 
 namespace atom
@@ -196,7 +200,7 @@ UnityScreen::UnityScreen(CompScreen* screen)
   , WM(PluginAdapter::Initialize(screen))
   , menus_(std::make_shared<menu::Manager>(std::make_shared<indicator::DBusIndicators>(), std::make_shared<key::GnomeGrabber>()))
   , deco_manager_(std::make_shared<decoration::Manager>(menus_))
-  , debugger_(this)
+  , debugger_(this, &frame_stats_)
   , session_(std::make_shared<session::GnomeManager>())
   , needsRelayout(false)
   , super_keypressed_(false)
@@ -216,6 +220,8 @@ UnityScreen::UnityScreen(CompScreen* screen)
   , paint_panel_under_dash_(false)
   , scale_just_activated_(false)
   , screen_introspection_(screen)
+  , propagating_damage_(false)
+  , panel_shadow_rects_valid_(false)
   , ignore_redraw_request_(false)
   , dirty_helpers_on_this_frame_(false)
   , is_desktop_active_(false)
@@ -450,6 +456,33 @@ UnityScreen::UnityScreen(CompScreen* screen)
 
      LoadPanelShadowTexture();
      theme::Settings::Get()->theme.changed.connect(sigc::hide(sigc::mem_fun(this, &UnityScreen::LoadPanelShadowTexture)));
+     panel_style_.changed.connect([this] { panel_shadow_rects_valid_ = false; });
+     unity_settings_.dpi_changed.connect([this] { panel_shadow_rects_valid_ = false; });
+
+     damage_propagation_.present_windows = [this] (nux::Geometry const& geo) {
+       wt->PresentWindowsIntersectingGeometryOnThisFrame(geo);
+     };
+
+     damage_propagation_.presentation_list = [this] {
+       auto const& geometries = wt->GetPresentationListGeometries();
+       return impl::Geometries(geometries.begin(), geometries.end());
+     };
+
+     damage_propagation_.damage = [this] (impl::Geometries const& rects) {
+       CompRegion damage;
+       for (auto const& geo : rects)
+         damage += CompRectFromNuxGeo(geo);
+
+       cScreen->damageRegion(damage);
+     };
+
+     damage_propagation_.damage_processed = [this] (impl::Geometries const& rects) {
+       CompRegion damage;
+       for (auto const& geo : rects)
+         damage += CompRectFromNuxGeo(geo);
+
+       redrawNuxViewsForDamage(damage);
+     };
 
      ubus_manager_.RegisterInterest(UBUS_OVERLAY_SHOWN, [this](GVariant * data)
      {
@@ -492,6 +525,9 @@ UnityScreen::UnityScreen(CompScreen* screen)
 
     Introspectable::AddChild(&WM);
     Introspectable::AddChild(&screen_introspection_);
+    Introspectable::AddChild(&frame_stats_);
+    Introspectable::AddChild(&input_monitor_);
+    Introspectable::AddChild(&IconLoader::GetDefault());
 
     /* Create blur backup texture */
     auto gpu_device = nux::GetGraphicsDisplay()->GetGpuDevice();
@@ -514,6 +550,8 @@ UnityScreen::~UnityScreen()
 
   unity_a11y_finalize();
   QuicklistManager::Destroy();
+  TextureCache::GetDefault().SetRetentionBudget(0);
+  StaticCairoText::ClearLayoutCache();
   decoration::DataPool::Reset();
 
   if (!session_->AutomaticLogin())
@@ -728,6 +766,7 @@ void UnityScreen::LoadPanelShadowTexture()
   CompString pname;
   CompSize size;
   _shadow_texture = GLTexture::readImageToTexture(name, pname, size);
+  panel_shadow_rects_valid_ = false;
 }
 
 void UnityScreen::setPanelShadowMatrix(GLMatrix const& matrix)
@@ -749,6 +788,27 @@ void UnityScreen::FillShadowRectForOutput(CompRect& shadowRect, CompOutput const
   shadowRect.setGeometry(shadowX, shadowY, shadowWidth, shadowHeight);
 }
 
+impl::Geometries const& UnityScreen::GetPanelShadowRects()
+{
+  if (!panel_shadow_rects_valid_)
+  {
+    panel_shadow_rects_.clear();
+
+    for (CompOutput const& output : screen->outputDevs())
+    {
+      CompRect shadow_rect;
+      FillShadowRectForOutput(shadow_rect, output);
+
+      if (!shadow_rect.isEmpty())
+        panel_shadow_rects_.push_back(NuxGeometryFromCompRect(shadow_rect));
+    }
+
+    panel_shadow_rects_valid_ = true;
+  }
+
+  return panel_shadow_rects_;
+}
+
 void UnityScreen::paintPanelShadow(CompRegion const& clip)
 {
   // You have no shadow texture. But how?
@@ -890,6 +950,8 @@ void UnityScreen::DamageBlurUpdateRegion(nux::Geometry const& blur_update)
 
 void UnityScreen::paintOutput()
 {
+  debug::FrameStats::ScopedPhase phase(frame_stats_, debug::FrameStats::Phase::PAINT_OUTPUT);
+
   CompOutput *output = last_output_;
 
   DrawPanelUnderDash();
@@ -918,7 +980,9 @@ void UnityScreen::paintOutput()
      * where it might make sense to. Saves calls into OpenGL */
     CompRegion blur_region;
 
-    for (auto const& blur_geometry : BackgroundEffectHelper::GetBlurGeometries())
+    /* Only the parts of the blur regions that are going to be re-blurred
+     * need to be copied, the cached blur textures are valid elsewhere */
+    for (auto const& blur_geometry : BackgroundEffectHelper::GetDirtyBlurGeometries())
     {
       auto blur_rect = CompRectFromNuxGeo(blur_geometry);
       blur_region += (blur_rect & *output);
@@ -1496,6 +1560,8 @@ bool UnityScreen::glPaintOutput(const GLScreenPaintAttrib& attrib,
                                 CompOutput* output,
                                 unsigned int mask)
 {
+  debug::FrameStats::ScopedPhase phase(frame_stats_, debug::FrameStats::Phase::GL_PAINT_OUTPUT);
+
   if (G_UNLIKELY(lockscreen_controller_->IsPaintInhibited()))
   {
     CHECKGL(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
@@ -1524,6 +1590,12 @@ bool UnityScreen::glPaintOutput(const GLScreenPaintAttrib& attrib,
   last_output_ = output;
   paint_panel_under_dash_ = false;
 
+  if (auto* frame = frame_stats_.current())
+  {
+    unsigned presentation_list_size = wt->GetPresentationListGeometries().size();
+    frame->presentation_list_size = std::max(frame->presentation_list_size, presentation_list_size);
+  }
+
   // CompRegion has no clear() method. So this is the fastest alternative.
   fullscreenRegion = CompRegion();
   nuxRegion = CompRegion();
@@ -1623,6 +1695,12 @@ void UnityScreen::updateBlurDamage()
 
 void UnityScreen::damageCutoff()
 {
+  debug::FrameStats::ScopedPhase phase(frame_stats_, debug::FrameStats::Phase::DAMAGE_CUTOFF);
+  auto* frame = frame_stats_.current();
+
+  if (frame)
+    frame->force_draw_countdown = force_draw_countdown_;
+
   if (force_draw_countdown_ > 0)
   {
     typedef nux::WindowCompositor::WeakBaseWindowPtr WeakBaseWindowPtr;
@@ -1647,27 +1725,20 @@ void UnityScreen::damageCutoff()
   /* Determine nux region damage last */
   cScreen->damageCutoff();
 
-  CompRegion damage_buffer, last_damage_buffer;
+  /* Present the nux windows intersecting the compiz damage, and damage
+   * compiz with what nux is going to draw, until nothing else changes */
+  unsigned passes = propagateNuxDamage();
 
-  do
+  if (frame)
   {
-    last_damage_buffer = damage_buffer;
+    frame->damage_cutoff_iterations = passes;
 
-    /* First apply any damage accumulated to nux to see
-     * what windows need to be redrawn there */
-    compizDamageNux(buffered_compiz_damage_this_frame_);
-
-    /* Apply the redraw regions to compiz so that we can
-     * draw this frame with that region included */
-    determineNuxDamage(damage_buffer);
-
-    /* We want to track the nux damage here as we will use it to
-     * determine if we need to present other nux windows too */
-    cScreen->damageRegion(damage_buffer);
-
-    /* If we had to put more damage into the damage buffer then
-     * damage compiz with it and keep going */
-  } while (last_damage_buffer != damage_buffer);
+    for (CompRect const& r : buffered_compiz_damage_this_frame_.rects())
+    {
+      ++frame->damage_rects;
+      frame->damage_area += r.width() * r.height();
+    }
+  }
 
   /* Clear damage buffer */
   buffered_compiz_damage_last_frame_ = buffered_compiz_damage_this_frame_;
@@ -1680,10 +1751,16 @@ void UnityScreen::damageCutoff()
   /* We need to track this per-frame to figure out whether or not
    * to bind the contents fbo on each monitor pass */
   dirty_helpers_on_this_frame_ = BackgroundEffectHelper::HasDirtyHelpers();
+
+  if (frame)
+    frame->blur_dirty = dirty_helpers_on_this_frame_;
 }
 
 void UnityScreen::preparePaint(int ms)
 {
+  frame_stats_.BeginFrame();
+  debug::FrameStats::ScopedPhase phase(frame_stats_, debug::FrameStats::Phase::PREPARE_PAINT);
+
   cScreen->preparePaint(ms);
 
   big_tick_ += ms*1000;
@@ -1699,6 +1776,8 @@ void UnityScreen::preparePaint(int ms)
 
 void UnityScreen::donePaint()
 {
+  gint64 start_time = frame_stats_.current() ? g_get_monotonic_time() : 0;
+
   if (G_UNLIKELY(lockscreen_controller_->IsPaintInhibited()))
   {
     lockscreen_controller_->MarkBufferHasCleared();
@@ -1750,6 +1829,22 @@ void UnityScreen::donePaint()
   }
 
   cScreen->donePaint();
+
+  if (auto* frame = frame_stats_.current())
+  {
+    auto const& blur_stats = BackgroundEffectHelper::GetBlurStats();
+    frame->blurred_pixels = blur_stats.blurred_pixels;
+    frame->blur_full_updates = blur_stats.full_updates;
+    frame->blur_partial_updates = blur_stats.partial_updates;
+  }
+
+  BackgroundEffectHelper::ResetBlurStats();
+
+  if (start_time)
+  {
+    frame_stats_.AddPhaseTime(debug::FrameStats::Phase::DONE_PAINT, start_time, g_get_monotonic_time() - start_time);
+    frame_stats_.EndFrame();
+  }
 }
 
 void redraw_view_if_damaged(nux::ObjectPtr<CairoBaseWindow> const& view, CompRegion const& damage)
@@ -1783,6 +1878,11 @@ void UnityScreen::compizDamageNux(CompRegion const& damage)
     wt->PresentWindowsIntersectingGeometryOnThisFrame(geo);
   }
 
+  redrawNuxViewsForDamage(damage);
+}
+
+void UnityScreen::redrawNuxViewsForDamage(CompRegion const& damage)
+{
   auto const& launchers = launcher_controller_->launchers();
 
   for (auto const& launcher : launchers)
@@ -1799,31 +1899,35 @@ void UnityScreen::compizDamageNux(CompRegion const& damage)
   }
 }
 
-/* Grab changed nux regions and add damage rects for them */
-void UnityScreen::determineNuxDamage(CompRegion& nux_damage)
+unsigned UnityScreen::propagateNuxDamage()
 {
-  /* Fetch all the dirty geometry from nux and aggregate it */
-  auto const& dirty = wt->GetPresentationListGeometries();
-  auto const& panels_geometries = panel_controller_->GetGeometries();
+  typedef nux::WindowCompositor::WeakBaseWindowPtr WeakBaseWindowPtr;
 
-  for (auto const& dirty_geo : dirty)
-  {
-    nux_damage += CompRegionFromNuxGeo(dirty_geo);
+  /* The nux windows don't change during the propagation, so we index
+   * them once and only present the ones that some damage rect hits */
+  auto& windows = damage_propagation_.windows;
+  windows.Clear();
 
-    /* Special case, we need to redraw the panel shadow on panel updates */
-    for (auto const& panel_geo : panels_geometries)
-    {
-      if (!dirty_geo.IsIntersecting(panel_geo))
-        continue;
+  wt->GetWindowCompositor().ForEachBaseWindow([&windows] (WeakBaseWindowPtr const& w) {
+    if (w)
+      windows.Add(w->GetAbsoluteGeometry());
+  });
 
-      for (CompOutput const& o : screen->outputDevs())
-      {
-        CompRect shadowRect;
-        FillShadowRectForOutput(shadowRect, o);
-        nux_damage += shadowRect;
-      }
-    }
-  }
+  windows.Build();
+
+  damage_propagation_.panels = panel_controller_->GetGeometries();
+  damage_propagation_.panel_shadows = GetPanelShadowRects();
+
+  for (CompRect const& r : buffered_compiz_damage_this_frame_.rects())
+    damage_propagation_.AddDamage(NuxGeometryFromCompRect(r));
+
+  /* Any damage applied during the propagation gets back to us via
+   * damageRegion, so that the windows it intersects are presented too */
+  propagating_damage_ = true;
+  unsigned passes = damage_propagation_.Propagate();
+  propagating_damage_ = false;
+
+  return passes;
 }
 
 void UnityScreen::addSupportedAtoms(std::vector<Atom>& atoms)
@@ -2125,6 +2229,13 @@ void UnityScreen::handleEvent(XEvent* event)
 void UnityScreen::damageRegion(const CompRegion &region)
 {
   buffered_compiz_damage_this_frame_ += region;
+
+  if (propagating_damage_)
+  {
+    for (CompRect const& r : region.rects())
+      damage_propagation_.AddDamage(NuxGeometryFromCompRect(r));
+  }
+
   cScreen->damageRegion(region);
 }
 
@@ -3828,6 +3939,7 @@ bool UnityScreen::setOptionForPlugin(const char* plugin, const char* name,
 void UnityScreen::outputChangeNotify()
 {
   screen->outputChangeNotify ();
+  panel_shadow_rects_valid_ = false;
 
   auto gpu_device = nux::GetGraphicsDisplay()->GetGpuDevice();
   gpu_device->backup_texture0_ =
@@ -3880,12 +3992,11 @@ bool UnityScreen::layoutSlotsAndAssignWindows()
     }
 
     nux::Geometry final_bounds;
-    ui::LayoutSystem layout;
-    layout.max_row_height = max_bounds.height;
-    layout.spacing = local::SCALE_SPACING.CP(monitor_scale);
+    spread_layout_.max_row_height = max_bounds.height;
+    spread_layout_.spacing = local::SCALE_SPACING.CP(monitor_scale);
     int padding = local::SCALE_PADDING.CP(monitor_scale);
     max_bounds.Expand(-padding, -padding);
-    layout.LayoutWindowsNearest(layout_windows, max_bounds, final_bounds);
+    spread_layout_.LayoutWindowsNearest(layout_windows, max_bounds, final_bounds);
 
     for (auto const& lw : layout_windows)
     {
@@ -4067,6 +4178,9 @@ void UnityScreen::InitUnityComponents()
   Timer timer;
   nux::GetWindowCompositor().sigHiddenViewWindow.connect(sigc::mem_fun(this, &UnityScreen::OnViewHidden));
 
+  // Keep the recently used textures around, so that re-opening the dash doesn't re-rasterize them
+  TextureCache::GetDefault().SetRetentionBudget(local::TEXTURE_CACHE_RETENTION_BYTES);
+
   bghash_.reset(new BGHash());
   bghash_->UpdateColor(screen->averageColor(), nux::animation::Animation::State::Stopped);
   LOG_INFO(logger) << "InitUnityComponents-BGHash " << timer.ElapsedSeconds() << "s";
@@ -64,7 +64,9 @@
 #include "PanelController.h"
 #include "PanelStyle.h"
 #include "UScreen.h"
+#include "DamagePropagation.h"
 #include "DebugDBusInterface.h"
+#include "FrameStats.h"
 #include "ScreenIntrospection.h"
 #include "ScreenSaverDBusManager.h"
 #include "SwitcherController.h"
@@ -252,7 +254,8 @@ private:
   void EnableCancelAction(CancelActionTarget target, bool enabled, int modifiers = 0);
 
   void compizDamageNux(CompRegion const& region);
-  void determineNuxDamage(CompRegion &nux_damage);
+  void redrawNuxViewsForDamage(CompRegion const& damage);
+  unsigned propagateNuxDamage();
 
   void Relayout();
   void RaiseInputWindows();
@@ -291,6 +294,7 @@ private:
   void DrawPanelUnderDash();
 
   void FillShadowRectForOutput(CompRect &shadowRect, CompOutput const &output);
+  impl::Geometries const& GetPanelShadowRects();
   unsigned CompizModifiersToNux(unsigned input) const;
   unsigned XModifiersToNux(unsigned input) const;
 
@@ -343,9 +347,11 @@ private:
   lockscreen::DBusManager::Ptr screensaver_dbus_manager_;
   lockscreen::Controller::Ptr lockscreen_controller_;
   ui::EdgeBarrierController::Ptr edge_barriers_;
+  debug::FrameStats         frame_stats_;
   debug::DebugDBusInterface debugger_;
   std::unique_ptr<BGHash>   bghash_;
   spread::Widgets::Ptr      spread_widgets_;
+  ui::LayoutSystem          spread_layout_;
 
   session::Manager::Ptr session_;
 
@@ -417,6 +423,10 @@ private:
 
   CompRegion buffered_compiz_damage_this_frame_;
   CompRegion buffered_compiz_damage_last_frame_;
+  impl::DamagePropagation damage_propagation_;
+  bool propagating_damage_;
+  impl::Geometries panel_shadow_rects_;
+  bool panel_shadow_rects_valid_;
   bool ignore_redraw_request_;
   bool dirty_helpers_on_this_frame_;
   bool is_desktop_active_;
@@ -101,6 +101,13 @@ static const gchar introspection_xml[] =
   "     <arg type='s' name='entry_id' />"
   "    </signal>"
   ""
+  "    <signal name='EntryChanged'>"
+  "     <arg type='u' name='sequence' />"
+  "     <arg type='s' name='indicator_id' />"
+  "     <arg type='s' name='entry_id' />"
+  "     <arg type='a{sv}' name='changes' />"
+  "    </signal>"
+  ""
   "    <signal name='IconPathsChanged' />"
   ""
   "  </interface>"
@@ -324,6 +331,27 @@ on_service_entry_activate_request (PanelService    *service,
     }
 }
 
+static void
+on_service_entry_changed (PanelService    *service,
+                          GVariant        *delta,
+                          GDBusConnection *connection)
+{
+  GError *error = NULL;
+  g_dbus_connection_emit_signal (connection,
+                                 NULL,
+                                 UPS_PATH,
+                                 UPS_IFACE,
+                                 "EntryChanged",
+                                 delta,
+                                 &error);
+
+  if (error)
+    {
+      g_warning ("Unable to emit EntryChanged signal: %s", error->message);
+      g_error_free (error);
+    }
+}
+
 static void
 on_icon_theme_changed (GtkIconTheme* theme, GDBusConnection *connection)
 {
@@ -389,6 +417,8 @@ on_bus_acquired (GDBusConnection *connection,
                     G_CALLBACK (on_service_entry_activated), connection);
   g_signal_connect (service, "entry-activate-request",
                     G_CALLBACK (on_service_entry_activate_request), connection);
+  g_signal_connect (service, "entry-changed",
+                    G_CALLBACK (on_service_entry_changed), connection);
 
   g_signal_connect (gtk_icon_theme_get_default(), "changed",
                     G_CALLBACK (on_icon_theme_changed), connection);
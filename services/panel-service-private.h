@@ -38,6 +38,12 @@ extern "C" {
 
 #define ENTRY_SIGNATURE "(sssusbbusbbi)"
 #define ENTRY_ARRAY_SIGNATURE "a" ENTRY_SIGNATURE ""
+#define ENTRY_DELTA_SIGNATURE "(ussa{sv})"
+
+/* Pixbuf images are sent as "<hash>:<base64 png>" the first time, and then
+ * only as "<hash>", until they're not in the last IMAGE_CACHE_SIZE sent ones */
+#define IMAGE_HASH_SEPARATOR ':'
+#define IMAGE_CACHE_SIZE 64
 
 #define AltMask Mod1Mask
 #define SuperMask Mod4Mask
@@ -67,6 +67,13 @@ struct _PanelServicePrivate
   guint timeouts[N_TIMEOUT_SLOTS];
   guint remove_idle;
 
+  GHashTable *entry2delta_hash;
+  guint delta_timeout;
+  guint32 delta_sequence;
+
+  GHashTable *sent_images;
+  GQueue     *sent_images_queue;
+
   IndicatorObjectEntry *last_entry;
   IndicatorObjectEntry *last_dropdown_entry;
   const gchar *last_panel;
@@ -98,6 +105,7 @@ enum
   ENTRY_ACTIVATED = 0,
   RE_SYNC,
   ENTRY_ACTIVATE_REQUEST,
+  ENTRY_CHANGED,
   GEOMETRIES_CHANGED,
   INDICATORS_CLEARED,
 
@@ -110,6 +118,22 @@ enum
   SYNC_NEUTRAL = 0,
 };
 
+typedef enum
+{
+  ENTRY_DELTA_LABEL           = 1 << 0,
+  ENTRY_DELTA_LABEL_SENSITIVE = 1 << 1,
+  ENTRY_DELTA_LABEL_VISIBLE   = 1 << 2,
+  ENTRY_DELTA_IMAGE           = 1 << 3,
+  ENTRY_DELTA_IMAGE_SENSITIVE = 1 << 4,
+  ENTRY_DELTA_IMAGE_VISIBLE   = 1 << 5,
+} EntryDeltaFields;
+
+typedef struct
+{
+  IndicatorObject *object;
+  guint fields;
+} EntryDelta;
+
 static guint32 _service_signals[LAST_SIGNAL] = { 0 };
 
 static const gchar * indicator_order[][2] = {
@@ -140,6 +164,8 @@ static void update_keybinding (GSettings *, const gchar *, gpointer);
 static void emit_upstart_event (const gchar *);
 static void menu_shell_deactivate_override (GtkMenuShell *menu_shell);
 static gchar * get_indicator_entry_id_by_entry (IndicatorObjectEntry *entry);
+static gchar * gtk_image_to_data (GtkImage *image, guint32 *storage_type);
+static void panel_service_clear_sent_images (PanelService *self);
 static IndicatorObjectEntry * get_indicator_entry_by_id (PanelService *self, const gchar *entry_id);
 static GdkFilterReturn event_filter (GdkXEvent *, GdkEvent *, PanelService *);
 
@@ -167,6 +193,12 @@ panel_service_class_dispose (GObject *self)
       priv->last_menu = NULL;
     }
 
+  if (priv->delta_timeout)
+    {
+      g_source_remove (priv->delta_timeout);
+      priv->delta_timeout = 0;
+    }
+
   for (i = 0; i < N_TIMEOUT_SLOTS; i++)
     {
       if (priv->timeouts[i] > 0 && priv->timeouts[i] != SYNC_WAITING)
@@ -199,6 +231,7 @@ panel_service_clear_remote_data (PanelService *self)
   g_return_if_fail (PANEL_IS_SERVICE (self));
 
   g_hash_table_remove_all (self->priv->panel2entries_hash);
+  panel_service_clear_sent_images (self);
 }
 
 static void
@@ -208,6 +241,9 @@ panel_service_class_finalize (GObject *object)
 
   g_hash_table_destroy (priv->id2entry_hash);
   g_hash_table_destroy (priv->panel2entries_hash);
+  g_hash_table_destroy (priv->entry2delta_hash);
+  g_hash_table_destroy (priv->sent_images);
+  g_queue_free_full (priv->sent_images_queue, g_free);
 
   static_service = NULL;
 
@@ -248,6 +284,14 @@ panel_service_class_init (PanelServiceClass *klass)
                   NULL, NULL, NULL,
                   G_TYPE_NONE, 1, G_TYPE_STRING);
 
+  _service_signals[ENTRY_CHANGED] =
+    g_signal_new ("entry-changed",
+                  G_OBJECT_CLASS_TYPE (obj_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 1, G_TYPE_VARIANT);
+
  _service_signals[GEOMETRIES_CHANGED] =
     g_signal_new ("geometries-changed",
                   G_OBJECT_CLASS_TYPE (obj_class),
@@ -883,6 +927,9 @@ panel_service_init (PanelService *self)
   priv->panel2entries_hash = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                     g_free,
                                                     (GDestroyNotify) g_hash_table_destroy);
+  priv->entry2delta_hash = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+  priv->sent_images = g_hash_table_new (g_str_hash, g_str_equal);
+  priv->sent_images_queue = g_queue_new ();
 
   priv->gsettings = g_settings_new_with_path (COMPIZ_OPTION_SCHEMA, COMPIZ_OPTION_PATH);
   g_signal_connect (priv->gsettings, "changed::"MENU_TOGGLE_KEYBINDING_KEY,
@@ -948,6 +995,7 @@ panel_service_actually_remove_indicator (PanelService *self, IndicatorObject *in
           GSList *ll;
 
           entry = l->data;
+          g_hash_table_remove (self->priv->entry2delta_hash, entry);
 
           if (entry->label)
             {
@@ -1247,19 +1295,198 @@ notify_object (IndicatorObject *object)
                                             object);
 }
 
+static GVariant *
+indicator_entry_delta_to_variant (IndicatorObjectEntry *entry,
+                                  const gchar          *indicator_id,
+                                  guint                 fields,
+                                  guint32               sequence)
+{
+  GVariantBuilder b;
+  gboolean is_label = GTK_IS_LABEL (entry->label);
+  gboolean is_image = GTK_IS_IMAGE (entry->image);
+  gchar *id = get_indicator_entry_id_by_entry (entry);
+
+  g_variant_builder_init (&b, G_VARIANT_TYPE (ENTRY_DELTA_SIGNATURE));
+  g_variant_builder_add (&b, "u", sequence);
+  g_variant_builder_add (&b, "s", indicator_id);
+  g_variant_builder_add (&b, "s", id);
+  g_variant_builder_open (&b, G_VARIANT_TYPE ("a{sv}"));
+
+  if (fields & ENTRY_DELTA_LABEL)
+    {
+      g_variant_builder_add (&b, "{sv}", "label",
+                             g_variant_new_string (is_label ? gtk_label_get_label (entry->label) : ""));
+    }
+
+  if (fields & ENTRY_DELTA_LABEL_SENSITIVE)
+    {
+      g_variant_builder_add (&b, "{sv}", "label_sensitive",
+                             g_variant_new_boolean (is_label ? gtk_widget_get_sensitive (GTK_WIDGET (entry->label)) : FALSE));
+    }
+
+  if (fields & ENTRY_DELTA_LABEL_VISIBLE)
+    {
+      g_variant_builder_add (&b, "{sv}", "label_visible",
+                             g_variant_new_boolean (is_label ? gtk_widget_get_visible (GTK_WIDGET (entry->label)) : FALSE));
+    }
+
+  if (fields & ENTRY_DELTA_IMAGE)
+    {
+      guint32 image_type = 0;
+      gchar *image_data = gtk_image_to_data (entry->image, &image_type);
+
+      g_variant_builder_add (&b, "{sv}", "image_type",
+                             g_variant_new_uint32 (is_image ? image_type : 0));
+      g_variant_builder_add (&b, "{sv}", "image_data",
+                             g_variant_new_string (image_data ? image_data : ""));
+      g_free (image_data);
+    }
+
+  if (fields & ENTRY_DELTA_IMAGE_SENSITIVE)
+    {
+      g_variant_builder_add (&b, "{sv}", "image_sensitive",
+                             g_variant_new_boolean (is_image ? gtk_widget_get_sensitive (GTK_WIDGET (entry->image)) : FALSE));
+    }
+
+  if (fields & ENTRY_DELTA_IMAGE_VISIBLE)
+    {
+      g_variant_builder_add (&b, "{sv}", "image_visible",
+                             g_variant_new_boolean (is_image ? gtk_widget_get_visible (GTK_WIDGET (entry->image)) : FALSE));
+    }
+
+  g_variant_builder_close (&b);
+  g_free (id);
+
+  return g_variant_builder_end (&b);
+}
+
+static gboolean
+actually_notify_entry_deltas (PanelService *self)
+{
+  PanelServicePrivate *priv = self->priv;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  priv->delta_timeout = 0;
+
+  g_hash_table_iter_init (&iter, priv->entry2delta_hash);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      IndicatorObjectEntry *entry = key;
+      EntryDelta *delta = value;
+      GObject *object = G_OBJECT (delta->object);
+      gint position = GPOINTER_TO_INT (g_object_get_data (object, "position"));
+
+      /* A full sync of this indicator is already on its way */
+      if (priv->timeouts[position] != SYNC_NEUTRAL ||
+          GPOINTER_TO_INT (g_object_get_data (object, "remove")))
+        continue;
+
+      GVariant *params = indicator_entry_delta_to_variant (entry,
+                                                          g_object_get_data (object, "id"),
+                                                          delta->fields,
+                                                          ++priv->delta_sequence);
+      g_variant_ref_sink (params);
+      g_signal_emit (self, _service_signals[ENTRY_CHANGED], 0, params);
+      g_variant_unref (params);
+    }
+
+  g_hash_table_remove_all (priv->entry2delta_hash);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+notify_entry_delta (IndicatorObject *object, GObject *widget, guint fields)
+{
+  PanelService         *self;
+  PanelServicePrivate  *priv;
+  IndicatorObjectEntry *entry = NULL;
+  EntryDelta           *delta;
+  GList                *entries, *l;
+  gint                  position;
+
+  if (suppress_signals)
+    return;
+
+  self = panel_service_get_default ();
+  priv = self->priv;
+
+  position = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (object), "position"));
+
+  if (priv->timeouts[position] != SYNC_NEUTRAL)
+    {
+      /* The whole indicator will be synced anyway */
+      return;
+    }
+
+  entries = indicator_object_get_entries (object);
+
+  for (l = entries; l; l = l->next)
+    {
+      IndicatorObjectEntry *e = l->data;
+
+      if (G_OBJECT (e->label) == widget || G_OBJECT (e->image) == widget)
+        {
+          entry = e;
+          break;
+        }
+    }
+
+  g_list_free (entries);
+
+  if (!entry)
+    {
+      notify_object (object);
+      return;
+    }
+
+  delta = g_hash_table_lookup (priv->entry2delta_hash, entry);
+
+  if (!delta)
+    {
+      delta = g_new0 (EntryDelta, 1);
+      delta->object = object;
+      g_hash_table_insert (priv->entry2delta_hash, entry, delta);
+    }
+
+  delta->fields |= fields;
+
+  if (!priv->delta_timeout)
+    {
+      priv->delta_timeout = g_timeout_add (NOTIFY_TIMEOUT,
+                                           (GSourceFunc)actually_notify_entry_deltas,
+                                           self);
+    }
+}
+
 static void
 on_entry_property_changed (GObject        *o,
                            GParamSpec      *pspec,
                            IndicatorObject *object)
 {
-  notify_object (object);
+  guint fields;
+
+  if (GTK_IS_LABEL (o))
+    {
+      fields = g_strcmp0 (pspec->name, "sensitive") == 0 ?
+               ENTRY_DELTA_LABEL_SENSITIVE : ENTRY_DELTA_LABEL;
+    }
+  else
+    {
+      fields = g_strcmp0 (pspec->name, "sensitive") == 0 ?
+               ENTRY_DELTA_IMAGE_SENSITIVE : ENTRY_DELTA_IMAGE;
+    }
+
+  notify_entry_delta (object, o, fields);
 }
 
 static void
 on_entry_changed (GObject *o,
                   IndicatorObject *object)
 {
-  notify_object (object);
+  notify_entry_delta (object, o, GTK_IS_LABEL (o) ? ENTRY_DELTA_LABEL_VISIBLE :
+                                                    ENTRY_DELTA_IMAGE_VISIBLE);
 }
 
 static void
@@ -1357,6 +1584,7 @@ on_entry_removed (IndicatorObject      *object,
 
   gchar *entry_id = get_indicator_entry_id_by_entry (entry);
   g_hash_table_remove (self->priv->id2entry_hash, entry_id);
+  g_hash_table_remove (self->priv->entry2delta_hash, entry);
   g_free (entry_id);
 
   if (entry->label)
@@ -1600,6 +1828,92 @@ sort_indicators (PanelService *self)
     }
 }
 
+static gchar *
+pixbuf_content_hash (GdkPixbuf *pixbuf)
+{
+  /* 64 bit FNV-1a, this is only used to recognize already sent images */
+  const guchar *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  gint width = gdk_pixbuf_get_width (pixbuf);
+  gint height = gdk_pixbuf_get_height (pixbuf);
+  gint rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  gint row_bytes = width * gdk_pixbuf_get_n_channels (pixbuf) *
+                   gdk_pixbuf_get_bits_per_sample (pixbuf) / 8;
+  guint64 hash = G_GUINT64_CONSTANT (14695981039346656037);
+  gint x, y;
+
+  hash = (hash ^ width) * G_GUINT64_CONSTANT (1099511628211);
+  hash = (hash ^ height) * G_GUINT64_CONSTANT (1099511628211);
+  hash = (hash ^ gdk_pixbuf_get_has_alpha (pixbuf)) * G_GUINT64_CONSTANT (1099511628211);
+
+  for (y = 0; y < height; ++y)
+    {
+      const guchar *row = pixels + y * rowstride;
+
+      for (x = 0; x < row_bytes; ++x)
+        hash = (hash ^ row[x]) * G_GUINT64_CONSTANT (1099511628211);
+    }
+
+  return g_strdup_printf ("%016" G_GINT64_MODIFIER "x", hash);
+}
+
+static void
+panel_service_clear_sent_images (PanelService *self)
+{
+  g_hash_table_remove_all (self->priv->sent_images);
+  g_queue_free_full (self->priv->sent_images_queue, g_free);
+  self->priv->sent_images_queue = g_queue_new ();
+}
+
+static gchar *
+pixbuf_to_data (GdkPixbuf *pixbuf)
+{
+  PanelServicePrivate *priv = panel_service_get_default ()->priv;
+  gchar *buffer = NULL;
+  gsize buffer_size = 0;
+  GError *error = NULL;
+  gchar *ret = NULL;
+  gchar *hash;
+
+  if (!GDK_IS_PIXBUF (pixbuf))
+    return NULL;
+
+  hash = pixbuf_content_hash (pixbuf);
+
+  if (g_hash_table_contains (priv->sent_images, hash))
+    {
+      /* The client has already this image, no need to encode it again */
+      return hash;
+    }
+
+  if (gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_size, "png", &error, NULL))
+    {
+      gchar *encoded = g_base64_encode ((const guchar *)buffer, buffer_size);
+      ret = g_strdup_printf ("%s%c%s", hash, IMAGE_HASH_SEPARATOR, encoded);
+      g_free (encoded);
+      g_free (buffer);
+
+      g_hash_table_add (priv->sent_images, hash);
+      g_queue_push_tail (priv->sent_images_queue, hash);
+
+      if (g_queue_get_length (priv->sent_images_queue) > IMAGE_CACHE_SIZE)
+        {
+          gchar *oldest = g_queue_pop_head (priv->sent_images_queue);
+          g_hash_table_remove (priv->sent_images, oldest);
+          g_free (oldest);
+        }
+    }
+  else
+    {
+      g_warning ("Unable to convert pixbuf to png data: '%s'", error ? error->message : "unknown");
+      if (error)
+        g_error_free (error);
+
+      g_free (hash);
+    }
+
+  return ret;
+}
+
 static gchar *
 gtk_image_to_data (GtkImage *image, guint32 *storage_type)
 {
@@ -1628,25 +1942,7 @@ gtk_image_to_data (GtkImage *image, guint32 *storage_type)
             g_free (file);
           }
 
-        GdkPixbuf  *pixbuf;
-        gchar      *buffer = NULL;
-        gsize       buffer_size = 0;
-        GError     *error = NULL;
-
-        pixbuf = gtk_image_get_pixbuf (image);
-
-        if (gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_size, "png", &error, NULL))
-          {
-            ret = g_base64_encode ((const guchar *)buffer, buffer_size);
-            g_free (buffer);
-          }
-        else
-          {
-            g_warning ("Unable to convert pixbuf to png data: '%s'", error ? error->message : "unknown");
-            if (error)
-              g_error_free (error);
-          }
-
+        ret = pixbuf_to_data (gtk_image_get_pixbuf (image));
         break;
       }
       case GTK_IMAGE_STOCK:
@@ -1896,6 +2192,18 @@ on_active_menu_hidden (GtkMenu *menu, PanelService *self)
 }
 
 
+static void
+reset_sync_timeout (PanelService *self, gint position)
+{
+  guint timeout = self->priv->timeouts[position];
+
+  /* The client is getting the full state now, a pending re-sync is useless */
+  if (timeout != SYNC_NEUTRAL && timeout != SYNC_WAITING)
+    g_source_remove (timeout);
+
+  self->priv->timeouts[position] = SYNC_NEUTRAL;
+}
+
 /*
  * Public Methods
  */
@@ -1907,6 +2215,9 @@ panel_service_sync (PanelService *self)
   GSList *i;
   gint position;
 
+  /* A full sync may come from a new client, so send all the images again */
+  panel_service_clear_sent_images (self);
+
   g_variant_builder_init (&b, G_VARIANT_TYPE ("("ENTRY_ARRAY_SIGNATURE")"));
   g_variant_builder_open (&b, G_VARIANT_TYPE (ENTRY_ARRAY_SIGNATURE));
 
@@ -1921,7 +2232,7 @@ panel_service_sync (PanelService *self)
       indicator_object_to_variant (self, indicator, indicator_id, &b);
 
       /* Set the sync back to neutral */
-      self->priv->timeouts[position] = SYNC_NEUTRAL;
+      reset_sync_timeout (self, position);
     }
 
   g_variant_builder_close (&b);
@@ -1946,7 +2257,7 @@ panel_service_sync_one (PanelService *self, const gchar *indicator_id)
           indicator_object_to_variant (self, i->data, indicator_id, &b);
 
           /* Set the sync back to neutral */
-          self->priv->timeouts[position] = SYNC_NEUTRAL;
+          reset_sync_timeout (self, position);
 
           break;
         }
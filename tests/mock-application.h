@@ -314,10 +314,10 @@ struct MockApplicationManager : public unity::ApplicationManager
     ON_CALL(*this, GetUnityApplication()).WillByDefault(Invoke(this, &MockApplicationManager::LocalGetUnityApplication));
     ON_CALL(*this, GetApplicationForDesktopFile(_)).WillByDefault(Invoke(this, &MockApplicationManager::LocalGetApplicationForDesktopFile));
     ON_CALL(*this, GetActiveWindow()).WillByDefault(Invoke([this] { return unity::ApplicationWindowPtr(); } ));
-    ON_CALL(*this, GetRunningApplications()).WillByDefault(Invoke([this] { return unity::ApplicationList(); } ));
+    ON_CALL(*this, GetRunningApplications()).WillByDefault(Invoke([this] { return std::make_shared<unity::ApplicationList>(); } ));
     ON_CALL(*this, GetApplicationForWindow(_)).WillByDefault(Invoke([this] (Window) { return unity::ApplicationPtr(); } ));
     ON_CALL(*this, GetActiveApplication()).WillByDefault(Invoke([this] { return unity::ApplicationPtr(); } ));
-    ON_CALL(*this, GetWindowsForMonitor(_)).WillByDefault(Invoke([this] (Window) { return unity::WindowList(); } ));
+    ON_CALL(*this, GetWindowsForMonitor(_)).WillByDefault(Invoke([this] (Window) { return std::make_shared<unity::WindowList>(); } ));
     ON_CALL(*this, GetWindowForId(_)).WillByDefault(Invoke([this] (int) { return unity::ApplicationWindowPtr(); } ));
   }
 
@@ -333,10 +333,10 @@ struct MockApplicationManager : public unity::ApplicationManager
   MOCK_CONST_METHOD0(GetUnityApplication, unity::ApplicationPtr());
   MOCK_CONST_METHOD0(GetActiveWindow, unity::ApplicationWindowPtr());
   MOCK_CONST_METHOD1(GetApplicationForDesktopFile, unity::ApplicationPtr(std::string const&));
-  MOCK_CONST_METHOD0(GetRunningApplications, unity::ApplicationList());
+  MOCK_CONST_METHOD0(GetRunningApplications, unity::ApplicationListPtr());
   MOCK_CONST_METHOD1(GetApplicationForWindow, unity::ApplicationPtr(Window));
   MOCK_CONST_METHOD0(GetActiveApplication, unity::ApplicationPtr());
-  MOCK_CONST_METHOD1(GetWindowsForMonitor, unity::WindowList(int));
+  MOCK_CONST_METHOD1(GetWindowsForMonitor, unity::WindowListPtr(int));
   MOCK_CONST_METHOD1(GetWindowForId, unity::ApplicationWindowPtr(Window));
   MOCK_CONST_METHOD3(FocusWindowGroup, void(unity::WindowList const&, bool, int));
 
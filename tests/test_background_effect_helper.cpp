@@ -0,0 +1,155 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include "unity-shared/BackgroundEffectHelper.h"
+
+namespace unity
+{
+namespace
+{
+
+typedef BackgroundEffectHelper::CacheState CacheState;
+typedef BackgroundEffectHelper::Update Update;
+
+struct TestBlurCacheState : Test
+{
+  TestBlurCacheState()
+    : region(0, 0, 400, 300)
+  {
+    state.Clear();
+  }
+
+  nux::Geometry region;
+  CacheState state;
+};
+
+TEST(TestBlurCacheStateNew, NeedsFullUpdate)
+{
+  CacheState state;
+  nux::Geometry geo(0, 0, 400, 300);
+
+  EXPECT_TRUE(state.IsDirty());
+  EXPECT_TRUE(state.IsFullyDirty());
+  EXPECT_EQ(Update::FULL, state.NextUpdate(geo, geo, false));
+  EXPECT_EQ(Update::FULL, state.NextUpdate(geo, geo, true));
+}
+
+TEST(TestBlurCacheStateNew, DamageIsIgnored)
+{
+  CacheState state;
+  nux::Geometry geo(0, 0, 400, 300);
+
+  EXPECT_EQ(Update::NONE, state.Damage(nux::Geometry(10, 10, 5, 5), geo));
+  EXPECT_TRUE(state.DirtyRects().empty());
+}
+
+TEST_F(TestBlurCacheState, CleanCacheIsReused)
+{
+  EXPECT_FALSE(state.IsDirty());
+  EXPECT_EQ(Update::NONE, state.NextUpdate(region, region, true));
+}
+
+TEST_F(TestBlurCacheState, InvalidTextureNeedsFullUpdate)
+{
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, region, false));
+}
+
+TEST_F(TestBlurCacheState, GeometryChangeNeedsFullUpdate)
+{
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, nux::Geometry(0, 0, 400, 301), true));
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, nux::Geometry(1, 0, 400, 300), true));
+}
+
+TEST_F(TestBlurCacheState, Invalidate)
+{
+  EXPECT_EQ(Update::FULL, state.Invalidate());
+  EXPECT_TRUE(state.IsFullyDirty());
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, region, true));
+
+  EXPECT_EQ(Update::NONE, state.Invalidate());
+}
+
+TEST_F(TestBlurCacheState, DamageDirtiesTiles)
+{
+  nux::Geometry rect(10, 10, 20, 20);
+
+  EXPECT_EQ(Update::PARTIAL, state.Damage(rect, region));
+  EXPECT_TRUE(state.IsDirty());
+  EXPECT_FALSE(state.IsFullyDirty());
+  EXPECT_THAT(state.DirtyRects(), ElementsAre(rect));
+  EXPECT_EQ(Update::PARTIAL, state.NextUpdate(region, region, true));
+}
+
+TEST_F(TestBlurCacheState, DamageWithGeometryChangeNeedsFullUpdate)
+{
+  ASSERT_EQ(Update::PARTIAL, state.Damage(nux::Geometry(10, 10, 20, 20), region));
+
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, nux::Geometry(0, 0, 200, 300), true));
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, region, false));
+}
+
+TEST_F(TestBlurCacheState, DamageInsideDirtyTileIsIgnored)
+{
+  ASSERT_EQ(Update::PARTIAL, state.Damage(nux::Geometry(10, 10, 20, 20), region));
+
+  EXPECT_EQ(Update::NONE, state.Damage(nux::Geometry(10, 10, 20, 20), region));
+  EXPECT_EQ(Update::NONE, state.Damage(nux::Geometry(15, 15, 5, 5), region));
+  EXPECT_EQ(1u, state.DirtyRects().size());
+}
+
+TEST_F(TestBlurCacheState, NullDamageIsIgnored)
+{
+  EXPECT_EQ(Update::NONE, state.Damage(nux::Geometry(), region));
+  EXPECT_FALSE(state.IsDirty());
+}
+
+TEST_F(TestBlurCacheState, LargeDamageDirtiesAll)
+{
+  EXPECT_EQ(Update::FULL, state.Damage(nux::Geometry(0, 0, 400, 151), region));
+  EXPECT_TRUE(state.IsFullyDirty());
+  EXPECT_TRUE(state.DirtyRects().empty());
+}
+
+TEST_F(TestBlurCacheState, ManyTilesDirtyAll)
+{
+  Update update = Update::NONE;
+
+  for (int i = 0; i < 20 && update != Update::FULL; ++i)
+    update = state.Damage(nux::Geometry(i * 10, 0, 5, 5), region);
+
+  EXPECT_EQ(Update::FULL, update);
+  EXPECT_TRUE(state.IsFullyDirty());
+  EXPECT_EQ(Update::FULL, state.NextUpdate(region, region, true));
+}
+
+TEST_F(TestBlurCacheState, ClearAfterPartialUpdate)
+{
+  ASSERT_EQ(Update::PARTIAL, state.Damage(nux::Geometry(10, 10, 20, 20), region));
+  state.Clear();
+
+  EXPECT_FALSE(state.IsDirty());
+  EXPECT_TRUE(state.DirtyRects().empty());
+  EXPECT_EQ(Update::NONE, state.NextUpdate(region, region, true));
+}
+
+} // anonymous namespace
+} // unity namespace
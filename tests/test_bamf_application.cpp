@@ -25,6 +25,7 @@
 #include "bamf-mock-window.h"
 #include "mock-application.h"
 #include "test_standalone_wm.h"
+#include "test_utils.h"
 
 #include <UnityCore/GLibWrapper.h>
 
@@ -103,4 +104,104 @@ TEST_F(TestBamfApplication, GetWindows)
   g_list_free_full(children, g_object_unref);
 }
 
+struct TestBamfApplicationManager : public testing::Test
+{
+  std::vector<unity::glib::Object<BamfMockWindow>> AddWindows(unsigned n_windows)
+  {
+    std::vector<unity::glib::Object<BamfMockWindow>> windows;
+
+    for (unsigned i = 1; i <= n_windows; ++i)
+    {
+      unity::glib::Object<BamfMockWindow> window(bamf_mock_window_new());
+      bamf_mock_window_set_xid(window, i);
+      manager_.EnsureWindow(unity::glib::object_cast<BamfView>(window));
+      windows.push_back(window);
+    }
+
+    return windows;
+  }
+
+  void CloseWindows(std::vector<unity::glib::Object<BamfMockWindow>> const& windows)
+  {
+    for (auto const& window : windows)
+      g_signal_emit_by_name(window, "closed");
+  }
+
+  unity::testwrapper::StandaloneWM WM;
+  unity::bamf::Manager manager_;
+};
+
+TEST_F(TestBamfApplicationManager, GetWindowForId)
+{
+  auto const& windows = AddWindows(5);
+
+  for (Window xid = 1; xid <= windows.size(); ++xid)
+  {
+    auto const& win = manager_.GetWindowForId(xid);
+    ASSERT_NE(win, nullptr);
+    EXPECT_EQ(win->window_id(), xid);
+    EXPECT_EQ(win, manager_.EnsureWindow(unity::glib::object_cast<BamfView>(windows[xid-1])));
+  }
+
+  EXPECT_EQ(manager_.GetWindowForId(0), nullptr);
+  CloseWindows(windows);
+}
+
+TEST_F(TestBamfApplicationManager, GetWindowForIdAfterClose)
+{
+  auto const& windows = AddWindows(2);
+  auto const& win = manager_.GetWindowForId(1);
+  ASSERT_NE(win, nullptr);
+
+  bool closed = false;
+  win->closed.connect([&closed] { closed = true; });
+  g_signal_emit_by_name(windows[0], "closed");
+
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(manager_.GetWindowForId(1), nullptr);
+  EXPECT_NE(manager_.GetWindowForId(2), nullptr);
+  CloseWindows({windows[1]});
+}
+
+TEST_F(TestBamfApplicationManager, BENCHMARK_TEST(GetWindowForIdBenchmark))
+{
+  const unsigned n_windows = 300;
+  auto const& windows = AddWindows(n_windows);
+
+  unity::WindowList wins;
+  for (auto const& window : windows)
+    wins.push_back(manager_.EnsureWindow(unity::glib::object_cast<BamfView>(window)));
+
+  unsigned found = 0;
+
+  // The lookup on all the known windows we used to do
+  double old_usec = Utils::BenchmarkUSec([&wins, &found] {
+    for (Window xid = 1; xid <= wins.size(); ++xid)
+    {
+      for (auto const& win : wins)
+      {
+        if (win->window_id() == xid)
+        {
+          ++found;
+          break;
+        }
+      }
+    }
+  }, 10);
+
+  double new_usec = Utils::BenchmarkUSec([this, &found] {
+    for (Window xid = 1; xid <= n_windows; ++xid)
+    {
+      if (manager_.GetWindowForId(xid))
+        ++found;
+    }
+  }, 10);
+
+  EXPECT_EQ(2 * 10 * n_windows, found);
+  CloseWindows(windows);
+
+  RecordProperty("300_windows_old_usec", std::to_string(old_usec));
+  RecordProperty("300_windows_new_usec", std::to_string(new_usec));
+}
+
 }
@@ -0,0 +1,391 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <random>
+#include <set>
+#include "DamagePropagation.h"
+
+namespace unity
+{
+namespace impl
+{
+namespace
+{
+
+const int SCREEN_WIDTH = 160;
+const int SCREEN_HEIGHT = 100;
+
+// Damage and windows can go beyond the screen edges
+const int REGION_OFFSET = 10;
+const int REGION_WIDTH = SCREEN_WIDTH * 2;
+const int REGION_HEIGHT = SCREEN_HEIGHT * 2;
+
+// A pixel based region, simple enough to be obviously right
+struct Region
+{
+  Region() : pixels(REGION_WIDTH * REGION_HEIGHT, 0) {}
+
+  void Add(nux::Geometry const& geo)
+  {
+    for (int y = geo.y; y < geo.y + geo.height; ++y)
+      for (int x = geo.x; x < geo.x + geo.width; ++x)
+        pixels[Index(x, y)] = 1;
+  }
+
+  bool Intersects(nux::Geometry const& geo) const
+  {
+    for (int y = geo.y; y < geo.y + geo.height; ++y)
+      for (int x = geo.x; x < geo.x + geo.width; ++x)
+        if (pixels[Index(x, y)])
+          return true;
+
+    return false;
+  }
+
+  static int Index(int x, int y)
+  {
+    return (y + REGION_OFFSET) * REGION_WIDTH + x + REGION_OFFSET;
+  }
+
+  bool operator==(Region const& other) const { return pixels == other.pixels; }
+  bool operator!=(Region const& other) const { return !(*this == other); }
+
+  std::vector<char> pixels;
+};
+
+// Mimics the nux window compositor presentation behavior
+struct FakeCompositor
+{
+  struct Window
+  {
+    nux::Geometry geo;
+    bool presentable;
+    bool presented;
+  };
+
+  void Present(nux::Geometry const& rect)
+  {
+    ++present_calls;
+
+    for (auto& win : windows)
+    {
+      if (win.presentable && win.geo.IsIntersecting(rect))
+        win.presented = true;
+    }
+  }
+
+  void Present(Region const& region)
+  {
+    ++present_calls;
+
+    for (auto& win : windows)
+    {
+      if (win.presentable && region.Intersects(win.geo))
+        win.presented = true;
+    }
+  }
+
+  Geometries PresentationList() const
+  {
+    Geometries geometries;
+
+    for (auto const& win : windows)
+    {
+      if (win.presented)
+        geometries.push_back(win.geo);
+    }
+
+    return geometries;
+  }
+
+  std::vector<bool> Presented() const
+  {
+    std::vector<bool> presented;
+
+    for (auto const& win : windows)
+      presented.push_back(win.presented);
+
+    return presented;
+  }
+
+  std::vector<Window> windows;
+  unsigned present_calls = 0;
+};
+
+struct Scenario
+{
+  std::vector<FakeCompositor::Window> windows;
+  Geometries compiz_damage;
+  Geometries panels;
+  Geometries shadows;
+};
+
+nux::Geometry RandomGeometry(std::mt19937& gen, int max_size)
+{
+  std::uniform_int_distribution<int> x(-REGION_OFFSET, SCREEN_WIDTH);
+  std::uniform_int_distribution<int> y(-REGION_OFFSET, SCREEN_HEIGHT);
+  std::uniform_int_distribution<int> size(1, max_size);
+  return nux::Geometry(x(gen), y(gen), size(gen), size(gen));
+}
+
+Scenario RandomScenario(unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::bernoulli_distribution chance(0.25);
+  std::uniform_int_distribution<int> n_windows(0, 12);
+  std::uniform_int_distribution<int> n_damage(0, 25);
+  Scenario scenario;
+
+  // Two monitors, each one with its panel and panel shadow
+  scenario.panels = {{0, 0, SCREEN_WIDTH / 2, 10}, {SCREEN_WIDTH / 2, 0, SCREEN_WIDTH / 2, 10}};
+  scenario.shadows = {{0, 10, SCREEN_WIDTH / 2, 4}, {SCREEN_WIDTH / 2, 10, SCREEN_WIDTH / 2, 4}};
+
+  for (int i = n_windows(gen); i > 0; --i)
+    scenario.windows.push_back({RandomGeometry(gen, 60), !chance(gen), chance(gen)});
+
+  for (int i = n_damage(gen); i > 0; --i)
+    scenario.compiz_damage.push_back(RandomGeometry(gen, 15));
+
+  return scenario;
+}
+
+// The loop used by UnityScreen::damageCutoff before the switch to DamagePropagation
+Region OldDamageCutoff(FakeCompositor& compositor, Scenario const& scenario)
+{
+  Region buffered_compiz_damage;
+
+  for (auto const& rect : scenario.compiz_damage)
+    buffered_compiz_damage.Add(rect);
+
+  Region damage_buffer, last_damage_buffer;
+
+  do
+  {
+    last_damage_buffer = damage_buffer;
+    compositor.Present(buffered_compiz_damage);
+
+    for (auto const& dirty_geo : compositor.PresentationList())
+    {
+      damage_buffer.Add(dirty_geo);
+
+      for (auto const& panel_geo : scenario.panels)
+      {
+        if (!dirty_geo.IsIntersecting(panel_geo))
+          continue;
+
+        for (auto const& shadow : scenario.shadows)
+          damage_buffer.Add(shadow);
+      }
+    }
+
+    for (unsigned i = 0; i < damage_buffer.pixels.size(); ++i)
+      buffered_compiz_damage.pixels[i] = buffered_compiz_damage.pixels[i] || damage_buffer.pixels[i];
+  } while (last_damage_buffer != damage_buffer);
+
+  return buffered_compiz_damage;
+}
+
+Region NewDamageCutoff(FakeCompositor& compositor, Scenario const& scenario, unsigned* passes = nullptr)
+{
+  Region buffered_compiz_damage;
+  DamagePropagation propagation;
+
+  propagation.present_windows = [&compositor] (nux::Geometry const& geo) { compositor.Present(geo); };
+  propagation.presentation_list = [&compositor] { return compositor.PresentationList(); };
+  propagation.damage = [&] (Geometries const& rects) {
+    for (auto const& rect : rects)
+    {
+      buffered_compiz_damage.Add(rect);
+      propagation.AddDamage(rect);
+    }
+  };
+
+  for (auto const& win : compositor.windows)
+    propagation.windows.Add(win.geo);
+
+  propagation.windows.Build();
+  propagation.panels = scenario.panels;
+  propagation.panel_shadows = scenario.shadows;
+
+  for (auto const& rect : scenario.compiz_damage)
+  {
+    buffered_compiz_damage.Add(rect);
+    propagation.AddDamage(rect);
+  }
+
+  unsigned n_passes = propagation.Propagate();
+
+  if (passes)
+    *passes = n_passes;
+
+  return buffered_compiz_damage;
+}
+
+TEST(TestWindowIntervalIndex, Empty)
+{
+  WindowIntervalIndex index;
+  index.Build();
+  EXPECT_TRUE(index.empty());
+
+  bool called = false;
+  index.ForEachIntersecting(nux::Geometry(0, 0, 100, 100), [&called] (unsigned) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(TestWindowIntervalIndex, MatchesBruteForce)
+{
+  std::mt19937 gen(42);
+
+  for (unsigned round = 0; round < 50; ++round)
+  {
+    WindowIntervalIndex index;
+    Geometries geometries;
+
+    for (unsigned i = 0; i < 30; ++i)
+    {
+      geometries.push_back(RandomGeometry(gen, 80));
+      EXPECT_EQ(i, index.Add(geometries.back()));
+    }
+
+    index.Build();
+    ASSERT_EQ(geometries.size(), index.size());
+
+    for (unsigned q = 0; q < 50; ++q)
+    {
+      auto const& rect = RandomGeometry(gen, 60);
+      std::set<unsigned> expected, found;
+
+      for (unsigned i = 0; i < geometries.size(); ++i)
+      {
+        if (geometries[i].IsIntersecting(rect))
+          expected.insert(i);
+      }
+
+      index.ForEachIntersecting(rect, [&found] (unsigned id) { EXPECT_TRUE(found.insert(id).second); });
+      EXPECT_EQ(expected, found);
+    }
+  }
+}
+
+TEST(TestWindowIntervalIndex, TouchingIsNotIntersecting)
+{
+  WindowIntervalIndex index;
+  index.Add(nux::Geometry(10, 10, 10, 10));
+  index.Build();
+
+  unsigned hits = 0;
+  auto count = [&hits] (unsigned) { ++hits; };
+
+  index.ForEachIntersecting(nux::Geometry(20, 10, 5, 5), count);
+  index.ForEachIntersecting(nux::Geometry(0, 10, 10, 5), count);
+  index.ForEachIntersecting(nux::Geometry(10, 20, 5, 5), count);
+  EXPECT_EQ(0u, hits);
+
+  index.ForEachIntersecting(nux::Geometry(19, 19, 5, 5), count);
+  EXPECT_EQ(1u, hits);
+}
+
+TEST(TestDamagePropagation, NoDamageIsSinglePass)
+{
+  FakeCompositor compositor;
+  compositor.windows = {{{0, 50, 60, 40}, true, false}};
+  Scenario scenario;
+
+  unsigned passes = 0;
+  NewDamageCutoff(compositor, scenario, &passes);
+
+  EXPECT_EQ(1u, passes);
+  EXPECT_EQ(0u, compositor.present_calls);
+  EXPECT_FALSE(compositor.windows[0].presented);
+}
+
+TEST(TestDamagePropagation, DamageChainsThroughWindows)
+{
+  FakeCompositor compositor;
+  compositor.windows = {{{0, 50, 60, 40}, true, false},
+                        {{50, 50, 60, 40}, true, false},
+                        {{100, 50, 50, 40}, true, false},
+                        {{150, 90, 5, 5}, true, false}};
+  Scenario scenario;
+  scenario.compiz_damage = {{5, 60, 2, 2}};
+
+  NewDamageCutoff(compositor, scenario);
+
+  EXPECT_THAT(compositor.Presented(), ElementsAre(true, true, true, false));
+}
+
+TEST(TestDamagePropagation, PanelDamagesShadows)
+{
+  Scenario scenario;
+  scenario.panels = {{0, 0, 160, 10}};
+  scenario.shadows = {{0, 10, 160, 4}};
+  scenario.compiz_damage = {{5, 5, 2, 2}};
+
+  FakeCompositor compositor;
+  compositor.windows = {{{0, 0, 160, 10}, true, false}, {{100, 12, 40, 40}, true, false}};
+
+  Region damage = NewDamageCutoff(compositor, scenario);
+
+  EXPECT_TRUE(damage.Intersects(nux::Geometry(50, 12, 1, 1)));
+  EXPECT_THAT(compositor.Presented(), ElementsAre(true, true));
+}
+
+TEST(TestDamagePropagation, FewerPresentCallsThanDamageRects)
+{
+  Scenario scenario;
+
+  for (int i = 0; i < 50; ++i)
+    scenario.compiz_damage.push_back(nux::Geometry(i * 3, 50, 2, 2));
+
+  FakeCompositor compositor;
+  compositor.windows = {{{0, 40, 20, 20}, true, false}};
+
+  NewDamageCutoff(compositor, scenario);
+
+  EXPECT_TRUE(compositor.windows[0].presented);
+  EXPECT_EQ(1u, compositor.present_calls);
+}
+
+class TestDamagePropagationRegression : public TestWithParam<unsigned>
+{};
+
+TEST_P(TestDamagePropagationRegression, SameAsOldLoop)
+{
+  auto const& scenario = RandomScenario(GetParam());
+
+  FakeCompositor old_compositor;
+  old_compositor.windows = scenario.windows;
+  Region old_damage = OldDamageCutoff(old_compositor, scenario);
+
+  FakeCompositor new_compositor;
+  new_compositor.windows = scenario.windows;
+  Region new_damage = NewDamageCutoff(new_compositor, scenario);
+
+  EXPECT_EQ(old_compositor.Presented(), new_compositor.Presented());
+  EXPECT_TRUE(old_damage == new_damage);
+}
+
+INSTANTIATE_TEST_CASE_P(TestDamagePropagationScenarios, TestDamagePropagationRegression, Range(0u, 200u));
+
+} // anonymous namespace
+} // impl namespace
+} // unity namespace
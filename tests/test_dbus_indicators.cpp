@@ -4,6 +4,7 @@
 #include <UnityCore/GLibSource.h>
 #include <UnityCore/GLibWrapper.h>
 #include <UnityCore/DBusIndicators.h>
+#include <UnityCore/Variant.h>
 
 #include "panel-service-private.h"
 #include "test_utils.h"
@@ -49,12 +50,40 @@ public:
     return g_variant_get_boolean(g_variant_get_child_value(ret, 0));
   }
 
-  GVariant* CallPanelMethod(std::string const& name) const
+  unsigned SyncCount() const
+  {
+    glib::Variant ret(CallPanelMethod("SyncCount"), glib::StealRef());
+    return glib::Variant(g_variant_get_child_value(ret, 0), glib::StealRef()).GetUInt32();
+  }
+
+  std::string FirstEntryImage() const
+  {
+    auto const& indicators = dbus_indicators->GetIndicators();
+
+    if (indicators.empty())
+      return "";
+
+    auto const& entry = indicators.front()->GetEntry("test_entry_id");
+    return entry ? entry->image_data() : "";
+  }
+
+  std::string FirstEntryLabel() const
+  {
+    auto const& indicators = dbus_indicators->GetIndicators();
+
+    if (indicators.empty())
+      return "";
+
+    auto const& entry = indicators.front()->GetEntry("test_entry_id");
+    return entry ? entry->label() : "";
+  }
+
+  GVariant* CallPanelMethod(std::string const& name, GVariant* parameters = NULL) const
   {
     return g_dbus_connection_call_sync(session, "com.canonical.Unity.Test",
                                        UPS_PATH, UPS_IFACE,
                                        name.c_str(),
-                                       NULL,
+                                       parameters,
                                        NULL,
                                        G_DBUS_CALL_FLAGS_NONE,
                                        -1,
@@ -95,4 +124,63 @@ TEST_F(TestDBusIndicators, TestSync)
   EXPECT_EQ(dbus_indicators->GetIndicators().front()->GetEntries().back()->id(), "test_entry_id");
 }
 
+TEST_F(TestDBusIndicators, TestEntryChangedDelta)
+{
+  Utils::WaitUntil(sigc::mem_fun(*dbus_indicators, &DBusIndicatorsTest::HasIndicators), true, 5);
+  unsigned syncs = SyncCount();
+
+  CallPanelMethod("TriggerEntryLabelChanged", g_variant_new("(us)", 1, "delta_label_1"));
+  Utils::WaitUntil([this] { return FirstEntryLabel() == "delta_label_1"; }, true, 5);
+
+  CallPanelMethod("TriggerEntryLabelChanged", g_variant_new("(us)", 2, "delta_label_2"));
+  Utils::WaitUntil([this] { return FirstEntryLabel() == "delta_label_2"; }, true, 5);
+
+  auto const& entry = dbus_indicators->GetIndicators().front()->GetEntry("test_entry_id");
+  EXPECT_TRUE(entry->label_sensitive());
+  EXPECT_TRUE(entry->label_visible());
+  EXPECT_EQ(syncs, SyncCount());
+}
+
+TEST_F(TestDBusIndicators, TestEntryChangedSequenceGapResyncs)
+{
+  Utils::WaitUntil(sigc::mem_fun(*dbus_indicators, &DBusIndicatorsTest::HasIndicators), true, 5);
+
+  CallPanelMethod("TriggerEntryLabelChanged", g_variant_new("(us)", 10, "delta_label"));
+  Utils::WaitUntil([this] { return FirstEntryLabel() == "delta_label"; }, true, 5);
+  unsigned syncs = SyncCount();
+
+  CallPanelMethod("TriggerEntryLabelChanged", g_variant_new("(us)", 12, "delta_label_gap"));
+  Utils::WaitUntil([this, syncs] { return SyncCount() > syncs; }, true, 5);
+
+  // The full sync reply restores the service state
+  Utils::WaitUntil([this] { return FirstEntryLabel() == "test_entry_label"; }, true, 5);
+}
+
+TEST_F(TestDBusIndicators, TestEntryChangedImageReferences)
+{
+  Utils::WaitUntil(sigc::mem_fun(*dbus_indicators, &DBusIndicatorsTest::HasIndicators), true, 5);
+
+  std::string const& image1 = "0123456789abcdef:aW1hZ2Ux";
+  std::string const& image2 = "fedcba9876543210:aW1hZ2Uy";
+
+  CallPanelMethod("TriggerEntryImageChanged", g_variant_new("(us)", 1, image1.c_str()));
+  Utils::WaitUntil([this, image1] { return FirstEntryImage() == image1; }, true, 5);
+
+  CallPanelMethod("TriggerEntryImageChanged", g_variant_new("(us)", 2, image2.c_str()));
+  Utils::WaitUntil([this, image2] { return FirstEntryImage() == image2; }, true, 5);
+
+  // Only the hash is sent for already known images
+  CallPanelMethod("TriggerEntryImageChanged", g_variant_new("(us)", 3, "0123456789abcdef"));
+  Utils::WaitUntil([this, image1] { return FirstEntryImage() == image1; }, true, 5);
+}
+
+TEST_F(TestDBusIndicators, TestEntryChangedUnknownImageResyncs)
+{
+  Utils::WaitUntil(sigc::mem_fun(*dbus_indicators, &DBusIndicatorsTest::HasIndicators), true, 5);
+  unsigned syncs = SyncCount();
+
+  CallPanelMethod("TriggerEntryImageChanged", g_variant_new("(us)", 1, "1111111111111111"));
+  Utils::WaitUntil([this, syncs] { return SyncCount() > syncs; }, true, 5);
+}
+
 }
@@ -0,0 +1,197 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <UnityCore/GLibWrapper.h>
+#include <UnityCore/Variant.h>
+#include "unity-shared/DebugDBusInterfacePrivate.h"
+#include "unity-shared/Introspectable.h"
+
+namespace unity
+{
+namespace debug
+{
+namespace
+{
+
+struct TestNode : Introspectable
+{
+  TestNode(std::string const& name, bool visible = true)
+    : name(name)
+    , visible(visible)
+    , introspections(0)
+  {}
+
+  std::string GetName() const { return name; }
+
+  void AddProperties(IntrospectionData& data)
+  {
+    ++introspections;
+    data.add("visible", visible).add("label", name);
+  }
+
+  std::string name;
+  bool visible;
+  unsigned introspections;
+};
+
+struct TestDebugDBusInterface : Test
+{
+  TestDebugDBusInterface()
+    : root("Unity")
+    , launcher("Launcher")
+    , panel("Panel", false)
+    , icon("LauncherIcon")
+  {
+    root.AddChild(&launcher);
+    root.AddChild(&panel);
+    launcher.AddChild(&icon);
+  }
+
+  std::vector<std::string> Paths(glib::Variant const& states)
+  {
+    std::vector<std::string> paths;
+    GVariantIter iter;
+    const gchar* path;
+    GVariant* state;
+
+    g_variant_iter_init(&iter, states);
+
+    while (g_variant_iter_loop(&iter, "(&sv)", &path, &state))
+      paths.push_back(path);
+
+    return paths;
+  }
+
+  std::vector<std::vector<std::string>> States(std::vector<std::string> const& queries)
+  {
+    glib::Variant reply(impl::GetStates(&root, queries));
+    EXPECT_TRUE(g_variant_is_of_type(reply, G_VARIANT_TYPE("(aa(sv))")));
+
+    std::vector<std::vector<std::string>> results;
+    glib::Variant states(g_variant_get_child_value(reply, 0), glib::StealRef());
+
+    for (gsize i = 0; i < g_variant_n_children(states); ++i)
+      results.push_back(Paths(glib::Variant(g_variant_get_child_value(states, i), glib::StealRef())));
+
+    return results;
+  }
+
+  TestNode root;
+  TestNode launcher;
+  TestNode panel;
+  TestNode icon;
+};
+
+TEST_F(TestDebugDBusInterface, GetState)
+{
+  glib::Variant reply(impl::GetState(&root, "/Unity/Launcher"));
+  ASSERT_TRUE(g_variant_is_of_type(reply, G_VARIANT_TYPE("(a(sv))")));
+
+  glib::Variant states(g_variant_get_child_value(reply, 0), glib::StealRef());
+  EXPECT_THAT(Paths(states), ElementsAre("/Unity/Launcher"));
+}
+
+TEST_F(TestDebugDBusInterface, GetStates)
+{
+  auto const& results = States({"/Unity/Launcher", "//Panel", "//LauncherIcon", "//Missing"});
+
+  ASSERT_EQ(4u, results.size());
+  EXPECT_THAT(results[0], ElementsAre("/Unity/Launcher"));
+  EXPECT_THAT(results[1], ElementsAre("/Unity/Panel"));
+  EXPECT_THAT(results[2], ElementsAre("/Unity/Launcher/LauncherIcon"));
+  EXPECT_THAT(results[3], IsEmpty());
+}
+
+TEST_F(TestDebugDBusInterface, GetStatesMatchesProperties)
+{
+  auto const& results = States({"/Unity/*[visible=True]", "/Unity/*[visible=False]", "//*[label=LauncherIcon]"});
+
+  ASSERT_EQ(3u, results.size());
+  EXPECT_THAT(results[0], ElementsAre("/Unity/Launcher"));
+  EXPECT_THAT(results[1], ElementsAre("/Unity/Panel"));
+  EXPECT_THAT(results[2], ElementsAre("/Unity/Launcher/LauncherIcon"));
+}
+
+TEST_F(TestDebugDBusInterface, GetStatesIntrospectsNodesOnce)
+{
+  States({"//Launcher", "/Unity/Launcher[visible=True]", "//*[label=Launcher]"});
+  EXPECT_EQ(1u, launcher.introspections);
+}
+
+TEST_F(TestDebugDBusInterface, ChildrenAreRefreshed)
+{
+  auto adapter = std::make_shared<impl::IntrospectableAdapter>(&root);
+  auto const& children = adapter->Children();
+  ASSERT_EQ(2u, children.size());
+
+  TestNode dash("Dash");
+  root.AddChild(&dash);
+
+  auto const& added = adapter->Children();
+  ASSERT_EQ(3u, added.size());
+  EXPECT_EQ(children[0], added[0]);
+  EXPECT_EQ(children[1], added[1]);
+  EXPECT_EQ("/Unity/Dash", added[2]->GetPath());
+
+  root.RemoveChild(&launcher);
+
+  auto const& removed = adapter->Children();
+  ASSERT_EQ(2u, removed.size());
+  EXPECT_EQ(children[1], removed[0]);
+  EXPECT_EQ(added[2], removed[1]);
+
+  root.RemoveChild(&dash);
+}
+
+TEST_F(TestDebugDBusInterface, GetStatesAfterChildrenChanges)
+{
+  TestNode dash("Dash");
+  root.AddChild(&dash);
+  root.RemoveChild(&panel);
+
+  auto const& results = States({"/Unity/*"});
+  ASSERT_EQ(1u, results.size());
+  EXPECT_THAT(results[0], ElementsAre("/Unity/Launcher", "/Unity/Dash"));
+
+  root.RemoveChild(&dash);
+}
+
+TEST_F(TestDebugDBusInterface, DeadParent)
+{
+  auto adapter = std::make_shared<impl::IntrospectableAdapter>(&root);
+  auto child = std::static_pointer_cast<impl::IntrospectableAdapter const>(adapter->Children().front());
+  ASSERT_EQ(adapter, child->GetParent());
+
+  adapter.reset();
+  EXPECT_EQ(nullptr, child->GetParent());
+  EXPECT_EQ("/Unity/Launcher", child->GetPath());
+  EXPECT_TRUE(child->MatchBooleanProperty("visible", true));
+
+  auto const& grand_children = child->Children();
+  ASSERT_EQ(1u, grand_children.size());
+  EXPECT_EQ(child, grand_children[0]->GetParent());
+  EXPECT_EQ("/Unity/Launcher/LauncherIcon", grand_children[0]->GetPath());
+}
+
+} // anonymous namespace
+} // debug namespace
+} // unity namespace
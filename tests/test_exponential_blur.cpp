@@ -0,0 +1,174 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <cmath>
+#include <vector>
+#include "unity-shared/ExponentialBlur.h"
+#include "test_utils.h"
+
+namespace unity
+{
+namespace
+{
+
+// The implementation used by dash::Style::Blur before the switch to ExponentialBlur
+namespace old
+{
+inline void blurinner(guchar* pixel, gint* zR, gint* zG, gint* zB, gint* zA,
+                      gint alpha, gint aprec, gint zprec)
+{
+  gint r = *pixel;
+  gint g = *(pixel + 1);
+  gint b = *(pixel + 2);
+  guchar a = *(pixel + 3);
+
+  *zR += (alpha * ((r << zprec) - *zR)) >> aprec;
+  *zG += (alpha * ((g << zprec) - *zG)) >> aprec;
+  *zB += (alpha * ((b << zprec) - *zB)) >> aprec;
+  *zA += (alpha * ((a << zprec) - *zA)) >> aprec;
+
+  *pixel       = *zR >> zprec;
+  *(pixel + 1) = *zG >> zprec;
+  *(pixel + 2) = *zB >> zprec;
+  *(pixel + 3) = *zA >> zprec;
+}
+
+void expblur(guchar* pixels, gint width, gint height, gint channels,
+             gint radius, gint aprec, gint zprec)
+{
+  if (radius < 1)
+    return;
+
+  gint alpha = (gint) ((1 << aprec) * (1.0f - expf (-2.3f / (radius + 1.f))));
+
+  for (gint line = 0; line < height; ++line)
+  {
+    guchar* scanline = &(pixels[line * width * channels]);
+    gint zR = *scanline << zprec;
+    gint zG = *(scanline + 1) << zprec;
+    gint zB = *(scanline + 2) << zprec;
+    gint zA = *(scanline + 3) << zprec;
+
+    for (gint index = 0; index < width; index ++)
+      blurinner(&scanline[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+
+    for (gint index = width - 2; index >= 0; index--)
+      blurinner(&scanline[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+  }
+
+  for (gint x = 0; x < width; ++x)
+  {
+    guchar* ptr = pixels + x * channels;
+    gint zR = *(ptr    ) << zprec;
+    gint zG = *(ptr + 1) << zprec;
+    gint zB = *(ptr + 2) << zprec;
+    gint zA = *(ptr + 3) << zprec;
+
+    for (gint index = width; index < (height - 1) * width; index += width)
+      blurinner(&ptr[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+
+    for (gint index = (height - 2) * width; index >= 0; index -= width)
+      blurinner(&ptr[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+  }
+}
+}
+
+std::vector<guchar> RandomPixels(int width, int height, guint32 seed)
+{
+  std::vector<guchar> pixels(width * height * 4);
+  GRand* rand = g_rand_new_with_seed(seed);
+
+  for (auto& p : pixels)
+    p = g_rand_int_range(rand, 0, 256);
+
+  g_rand_free(rand);
+  return pixels;
+}
+
+struct Size
+{
+  int width;
+  int height;
+};
+
+class TestExponentialBlur : public TestWithParam<std::tuple<Size, int>>
+{};
+
+TEST_P(TestExponentialBlur, SameAsOldImplementation)
+{
+  Size size = std::get<0>(GetParam());
+  int radius = std::get<1>(GetParam());
+
+  auto expected = RandomPixels(size.width, size.height, size.width * size.height);
+  auto pixels = expected;
+
+  old::expblur(expected.data(), size.width, size.height, 4, radius, 16, 7);
+  graphics::ExponentialBlur(pixels.data(), size.width, size.height, 4, radius);
+
+  EXPECT_EQ(expected, pixels);
+}
+
+INSTANTIATE_TEST_CASE_P(TestExponentialBlurSizes, TestExponentialBlur,
+  Combine(Values(Size{1, 1}, Size{1, 7}, Size{7, 1}, Size{2, 2}, Size{33, 31},
+                 Size{150, 40}, Size{300, 300}, Size{640, 480}),
+          Values(1, 3, 6, 20)));
+
+TEST(TestExponentialBlurEmpty, NoRadiusIsNoop)
+{
+  auto expected = RandomPixels(10, 10, 0);
+  auto pixels = expected;
+
+  graphics::ExponentialBlur(pixels.data(), 10, 10, 4, 0);
+  EXPECT_EQ(expected, pixels);
+}
+
+TEST(TestExponentialBlurBenchmark, BENCHMARK_TEST(DashTextures))
+{
+  // Buttons, search bar, scope bar and preview sized textures
+  std::vector<Size> sizes = {{150, 40}, {660, 42}, {960, 48}, {770, 380}};
+
+  for (double scale : {1.0, 1.5, 2.0})
+  {
+    for (auto const& base : sizes)
+    {
+      int width = std::round(base.width * scale);
+      int height = std::round(base.height * scale);
+      auto pixels = RandomPixels(width, height, width);
+      int radius = std::round(6 * scale);
+
+      double old_usec = Utils::BenchmarkUSec([&] {
+        old::expblur(pixels.data(), width, height, 4, radius, 16, 7);
+      }, 20);
+
+      double new_usec = Utils::BenchmarkUSec([&] {
+        graphics::ExponentialBlur(pixels.data(), width, height, 4, radius);
+      }, 20);
+
+      auto const& prefix = std::to_string(width) + "x" + std::to_string(height) + "_";
+      RecordProperty(prefix + "old_usec", std::to_string(old_usec));
+      RecordProperty(prefix + "new_usec", std::to_string(new_usec));
+    }
+  }
+}
+
+} // anonymous namespace
+} // unity namespace
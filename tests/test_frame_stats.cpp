@@ -0,0 +1,228 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <glib/gstdio.h>
+#include <UnityCore/GLibWrapper.h>
+#include <UnityCore/Variant.h>
+#include "unity-shared/FrameStats.h"
+
+namespace unity
+{
+namespace debug
+{
+namespace
+{
+
+typedef FrameStats::Phase Phase;
+
+void RecordFrame(FrameStats& stats, unsigned iterations = 1, uint64_t blurred_pixels = 0)
+{
+  stats.BeginFrame();
+  {
+    FrameStats::ScopedPhase phase(stats, Phase::DAMAGE_CUTOFF);
+
+    if (auto* frame = stats.current())
+    {
+      frame->damage_cutoff_iterations = iterations;
+      frame->blurred_pixels = blurred_pixels;
+      frame->blur_partial_updates = blurred_pixels ? 1 : 0;
+    }
+  }
+  stats.EndFrame();
+}
+
+glib::Variant PropertyValue(glib::Variant const& props, std::string const& name)
+{
+  glib::Variant value(g_variant_lookup_value(props, name.c_str(), nullptr), glib::StealRef());
+
+  if (!value)
+    return glib::Variant();
+
+  glib::Variant child(g_variant_get_child_value(value, 1), glib::StealRef());
+  return child.GetVariant();
+}
+
+TEST(TestFrameStats, Construct)
+{
+  FrameStats stats(10);
+  EXPECT_FALSE(stats.IsEnabled());
+  EXPECT_EQ(10u, stats.capacity());
+  EXPECT_EQ(0u, stats.size());
+  EXPECT_EQ(nullptr, stats.current());
+  EXPECT_TRUE(stats.Frames().empty());
+}
+
+TEST(TestFrameStats, RecordsFrame)
+{
+  FrameStats stats(10);
+  stats.SetEnabled(true);
+  stats.BeginFrame();
+  ASSERT_NE(nullptr, stats.current());
+
+  stats.AddPhaseTime(Phase::GL_PAINT_OUTPUT, 100, 5);
+  stats.AddPhaseTime(Phase::GL_PAINT_OUTPUT, 200, 7);
+  stats.current()->damage_rects = 3;
+  stats.EndFrame();
+
+  EXPECT_EQ(nullptr, stats.current());
+  auto const& frames = stats.Frames();
+  ASSERT_EQ(1u, frames.size());
+
+  auto const& phase = frames[0].phases[unsigned(Phase::GL_PAINT_OUTPUT)];
+  EXPECT_EQ(100, phase.start);
+  EXPECT_EQ(12, phase.duration);
+  EXPECT_EQ(2u, phase.calls);
+  EXPECT_EQ(3u, frames[0].damage_rects);
+  EXPECT_EQ(1u, frames[0].sequence);
+  EXPECT_LE(frames[0].start, frames[0].end);
+}
+
+TEST(TestFrameStats, ScopedPhaseOutsideFrameIsIgnored)
+{
+  FrameStats stats(10);
+  stats.SetEnabled(true);
+  {
+    FrameStats::ScopedPhase phase(stats, Phase::PAINT_OUTPUT);
+  }
+  stats.EndFrame();
+
+  EXPECT_EQ(0u, stats.size());
+  EXPECT_EQ(0u, stats.total_frames());
+}
+
+TEST(TestFrameStats, RingWrapsAround)
+{
+  FrameStats stats(4);
+  stats.SetEnabled(true);
+
+  for (unsigned i = 1; i <= 10; ++i)
+    RecordFrame(stats, i);
+
+  EXPECT_EQ(4u, stats.size());
+  EXPECT_EQ(10u, stats.total_frames());
+
+  auto const& frames = stats.Frames();
+  ASSERT_EQ(4u, frames.size());
+
+  for (unsigned i = 0; i < frames.size(); ++i)
+  {
+    EXPECT_EQ(7 + i, frames[i].sequence);
+    EXPECT_EQ(7 + i, frames[i].damage_cutoff_iterations);
+    EXPECT_EQ(1u, frames[i].phases[unsigned(Phase::DAMAGE_CUTOFF)].calls);
+  }
+}
+
+TEST(TestFrameStats, UnfinishedFrameIsClosedOnBegin)
+{
+  FrameStats stats(4);
+  stats.SetEnabled(true);
+  stats.BeginFrame();
+  stats.BeginFrame();
+  stats.EndFrame();
+
+  EXPECT_EQ(2u, stats.size());
+}
+
+TEST(TestFrameStats, DisabledRecordsNothing)
+{
+  FrameStats stats(4);
+  RecordFrame(stats);
+
+  EXPECT_FALSE(stats.IsEnabled());
+  EXPECT_EQ(0u, stats.size());
+  EXPECT_EQ(nullptr, stats.current());
+
+  stats.SetEnabled(true);
+  RecordFrame(stats);
+  EXPECT_EQ(1u, stats.size());
+}
+
+TEST(TestFrameStats, Reset)
+{
+  FrameStats stats(4);
+  stats.SetEnabled(true);
+  RecordFrame(stats);
+  RecordFrame(stats);
+  stats.Reset();
+
+  EXPECT_EQ(0u, stats.size());
+  EXPECT_TRUE(stats.Frames().empty());
+}
+
+TEST(TestFrameStats, ChromeTrace)
+{
+  FrameStats stats(4);
+  stats.SetEnabled(true);
+  RecordFrame(stats, 3, 1024);
+
+  auto const& trace = stats.ChromeTrace();
+  EXPECT_THAT(trace, StartsWith("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"frame\""));
+  EXPECT_THAT(trace, HasSubstr("\"damage_cutoff_iterations\":3"));
+  EXPECT_THAT(trace, HasSubstr("\"blurred_pixels\":1024"));
+  EXPECT_THAT(trace, HasSubstr("\"blur_partial_updates\":1"));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"damage_cutoff\""));
+  EXPECT_THAT(trace, Not(HasSubstr("\"name\":\"paint_output\"")));
+}
+
+TEST(TestFrameStats, DumpChromeTrace)
+{
+  FrameStats stats(4);
+  stats.SetEnabled(true);
+  RecordFrame(stats);
+
+  glib::String path(g_build_filename(g_get_tmp_dir(), "unity-test-frame-stats.json", nullptr));
+  ASSERT_TRUE(stats.DumpChromeTrace(path.Str()));
+
+  gchar* contents = nullptr;
+  ASSERT_TRUE(g_file_get_contents(path, &contents, nullptr, nullptr));
+  EXPECT_EQ(stats.ChromeTrace(), glib::String(contents).Str());
+  g_unlink(path);
+
+  EXPECT_FALSE(stats.DumpChromeTrace("/this/path/does/not/exist/trace.json"));
+}
+
+TEST(TestFrameStats, Introspection)
+{
+  FrameStats stats(4);
+  stats.SetEnabled(true);
+  RecordFrame(stats, 2, 300);
+  RecordFrame(stats, 4, 100);
+
+  IntrospectionData data;
+  stats.AddProperties(data);
+  glib::Variant props(data.Get());
+
+  EXPECT_EQ(2u, PropertyValue(props, "frames").GetUInt64());
+  EXPECT_EQ(4u, PropertyValue(props, "max_damage_cutoff_iterations").GetUInt32());
+  EXPECT_DOUBLE_EQ(3.0, PropertyValue(props, "average_damage_cutoff_iterations").GetDouble());
+  EXPECT_EQ(300u, PropertyValue(props, "max_blurred_pixels").GetUInt64());
+  EXPECT_EQ(100u, PropertyValue(props, "last_blurred_pixels").GetUInt64());
+  EXPECT_DOUBLE_EQ(200.0, PropertyValue(props, "average_blurred_pixels").GetDouble());
+  EXPECT_EQ(2u, PropertyValue(props, "blur_partial_updates").GetUInt32());
+  EXPECT_TRUE(PropertyValue(props, "damage_cutoff_average_usec"));
+  EXPECT_TRUE(PropertyValue(props, "done_paint_max_usec"));
+}
+
+} // anonymous namespace
+} // debug namespace
+} // unity namespace
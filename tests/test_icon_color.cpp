@@ -0,0 +1,242 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <UnityCore/GLibWrapper.h>
+#include "unity-shared/IconColor.h"
+#include "test_utils.h"
+
+namespace unity
+{
+namespace
+{
+
+glib::Object<GdkPixbuf> CreatePixbuf(int size, guint32 seed, bool has_alpha = true)
+{
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, has_alpha, 8, size, size));
+  GRand* rand = g_rand_new_with_seed(seed);
+  guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  int n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+
+  for (int j = 0; j < size; ++j)
+    for (int i = 0; i < size * n_channels; ++i)
+      pixels[j * rowstride + i] = g_rand_int_range(rand, 0, 256);
+
+  g_rand_free(rand);
+  return pixbuf;
+}
+
+glib::Object<GdkPixbuf> CreateSolidPixbuf(guint32 rgba)
+{
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 16, 16));
+  gdk_pixbuf_fill(pixbuf, rgba);
+  return pixbuf;
+}
+
+// The implementation used by LauncherIcon::ColorForIcon before the switch to IconColor
+nux::color::RedGreenBlue OldAverage(GdkPixbuf* pixbuf)
+{
+  unsigned int width = gdk_pixbuf_get_width(pixbuf);
+  unsigned int height = gdk_pixbuf_get_height(pixbuf);
+  unsigned int row_bytes = gdk_pixbuf_get_rowstride(pixbuf);
+
+  long int rtotal = 0, gtotal = 0, btotal = 0;
+  float total = 0.0f;
+
+  guchar* img = gdk_pixbuf_get_pixels(pixbuf);
+
+  for (unsigned int i = 0; i < width; i++)
+  {
+    for (unsigned int j = 0; j < height; j++)
+    {
+      guchar* pixels = img + (j * row_bytes + i * 4);
+      guchar r = *(pixels + 0);
+      guchar g = *(pixels + 1);
+      guchar b = *(pixels + 2);
+      guchar a = *(pixels + 3);
+
+      float saturation = (MAX(r, MAX(g, b)) - MIN(r, MIN(g, b))) / 255.0f;
+      float relevance = .1 + .9 * (a / 255.0f) * saturation;
+
+      rtotal += (guchar)(r * relevance);
+      gtotal += (guchar)(g * relevance);
+      btotal += (guchar)(b * relevance);
+
+      total += relevance * 255;
+    }
+  }
+
+  return nux::color::RedGreenBlue(rtotal / total, gtotal / total, btotal / total);
+}
+
+TEST(TestIconColor, InvalidPixbufIsWhite)
+{
+  auto rgb = icon_color::Average(nullptr);
+  EXPECT_FLOAT_EQ(1.0f, rgb.red);
+  EXPECT_FLOAT_EQ(1.0f, rgb.green);
+  EXPECT_FLOAT_EQ(1.0f, rgb.blue);
+}
+
+TEST(TestIconColor, SolidColor)
+{
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 33, 33));
+  gdk_pixbuf_fill(pixbuf, 0xff800000 | 0xff);
+
+  auto rgb = icon_color::Average(pixbuf);
+  EXPECT_FLOAT_EQ(1.0f, rgb.red);
+  EXPECT_FLOAT_EQ(128 / 255.0f, rgb.green);
+  EXPECT_FLOAT_EQ(0.0f, rgb.blue);
+}
+
+TEST(TestIconColor, NoAlphaChannel)
+{
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 17, 17));
+  gdk_pixbuf_fill(pixbuf, 0x00ff0000);
+
+  auto rgb = icon_color::Average(pixbuf);
+  EXPECT_FLOAT_EQ(0.0f, rgb.red);
+  EXPECT_FLOAT_EQ(1.0f, rgb.green);
+  EXPECT_FLOAT_EQ(0.0f, rgb.blue);
+}
+
+TEST(TestIconColor, UnalignedWidthMatchesSubRegion)
+{
+  auto pixbuf = CreatePixbuf(64, 42);
+
+  for (int width : {1, 3, 5, 63})
+  {
+    glib::Object<GdkPixbuf> sub(gdk_pixbuf_new_subpixbuf(pixbuf, 0, 0, width, 64));
+    glib::Object<GdkPixbuf> copy(gdk_pixbuf_copy(sub));
+
+    auto sub_rgb = icon_color::Average(sub);
+    auto copy_rgb = icon_color::Average(copy);
+    EXPECT_FLOAT_EQ(copy_rgb.red, sub_rgb.red);
+    EXPECT_FLOAT_EQ(copy_rgb.green, sub_rgb.green);
+    EXPECT_FLOAT_EQ(copy_rgb.blue, sub_rgb.blue);
+  }
+}
+
+TEST(TestIconColor, MatchesOldImplementation)
+{
+  for (int size : {48, 64, 128, 256})
+  {
+    auto pixbuf = CreatePixbuf(size, size);
+    auto old_rgb = OldAverage(pixbuf);
+    auto rgb = icon_color::Average(pixbuf);
+
+    // The old code was truncating every weighted channel value to an integer
+    EXPECT_NEAR(old_rgb.red, rgb.red, 0.02f);
+    EXPECT_NEAR(old_rgb.green, rgb.green, 0.02f);
+    EXPECT_NEAR(old_rgb.blue, rgb.blue, 0.02f);
+  }
+}
+
+TEST(TestIconColor, MatchesUnvectorizedImplementation)
+{
+  for (int size : {1, 3, 5, 48, 63, 64, 128, 256})
+  {
+    for (bool has_alpha : {true, false})
+    {
+      auto pixbuf = CreatePixbuf(size, size, has_alpha);
+      auto rgb = icon_color::Average(pixbuf);
+      auto plain_rgb = icon_color::AverageUnvectorized(gdk_pixbuf_get_pixels(pixbuf), size, size,
+                                                       gdk_pixbuf_get_rowstride(pixbuf),
+                                                       gdk_pixbuf_get_n_channels(pixbuf));
+      EXPECT_EQ(plain_rgb.red, rgb.red);
+      EXPECT_EQ(plain_rgb.green, rgb.green);
+      EXPECT_EQ(plain_rgb.blue, rgb.blue);
+    }
+  }
+}
+
+TEST(TestIconColor, CacheReturnsCachedColors)
+{
+  icon_color::Cache cache;
+  auto red = CreateSolidPixbuf(0xff0000ff);
+  auto blue = CreateSolidPixbuf(0x0000ffff);
+  auto colors = cache.ForPixbuf("icon", "theme", red);
+
+  EXPECT_EQ(colors.glow, cache.ForPixbuf("icon", "theme", blue).glow);
+  EXPECT_EQ(1u, cache.Size());
+}
+
+TEST(TestIconColor, CacheKeysByThemeName)
+{
+  icon_color::Cache cache;
+  auto pixbuf = CreateSolidPixbuf(0xff0000ff);
+  auto other_pixbuf = CreateSolidPixbuf(0x0000ffff);
+
+  auto colors = cache.ForPixbuf("icon", "theme", pixbuf);
+  auto other_colors = cache.ForPixbuf("icon", "other-theme", other_pixbuf);
+
+  EXPECT_EQ(icon_color::ForPixbuf(pixbuf).glow, colors.glow);
+  EXPECT_EQ(icon_color::ForPixbuf(other_pixbuf).glow, other_colors.glow);
+  EXPECT_EQ(2u, cache.Size());
+}
+
+TEST(TestIconColor, CacheIgnoresUnnamedThemes)
+{
+  icon_color::Cache cache;
+  auto pixbuf = CreateSolidPixbuf(0xff0000ff);
+  auto other_pixbuf = CreateSolidPixbuf(0x0000ffff);
+
+  cache.ForPixbuf("/path/to/icon.png", "", pixbuf);
+  auto colors = cache.ForPixbuf("/path/to/icon.png", "", other_pixbuf);
+
+  EXPECT_EQ(icon_color::ForPixbuf(other_pixbuf).glow, colors.glow);
+  EXPECT_EQ(0u, cache.Size());
+}
+
+TEST(TestIconColor, CacheDropsLeastRecentlyUsed)
+{
+  icon_color::Cache cache(2);
+  auto pixbuf = CreateSolidPixbuf(0xff0000ff);
+  auto other_pixbuf = CreateSolidPixbuf(0x0000ffff);
+
+  cache.ForPixbuf("first", "theme", pixbuf);
+  cache.ForPixbuf("second", "theme", pixbuf);
+  cache.ForPixbuf("first", "theme", pixbuf);
+  cache.ForPixbuf("third", "theme", pixbuf);
+  ASSERT_EQ(2u, cache.Size());
+
+  EXPECT_EQ(icon_color::ForPixbuf(pixbuf).glow, cache.ForPixbuf("first", "theme", other_pixbuf).glow);
+  EXPECT_EQ(icon_color::ForPixbuf(other_pixbuf).glow, cache.ForPixbuf("second", "theme", other_pixbuf).glow);
+  EXPECT_EQ(2u, cache.Size());
+}
+
+TEST(TestIconColor, BENCHMARK_TEST(Benchmark))
+{
+  for (int size : {48, 64, 128, 256})
+  {
+    auto pixbuf = CreatePixbuf(size, size);
+
+    double old_usec = Utils::BenchmarkUSec([&pixbuf] { OldAverage(pixbuf); });
+    double new_usec = Utils::BenchmarkUSec([&pixbuf] { icon_color::Average(pixbuf); });
+
+    auto const& prefix = std::to_string(size) + "px_";
+    RecordProperty(prefix + "old_usec", std::to_string(old_usec));
+    RecordProperty(prefix + "new_usec", std::to_string(new_usec));
+  }
+}
+
+} // anonymous namespace
+} // unity namespace
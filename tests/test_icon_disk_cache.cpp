@@ -0,0 +1,331 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <glib/gstdio.h>
+#include <utime.h>
+#include <UnityCore/GLibWrapper.h>
+#include "unity-shared/IconDiskCache.h"
+#include "test_utils.h"
+
+namespace unity
+{
+namespace
+{
+
+glib::Object<GdkPixbuf> CreatePixbuf(int width, int height, guint32 seed, bool has_alpha = true)
+{
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, has_alpha, 8, width, height));
+  GRand* rand = g_rand_new_with_seed(seed);
+  guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  int n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+
+  for (int j = 0; j < height; ++j)
+    for (int i = 0; i < width * n_channels; ++i)
+      pixels[j * rowstride + i] = g_rand_int_range(rand, 0, 256);
+
+  g_rand_free(rand);
+  return pixbuf;
+}
+
+bool SamePixels(GdkPixbuf* a, GdkPixbuf* b)
+{
+  if (gdk_pixbuf_get_width(a) != gdk_pixbuf_get_width(b) ||
+      gdk_pixbuf_get_height(a) != gdk_pixbuf_get_height(b) ||
+      gdk_pixbuf_get_has_alpha(a) != gdk_pixbuf_get_has_alpha(b))
+  {
+    return false;
+  }
+
+  int row_length = gdk_pixbuf_get_width(a) * gdk_pixbuf_get_n_channels(a);
+
+  for (int j = 0; j < gdk_pixbuf_get_height(a); ++j)
+  {
+    auto* row_a = gdk_pixbuf_get_pixels(a) + j * gdk_pixbuf_get_rowstride(a);
+    auto* row_b = gdk_pixbuf_get_pixels(b) + j * gdk_pixbuf_get_rowstride(b);
+
+    if (memcmp(row_a, row_b, row_length) != 0)
+      return false;
+  }
+
+  return true;
+}
+
+std::vector<std::string> ListDirectory(std::string const& directory)
+{
+  std::vector<std::string> files;
+
+  if (GDir* dir = g_dir_open(directory.c_str(), 0, nullptr))
+  {
+    while (const gchar* name = g_dir_read_name(dir))
+      files.push_back(directory + G_DIR_SEPARATOR_S + name);
+
+    g_dir_close(dir);
+  }
+
+  return files;
+}
+
+struct TestIconDiskCache : Test
+{
+  TestIconDiskCache()
+    : root(g_dir_make_tmp("unity-test-icon-cache-XXXXXX", nullptr))
+  {}
+
+  ~TestIconDiskCache()
+  {
+    for (auto const& dir : ListDirectory(root.Str()))
+    {
+      for (auto const& file : ListDirectory(dir))
+        g_unlink(file.c_str());
+
+      g_rmdir(dir.c_str());
+    }
+
+    g_rmdir(root);
+  }
+
+  glib::String root;
+};
+
+TEST_F(TestIconDiskCache, Construct)
+{
+  IconDiskCache cache(root.Str(), "stamp");
+  EXPECT_THAT(cache.directory(), StartsWith(root.Str()));
+  EXPECT_TRUE(g_file_test(cache.directory().c_str(), G_FILE_TEST_IS_DIR));
+}
+
+TEST_F(TestIconDiskCache, LookupMissing)
+{
+  IconDiskCache cache(root.Str(), "stamp");
+  EXPECT_FALSE(cache.Lookup("0:missing-icon:48x48"));
+}
+
+TEST_F(TestIconDiskCache, StoreAndLookup)
+{
+  IconDiskCache cache(root.Str(), "stamp");
+
+  for (bool has_alpha : {true, false})
+  {
+    // Odd widths have a padded rowstride without alpha
+    auto const& pixbuf = CreatePixbuf(33, 17, 5, has_alpha);
+    auto const& key = "0:icon-" + std::to_string(has_alpha) + ":33x17";
+
+    ASSERT_TRUE(cache.Store(key, pixbuf));
+    auto const& cached = cache.Lookup(key);
+
+    ASSERT_TRUE(cached);
+    EXPECT_TRUE(SamePixels(pixbuf, cached));
+  }
+}
+
+TEST_F(TestIconDiskCache, CachedPixbufCanBeModified)
+{
+  IconDiskCache cache(root.Str(), "stamp");
+  auto const& pixbuf = CreatePixbuf(16, 16, 1);
+  ASSERT_TRUE(cache.Store("key", pixbuf));
+
+  auto const& cached = cache.Lookup("key");
+  ASSERT_TRUE(cached);
+  gdk_pixbuf_fill(cached, 0xff0000ff);
+
+  EXPECT_TRUE(SamePixels(pixbuf, cache.Lookup("key")));
+}
+
+TEST_F(TestIconDiskCache, PersistsWithSameStamp)
+{
+  auto const& pixbuf = CreatePixbuf(24, 24, 2);
+  {
+    IconDiskCache cache(root.Str(), "stamp");
+    ASSERT_TRUE(cache.Store("key", pixbuf));
+  }
+
+  IconDiskCache cache(root.Str(), "stamp");
+  auto const& cached = cache.Lookup("key");
+  ASSERT_TRUE(cached);
+  EXPECT_TRUE(SamePixels(pixbuf, cached));
+}
+
+TEST_F(TestIconDiskCache, StampChangeInvalidates)
+{
+  std::string old_directory;
+  {
+    IconDiskCache cache(root.Str(), "old-stamp");
+    old_directory = cache.directory();
+    ASSERT_TRUE(cache.Store("key", CreatePixbuf(24, 24, 3)));
+  }
+
+  IconDiskCache cache(root.Str(), "new-stamp");
+  EXPECT_NE(old_directory, cache.directory());
+  EXPECT_FALSE(cache.Lookup("key"));
+  EXPECT_FALSE(g_file_test(old_directory.c_str(), G_FILE_TEST_EXISTS));
+  EXPECT_EQ(1u, ListDirectory(root.Str()).size());
+}
+
+TEST_F(TestIconDiskCache, InvalidEntriesAreRemoved)
+{
+  IconDiskCache cache(root.Str(), "stamp");
+  ASSERT_TRUE(cache.Store("key", CreatePixbuf(24, 24, 4)));
+
+  auto const& files = ListDirectory(cache.directory());
+  ASSERT_EQ(1u, files.size());
+  ASSERT_TRUE(g_file_set_contents(files[0].c_str(), "garbage", -1, nullptr));
+
+  EXPECT_FALSE(cache.Lookup("key"));
+  EXPECT_TRUE(ListDirectory(cache.directory()).empty());
+}
+
+TEST_F(TestIconDiskCache, Clear)
+{
+  IconDiskCache cache(root.Str(), "stamp");
+  ASSERT_TRUE(cache.Store("key1", CreatePixbuf(24, 24, 5)));
+  ASSERT_TRUE(cache.Store("key2", CreatePixbuf(24, 24, 6)));
+
+  cache.Clear();
+  EXPECT_FALSE(cache.Lookup("key1"));
+  EXPECT_FALSE(cache.Lookup("key2"));
+}
+
+TEST_F(TestIconDiskCache, MaxEntriesOnStore)
+{
+  IconDiskCache cache(root.Str(), "stamp", 3);
+
+  for (unsigned i = 0; i < 3; ++i)
+    ASSERT_TRUE(cache.Store("key" + std::to_string(i), CreatePixbuf(8, 8, i)));
+
+  ASSERT_EQ(3u, ListDirectory(cache.directory()).size());
+
+  // Replacing an entry doesn't add a new one
+  ASSERT_TRUE(cache.Store("key0", CreatePixbuf(8, 8, 10)));
+  ASSERT_EQ(3u, ListDirectory(cache.directory()).size());
+
+  ASSERT_TRUE(cache.Store("key3", CreatePixbuf(8, 8, 3)));
+  EXPECT_EQ(1u, ListDirectory(cache.directory()).size());
+  EXPECT_TRUE(cache.Lookup("key3"));
+  EXPECT_FALSE(cache.Lookup("key0"));
+
+  ASSERT_TRUE(cache.Store("key4", CreatePixbuf(8, 8, 4)));
+  EXPECT_EQ(2u, ListDirectory(cache.directory()).size());
+}
+
+TEST_F(TestIconDiskCache, MaxEntriesAfterInvalidEntries)
+{
+  IconDiskCache cache(root.Str(), "stamp", 3);
+
+  for (unsigned i = 0; i < 3; ++i)
+    ASSERT_TRUE(cache.Store("key" + std::to_string(i), CreatePixbuf(8, 8, i)));
+
+  for (auto const& file : ListDirectory(cache.directory()))
+    ASSERT_TRUE(g_file_set_contents(file.c_str(), "garbage", -1, nullptr));
+
+  for (unsigned i = 0; i < 3; ++i)
+    ASSERT_FALSE(cache.Lookup("key" + std::to_string(i)));
+
+  // The removed entries don't count anymore, so nothing is cleared
+  for (unsigned i = 3; i < 6; ++i)
+    ASSERT_TRUE(cache.Store("key" + std::to_string(i), CreatePixbuf(8, 8, i)));
+
+  EXPECT_EQ(3u, ListDirectory(cache.directory()).size());
+  EXPECT_TRUE(cache.Lookup("key3"));
+}
+
+TEST_F(TestIconDiskCache, MaxEntriesOnConstruction)
+{
+  {
+    IconDiskCache cache(root.Str(), "stamp");
+
+    for (unsigned i = 0; i < 3; ++i)
+      ASSERT_TRUE(cache.Store("key" + std::to_string(i), CreatePixbuf(8, 8, i)));
+  }
+
+  IconDiskCache cache(root.Str(), "stamp", 2);
+  EXPECT_TRUE(ListDirectory(cache.directory()).empty());
+}
+
+TEST_F(TestIconDiskCache, ThemeStampChecksDirectories)
+{
+  auto const& icons_dir = root.Str() + G_DIR_SEPARATOR_S "icons";
+  auto const& theme_dir = icons_dir + G_DIR_SEPARATOR_S "hicolor";
+  auto const& apps_dir = theme_dir + G_DIR_SEPARATOR_S "apps";
+  auto const& icon_path = apps_dir + G_DIR_SEPARATOR_S "icon.png";
+  ASSERT_EQ(0, g_mkdir_with_parents(apps_dir.c_str(), 0700));
+
+  struct utimbuf old_time = { 1000, 1000 };
+  g_utime(apps_dir.c_str(), &old_time);
+  g_utime(theme_dir.c_str(), &old_time);
+  g_utime(icons_dir.c_str(), &old_time);
+
+  glib::Object<GtkIconTheme> theme(gtk_icon_theme_new());
+  const gchar* search_path[] = { icons_dir.c_str() };
+  gtk_icon_theme_set_search_path(theme, search_path, G_N_ELEMENTS(search_path));
+
+  auto const& stamp = IconDiskCache::ThemeStamp(theme);
+  EXPECT_EQ(stamp, IconDiskCache::ThemeStamp(theme));
+
+  // Files and nested folders are not checked
+  ASSERT_TRUE(g_file_set_contents(icon_path.c_str(), "icon", -1, nullptr));
+  EXPECT_EQ(stamp, IconDiskCache::ThemeStamp(theme));
+
+  // A theme update replaces its icon-theme.cache, changing the folder time
+  struct utimbuf new_time = { 2000, 2000 };
+  g_utime(theme_dir.c_str(), &new_time);
+  EXPECT_NE(stamp, IconDiskCache::ThemeStamp(theme));
+
+  g_unlink(icon_path.c_str());
+  g_rmdir(apps_dir.c_str());
+  g_rmdir(theme_dir.c_str());
+}
+
+TEST_F(TestIconDiskCache, InvalidDirectory)
+{
+  IconDiskCache cache("", "stamp");
+  EXPECT_FALSE(cache.Store("key", CreatePixbuf(24, 24, 7)));
+  EXPECT_FALSE(cache.Lookup("key"));
+}
+
+TEST_F(TestIconDiskCache, BENCHMARK_TEST(Benchmark))
+{
+  IconDiskCache cache(root.Str(), "stamp");
+  auto const& png_path = root.Str() + G_DIR_SEPARATOR_S "icon.png";
+  ASSERT_TRUE(gdk_pixbuf_save(CreatePixbuf(256, 256, 8), png_path.c_str(), "png", nullptr, nullptr));
+
+  for (int size : {32, 48, 64, 128})
+  {
+    auto const& key = "0:icon:" + std::to_string(size);
+    glib::Object<GdkPixbuf> scaled(gdk_pixbuf_new_from_file_at_scale(png_path.c_str(), size, size, TRUE, nullptr));
+    ASSERT_TRUE(cache.Store(key, scaled));
+
+    double old_usec = Utils::BenchmarkUSec([&png_path, size] {
+      glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new_from_file_at_scale(png_path.c_str(), size, size, TRUE, nullptr));
+    }, 20);
+    double new_usec = Utils::BenchmarkUSec([&cache, &key] { cache.Lookup(key); }, 20);
+
+    auto const& prefix = std::to_string(size) + "px_";
+    RecordProperty(prefix + "old_usec", std::to_string(old_usec));
+    RecordProperty(prefix + "new_usec", std::to_string(new_usec));
+  }
+
+  g_unlink(png_path.c_str());
+}
+
+} // anonymous namespace
+} // unity namespace
@@ -17,6 +17,7 @@
  * Authored by: Michal Hruby <michal.hruby@canonical.com>
  */
 
+#include <config.h>
 #include <gmock/gmock.h>
 #include <sigc++/sigc++.h>
 
@@ -231,5 +232,88 @@ TEST_F(TestIconLoader, UNSTABLE_TEST (TestCancelSome))
   CheckResults(results);
 }
 
+struct TestIconLoaderPriorities : testing::Test
+{
+  struct PausedIconLoader : IconLoader
+  {
+    // A single worker, so that tasks are completed in the queue order
+    PausedIconLoader() : IconLoader(1, true) {}
+    using IconLoader::SetWorkersPaused;
+  };
+
+  TestIconLoaderPriorities()
+  {
+    // Disk cached icons would be returned synchronously
+    g_setenv("UNITY_ICON_LOADER_NO_DISK_CACHE", "1", TRUE);
+    icon_loader.reset(new PausedIconLoader());
+  }
+
+  ~TestIconLoaderPriorities()
+  {
+    icon_loader.reset();
+    g_unsetenv("UNITY_ICON_LOADER_NO_DISK_CACHE");
+  }
+
+  void Load(int id, int size, IconLoader::Priority priority)
+  {
+    auto handle = icon_loader->LoadFromFilename(BUILDDIR"/tests/data/bfb.png", -1, size,
+      [this, id] (std::string const&, int, int, glib::Object<GdkPixbuf> const& pixbuf) {
+        EXPECT_TRUE(IsValidPixbuf(pixbuf));
+        completed.push_back(id);
+      }, priority);
+
+    ASSERT_NE(0u, handle);
+  }
+
+  std::unique_ptr<PausedIconLoader> icon_loader;
+  std::vector<int> completed;
+};
+
+TEST_F(TestIconLoaderPriorities, VisibleBeforePreloadBeforeBackground)
+{
+  Load(0, 24, IconLoader::Priority::BACKGROUND);
+  Load(1, 26, IconLoader::Priority::BACKGROUND);
+  Load(2, 28, IconLoader::Priority::BACKGROUND);
+  Load(3, 30, IconLoader::Priority::PRELOAD);
+  Load(4, 32, IconLoader::Priority::VISIBLE);
+
+  icon_loader->SetWorkersPaused(false);
+  Utils::WaitUntilMSec([this] { return completed.size() == 5; }, true, WAIT_TIMEOUT);
+
+  EXPECT_THAT(completed, ElementsAre(4, 3, 0, 1, 2));
+}
+
+TEST_F(TestIconLoaderPriorities, DuplicateRequestBumpsPriority)
+{
+  Load(0, 24, IconLoader::Priority::BACKGROUND);
+  Load(1, 26, IconLoader::Priority::BACKGROUND);
+  Load(2, 26, IconLoader::Priority::VISIBLE);
+
+  icon_loader->SetWorkersPaused(false);
+  Utils::WaitUntilMSec([this] { return completed.size() == 3; }, true, WAIT_TIMEOUT);
+
+  EXPECT_THAT(completed, ElementsAre(1, 2, 0));
+}
+
+TEST_F(TestIconLoader, TestCancelAllQueued)
+{
+  std::vector<LoadResult> results(10);
+
+  for (auto& result : results)
+  {
+    auto handle = icon_loader.LoadFromIconName("gtk-about", -1, 42,
+      sigc::mem_fun(result, &LoadResult::IconLoaded), IconLoader::Priority::BACKGROUND);
+
+    // Icons already in the disk cache are returned synchronously
+    if (handle)
+    {
+      icon_loader.DisconnectHandle(handle);
+      result.disconnected = true;
+    }
+  }
+
+  CheckResults(results);
+}
+
 
 }
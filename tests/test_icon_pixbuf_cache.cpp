@@ -0,0 +1,173 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include "unity-shared/IconPixbufCache.h"
+
+namespace unity
+{
+namespace
+{
+
+typedef IconPixbufCache::Key Key;
+typedef IconPixbufCache::Pool Pool;
+
+glib::Object<GdkPixbuf> CreatePixbuf(int size)
+{
+  return glib::Object<GdkPixbuf>(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, size, size));
+}
+
+TEST(TestIconPixbufCache, KeyEquality)
+{
+  EXPECT_EQ(Key(Pool::ICON_NAME, "foo", 48, 48), Key(Pool::ICON_NAME, "foo", 48, 48));
+  EXPECT_NE(Key(Pool::ICON_NAME, "foo", 48, 48), Key(Pool::GICON_STRING, "foo", 48, 48));
+  EXPECT_NE(Key(Pool::ICON_NAME, "foo", 48, 48), Key(Pool::ICON_NAME, "bar", 48, 48));
+  EXPECT_NE(Key(Pool::ICON_NAME, "foo", 48, 48), Key(Pool::ICON_NAME, "foo", 48, -1));
+  EXPECT_NE(Key(Pool::ICON_NAME, "foo", 48, 48), Key(Pool::ICON_NAME, "foo", 32, 48));
+
+  IconPixbufCache::KeyHash hash;
+  EXPECT_EQ(hash(Key(Pool::URI, "foo", 48, 48)), hash(Key(Pool::URI, "foo", 48, 48)));
+}
+
+TEST(TestIconPixbufCache, LookupAndStats)
+{
+  IconPixbufCache cache;
+  Key key(Pool::ICON_NAME, "foo", 48, 48);
+  EXPECT_FALSE(cache.Lookup(key));
+
+  auto const& pixbuf = CreatePixbuf(48);
+  cache.Insert(key, pixbuf);
+  EXPECT_EQ(pixbuf, cache.Lookup(key));
+  EXPECT_FALSE(cache.Lookup(Key(Pool::GICON_STRING, "foo", 48, 48)));
+
+  auto const& stats = cache.GetStats(Pool::ICON_NAME);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.entries);
+  EXPECT_EQ(IconPixbufCache::PixbufBytes(pixbuf), stats.bytes);
+  EXPECT_EQ(IconPixbufCache::DEFAULT_POOL_BUDGET, stats.budget);
+  EXPECT_EQ(1u, cache.GetStats(Pool::GICON_STRING).misses);
+}
+
+TEST(TestIconPixbufCache, ReplaceEntry)
+{
+  IconPixbufCache cache;
+  Key key(Pool::FILE, "file:///foo.png", 48, 48);
+  cache.Insert(key, CreatePixbuf(48));
+
+  auto const& pixbuf = CreatePixbuf(16);
+  cache.Insert(key, pixbuf);
+
+  EXPECT_EQ(pixbuf, cache.Lookup(key));
+  EXPECT_EQ(1u, cache.GetStats(Pool::FILE).entries);
+  EXPECT_EQ(IconPixbufCache::PixbufBytes(pixbuf), cache.GetStats(Pool::FILE).bytes);
+}
+
+TEST(TestIconPixbufCache, EvictsLeastRecentlyUsed)
+{
+  IconPixbufCache cache;
+  auto bytes = IconPixbufCache::PixbufBytes(CreatePixbuf(32));
+  cache.SetBudget(Pool::URI, bytes * 3);
+
+  for (int i = 0; i < 3; ++i)
+    cache.Insert(Key(Pool::URI, std::to_string(i), 32, 32), CreatePixbuf(32));
+
+  // Makes "0" the most recently used
+  ASSERT_TRUE(cache.Lookup(Key(Pool::URI, "0", 32, 32)));
+  cache.Insert(Key(Pool::URI, "3", 32, 32), CreatePixbuf(32));
+
+  EXPECT_TRUE(cache.Lookup(Key(Pool::URI, "0", 32, 32)));
+  EXPECT_FALSE(cache.Lookup(Key(Pool::URI, "1", 32, 32)));
+  EXPECT_TRUE(cache.Lookup(Key(Pool::URI, "2", 32, 32)));
+  EXPECT_TRUE(cache.Lookup(Key(Pool::URI, "3", 32, 32)));
+
+  auto const& stats = cache.GetStats(Pool::URI);
+  EXPECT_EQ(1u, stats.evictions);
+  EXPECT_EQ(3u, stats.entries);
+  EXPECT_EQ(bytes * 3, stats.bytes);
+}
+
+TEST(TestIconPixbufCache, PoolsHaveSeparateBudgets)
+{
+  IconPixbufCache cache;
+  auto bytes = IconPixbufCache::PixbufBytes(CreatePixbuf(32));
+  cache.SetBudget(Pool::URI, bytes);
+
+  cache.Insert(Key(Pool::ICON_NAME, "themed", 32, 32), CreatePixbuf(32));
+
+  for (int i = 0; i < 10; ++i)
+    cache.Insert(Key(Pool::URI, std::to_string(i), 32, 32), CreatePixbuf(32));
+
+  EXPECT_TRUE(cache.Lookup(Key(Pool::ICON_NAME, "themed", 32, 32)));
+  EXPECT_EQ(1u, cache.GetStats(Pool::URI).entries);
+  EXPECT_EQ(9u, cache.GetStats(Pool::URI).evictions);
+}
+
+TEST(TestIconPixbufCache, KeepsEntryBiggerThanBudget)
+{
+  IconPixbufCache cache;
+  cache.SetBudget(Pool::FILE, 1);
+  cache.Insert(Key(Pool::FILE, "big", 64, 64), CreatePixbuf(64));
+
+  EXPECT_TRUE(cache.Lookup(Key(Pool::FILE, "big", 64, 64)));
+}
+
+TEST(TestIconPixbufCache, ShrinkingBudgetEvicts)
+{
+  IconPixbufCache cache;
+
+  for (int i = 0; i < 5; ++i)
+    cache.Insert(Key(Pool::GICON_STRING, std::to_string(i), 32, 32), CreatePixbuf(32));
+
+  cache.SetBudget(Pool::GICON_STRING, IconPixbufCache::PixbufBytes(CreatePixbuf(32)) * 2);
+
+  EXPECT_EQ(2u, cache.GetStats(Pool::GICON_STRING).entries);
+  EXPECT_TRUE(cache.Lookup(Key(Pool::GICON_STRING, "4", 32, 32)));
+  EXPECT_TRUE(cache.Lookup(Key(Pool::GICON_STRING, "3", 32, 32)));
+}
+
+TEST(TestIconPixbufCache, ClearPool)
+{
+  IconPixbufCache cache;
+  cache.Insert(Key(Pool::ICON_NAME, "foo", 32, 32), CreatePixbuf(32));
+  cache.Insert(Key(Pool::FILE, "file:///foo.png", 32, 32), CreatePixbuf(32));
+
+  cache.Clear(Pool::ICON_NAME);
+
+  EXPECT_FALSE(cache.Lookup(Key(Pool::ICON_NAME, "foo", 32, 32)));
+  EXPECT_TRUE(cache.Lookup(Key(Pool::FILE, "file:///foo.png", 32, 32)));
+  EXPECT_EQ(0u, cache.GetStats(Pool::ICON_NAME).bytes);
+  EXPECT_EQ(0u, cache.GetStats(Pool::ICON_NAME).entries);
+
+  cache.Clear();
+  EXPECT_FALSE(cache.Lookup(Key(Pool::FILE, "file:///foo.png", 32, 32)));
+}
+
+TEST(TestIconPixbufCache, PoolName)
+{
+  EXPECT_EQ("icon_name", IconPixbufCache::PoolName(Pool::ICON_NAME));
+  EXPECT_EQ("gicon_string", IconPixbufCache::PoolName(Pool::GICON_STRING));
+  EXPECT_EQ("file", IconPixbufCache::PoolName(Pool::FILE));
+  EXPECT_EQ("uri", IconPixbufCache::PoolName(Pool::URI));
+}
+
+} // anonymous namespace
+} // unity namespace
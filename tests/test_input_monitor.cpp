@@ -0,0 +1,279 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the  Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 3 along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+#include <sigc++/sigc++.h>
+#include <UnityCore/GLibWrapper.h>
+#include <UnityCore/Variant.h>
+
+#include "InputMonitor.h"
+#include "IntrospectionData.h"
+#include "test_utils.h"
+
+using namespace testing;
+
+namespace unity
+{
+namespace input
+{
+namespace
+{
+
+struct DispatchingMonitor : Monitor
+{
+  using Monitor::Dispatch;
+};
+
+XEvent MakeEvent(int type)
+{
+  XEvent event = {};
+  event.type = type;
+  return event;
+}
+
+struct Client : sigc::trackable
+{
+  void OnEvent(XEvent const& event) { events.push_back(event.type); }
+  std::vector<int> events;
+};
+
+struct TestInputMonitor : Test
+{
+  glib::Variant Property(std::string const& name)
+  {
+    debug::IntrospectionData data;
+    static_cast<debug::Introspectable&>(monitor).AddProperties(data);
+    glib::Variant props(data.Get());
+    glib::Variant value(g_variant_lookup_value(props, name.c_str(), nullptr), glib::StealRef());
+
+    if (!value)
+      return glib::Variant();
+
+    glib::Variant child(g_variant_get_child_value(value, 1), glib::StealRef());
+    return child.GetVariant();
+  }
+
+  unsigned MonitorUpdates()
+  {
+    return Property("event_monitor_updates").GetUInt32();
+  }
+
+  DispatchingMonitor monitor;
+};
+
+TEST_F(TestInputMonitor, RegisterClient)
+{
+  Monitor::EventCallback cb = [] (XEvent const&) {};
+
+  EXPECT_TRUE(monitor.RegisterClient(Events::POINTER, cb));
+  EXPECT_FALSE(monitor.RegisterClient(Events::POINTER, cb));
+  EXPECT_EQ(Events::POINTER, monitor.RegisteredEvents(cb));
+
+  EXPECT_TRUE(monitor.RegisterClient(Events::KEYS, cb));
+  EXPECT_EQ(Events::INPUT, monitor.RegisteredEvents(cb));
+  EXPECT_EQ(1u, Property("pointer_clients").GetUInt64());
+  EXPECT_EQ(1u, Property("key_clients").GetUInt64());
+  EXPECT_EQ(0u, Property("barrier_clients").GetUInt64());
+}
+
+TEST_F(TestInputMonitor, UnregisterClient)
+{
+  Monitor::EventCallback cb = [] (XEvent const&) {};
+  ASSERT_TRUE(monitor.RegisterClient(Events::ALL, cb));
+
+  EXPECT_TRUE(monitor.UnregisterClient(cb));
+  EXPECT_FALSE(monitor.UnregisterClient(cb));
+  EXPECT_EQ(Events::NONE, monitor.RegisteredEvents(cb));
+}
+
+TEST_F(TestInputMonitor, UpdatesAreBatched)
+{
+  Monitor::EventCallback pointer_cb = [] (XEvent const&) {};
+  Monitor::EventCallback keys_cb = [] (XEvent const&) {};
+  Monitor::EventCallback barrier_cb = [] (XEvent const&) {};
+
+  monitor.RegisterClient(Events::POINTER, pointer_cb);
+  monitor.RegisterClient(Events::KEYS, keys_cb);
+  monitor.RegisterClient(Events::BARRIER, barrier_cb);
+  monitor.UnregisterClient(keys_cb);
+  EXPECT_EQ(0u, MonitorUpdates());
+
+  Utils::WaitPendingEvents();
+  EXPECT_EQ(1u, MonitorUpdates());
+
+  // The selected events didn't change, so there's nothing to update
+  monitor.UnregisterClient(pointer_cb);
+  monitor.RegisterClient(Events::POINTER, pointer_cb);
+  Utils::WaitPendingEvents();
+  EXPECT_EQ(1u, MonitorUpdates());
+
+  monitor.UnregisterClient(pointer_cb);
+  monitor.UnregisterClient(barrier_cb);
+  Utils::WaitPendingEvents();
+  EXPECT_EQ(2u, MonitorUpdates());
+}
+
+TEST_F(TestInputMonitor, DispatchToClients)
+{
+  std::vector<int> pointer_events, other_pointer_events, key_events;
+  Monitor::EventCallback pointer_cb = [&pointer_events] (XEvent const& e) { pointer_events.push_back(e.type); };
+  Monitor::EventCallback other_pointer_cb = [&other_pointer_events] (XEvent const& e) { other_pointer_events.push_back(e.type); };
+  Monitor::EventCallback key_cb = [&key_events] (XEvent const& e) { key_events.push_back(e.type); };
+
+  monitor.RegisterClient(Events::POINTER, pointer_cb);
+  monitor.RegisterClient(Events::POINTER, other_pointer_cb);
+  monitor.RegisterClient(Events::KEYS, key_cb);
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  monitor.Dispatch(Events::POINTER, MakeEvent(MotionNotify));
+  monitor.Dispatch(Events::KEYS, MakeEvent(KeyPress));
+
+  EXPECT_THAT(pointer_events, ElementsAre(ButtonPress, MotionNotify));
+  EXPECT_THAT(other_pointer_events, ElementsAre(ButtonPress, MotionNotify));
+  EXPECT_THAT(key_events, ElementsAre(KeyPress));
+
+  monitor.UnregisterClient(other_pointer_cb);
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonRelease));
+  EXPECT_THAT(pointer_events, ElementsAre(ButtonPress, MotionNotify, ButtonRelease));
+  EXPECT_THAT(other_pointer_events, ElementsAre(ButtonPress, MotionNotify));
+}
+
+TEST_F(TestInputMonitor, UnregisterItselfInCallback)
+{
+  unsigned calls = 0;
+  Monitor::EventCallback cb;
+  cb = [this, &calls, &cb] (XEvent const&) { ++calls; monitor.UnregisterClient(cb); };
+  monitor.RegisterClient(Events::POINTER, cb);
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+
+  EXPECT_EQ(1u, calls);
+  EXPECT_EQ(Events::NONE, monitor.RegisteredEvents(cb));
+  EXPECT_EQ(0u, Property("pointer_clients").GetUInt64());
+}
+
+TEST_F(TestInputMonitor, UnregisterOtherInCallback)
+{
+  unsigned first_calls = 0;
+  unsigned second_calls = 0;
+  Monitor::EventCallback first_cb, second_cb;
+  first_cb = [this, &first_calls, &second_cb] (XEvent const&) { ++first_calls; monitor.UnregisterClient(second_cb); };
+  second_cb = [this, &second_calls, &first_cb] (XEvent const&) { ++second_calls; monitor.UnregisterClient(first_cb); };
+  monitor.RegisterClient(Events::POINTER, first_cb);
+  monitor.RegisterClient(Events::POINTER, second_cb);
+
+  // Whatever callback is called first, the other one must be skipped
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  EXPECT_EQ(1u, first_calls + second_calls);
+  EXPECT_EQ(1u, Property("pointer_clients").GetUInt64());
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  EXPECT_EQ(2u, first_calls + second_calls);
+  EXPECT_TRUE(first_calls == 2 || second_calls == 2);
+}
+
+TEST_F(TestInputMonitor, RegisterInCallback)
+{
+  unsigned added_calls = 0;
+  Monitor::EventCallback added_cb = [&added_calls] (XEvent const&) { ++added_calls; };
+  Monitor::EventCallback cb = [this, &added_cb] (XEvent const&) { monitor.RegisterClient(Events::POINTER, added_cb); };
+  monitor.RegisterClient(Events::POINTER, cb);
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  EXPECT_EQ(0u, added_calls);
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  EXPECT_EQ(1u, added_calls);
+}
+
+TEST_F(TestInputMonitor, EmptySlotsArePruned)
+{
+  unsigned calls = 0;
+  Monitor::EventCallback cb = [&calls] (XEvent const&) { ++calls; };
+  auto client = std::make_shared<Client>();
+  monitor.RegisterClient(Events::POINTER, cb);
+  monitor.RegisterClient(Events::POINTER, sigc::mem_fun(client.get(), &Client::OnEvent));
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  EXPECT_EQ(1u, calls);
+  EXPECT_THAT(client->events, ElementsAre(ButtonPress));
+  ASSERT_EQ(2u, Property("pointer_clients").GetUInt64());
+
+  client.reset();
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+  EXPECT_EQ(2u, calls);
+  EXPECT_EQ(1u, Property("pointer_clients").GetUInt64());
+}
+
+TEST_F(TestInputMonitor, NestedDispatch)
+{
+  std::vector<int> outer_events, other_events;
+  Monitor::EventCallback outer_cb = [this, &outer_events] (XEvent const& e) {
+    outer_events.push_back(e.type);
+
+    // Like a callback that runs a nested loop
+    if (e.type == ButtonPress)
+      monitor.Dispatch(Events::POINTER, MakeEvent(MotionNotify));
+  };
+  Monitor::EventCallback other_cb = [&other_events] (XEvent const& e) { other_events.push_back(e.type); };
+  monitor.RegisterClient(Events::POINTER, outer_cb);
+  monitor.RegisterClient(Events::POINTER, other_cb);
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+
+  EXPECT_THAT(outer_events, ElementsAre(ButtonPress, MotionNotify));
+  EXPECT_THAT(other_events, UnorderedElementsAre(ButtonPress, MotionNotify));
+}
+
+TEST_F(TestInputMonitor, NestedDispatchAfterUnregister)
+{
+  std::vector<std::string> calls;
+  Monitor::EventCallback removed_cb = [&calls] (XEvent const&) { calls.push_back("removed"); };
+  Monitor::EventCallback outer_cb = [this, &calls, &removed_cb] (XEvent const& e) {
+    calls.push_back("outer");
+
+    if (e.type == ButtonPress)
+    {
+      // The nested dispatch rebuilds the clients list, the outer one must
+      // still skip the removed client
+      monitor.UnregisterClient(removed_cb);
+      monitor.Dispatch(Events::POINTER, MakeEvent(MotionNotify));
+    }
+  };
+  monitor.RegisterClient(Events::POINTER, outer_cb);
+  monitor.RegisterClient(Events::POINTER, removed_cb);
+
+  monitor.Dispatch(Events::POINTER, MakeEvent(ButtonPress));
+
+  auto outer_it = std::find(calls.begin(), calls.end(), "outer");
+  ASSERT_NE(calls.end(), outer_it);
+  EXPECT_EQ(calls.end(), std::find(outer_it, calls.end(), "removed"));
+  EXPECT_EQ(2, std::count(calls.begin(), calls.end(), "outer"));
+}
+
+TEST_F(TestInputMonitor, EventsIntrospection)
+{
+  EXPECT_EQ(0u, Property("events").GetUInt64());
+  EXPECT_DOUBLE_EQ(0.0, Property("event_rate").GetDouble());
+}
+
+} // anonymous namespace
+} // input namespace
+} // unity namespace
@@ -913,7 +913,9 @@ TEST_F(TestLauncherController, AddRunningApps)
   lc.Impl()->AddRunningApps();
 
   // This test should be rewritten to not use the default application manager.
-  for (auto& app : ApplicationManager::Default().GetRunningApplications())
+  auto const& apps = ApplicationManager::Default().GetRunningApplications();
+
+  for (auto& app : *apps)
   {
     if (app->sticky())
       continue;
@@ -1005,7 +1007,9 @@ TEST_F(TestLauncherController, SetupIcons)
   fav = lc.Impl()->GetIconByUri(FavoriteStore::URI_PREFIX_APP + app::UPDATE_MANAGER);
   EXPECT_EQ(model->IconIndex(fav), ++icon_index);
 
-  for (auto& app : ApplicationManager::Default().GetRunningApplications())
+  auto const& apps = ApplicationManager::Default().GetRunningApplications();
+
+  for (auto& app : *apps)
   {
     if (app->sticky())
       continue;
@@ -1047,7 +1051,9 @@ TEST_F(TestLauncherController, ResetIconPriorities)
   auto fav = lc.Impl()->GetIconByUri(FavoriteStore::URI_PREFIX_APP + app::SW_CENTER);
   EXPECT_EQ(model->IconIndex(fav), ++icon_index);
 
-  for (auto& app : ApplicationManager::Default().GetRunningApplications())
+  auto const& apps = ApplicationManager::Default().GetRunningApplications();
+
+  for (auto& app : *apps)
   {
     if (app->sticky())
       continue;
@@ -264,6 +264,93 @@ TEST_F(TestLayoutSystem, GetRowSizesUnEven)
   EXPECT_EQ(row_sizes[1], 3);
 }
 
+TEST_F(TestLayoutSystem, GetRowsMinimizesWidestRow)
+{
+  nux::Geometry max_bounds(0, 0, 200, 100);
+  lwindows.clear();
+
+  Window xid = 3;
+  AddFakeWindowToWM(xid, nux::Geometry(0, 0, 300, 100));
+  lwindows.push_back(std::make_shared<LayoutWindow>(xid));
+
+  for (xid = 4; xid < 7; ++xid)
+  {
+    AddFakeWindowToWM(xid, nux::Geometry(0, 0, 100, 100));
+    lwindows.push_back(std::make_shared<LayoutWindow>(xid));
+  }
+
+  std::vector<int> const& row_sizes = ls.GetRowSizes(lwindows, max_bounds);
+  ASSERT_EQ(row_sizes.size(), 2u);
+  EXPECT_EQ(row_sizes[0], 1);
+  EXPECT_EQ(row_sizes[1], 3);
+}
+
+TEST_F(TestLayoutSystem, LayoutWindowsIsCached)
+{
+  nux::Geometry max_bounds(0, 0, 200, 100);
+  nux::Geometry final_bounds;
+  ls.LayoutWindows(lwindows, max_bounds, final_bounds);
+
+  nux::Geometry win_geo1 = lwindows.at(0)->result;
+  nux::Geometry win_geo2 = lwindows.at(1)->result;
+  float scale1 = lwindows.at(0)->scale;
+
+  lwindows.at(0)->result = nux::Geometry();
+  lwindows.at(0)->scale = 1.0f;
+  lwindows.at(1)->result = nux::Geometry();
+
+  nux::Geometry cached_final_bounds;
+  ls.LayoutWindows(lwindows, max_bounds, cached_final_bounds);
+
+  EXPECT_EQ(final_bounds, cached_final_bounds);
+  EXPECT_EQ(win_geo1, lwindows.at(0)->result);
+  EXPECT_EQ(win_geo2, lwindows.at(1)->result);
+  EXPECT_FLOAT_EQ(scale1, lwindows.at(0)->scale);
+}
+
+TEST_F(TestLayoutSystem, LayoutWindowsCacheFollowsChanges)
+{
+  nux::Geometry max_bounds(0, 0, 200, 100);
+  nux::Geometry final_bounds;
+  ls.LayoutWindows(lwindows, max_bounds, final_bounds);
+  nux::Geometry win_geo1 = lwindows.at(0)->result;
+
+  lwindows.at(0)->geo.width *= 2;
+  lwindows.at(0)->aspect_ratio *= 2;
+  ls.LayoutWindows(lwindows, max_bounds, final_bounds);
+  EXPECT_NE(win_geo1, lwindows.at(0)->result);
+
+  Window xid = 3;
+  AddFakeWindowToWM(xid, nux::Geometry(4, 5, 200, 200));
+  lwindows.push_back(std::make_shared<LayoutWindow>(xid));
+  ls.LayoutWindows(lwindows, max_bounds, final_bounds);
+  EXPECT_NE(nux::Geometry(), lwindows.at(2)->result);
+
+  ls.spacing = 20;
+  nux::Geometry spaced_bounds;
+  ls.LayoutWindows(lwindows, max_bounds, spaced_bounds);
+  EXPECT_NE(final_bounds, spaced_bounds);
+}
+
+TEST_F(TestLayoutSystem, LayoutWindowsNearestIsCached)
+{
+  nux::Geometry max_bounds(0, 0, 200, 100);
+  nux::Geometry final_bounds;
+  LayoutWindow::Vector input = {lwindows.at(1), lwindows.at(0)};
+
+  LayoutWindow::Vector windows = input;
+  ls.LayoutWindowsNearest(windows, max_bounds, final_bounds);
+  LayoutWindow::Vector ordered_windows = windows;
+  nux::Geometry win_geo1 = lwindows.at(0)->result;
+
+  lwindows.at(0)->result = nux::Geometry();
+  windows = input;
+  ls.LayoutWindowsNearest(windows, max_bounds, final_bounds);
+
+  EXPECT_EQ(ordered_windows, windows);
+  EXPECT_EQ(win_geo1, lwindows.at(0)->result);
+}
+
 }
 }
 }
@@ -8,6 +8,7 @@
 #include "logger_helper.h"
 #include "test_utils.h"
 #include "UnitySettings.h"
+#include "StaticCairoText.h"
 
 int main(int argc, char** argv)
 {
@@ -38,6 +39,9 @@ int main(int argc, char** argv)
   // StandaloneWindowManager brought in at link time.
   int ret = RUN_ALL_TESTS();
 
+  // Release the shared text textures while their display is still alive
+  unity::StaticCairoText::ClearLayoutCache();
+
   Utils::reset_gsettings_test_environment();
 
   return ret;
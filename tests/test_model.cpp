@@ -86,7 +86,139 @@ TEST_F(TestModel, TestSetGetRenderer)
   }
 }
 
+struct TestModelRowsChanged : public ::testing::Test
+{
+  TestModelRowsChanged()
+    : model(ModelType::LOCAL)
+  {
+    dee_model_set_schema(model.model(), "u", "s", NULL);
+    model.rows_changed.connect([this] (ModelDiff const& diff) { diffs.push_back(diff); });
+  }
 
+  DeeModelIter* AppendRow(unsigned index)
+  {
+    return dee_model_append(model.model(), index, "Test");
+  }
+
+  Model<TestAdaptor> model;
+  std::vector<ModelDiff> diffs;
+};
+
+TEST_F(TestModelRowsChanged, EmittedPerRowWithoutTransactions)
+{
+  AppendRow(0);
+  DeeModelIter* iter = AppendRow(1);
+  dee_model_set_value(model.model(), iter, 1, g_variant_new_string("Changed"));
+  dee_model_remove(model.model(), iter);
+
+  ASSERT_EQ(4u, diffs.size());
+  EXPECT_EQ(1u, diffs[0].added);
+  EXPECT_EQ(1u, diffs[1].added);
+  EXPECT_EQ(1u, diffs[1].ranges[0].position);
+  EXPECT_EQ(1u, diffs[2].changed);
+  EXPECT_EQ(1u, diffs[3].removed);
+  EXPECT_EQ(ModelDiff::Change::REMOVED, diffs[3].ranges[0].change);
+  EXPECT_EQ(1u, diffs[3].ranges[0].position);
+}
+
+TEST_F(TestModelRowsChanged, BatchedInTransaction)
+{
+  for (unsigned i = 0; i < 10; ++i)
+    AppendRow(i);
+
+  diffs.clear();
+  unsigned row_signals = 0;
+  model.row_added.connect([&row_signals] (TestAdaptor&) { ++row_signals; });
+  model.row_removed.connect([&row_signals] (TestAdaptor&) { ++row_signals; });
+
+  model.begin_transaction.emit(0, 1);
+  for (unsigned i = 0; i < 5; ++i)
+    dee_model_remove(model.model(), dee_model_get_first_iter(model.model()));
+  for (unsigned i = 0; i < 5; ++i)
+    AppendRow(i);
+  EXPECT_TRUE(diffs.empty());
+
+  model.end_transaction.emit(0, 1);
+
+  EXPECT_EQ(10u, row_signals);
+  ASSERT_EQ(1u, diffs.size());
+
+  ModelDiff const& diff = diffs[0];
+  EXPECT_EQ(5u, diff.added);
+  EXPECT_EQ(5u, diff.removed);
+  ASSERT_EQ(2u, diff.ranges.size());
+  EXPECT_EQ(ModelDiff::Change::REMOVED, diff.ranges[0].change);
+  EXPECT_EQ(0u, diff.ranges[0].position);
+  EXPECT_EQ(5u, diff.ranges[0].count);
+  EXPECT_EQ(ModelDiff::Change::ADDED, diff.ranges[1].change);
+  EXPECT_EQ(5u, diff.ranges[1].position);
+  EXPECT_EQ(5u, diff.ranges[1].count);
+}
+
+TEST_F(TestModelRowsChanged, FollowTransactions)
+{
+  Model<TestAdaptor> other(ModelType::LOCAL);
+  model.FollowTransactions(other);
+
+  bool ended = false;
+  model.end_transaction.connect([&ended] (uint64_t, uint64_t) { ended = true; });
+
+  other.begin_transaction.emit(0, 1);
+  AppendRow(0);
+  AppendRow(1);
+  EXPECT_TRUE(diffs.empty());
+
+  other.end_transaction.emit(0, 1);
+  EXPECT_TRUE(ended);
+  ASSERT_EQ(1u, diffs.size());
+  EXPECT_EQ(2u, diffs[0].added);
+  EXPECT_EQ(1u, diffs[0].ranges.size());
+}
+
+TEST_F(TestModelRowsChanged, ExistingRowsAreBatched)
+{
+  unity::glib::Object<DeeModel> new_model(dee_sequence_model_new());
+  dee_model_set_schema(new_model, "u", "s", NULL);
+  for (unsigned i = 0; i < 10; ++i)
+    dee_model_append(new_model, i, "Test");
+
+  model.SetModel(new_model);
+
+  ASSERT_EQ(1u, diffs.size());
+  EXPECT_EQ(10u, diffs[0].added);
+}
+
+TEST(TestModelDiff, MergeAdjacentRows)
+{
+  ModelDiff diff;
+  EXPECT_TRUE(diff.empty());
+
+  diff.Add(ModelDiff::Change::ADDED, 3);
+  diff.Add(ModelDiff::Change::ADDED, 4);
+  diff.Add(ModelDiff::Change::ADDED, 3);
+  diff.Add(ModelDiff::Change::CHANGED, 1);
+  diff.Add(ModelDiff::Change::CHANGED, 0);
+  diff.Add(ModelDiff::Change::CHANGED, 1);
+  diff.Add(ModelDiff::Change::REMOVED, 2);
+  diff.Add(ModelDiff::Change::REMOVED, 1);
+  diff.Add(ModelDiff::Change::REMOVED, 8);
+
+  ASSERT_EQ(4u, diff.ranges.size());
+  EXPECT_EQ(3u, diff.ranges[0].position);
+  EXPECT_EQ(3u, diff.ranges[0].count);
+  EXPECT_EQ(0u, diff.ranges[1].position);
+  EXPECT_EQ(2u, diff.ranges[1].count);
+  EXPECT_EQ(1u, diff.ranges[2].position);
+  EXPECT_EQ(2u, diff.ranges[2].count);
+  EXPECT_EQ(8u, diff.ranges[3].position);
+  EXPECT_EQ(3u, diff.added);
+  EXPECT_EQ(2u, diff.changed);
+  EXPECT_EQ(3u, diff.removed);
+
+  diff.Clear();
+  EXPECT_TRUE(diff.empty());
+  EXPECT_EQ(0u, diff.added);
+}
 
 void discard_g_log_calls(const gchar* log_domain,
                          GLogLevelFlags log_level,
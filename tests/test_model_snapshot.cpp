@@ -0,0 +1,261 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+#include <UnityCore/GLibWrapper.h>
+#include <UnityCore/ModelSnapshot.h>
+#include <UnityCore/Results.h>
+#include <dee.h>
+
+#include "test_utils.h"
+
+using namespace testing;
+using namespace unity;
+using namespace unity::dash;
+
+namespace
+{
+
+struct TestModelSnapshot : Test
+{
+  TestModelSnapshot()
+    : results(new Results(ModelType::LOCAL))
+  {
+    dee_model_set_schema(results->model(), "s", "s", "u", "u", "s", "s", "s", "s", "a{sv}", NULL);
+  }
+
+  DeeModelIter* AddResult(std::string const& uri, std::string const& icon, unsigned category)
+  {
+    GVariantBuilder b;
+    g_variant_builder_init(&b, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&b, "{sv}", "uri-length", g_variant_new_uint32(uri.size()));
+    glib::Variant hints = g_variant_builder_end(&b);
+
+    return dee_model_append(results->model(), uri.c_str(), icon.c_str(), category, 0,
+                            "text/plain", uri.c_str(), "", uri.c_str(), static_cast<GVariant*>(hints));
+  }
+
+  Results::Ptr results;
+};
+
+TEST_F(TestModelSnapshot, Empty)
+{
+  auto& snapshot = results->GetSnapshot();
+
+  EXPECT_TRUE(snapshot.empty());
+  EXPECT_TRUE(snapshot.GetStringColumn(Result::URI).empty());
+  EXPECT_TRUE(snapshot.GetUIntColumn(Result::CATEGORY).empty());
+}
+
+TEST_F(TestModelSnapshot, TypedColumns)
+{
+  AddResult("file:///foo", "foo-icon", 1);
+  AddResult("file:///bar", "bar-icon", 2);
+
+  auto& snapshot = results->GetSnapshot();
+  ASSERT_EQ(2u, snapshot.size());
+
+  auto const& uris = snapshot.GetStringColumn(Result::URI);
+  ASSERT_EQ(2u, uris.size());
+  EXPECT_EQ("file:///foo", *uris[0]);
+  EXPECT_EQ("file:///bar", *uris[1]);
+
+  auto const& icons = snapshot.GetStringColumn(Result::ICON_HINT);
+  EXPECT_EQ("foo-icon", *icons[0]);
+  EXPECT_EQ("bar-icon", *icons[1]);
+
+  EXPECT_THAT(snapshot.GetUIntColumn(Result::CATEGORY), ElementsAre(1, 2));
+
+  auto const& hints = snapshot.GetVariantColumn(Result::METADATA);
+  ASSERT_EQ(2u, hints.size());
+  glib::HintsMap hints_map;
+  ASSERT_TRUE(hints[1].ASVToHints(hints_map));
+  EXPECT_EQ(11u, hints_map["uri-length"].GetUInt32());
+}
+
+TEST_F(TestModelSnapshot, MismatchingTypeReturnsEmptyColumn)
+{
+  AddResult("file:///foo", "icon", 0);
+  auto& snapshot = results->GetSnapshot();
+
+  EXPECT_TRUE(snapshot.GetUIntColumn(Result::URI).empty());
+  EXPECT_TRUE(snapshot.GetStringColumn(Result::CATEGORY).empty());
+  EXPECT_TRUE(snapshot.GetIntColumn(Result::CATEGORY).empty());
+  EXPECT_TRUE(snapshot.GetDoubleColumn(Result::CATEGORY).empty());
+  EXPECT_TRUE(snapshot.GetStringColumn(Result::METADATA).empty());
+  EXPECT_TRUE(snapshot.GetStringColumn(100).empty());
+}
+
+TEST_F(TestModelSnapshot, StringsAreInterned)
+{
+  AddResult("file:///foo", "shared-icon", 0);
+  AddResult("file:///bar", "shared-icon", 0);
+
+  auto const& icons = results->GetSnapshot().GetStringColumn(Result::ICON_HINT);
+  ASSERT_EQ(2u, icons.size());
+  EXPECT_EQ(icons[0], icons[1]);
+}
+
+TEST_F(TestModelSnapshot, UpdatedOnChanges)
+{
+  auto& snapshot = results->GetSnapshot();
+  AddResult("file:///foo", "icon", 0);
+  ASSERT_EQ(1u, snapshot.size());
+
+  DeeModelIter* iter = AddResult("file:///bar", "icon", 0);
+  EXPECT_EQ(2u, snapshot.size());
+
+  dee_model_set_value(results->model(), iter, Result::CATEGORY, g_variant_new_uint32(5));
+  EXPECT_THAT(snapshot.GetUIntColumn(Result::CATEGORY), ElementsAre(0, 5));
+
+  dee_model_remove(results->model(), iter);
+  ASSERT_EQ(1u, snapshot.size());
+  EXPECT_EQ("file:///foo", *snapshot.GetStringColumn(Result::URI)[0]);
+}
+
+TEST_F(TestModelSnapshot, KeepsModelOrder)
+{
+  auto& snapshot = results->GetSnapshot();
+  AddResult("file:///foo", "icon", 0);
+  DeeModelIter* bar = AddResult("file:///bar", "icon", 1);
+  AddResult("file:///baz", "icon", 2);
+
+  glib::Variant hints(g_variant_new_array(G_VARIANT_TYPE("{sv}"), nullptr, 0));
+  dee_model_prepend(results->model(), "file:///first", "icon", 3, 0, "text/plain",
+                    "first", "", "file:///first", static_cast<GVariant*>(hints));
+  dee_model_remove(results->model(), bar);
+
+  std::vector<std::string> uris;
+  for (auto const* uri : snapshot.GetStringColumn(Result::URI))
+    uris.push_back(*uri);
+
+  EXPECT_THAT(uris, ElementsAre("file:///first", "file:///foo", "file:///baz"));
+  EXPECT_THAT(snapshot.GetUIntColumn(Result::CATEGORY), ElementsAre(3, 0, 2));
+}
+
+TEST_F(TestModelSnapshot, ChangedStringsAreInterned)
+{
+  auto& snapshot = results->GetSnapshot();
+  AddResult("file:///foo", "icon", 0);
+  DeeModelIter* iter = AddResult("file:///bar", "other-icon", 0);
+
+  dee_model_set_value(results->model(), iter, Result::ICON_HINT, g_variant_new_string("icon"));
+
+  auto const& icons = snapshot.GetStringColumn(Result::ICON_HINT);
+  ASSERT_EQ(2u, icons.size());
+  EXPECT_EQ("icon", *icons[1]);
+  EXPECT_EQ(icons[0], icons[1]);
+}
+
+TEST_F(TestModelSnapshot, IncludesRowsAddedBeforeCreation)
+{
+  AddResult("file:///foo", "icon", 0);
+  AddResult("file:///bar", "icon", 1);
+
+  ModelSnapshot snapshot(*results);
+  ASSERT_EQ(2u, snapshot.size());
+  EXPECT_EQ("file:///bar", *snapshot.GetStringColumn(Result::URI)[1]);
+  EXPECT_THAT(snapshot.GetUIntColumn(Result::CATEGORY), ElementsAre(0, 1));
+}
+
+TEST_F(TestModelSnapshot, ConsistentInsideRemovedSignal)
+{
+  AddResult("file:///foo", "icon", 0);
+  DeeModelIter* iter = AddResult("file:///bar", "icon", 0);
+  std::vector<std::string> uris_on_removal;
+
+  results->result_removed.connect([this, &uris_on_removal] (Result const&) {
+    for (auto const* uri : results->GetSnapshot().GetStringColumn(Result::URI))
+      uris_on_removal.push_back(*uri);
+  });
+
+  dee_model_remove(results->model(), iter);
+  EXPECT_THAT(uris_on_removal, ElementsAre("file:///foo"));
+  EXPECT_EQ(1u, results->GetSnapshot().size());
+}
+
+TEST_F(TestModelSnapshot, FollowsModelChanges)
+{
+  AddResult("file:///foo", "icon", 0);
+  auto& snapshot = results->GetSnapshot();
+  ASSERT_EQ(1u, snapshot.size());
+
+  glib::Object<DeeModel> model(dee_sequence_model_new());
+  dee_model_set_schema(model, "s", "s", "u", "u", "s", "s", "s", "s", "a{sv}", NULL);
+  results->SetModel(model);
+
+  EXPECT_TRUE(snapshot.empty());
+}
+
+TEST_F(TestModelSnapshot, BENCHMARK_TEST(Benchmark))
+{
+  for (unsigned n_results : {100, 1000, 10000})
+  {
+    results.reset(new Results(ModelType::LOCAL));
+    dee_model_set_schema(results->model(), "s", "s", "u", "u", "s", "s", "s", "s", "a{sv}", NULL);
+
+    for (unsigned i = 0; i < n_results; ++i)
+      AddResult("file:///result" + std::to_string(i), "icon-" + std::to_string(i % 10), i % 5);
+
+    std::string const& last_uri = "file:///result" + std::to_string(n_results - 1);
+    unsigned matches = 0;
+
+    // Looking up an uri and counting the results of a category, as views do
+    double old_usec = Utils::BenchmarkUSec([this, &last_uri, &matches] {
+      for (auto const& result : *results)
+      {
+        if (result.uri() == last_uri)
+          ++matches;
+
+        if (result.category_index() == 2)
+          ++matches;
+      }
+    }, 10);
+
+    auto& snapshot = results->GetSnapshot();
+
+    double new_usec = Utils::BenchmarkUSec([&snapshot, &last_uri, &matches] {
+      auto const& uris = snapshot.GetStringColumn(Result::URI);
+      auto const& categories = snapshot.GetUIntColumn(Result::CATEGORY);
+
+      for (unsigned i = 0; i < uris.size(); ++i)
+      {
+        if (*uris[i] == last_uri)
+          ++matches;
+
+        if (categories[i] == 2)
+          ++matches;
+      }
+    }, 10);
+
+    // The snapshot is updated by the model signals
+    double update_usec = Utils::BenchmarkUSec([this] {
+      dee_model_set_value(results->model(), dee_model_get_first_iter(results->model()), Result::CATEGORY, g_variant_new_uint32(0));
+    }, 10);
+
+    EXPECT_EQ(2 * 10 * (n_results / 5 + 1), matches);
+
+    auto const& prefix = std::to_string(n_results) + "_results_";
+    RecordProperty(prefix + "old_usec", std::to_string(old_usec));
+    RecordProperty(prefix + "new_usec", std::to_string(new_usec));
+    RecordProperty(prefix + "update_usec", std::to_string(update_usec));
+  }
+}
+
+}
@@ -58,7 +58,6 @@ struct TestPanelMenuView : public testing::Test
     using PanelMenuView::titlebar_grab_area_;
     using PanelMenuView::we_control_active_;
     using PanelMenuView::spread_showing_;
-    using PanelMenuView::maximized_wins_;
   };
 
   nux::ObjectPtr<nux::BaseWindow> AddPanelToWindow(int monitor)
@@ -24,6 +24,7 @@
 #include "panel-service.h"
 #include "panel-service-private.h"
 #include "mock_indicator_object.h"
+#include "test_utils.h"
 
 using namespace testing;
 using namespace unity;
@@ -423,6 +424,136 @@ TEST_F(TestPanelService, ActivateRequest)
   EXPECT_TRUE(called);
 }
 
+TEST_F(TestPanelService, EntryLabelChangeEmitsDelta)
+{
+  glib::Object<IndicatorObject> object(mock_indicator_object_new());
+  auto mock_object = glib::object_cast<MockIndicatorObject>(object);
+
+  auto* entry = mock_indicator_object_add_entry(mock_object, "Entry", "cmake");
+  panel_service_add_indicator(service, object);
+  glib::Variant result(panel_service_sync(service));
+
+  std::string const& id = glib::String(g_strdup_printf("%p", entry)).Str();
+  bool resynced = false;
+  std::vector<glib::Variant> deltas;
+
+  glib::Signal<void, PanelService*, const gchar*> resync_signal;
+  resync_signal.Connect(service, "re-sync", [&resynced] (PanelService*, const gchar*) {
+    resynced = true;
+  });
+
+  glib::Signal<void, PanelService*, GVariant*> delta_signal;
+  delta_signal.Connect(service, "entry-changed", [&deltas] (PanelService*, GVariant* delta) {
+    deltas.push_back(glib::Variant(delta));
+  });
+
+  gtk_label_set_label(entry->label, "Changed Entry");
+  gtk_widget_set_sensitive(GTK_WIDGET(entry->label), FALSE);
+  Utils::WaitUntilMSec([&deltas] { return !deltas.empty(); });
+
+  ASSERT_EQ(1u, deltas.size());
+  EXPECT_FALSE(resynced);
+
+  guint32 sequence;
+  glib::String indicator_id, entry_id;
+  GVariant* changes;
+  g_variant_get(deltas[0], ENTRY_DELTA_SIGNATURE, &sequence, &indicator_id, &entry_id, &changes);
+
+  glib::HintsMap hints;
+  glib::Variant(changes, glib::StealRef()).ASVToHints(hints);
+
+  EXPECT_GT(sequence, 0u);
+  EXPECT_EQ(id, entry_id.Str());
+  EXPECT_EQ(2u, hints.size());
+  EXPECT_EQ("Changed Entry", hints["label"].GetString());
+  EXPECT_FALSE(hints["label_sensitive"].GetBool());
+}
+
+TEST_F(TestPanelService, EntryChangeSequenceIsIncremental)
+{
+  glib::Object<IndicatorObject> object(mock_indicator_object_new());
+  auto mock_object = glib::object_cast<MockIndicatorObject>(object);
+
+  auto* entry = mock_indicator_object_add_entry(mock_object, "Entry", "cmake");
+  panel_service_add_indicator(service, object);
+  glib::Variant result(panel_service_sync(service));
+
+  std::vector<guint32> sequences;
+  glib::Signal<void, PanelService*, GVariant*> delta_signal;
+  delta_signal.Connect(service, "entry-changed", [&sequences] (PanelService*, GVariant* delta) {
+    sequences.push_back(glib::Variant(g_variant_get_child_value(delta, 0), glib::StealRef()).GetUInt32());
+  });
+
+  for (unsigned i = 0; i < 3; ++i)
+  {
+    gtk_image_set_from_icon_name(entry->image, ("icon" + std::to_string(i)).c_str(), GTK_ICON_SIZE_MENU);
+    Utils::WaitUntilMSec([&sequences, i] { return sequences.size() == i + 1; });
+  }
+
+  ASSERT_EQ(3u, sequences.size());
+  EXPECT_EQ(sequences[0] + 1, sequences[1]);
+  EXPECT_EQ(sequences[1] + 1, sequences[2]);
+}
+
+TEST_F(TestPanelService, PixbufImagesAreSentOnce)
+{
+  glib::Object<IndicatorObject> object(mock_indicator_object_new());
+  auto mock_object = glib::object_cast<MockIndicatorObject>(object);
+
+  auto* entry = mock_indicator_object_add_entry(mock_object, "Entry", "cmake");
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 22, 22));
+  gdk_pixbuf_fill(pixbuf, 0xff0000ff);
+  gtk_image_set_from_pixbuf(entry->image, pixbuf);
+  panel_service_add_indicator(service, object);
+
+  glib::Variant result(panel_service_sync(service));
+  auto results = GetResults(result);
+  ASSERT_EQ(1u, results.size());
+  ASSERT_EQ(static_cast<uint32_t>(GTK_IMAGE_PIXBUF), results[0].image_type);
+
+  auto const& full_data = results[0].image_data;
+  auto separator = full_data.find(IMAGE_HASH_SEPARATOR);
+  ASSERT_NE(std::string::npos, separator);
+  auto const& hash = full_data.substr(0, separator);
+  EXPECT_FALSE(full_data.substr(separator + 1).empty());
+
+  result = panel_service_sync_one(service, results[0].indicator_id.c_str());
+  results = GetResults(result);
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(hash, results[0].image_data);
+
+  // A full sync might come from a new client, so the data must be there again
+  result = panel_service_sync(service);
+  results = GetResults(result);
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(full_data, results[0].image_data);
+}
+
+TEST_F(TestPanelService, SamePixbufContentsShareHash)
+{
+  glib::Object<IndicatorObject> object(mock_indicator_object_new());
+  auto mock_object = glib::object_cast<MockIndicatorObject>(object);
+
+  auto* entry1 = mock_indicator_object_add_entry(mock_object, "Entry1", "cmake");
+  auto* entry2 = mock_indicator_object_add_entry(mock_object, "Entry2", "cmake");
+  glib::Object<GdkPixbuf> pixbuf1(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 22, 22));
+  glib::Object<GdkPixbuf> pixbuf2(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 22, 22));
+  gdk_pixbuf_fill(pixbuf1, 0x00ff00ff);
+  gdk_pixbuf_fill(pixbuf2, 0x00ff00ff);
+  gtk_image_set_from_pixbuf(entry1->image, pixbuf1);
+  gtk_image_set_from_pixbuf(entry2->image, pixbuf2);
+  panel_service_add_indicator(service, object);
+
+  glib::Variant result(panel_service_sync(service));
+  auto results = GetResults(result);
+  ASSERT_EQ(2u, results.size());
+
+  // The second entry only refers to the image already sent for the first one
+  auto const& full_data = results[0].image_data;
+  ASSERT_NE(std::string::npos, full_data.find(IMAGE_HASH_SEPARATOR));
+  EXPECT_EQ(full_data.substr(0, full_data.find(IMAGE_HASH_SEPARATOR)), results[1].image_data);
+}
+
 TEST(TestPanelServiceCompizShortcutParsing, Null)
 {
   KeyBinding kb;
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the  Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 3 along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ *
+ */
+
+#include <gmock/gmock.h>
+
+#include "PanelTopWindowTracker.h"
+#include "test_standalone_wm.h"
+#include "test_uscreen_mock.h"
+#include "test_utils.h"
+
+using namespace testing;
+
+namespace unity
+{
+namespace panel
+{
+namespace
+{
+const unsigned N_MONITORS = 3;
+
+struct TestPanelTopWindowTracker : Test
+{
+  TestPanelTopWindowTracker()
+  {
+    std::vector<nux::Geometry> monitors;
+
+    for (unsigned i = 0; i < N_MONITORS; ++i)
+      monitors.push_back(MonitorGeometry(i));
+
+    uscreen.SetMonitors(monitors);
+    tracker = TopWindowTracker::Get();
+  }
+
+  nux::Geometry MonitorGeometry(int monitor) const
+  {
+    return nux::Geometry(monitor * MockUScreen::MONITOR_WIDTH, 0, MockUScreen::MONITOR_WIDTH, MockUScreen::MONITOR_HEIGHT);
+  }
+
+  StandaloneWindow::Ptr AddWindow(Window xid, int monitor, bool maximized = false)
+  {
+    auto window = std::make_shared<StandaloneWindow>(xid);
+    auto geo = MonitorGeometry(monitor);
+    window->geo = maximized ? geo : nux::Geometry(geo.x + 10, geo.y + 10, geo.width / 2, geo.height / 2);
+    WM->AddStandaloneWindow(window);
+    window->maximized = maximized;
+
+    return window;
+  }
+
+  MockUScreen uscreen;
+  testwrapper::StandaloneWM WM;
+  TopWindowTracker::Ptr tracker;
+};
+
+TEST_F(TestPanelTopWindowTracker, Shared)
+{
+  EXPECT_EQ(tracker, TopWindowTracker::Get());
+}
+
+TEST_F(TestPanelTopWindowTracker, MaximizedWindowPerMonitor)
+{
+  AddWindow(1, 0, true);
+  AddWindow(2, 1);
+  AddWindow(3, 2, true);
+
+  EXPECT_EQ(1u, tracker->GetMaximizedWindow(0));
+  EXPECT_EQ(0u, tracker->GetMaximizedWindow(1));
+  EXPECT_EQ(3u, tracker->GetMaximizedWindow(2));
+  EXPECT_EQ(0u, tracker->GetMaximizedWindow(N_MONITORS));
+}
+
+TEST_F(TestPanelTopWindowTracker, ActiveMaximizedWindowIsOnTop)
+{
+  AddWindow(1, 0, true);
+  auto win = AddWindow(2, 0);
+  EXPECT_EQ(1u, tracker->GetMaximizedWindow(0));
+
+  win->active = true;
+  win->maximized = true;
+  EXPECT_EQ(2u, tracker->GetMaximizedWindow(0));
+
+  // Inactive windows go below the others
+  AddWindow(3, 0, true);
+  EXPECT_EQ(2u, tracker->GetMaximizedWindow(0));
+}
+
+TEST_F(TestPanelTopWindowTracker, RestoredAndMinimizedWindowsAreRemoved)
+{
+  auto win1 = AddWindow(1, 0, true);
+  auto win2 = AddWindow(2, 0);
+  win2->active = true;
+  win2->maximized = true;
+  ASSERT_EQ(2u, tracker->GetMaximizedWindow(0));
+
+  std::vector<int> changed;
+  tracker->maximized_window_changed.connect([&changed] (int monitor) { changed.push_back(monitor); });
+
+  win1->maximized = false;
+  EXPECT_TRUE(changed.empty());
+
+  win2->minimized = true;
+  EXPECT_THAT(changed, ElementsAre(0));
+  EXPECT_EQ(0u, tracker->GetMaximizedWindow(0));
+}
+
+TEST_F(TestPanelTopWindowTracker, InvalidWindowsAreSkipped)
+{
+  AddWindow(1, 1, true);
+  auto win = AddWindow(2, 1, true);
+  win->active = true;
+  win->maximized = false;
+  win->maximized = true;
+  EXPECT_EQ(2u, tracker->GetMaximizedWindow(1));
+
+  win->visible = false;
+  WM->show_desktop_changed.emit();
+  EXPECT_EQ(1u, tracker->GetMaximizedWindow(1));
+}
+
+TEST_F(TestPanelTopWindowTracker, MovedWindowsChangeMonitor)
+{
+  auto win = AddWindow(1, 0);
+  EXPECT_TRUE(tracker->IsWindowOnMonitor(1, 0));
+  EXPECT_FALSE(tracker->IsWindowOnMonitor(1, 1));
+
+  std::vector<Window> changed;
+  tracker->window_monitors_changed.connect([&changed] (Window xid) { changed.push_back(xid); });
+
+  auto geo = win->geo();
+  geo.x += 10;
+  win->geo = geo;
+  EXPECT_TRUE(changed.empty());
+
+  geo.x = MonitorGeometry(1).x;
+  win->geo = geo;
+  EXPECT_THAT(changed, ElementsAre(1));
+  EXPECT_FALSE(tracker->IsWindowOnMonitor(1, 0));
+  EXPECT_TRUE(tracker->IsWindowOnMonitor(1, 1));
+}
+
+TEST_F(TestPanelTopWindowTracker, MovedMaximizedWindowChangesMonitor)
+{
+  AddWindow(1, 0, true);
+  auto win = AddWindow(2, 0, true);
+  win->active = true;
+  win->maximized = false;
+  win->maximized = true;
+  ASSERT_EQ(2u, tracker->GetMaximizedWindow(0));
+
+  std::vector<int> changed;
+  tracker->maximized_window_changed.connect([&changed] (int monitor) { changed.push_back(monitor); });
+
+  win->geo = MonitorGeometry(2);
+  EXPECT_THAT(changed, ElementsAre(0, 2));
+  EXPECT_EQ(1u, tracker->GetMaximizedWindow(0));
+  EXPECT_EQ(0u, tracker->GetMaximizedWindow(1));
+  EXPECT_EQ(2u, tracker->GetMaximizedWindow(2));
+}
+
+TEST_F(TestPanelTopWindowTracker, MonitorsChanged)
+{
+  AddWindow(1, 2, true);
+  ASSERT_EQ(1u, tracker->GetMaximizedWindow(2));
+
+  uscreen.Reset();
+  EXPECT_EQ(0u, tracker->GetMaximizedWindow(2));
+  EXPECT_EQ(1u, tracker->GetMaximizedWindow(0));
+}
+
+TEST_F(TestPanelTopWindowTracker, RestackedWindowsAreSorted)
+{
+  AddWindow(1, 0, true);
+  AddWindow(2, 0, true);
+  ASSERT_EQ(1u, tracker->GetMaximizedWindow(0));
+
+  WM->Raise(2);
+  EXPECT_EQ(2u, tracker->GetMaximizedWindow(0));
+
+  WM->Raise(1);
+  EXPECT_EQ(1u, tracker->GetMaximizedWindow(0));
+}
+
+TEST_F(TestPanelTopWindowTracker, ViewportSwitchUpdatesMaximizedWindows)
+{
+  AddWindow(1, 0, true);
+  ASSERT_EQ(1u, tracker->GetMaximizedWindow(0));
+
+  std::vector<int> changed;
+  tracker->maximized_window_changed.connect([&changed] (int monitor) { changed.push_back(monitor); });
+
+  WM->SetCurrentDesktop(1);
+  WM->screen_viewport_switch_ended.emit();
+  EXPECT_THAT(changed, ElementsAre(0));
+  EXPECT_EQ(0u, tracker->GetMaximizedWindow(0));
+}
+
+TEST_F(TestPanelTopWindowTracker, BENCHMARK_TEST(DragBenchmark))
+{
+  const unsigned n_windows = 100;
+  std::vector<StandaloneWindow::Ptr> windows;
+
+  // Panels used to do all the work, measure that without a tracker
+  tracker.reset();
+
+  for (unsigned i = 0; i < n_windows; ++i)
+    windows.push_back(AddWindow(i + 1, i % N_MONITORS, i % 4 == 0));
+
+  auto dragged = windows.front();
+  dragged->active = true;
+
+  std::vector<Window> maximized_wins;
+  for (auto const& win : windows)
+  {
+    if (win->maximized())
+      maximized_wins.push_back(win->Xid());
+  }
+
+  auto const& drag = [this, &dragged] (std::function<void()> const& on_move) {
+    auto geo = MonitorGeometry(0);
+
+    for (; geo.x <= MonitorGeometry(N_MONITORS - 1).x; geo.x += 10)
+    {
+      dragged->geo = geo;
+      on_move();
+    }
+  };
+
+  // What each panel did on every move of a maximized window
+  Window old_top = 0;
+  double old_usec = Utils::BenchmarkUSec([this, &drag, &maximized_wins, &old_top] {
+    drag([this, &maximized_wins, &old_top] {
+      for (unsigned monitor = 0; monitor < N_MONITORS; ++monitor)
+      {
+        for (auto xid : maximized_wins)
+        {
+          auto const& window_geo = WM->GetWindowGeometry(xid);
+          auto const& intersect = MonitorGeometry(monitor).Intersect(window_geo);
+
+          if (intersect.width > window_geo.width/2 && intersect.height > 0 &&
+              WM->IsWindowOnCurrentDesktop(xid) && !WM->IsWindowObscured(xid) &&
+              WM->IsWindowVisible(xid))
+          {
+            old_top = xid;
+            break;
+          }
+        }
+      }
+    });
+  }, 10);
+
+  tracker = TopWindowTracker::Get();
+
+  for (auto xid : maximized_wins)
+  {
+    auto const& win = WM->GetWindowByXid(xid);
+    win->maximized = false;
+    win->maximized = true;
+  }
+
+  double new_usec = Utils::BenchmarkUSec([&drag] { drag([] {}); }, 10);
+
+  EXPECT_EQ(dragged->Xid(), tracker->GetMaximizedWindow(N_MONITORS - 1));
+  EXPECT_EQ(dragged->Xid(), old_top);
+  EXPECT_NE(dragged->Xid(), tracker->GetMaximizedWindow(0));
+
+  RecordProperty("100_windows_old_usec", std::to_string(old_usec));
+  RecordProperty("100_windows_new_usec", std::to_string(new_usec));
+}
+
+} // anonymous namespace
+} // panel namespace
+} // unity namespace
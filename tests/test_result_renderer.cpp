@@ -26,6 +26,7 @@
 #include "UnityCore/GLibWrapper.h"
 #include "UnityCore/Result.h"
 #include "dash/ResultRendererTile.h"
+#include "unity-shared/CairoTexture.h"
 
 #include "test_utils.h"
 
@@ -87,6 +88,30 @@ TEST_F(TestResultRenderer, TestConstruction)
   dash::ResultRendererTile renderer;
 }
 
+struct PoolingResultRendererTile : dash::ResultRendererTile
+{
+  using dash::ResultRendererTile::AcquireContainer;
+  using dash::ResultRendererTile::RecycleContainer;
+};
+
+TEST_F(TestResultRenderer, RecycledContainerHasNoPrelight)
+{
+  PoolingResultRendererTile renderer;
+  dash::TextureContainer* container = renderer.AcquireContainer();
+
+  nux::CairoGraphics cg(CAIRO_FORMAT_ARGB32, 8, 8);
+  container->prelight = texture_ptr_from_cairo_graphics(cg);
+  ASSERT_TRUE(container->prelight);
+
+  renderer.RecycleContainer(container);
+  std::unique_ptr<dash::TextureContainer> recycled(renderer.AcquireContainer());
+
+  ASSERT_EQ(container, recycled.get());
+  EXPECT_FALSE(recycled->prelight);
+  EXPECT_FALSE(recycled->icon);
+  EXPECT_EQ(0, recycled->slot_handle);
+}
+
 TEST_F(TestResultRenderer, TestDndIcon)
 {
   dash::ResultRendererTile renderer;
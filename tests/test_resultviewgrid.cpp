@@ -24,8 +24,12 @@
 #include <gmock/gmock.h>
 using namespace testing;
 
+#include <dee.h>
+#include <UnityCore/Results.h>
+
 #include "ResultViewGrid.h"
 #include "WindowManager.h"
+#include "test_utils.h"
 using namespace unity;
 
 namespace
@@ -115,4 +119,217 @@ TEST_F(TestResultViewGrid, DisconnectWMSignalsOnDestruction)
   color_property.changed.emit(nux::color::RandomColor());
 }
 
+const int TILE_SIZE = 100;
+const int VIEWPORT_HEIGHT = 600;
+const int ITEMS_PER_ROW = 8;
+
+struct LoadCountingRenderer : dash::ResultRenderer
+{
+  LoadCountingRenderer()
+    : dash::ResultRenderer(NUX_TRACKER_LOCATION)
+    , loaded(0)
+  {
+    width = TILE_SIZE;
+    height = TILE_SIZE;
+  }
+
+  void Preload(dash::Result const& row)
+  {
+    if (!row.renderer<LoadCountingRenderer*>())
+    {
+      const_cast<dash::Result&>(row).set_renderer(this);
+      ++loaded;
+    }
+  }
+
+  void Unload(dash::Result const& row)
+  {
+    if (row.renderer<LoadCountingRenderer*>())
+    {
+      const_cast<dash::Result&>(row).set_renderer<LoadCountingRenderer*>(nullptr);
+      --loaded;
+    }
+  }
+
+  void Render(nux::GraphicsEngine&, dash::Result& row, ResultRendererState, nux::Geometry const&, int, int, nux::Color const&, float)
+  {
+    std::string const& uri = row.uri();
+    rendered.push_back(std::stoi(uri.substr(uri.rfind('-') + 1)));
+  }
+
+  int loaded;
+  std::vector<int> rendered;
+};
+
+struct ScrollableResultViewGrid : dash::ResultViewGrid
+{
+  ScrollableResultViewGrid()
+    : dash::ResultViewGrid(NUX_TRACKER_LOCATION)
+    , scroll(0)
+  {}
+
+  nux::Geometry GetViewport()
+  {
+    return nux::Geometry(0, scroll, TILE_SIZE * ITEMS_PER_ROW, VIEWPORT_HEIGHT);
+  }
+
+  using dash::ResultViewGrid::DoLazyLoad;
+  using dash::ResultViewGrid::Draw;
+
+  int scroll;
+};
+
+struct TestResultViewGridVirtualization : Test
+{
+  TestResultViewGridVirtualization()
+    : view(new ScrollableResultViewGrid())
+    , renderer(new LoadCountingRenderer())
+    , results(std::make_shared<dash::Results>(dash::ModelType::LOCAL))
+  {
+    dee_model_set_schema(results->model(), "s", "s", "u", "u", "s", "s", "s", "s", "a{sv}", nullptr);
+    view->vertical_spacing = 0;
+    view->padding = 0;
+    view->SetModelRenderer(renderer.GetPointer());
+    view->SetResultsModel(results);
+  }
+
+  void AddResults(unsigned count)
+  {
+    glib::Variant hints(g_variant_new_array(G_VARIANT_TYPE("{sv}"), nullptr, 0));
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+      auto const& uri = "file:///result-" + std::to_string(i);
+      dee_model_append(results->model(), uri.c_str(), "icon", 0, 0, "text/plain",
+                       "Result", "", uri.c_str(), static_cast<GVariant*>(hints));
+    }
+
+    int rows = (count + ITEMS_PER_ROW - 1) / ITEMS_PER_ROW;
+    view->SetGeometry(nux::Geometry(0, 0, TILE_SIZE * ITEMS_PER_ROW, rows * TILE_SIZE));
+  }
+
+  void ScrollTo(int y)
+  {
+    view->scroll = y;
+    while (view->DoLazyLoad());
+  }
+
+  void Draw()
+  {
+    renderer->rendered.clear();
+    view->Draw(*nux::GetGraphicsDisplay()->GetGraphicsEngine(), false);
+  }
+
+  bool IsLoaded(unsigned index)
+  {
+    return view->GetIteratorAtRow(index)->renderer<LoadCountingRenderer*>() != nullptr;
+  }
+
+  nux::ObjectPtr<ScrollableResultViewGrid> view;
+  nux::ObjectPtr<LoadCountingRenderer> renderer;
+  dash::Results::Ptr results;
+};
+
+TEST_F(TestResultViewGridVirtualization, LoadsOnlyResultsAroundViewport)
+{
+  AddResults(1000);
+  ScrollTo(0);
+
+  int visible_results = (VIEWPORT_HEIGHT / TILE_SIZE) * ITEMS_PER_ROW;
+  EXPECT_TRUE(IsLoaded(0));
+  EXPECT_TRUE(IsLoaded(visible_results - 1));
+  EXPECT_FALSE(IsLoaded(999));
+  EXPECT_LT(renderer->loaded, visible_results * 4);
+}
+
+TEST_F(TestResultViewGridVirtualization, ScrollingUnloadsFarResults)
+{
+  AddResults(1000);
+  ScrollTo(0);
+  int loaded = renderer->loaded;
+
+  ScrollTo(60 * TILE_SIZE);
+
+  EXPECT_FALSE(IsLoaded(0));
+  EXPECT_TRUE(IsLoaded(60 * ITEMS_PER_ROW));
+  EXPECT_LE(renderer->loaded, loaded * 2);
+
+  ScrollTo(0);
+  EXPECT_TRUE(IsLoaded(0));
+  EXPECT_FALSE(IsLoaded(60 * ITEMS_PER_ROW));
+}
+
+TEST_F(TestResultViewGridVirtualization, NotExpandedLoadsFirstRow)
+{
+  AddResults(100);
+  view->expanded = false;
+  ScrollTo(0);
+
+  EXPECT_EQ(ITEMS_PER_ROW, renderer->loaded);
+}
+
+TEST_F(TestResultViewGridVirtualization, DrawsOnlyVisibleRows)
+{
+  const int first_row = 60;
+  const int visible_rows = VIEWPORT_HEIGHT / TILE_SIZE;
+  AddResults(5000);
+
+  for (int scroll : {0, first_row * TILE_SIZE, first_row * TILE_SIZE + TILE_SIZE / 2})
+  {
+    ScrollTo(scroll);
+    Draw();
+
+    int first_visible = (scroll / TILE_SIZE) * ITEMS_PER_ROW;
+    auto const& rendered = renderer->rendered;
+    ASSERT_GE(rendered.size(), unsigned(visible_rows * ITEMS_PER_ROW));
+    EXPECT_EQ(first_visible, *std::min_element(rendered.begin(), rendered.end()));
+    EXPECT_LT(*std::max_element(rendered.begin(), rendered.end()), first_visible + (visible_rows + 2) * ITEMS_PER_ROW);
+  }
+}
+
+TEST_F(TestResultViewGridVirtualization, BENCHMARK_TEST(DrawBenchmark))
+{
+  AddResults(10000);
+  int max_scroll = view->GetGeometry().height - VIEWPORT_HEIGHT;
+
+  for (int scroll : {0, max_scroll / 4, max_scroll / 2, max_scroll})
+  {
+    ScrollTo(scroll);
+
+    double usec = Utils::BenchmarkUSec([this] { Draw(); }, 200);
+
+    RecordProperty("draw_at_" + std::to_string(scroll) + "_usec", std::to_string(usec));
+    EXPECT_LE(renderer->rendered.size(), unsigned((VIEWPORT_HEIGHT / TILE_SIZE + 2) * ITEMS_PER_ROW));
+  }
+}
+
+TEST_F(TestResultViewGridVirtualization, BENCHMARK_TEST(Benchmark))
+{
+  for (unsigned count : {100, 1000, 10000})
+  {
+    view = new ScrollableResultViewGrid();
+    renderer = new LoadCountingRenderer();
+    results = std::make_shared<dash::Results>(dash::ModelType::LOCAL);
+    dee_model_set_schema(results->model(), "s", "s", "u", "u", "s", "s", "s", "s", "a{sv}", nullptr);
+    view->vertical_spacing = 0;
+    view->padding = 0;
+    view->SetModelRenderer(renderer.GetPointer());
+    view->SetResultsModel(results);
+    AddResults(count);
+    ScrollTo(0);
+
+    int max_scroll = std::max(0, view->GetGeometry().height - VIEWPORT_HEIGHT);
+    int scroll = 0;
+
+    double usec = Utils::BenchmarkUSec([this, &scroll, max_scroll] {
+      scroll = (scroll + TILE_SIZE / 2) % (max_scroll + 1);
+      ScrollTo(scroll);
+      view->GetIndexAtPosition(TILE_SIZE, scroll + TILE_SIZE);
+    }, 200);
+
+    RecordProperty(std::to_string(count) + "_results_scroll_frame_usec", std::to_string(usec));
+    EXPECT_LT(renderer->loaded, 10 * (VIEWPORT_HEIGHT / TILE_SIZE) * ITEMS_PER_ROW);
+  }
+}
+
 }
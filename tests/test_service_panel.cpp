@@ -25,6 +25,13 @@ static const char * panel_interface =
 "     <arg type='s' name='indicator_id' />"
 "    </signal>"
 "\n"
+"    <signal name='EntryChanged'>"
+"     <arg type='u' name='sequence' />"
+"     <arg type='s' name='indicator_id' />"
+"     <arg type='s' name='entry_id' />"
+"     <arg type='a{sv}' name='changes' />"
+"    </signal>"
+"\n"
 "<!-- Begin of test only methods/signals -->\n"
 "\n"
 "    <method name='TriggerResync1' />"
@@ -33,6 +40,20 @@ static const char * panel_interface =
 "      <arg type='b' name='sent' direction='out'/>"
 "    </method>"
 "\n"
+"    <method name='TriggerEntryLabelChanged'>"
+"      <arg type='u' name='sequence' direction='in'/>"
+"      <arg type='s' name='label' direction='in'/>"
+"    </method>"
+"\n"
+"    <method name='TriggerEntryImageChanged'>"
+"      <arg type='u' name='sequence' direction='in'/>"
+"      <arg type='s' name='image_data' direction='in'/>"
+"    </method>"
+"\n"
+"    <method name='SyncCount'>"
+"      <arg type='u' name='count' direction='out'/>"
+"    </method>"
+"\n"
 "        </interface>\n"
 "</node>\n"
 ;
@@ -76,6 +97,7 @@ void add_entry_id_2(GVariantBuilder *b, gint priority)
 Panel::Panel()
   : sync_return_mode_(0)
   , trigger_resync1_sent_(false)
+  , sync_count_(0)
 {
   auto object = glib::DBusObjectBuilder::GetObjectsForIntrospection(panel_interface).front();
   object->SetMethodsCallsHandler(sigc::mem_fun(this, &Panel::OnMethodCall));
@@ -88,6 +110,7 @@ GVariant* Panel::OnMethodCall(std::string const& method, GVariant *parameters)
   if (method == "Sync")
   {
     GVariantBuilder b;
+    ++sync_count_;
 
     g_variant_builder_init (&b, G_VARIANT_TYPE ("(" ENTRY_ARRAY_SIGNATURE ")"));
     g_variant_builder_open (&b, G_VARIANT_TYPE (ENTRY_ARRAY_SIGNATURE));
@@ -122,6 +145,37 @@ GVariant* Panel::OnMethodCall(std::string const& method, GVariant *parameters)
   {
     return g_variant_new("(b)", trigger_resync1_sent_ ? TRUE : FALSE);
   }
+  else if (method == "TriggerEntryLabelChanged")
+  {
+    guint32 sequence;
+    const gchar* label;
+    g_variant_get(parameters, "(u&s)", &sequence, &label);
+
+    GVariantBuilder changes;
+    g_variant_builder_init(&changes, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&changes, "{sv}", "label", g_variant_new_string(label));
+
+    server_.GetObjects().front()->EmitSignal("EntryChanged",
+      g_variant_new(ENTRY_DELTA_SIGNATURE, sequence, "test_indicator_id", "test_entry_id", &changes));
+  }
+  else if (method == "TriggerEntryImageChanged")
+  {
+    guint32 sequence;
+    const gchar* image_data;
+    g_variant_get(parameters, "(u&s)", &sequence, &image_data);
+
+    GVariantBuilder changes;
+    g_variant_builder_init(&changes, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&changes, "{sv}", "image_type", g_variant_new_uint32(1)); // GTK_IMAGE_PIXBUF
+    g_variant_builder_add(&changes, "{sv}", "image_data", g_variant_new_string(image_data));
+
+    server_.GetObjects().front()->EmitSignal("EntryChanged",
+      g_variant_new(ENTRY_DELTA_SIGNATURE, sequence, "test_indicator_id", "test_entry_id", &changes));
+  }
+  else if (method == "SyncCount")
+  {
+    return g_variant_new("(u)", sync_count_);
+  }
   else if (method == "GetIconPaths")
   {
     return g_variant_new("(as)", nullptr);
@@ -18,6 +18,7 @@ private:
 
   unsigned sync_return_mode_;
   bool trigger_resync1_sent_;
+  unsigned sync_count_;
 
   glib::DBusServer server_;
 };
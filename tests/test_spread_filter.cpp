@@ -22,9 +22,12 @@
 #include <Nux/NuxTimerTickSource.h>
 #include <NuxCore/AnimationController.h>
 
+#include <UnityCore/GLibWrapper.h>
+
 #include "SpreadFilter.h"
 #include "SearchBar.h"
 #include "DashStyle.h"
+#include "mock-application.h"
 #include "test_utils.h"
 
 namespace unity
@@ -111,5 +114,208 @@ TEST_F(TestSpreadFilter, InVisibleWithoutText)
 }
 
 } // anonymous namespace
+
+struct TestSpreadFilterIndex : Test
+{
+  TestSpreadFilterIndex()
+    : animation_controller(tick_source)
+  {}
+
+  testmocks::MockApplicationWindow::Ptr AddWindow(Window xid, std::string const& title)
+  {
+    auto win = std::make_shared<testmocks::MockApplicationWindow::Nice>(xid);
+    win->SetTitle(title);
+    ApplicationManager::Default().window_opened.emit(win);
+    return win;
+  }
+
+  std::set<uint64_t> const& Search(std::string const& search)
+  {
+    filter.text = search;
+    filter.UpdateFilteredWindows();
+    return filter.FilteredWindows();
+  }
+
+  dash::Style style_;
+  nux::NuxTimerTickSource tick_source;
+  nux::animation::AnimationController animation_controller;
+  Filter filter;
+};
+
+TEST_F(TestSpreadFilterIndex, MatchesWindowTitles)
+{
+  AddWindow(1, "Terminal");
+  AddWindow(2, "Unity - Text Editor");
+  AddWindow(3, "unity.cpp - Editor");
+
+  EXPECT_THAT(Search("unity"), ElementsAre(2, 3));
+  EXPECT_THAT(Search("EDITOR"), ElementsAre(2, 3));
+  EXPECT_THAT(Search("te"), ElementsAre(1, 2));
+  EXPECT_THAT(Search("- text"), ElementsAre(2));
+  EXPECT_THAT(Search("missing"), IsEmpty());
+  EXPECT_THAT(Search(""), IsEmpty());
+}
+
+TEST_F(TestSpreadFilterIndex, MatchesApplicationTitles)
+{
+  auto app = std::make_shared<testmocks::MockApplication::Nice>("editor.desktop", "", "Text Editor");
+  app->windows_ = { std::make_shared<testmocks::MockApplicationWindow::Nice>(10),
+                    std::make_shared<testmocks::MockApplicationWindow::Nice>(11) };
+  ApplicationManager::Default().application_started.emit(app);
+  AddWindow(12, "Editor settings");
+
+  EXPECT_THAT(Search("editor"), ElementsAre(10, 11, 12));
+  EXPECT_THAT(Search("text"), ElementsAre(10, 11));
+
+  ApplicationManager::Default().application_stopped.emit(app);
+  EXPECT_THAT(Search("editor"), ElementsAre(12));
+}
+
+TEST_F(TestSpreadFilterIndex, NarrowingSearch)
+{
+  AddWindow(1, "Files");
+  AddWindow(2, "Firefox");
+  AddWindow(3, "Fire alarm");
+
+  EXPECT_THAT(Search("fi"), ElementsAre(1, 2, 3));
+  EXPECT_THAT(Search("fir"), ElementsAre(2, 3));
+  EXPECT_THAT(Search("fire"), ElementsAre(2, 3));
+  EXPECT_THAT(Search("firef"), ElementsAre(2));
+  EXPECT_THAT(Search("fi"), ElementsAre(1, 2, 3));
+  EXPECT_THAT(Search("les"), ElementsAre(1));
+}
+
+TEST_F(TestSpreadFilterIndex, TitleChangesUpdateFilter)
+{
+  auto win = AddWindow(1, "Terminal");
+  AddWindow(2, "Editor");
+  EXPECT_THAT(Search("editor"), ElementsAre(2));
+
+  bool changed = false;
+  filter.text.changed.connect([&changed] (std::string const&) { changed = true; });
+
+  win->SetTitle("Terminal - Editor");
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(1, 2));
+  EXPECT_THAT(Search("editor"), ElementsAre(1, 2));
+
+  win->SetTitle("Terminal");
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(2));
+  EXPECT_THAT(Search("terminal"), ElementsAre(1));
+}
+
+TEST_F(TestSpreadFilterIndex, OpenedAndClosedWindows)
+{
+  AddWindow(1, "Editor");
+  EXPECT_THAT(Search("editor"), ElementsAre(1));
+
+  auto win = AddWindow(2, "Another Editor");
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(1, 2));
+
+  ApplicationManager::Default().window_closed.emit(win);
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(1));
+  EXPECT_THAT(Search("editor"), ElementsAre(1));
+}
+
+TEST_F(TestSpreadFilterIndex, OpenedWindowsRefilterOnlyWhenSearching)
+{
+  bool changed = false;
+  filter.text.changed.connect([&changed] (std::string const&) { changed = true; });
+
+  AddWindow(1, "Editor");
+  EXPECT_FALSE(changed);
+
+  Search("editor");
+  tick_source.tick(ANIMATION_DURATION);
+  ASSERT_TRUE(filter.Visible());
+
+  AddWindow(2, "Terminal");
+  EXPECT_FALSE(changed);
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(1));
+
+  AddWindow(3, "Another Editor");
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(1, 3));
+}
+
+TEST_F(TestSpreadFilterIndex, OpenedWindowsOfMatchingApplications)
+{
+  auto app = std::make_shared<testmocks::MockApplication::Nice>("editor.desktop", "", "Text Editor");
+  ApplicationManager::Default().application_started.emit(app);
+  EXPECT_THAT(Search("editor"), IsEmpty());
+
+  auto win = std::make_shared<testmocks::MockApplicationWindow::Nice>(10);
+  win->SetTitle("Untitled");
+  ON_CALL(*win, application()).WillByDefault(Return(app));
+  ApplicationManager::Default().window_opened.emit(win);
+
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(10));
+}
+
+TEST_F(TestSpreadFilterIndex, StartedApplications)
+{
+  AddWindow(1, "Editor");
+  EXPECT_THAT(Search("edit"), ElementsAre(1));
+
+  bool changed = false;
+  filter.text.changed.connect([&changed] (std::string const&) { changed = true; });
+
+  auto app = std::make_shared<testmocks::MockApplication::Nice>("editor.desktop", "", "Text Editor");
+  app->windows_ = { std::make_shared<testmocks::MockApplicationWindow::Nice>(10),
+                    std::make_shared<testmocks::MockApplicationWindow::Nice>(11) };
+  ApplicationManager::Default().application_started.emit(app);
+
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(filter.FilteredWindows(), ElementsAre(1, 10, 11));
+  EXPECT_THAT(Search("editor"), ElementsAre(1, 10, 11));
+}
+
+TEST_F(TestSpreadFilterIndex, BENCHMARK_TEST(Benchmark))
+{
+  const std::vector<std::string> typed_searches = {"d", "do", "doc", "docu", "document", "document 4", "document 42"};
+
+  for (unsigned n_windows : {100, 500, 1000})
+  {
+    std::vector<testmocks::MockApplicationWindow::Ptr> windows;
+
+    for (unsigned i = 0; i < n_windows; ++i)
+    {
+      auto const& title = "Document " + std::to_string(i) + " - Editor " + std::to_string(i % 7);
+      windows.push_back(AddWindow(1000 * n_windows + i, title));
+    }
+
+    // What the filter used to do at each search change
+    std::set<uint64_t> old_filtered;
+    double old_usec = Utils::BenchmarkUSec([&windows, &typed_searches, &old_filtered] {
+      for (auto const& search : typed_searches)
+      {
+        auto const& lower_search = glib::String(g_utf8_casefold(search.c_str(), -1)).Str();
+        old_filtered.clear();
+
+        for (auto const& win : windows)
+        {
+          if (glib::String(g_utf8_casefold(win->title().c_str(), -1)).Str().find(lower_search) != std::string::npos)
+            old_filtered.insert(win->window_id());
+        }
+      }
+    }, 10);
+
+    double new_usec = Utils::BenchmarkUSec([this, &typed_searches] {
+      Search("");
+      for (auto const& search : typed_searches)
+        Search(search);
+    }, 10);
+
+    EXPECT_EQ(old_filtered, filter.FilteredWindows());
+
+    for (auto const& win : windows)
+      ApplicationManager::Default().window_closed.emit(win);
+
+    auto const& prefix = std::to_string(n_windows) + "_windows_";
+    RecordProperty(prefix + "old_usec", std::to_string(old_usec));
+    RecordProperty(prefix + "new_usec", std::to_string(new_usec));
+  }
+}
+
 } // spread namespace
 } // unity namespace
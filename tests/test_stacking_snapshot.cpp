@@ -0,0 +1,140 @@
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the  Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 3 along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <gmock/gmock.h>
+#include "StackingSnapshot.h"
+#include <glib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace unity
+{
+namespace
+{
+const nux::Geometry SCREEN(0, 0, 1920, 1080);
+const nux::Point VIEWPORT(0, 0);
+
+bool Overlap(nux::Geometry const& a, nux::Geometry const& b)
+{
+  return (a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height);
+}
+
+struct TestStackingSnapshot : testing::Test
+{
+  StackingSnapshot snapshot;
+};
+
+TEST_F(TestStackingSnapshot, Empty)
+{
+  snapshot.Build(SCREEN);
+  EXPECT_TRUE(snapshot.empty());
+  EXPECT_FALSE(snapshot.Intersects(SCREEN));
+  EXPECT_FALSE(snapshot.IsObscured(1));
+}
+
+TEST_F(TestStackingSnapshot, Intersects)
+{
+  snapshot.Add(1, nux::Geometry(0, 0, 100, 100), VIEWPORT, StackingSnapshot::INTERSECTS);
+  snapshot.Add(2, nux::Geometry(500, 500, 100, 100), VIEWPORT, 0);
+  snapshot.Add(3, nux::Geometry(-3000, 0, 100, 100), VIEWPORT, StackingSnapshot::INTERSECTS);
+  snapshot.Build(SCREEN);
+
+  EXPECT_EQ(3u, snapshot.size());
+  EXPECT_TRUE(snapshot.Intersects(nux::Geometry(99, 99, 10, 10)));
+  EXPECT_FALSE(snapshot.Intersects(nux::Geometry(100, 100, 10, 10)));
+  EXPECT_FALSE(snapshot.Intersects(nux::Geometry(50, 50, 0, 10)));
+  EXPECT_FALSE(snapshot.Intersects(nux::Geometry(550, 550, 10, 10)));
+  EXPECT_TRUE(snapshot.Intersects(nux::Geometry(550, 550, 10, 10), 0));
+  EXPECT_TRUE(snapshot.Intersects(nux::Geometry(-2950, 50, 10, 10)));
+  EXPECT_FALSE(snapshot.Intersects(nux::Geometry(-2800, 50, 10, 10)));
+}
+
+TEST_F(TestStackingSnapshot, IsObscured)
+{
+  snapshot.Add(1, nux::Geometry(0, 0, 100, 100), VIEWPORT, StackingSnapshot::INTERSECTS);
+  snapshot.Add(2, nux::Geometry(0, 0, 1920, 1080), VIEWPORT, StackingSnapshot::OBSCURES);
+  snapshot.Add(3, nux::Geometry(50, 50, 100, 100), VIEWPORT, StackingSnapshot::INTERSECTS);
+  snapshot.Add(4, nux::Geometry(50, 50, 100, 100), nux::Point(1, 0), StackingSnapshot::INTERSECTS);
+  snapshot.Add(5, nux::Geometry(1800, 900, 100, 100), nux::Point(1, 0), StackingSnapshot::OBSCURES);
+  snapshot.Add(6, nux::Geometry(2000, 50, 100, 100), VIEWPORT, StackingSnapshot::SHOW_DESKTOP);
+  snapshot.Build(SCREEN);
+
+  EXPECT_TRUE(snapshot.IsObscured(1));
+  EXPECT_FALSE(snapshot.IsObscured(2));
+  EXPECT_FALSE(snapshot.IsObscured(3));
+  EXPECT_FALSE(snapshot.IsObscured(4));
+  EXPECT_FALSE(snapshot.IsObscured(5));
+  EXPECT_TRUE(snapshot.IsObscured(6));
+  EXPECT_FALSE(snapshot.IsObscured(7));
+}
+
+TEST_F(TestStackingSnapshot, Rebuild)
+{
+  snapshot.Add(1, nux::Geometry(0, 0, 100, 100), VIEWPORT, StackingSnapshot::INTERSECTS);
+  snapshot.Build(SCREEN);
+  ASSERT_TRUE(snapshot.Intersects(nux::Geometry(10, 10, 10, 10)));
+
+  snapshot.Clear();
+  snapshot.Add(1, nux::Geometry(200, 200, 100, 100), VIEWPORT, StackingSnapshot::INTERSECTS);
+  snapshot.Build(SCREEN);
+  EXPECT_FALSE(snapshot.Intersects(nux::Geometry(10, 10, 10, 10)));
+  EXPECT_TRUE(snapshot.Intersects(nux::Geometry(210, 210, 10, 10)));
+}
+
+TEST_F(TestStackingSnapshot, MatchesLinearScan)
+{
+  struct Win { Window xid; nux::Geometry geo; unsigned flags; };
+  std::vector<Win> windows;
+  g_random_set_seed(0);
+
+  for (Window xid = 1; xid <= 300; ++xid)
+  {
+    nux::Geometry geo(g_random_int_range(-SCREEN.width, SCREEN.width * 2), g_random_int_range(0, SCREEN.height),
+                      g_random_int_range(100, 800), g_random_int_range(100, 600));
+    unsigned flags = (xid % 10) ? StackingSnapshot::INTERSECTS : StackingSnapshot::OBSCURES;
+    windows.push_back({xid, geo, flags});
+    snapshot.Add(xid, geo, VIEWPORT, flags);
+  }
+
+  snapshot.Build(SCREEN);
+
+  // A launcher-like area, moving along the screen edge
+  for (int y = 0; y < SCREEN.height; y += 10)
+  {
+    nux::Geometry region(0, y, 64, 48);
+    bool intersects = std::any_of(windows.begin(), windows.end(), [&region] (Win const& win) {
+      return (win.flags & StackingSnapshot::INTERSECTS) && Overlap(win.geo, region);
+    });
+
+    EXPECT_EQ(intersects, snapshot.Intersects(region));
+  }
+
+  for (auto it = windows.begin(); it != windows.end(); ++it)
+  {
+    bool obscured = std::any_of(it + 1, windows.end(), [&it] (Win const& sibling) {
+      return (sibling.flags & StackingSnapshot::OBSCURES) && Overlap(sibling.geo, it->geo);
+    });
+
+    EXPECT_EQ(obscured, snapshot.IsObscured(it->xid));
+  }
+}
+
+} // anonymous namespace
+} // unity namespace
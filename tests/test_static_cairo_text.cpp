@@ -40,6 +40,7 @@ public:
 
   using StaticCairoText::GetTextureStartIndices;
   using StaticCairoText::GetTextureEndIndices;
+  using StaticCairoText::GetTextures;
   using StaticCairoText::PreLayoutManagement;
 };
 
@@ -133,4 +134,56 @@ TEST_F(TestStaticCairoText, TextRightToLeftExtentIncreasesWithLength)
   }
 }
 
+TEST_F(TestStaticCairoText, LayoutIsSharedBetweenTexts)
+{
+  StaticCairoText::ClearLayoutCache();
+  text->SetText("A shared text");
+  ASSERT_EQ(1u, StaticCairoText::GetLayoutCacheStats().misses);
+
+  nux::ObjectPtr<MockStaticCairoText> other(new NiceMock<MockStaticCairoText>());
+  other->SetText("A shared text");
+
+  auto const& stats = StaticCairoText::GetLayoutCacheStats();
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.entries);
+  EXPECT_EQ(text->GetTextExtents().width, other->GetTextExtents().width);
+  EXPECT_EQ(text->GetTextExtents().height, other->GetTextExtents().height);
+  EXPECT_EQ(text->GetTextureStartIndices(), other->GetTextureStartIndices());
+}
+
+TEST_F(TestStaticCairoText, ColorChangesDontRelayout)
+{
+  StaticCairoText::ClearLayoutCache();
+  text->SetText("A colored text");
+  auto const& stats = StaticCairoText::GetLayoutCacheStats();
+  auto const& textures = text->GetTextures();
+  ASSERT_FALSE(textures.empty());
+
+  text->SetTextColor(nux::color::Red);
+  text->SetTextAlpha(0);
+
+  auto const& new_stats = StaticCairoText::GetLayoutCacheStats();
+  EXPECT_EQ(stats.hits, new_stats.hits);
+  EXPECT_EQ(stats.misses, new_stats.misses);
+  EXPECT_EQ(textures, text->GetTextures());
+}
+
+TEST_F(TestStaticCairoText, MaximumWidthChangesLayout)
+{
+  StaticCairoText::ClearLayoutCache();
+  int max_width = text->GetMaximumWidth();
+  text->SetText("Just a test string of awesome text!");
+  int width = text->GetTextExtents().width;
+
+  text->SetMaximumWidth(width / 2);
+  EXPECT_LE(text->GetTextExtents().width, width / 2);
+  EXPECT_EQ(2u, StaticCairoText::GetLayoutCacheStats().misses);
+
+  text->SetMaximumWidth(max_width);
+  EXPECT_EQ(width, text->GetTextExtents().width);
+  EXPECT_EQ(2u, StaticCairoText::GetLayoutCacheStats().misses);
+  EXPECT_EQ(1u, StaticCairoText::GetLayoutCacheStats().hits);
+}
+
 }
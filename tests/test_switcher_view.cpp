@@ -181,6 +181,35 @@ TEST_P(AnimationProgress, UpdateRenderTargets)
   }
 }
 
+TEST_P(AnimationProgress, UpdateRenderTargetsRefreshesGeometry)
+{
+  float progress = GetParam();
+
+  AddFakeApplicationToSwitcher(1);
+  Window xid = switcher.GetModel()->DetailXids().front();
+  auto const& window = WM->GetWindowByXid(xid);
+
+  switcher.UpdateRenderTargets(progress);
+  auto layout_win = switcher.ExternalTargets().front();
+  ASSERT_EQ(window->geo(), layout_win->geo);
+
+  window->geo = nux::Geometry(10, 20, 300, 100);
+  window->maximized = true;
+  switcher.UpdateRenderTargets(progress);
+
+  ASSERT_EQ(layout_win, switcher.ExternalTargets().front());
+  EXPECT_EQ(5u, layout_win->decoration_height);
+  EXPECT_EQ(nux::Geometry(10, 20, 300, 105), layout_win->geo);
+  EXPECT_FLOAT_EQ(300 / 105.0f, layout_win->aspect_ratio);
+
+  window->maximized = false;
+  switcher.UpdateRenderTargets(progress);
+
+  EXPECT_EQ(0u, layout_win->decoration_height);
+  EXPECT_EQ(nux::Geometry(10, 20, 300, 100), layout_win->geo);
+  EXPECT_FLOAT_EQ(3.0f, layout_win->aspect_ratio);
+}
+
 TEST_P(AnimationProgress, ResizeRenderTargets)
 {
   AddFakeApplicationToSwitcher();
@@ -0,0 +1,256 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright 2016 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3, as
+ * published by the  Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the applicable version of the GNU Lesser General Public
+ * License for more details.
+ *
+ * You should have received a copy of both the GNU Lesser General Public
+ * License version 3 along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ *
+ */
+
+#include <gmock/gmock.h>
+using namespace testing;
+
+#include <pango/pangocairo.h>
+#include <UnityCore/GLibWrapper.h>
+#include "dash/TextTileRenderer.h"
+#include "test_utils.h"
+
+namespace unity
+{
+namespace dash
+{
+namespace
+{
+
+TextTileStyle DefaultStyle(double scale = 1.0)
+{
+  TextTileStyle style;
+  style.font = "Ubuntu 10";
+  style.width = 120 * scale;
+  style.height = 40 * scale;
+  style.scale = scale;
+
+  return style;
+}
+
+bool IsEmpty(TextTile::Ptr const& tile)
+{
+  for (int y = 0; y < tile->geometry().height; ++y)
+    for (int x = 0; x < tile->geometry().width; ++x)
+      if (tile->GetPixel(x, y))
+        return false;
+
+  return true;
+}
+
+struct TestTextTileRenderer : Test
+{
+  void WaitForTiles(std::vector<TextTile::Ptr> const& tiles)
+  {
+    Utils::WaitUntilMSec([&tiles] {
+      for (auto const& tile : tiles)
+        if (!tile->ready())
+          return false;
+
+      return true;
+    }, true, 3000);
+  }
+
+  TextTileRenderer renderer;
+};
+
+TEST_F(TestTextTileRenderer, InvalidStyle)
+{
+  TextTileStyle style = DefaultStyle();
+  style.width = 0;
+
+  EXPECT_FALSE(renderer.RenderText("Foo", style));
+}
+
+TEST_F(TestTextTileRenderer, RenderText)
+{
+  bool tiles_ready = false;
+  renderer.tiles_ready.connect([&tiles_ready] { tiles_ready = true; });
+
+  auto const& tile = renderer.RenderText("Foo Bar", DefaultStyle());
+  ASSERT_TRUE(tile);
+  EXPECT_FALSE(tile->ready());
+
+  Utils::WaitUntilMSec(tiles_ready);
+  EXPECT_TRUE(tile->ready());
+  EXPECT_EQ(120, tile->geometry().width);
+  EXPECT_EQ(40, tile->geometry().height);
+  EXPECT_FALSE(IsEmpty(tile));
+}
+
+TEST_F(TestTextTileRenderer, SameTextIsCached)
+{
+  auto const& tile = renderer.RenderText("Cached", DefaultStyle());
+  WaitForTiles({tile});
+
+  EXPECT_EQ(tile, renderer.RenderText("Cached", DefaultStyle()));
+  EXPECT_EQ(1u, renderer.GetStats().rendered_tiles);
+  EXPECT_EQ(1u, renderer.GetStats().cached_tiles);
+}
+
+TEST_F(TestTextTileRenderer, PendingTextIsNotRenderedTwice)
+{
+  auto const& tile = renderer.RenderText("Pending", DefaultStyle());
+  EXPECT_EQ(tile, renderer.RenderText("Pending", DefaultStyle()));
+
+  WaitForTiles({tile});
+  EXPECT_EQ(1u, renderer.GetStats().rendered_tiles);
+}
+
+TEST_F(TestTextTileRenderer, CacheKeysOnSizeAndScale)
+{
+  auto style = DefaultStyle();
+  auto const& tile = renderer.RenderText("Text", style);
+
+  style.width += 10;
+  auto const& wider_tile = renderer.RenderText("Text", style);
+
+  auto const& scaled_tile = renderer.RenderText("Text", DefaultStyle(2.0));
+
+  EXPECT_NE(tile, wider_tile);
+  EXPECT_NE(tile, scaled_tile);
+  EXPECT_NE(wider_tile, scaled_tile);
+  EXPECT_EQ(240, scaled_tile->geometry().width);
+
+  WaitForTiles({tile, wider_tile, scaled_tile});
+  EXPECT_EQ(3u, renderer.GetStats().rendered_tiles);
+}
+
+TEST_F(TestTextTileRenderer, TilesShareAtlasAndLayout)
+{
+  std::vector<TextTile::Ptr> tiles;
+
+  for (int i = 0; i < 100; ++i)
+    tiles.push_back(renderer.RenderText("Result " + std::to_string(i), DefaultStyle()));
+
+  WaitForTiles(tiles);
+
+  auto const& stats = renderer.GetStats();
+  EXPECT_EQ(100u, stats.rendered_tiles);
+  EXPECT_EQ(0u, stats.pending_tiles);
+  EXPECT_EQ(1u, stats.atlas_pages);
+  EXPECT_EQ(1u, stats.layouts);
+  EXPECT_LT(stats.batches, 100u);
+
+  for (unsigned i = 1; i < tiles.size(); ++i)
+  {
+    EXPECT_NE(tiles[i - 1]->geometry(), tiles[i]->geometry());
+    EXPECT_FALSE(IsEmpty(tiles[i]));
+  }
+}
+
+TEST_F(TestTextTileRenderer, NewLayoutPerFont)
+{
+  auto style = DefaultStyle();
+  auto const& tile = renderer.RenderText("Text", style);
+
+  style.font = "Ubuntu Bold 12";
+  auto const& bold_tile = renderer.RenderText("Text", style);
+
+  style.dpi = 120;
+  auto const& dpi_tile = renderer.RenderText("Text", style);
+
+  WaitForTiles({tile, bold_tile, dpi_tile});
+  EXPECT_EQ(3u, renderer.GetStats().layouts);
+}
+
+TEST_F(TestTextTileRenderer, UnusedTileIsKeptInCache)
+{
+  nux::Geometry geo;
+  {
+    auto const& tile = renderer.RenderText("Unused", DefaultStyle());
+    geo = tile->geometry();
+    WaitForTiles({tile});
+  }
+
+  auto const& tile = renderer.RenderText("Unused", DefaultStyle());
+  EXPECT_TRUE(tile->ready());
+  EXPECT_EQ(geo, tile->geometry());
+  EXPECT_EQ(1u, renderer.GetStats().rendered_tiles);
+}
+
+TEST_F(TestTextTileRenderer, BENCHMARK_TEST(Benchmark))
+{
+  const unsigned n_labels = 200;
+  auto const& style = DefaultStyle();
+  unsigned iteration = 0;
+
+  // What ResultRendererTile used to do for each result
+  double old_usec = Utils::BenchmarkUSec([&style, &iteration] {
+    for (unsigned i = 0; i < n_labels; ++i)
+    {
+      cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, style.width, style.height);
+      cairo_t* cr = cairo_create(surface);
+      PangoLayout* layout = pango_cairo_create_layout(cr);
+      PangoFontDescription* desc = pango_font_description_from_string(style.font.c_str());
+      pango_layout_set_font_description(layout, desc);
+      pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+      pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
+      pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_START);
+      pango_layout_set_width(layout, style.width * PANGO_SCALE);
+      pango_layout_set_height(layout, -2);
+
+      auto const& text = "Result " + std::to_string(iteration) + ":" + std::to_string(i);
+      glib::String escaped(g_markup_escape_text(text.c_str(), -1));
+      pango_layout_set_markup(layout, escaped, -1);
+      pango_cairo_context_set_resolution(pango_layout_get_context(layout), style.dpi);
+      pango_layout_context_changed(layout);
+
+      cairo_set_source_rgba(cr, 1.0f, 1.0f, 1.0f, 1.0f);
+      pango_cairo_show_layout(cr, layout);
+
+      pango_font_description_free(desc);
+      g_object_unref(layout);
+      cairo_destroy(cr);
+      cairo_surface_destroy(surface);
+    }
+
+    ++iteration;
+  }, 5);
+
+  iteration = 0;
+
+  // Time to first paint of a search returning new results
+  double new_usec = Utils::BenchmarkUSec([this, &style, &iteration] {
+    std::vector<TextTile::Ptr> tiles;
+
+    for (unsigned i = 0; i < n_labels; ++i)
+      tiles.push_back(renderer.RenderText("Result " + std::to_string(iteration) + ":" + std::to_string(i), style));
+
+    WaitForTiles(tiles);
+    ++iteration;
+  }, 5);
+
+  // The same search again, all the labels are cached
+  auto const& last_search = "Result " + std::to_string(iteration - 1) + ":";
+  double cached_usec = Utils::BenchmarkUSec([this, &style, &last_search] {
+    for (unsigned i = 0; i < n_labels; ++i)
+      renderer.RenderText(last_search + std::to_string(i), style);
+  }, 5);
+
+  RecordProperty("old_usec", std::to_string(old_usec));
+  RecordProperty("new_usec", std::to_string(new_usec));
+  RecordProperty("cached_usec", std::to_string(cached_usec));
+}
+
+} // anonymous namespace
+} // dash namespace
+} // unity namespace
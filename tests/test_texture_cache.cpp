@@ -19,6 +19,7 @@
 
 #include <gmock/gmock.h>
 
+#include <UnityCore/GLibWrapper.h>
 #include "TextureCache.h"
 
 using namespace testing;
@@ -134,4 +135,111 @@ TEST(TestTextureCache, Invalidate)
   EXPECT_EQ(2, counter.count);
 }
 
+nux::BaseTexture* SizedTextureCallback(std::string const&, int width, int height)
+{
+  glib::Object<GdkPixbuf> pixbuf(gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, width, height));
+  return nux::CreateTexture2DFromPixbuf(pixbuf, true);
+}
+
+struct TestTextureCacheRetention : Test
+{
+  TestTextureCacheRetention()
+    : cache(TextureCache::GetDefault())
+    , stats(cache.GetStats())
+  {}
+
+  ~TestTextureCacheRetention()
+  {
+    cache.SetRetentionBudget(0);
+  }
+
+  TextureCache& cache;
+  TextureCache::Stats stats;
+};
+
+TEST_F(TestTextureCacheRetention, SizeInBytes)
+{
+  auto t1 = cache.FindTexture("foo", 8, 4, SizedTextureCallback);
+  auto t2 = cache.FindTexture("bar", 2, 2, SizedTextureCallback);
+  EXPECT_EQ((8 * 4 + 2 * 2) * 4u, cache.SizeInBytes());
+
+  t1 = nux::ObjectPtr<nux::BaseTexture>();
+  EXPECT_EQ(2 * 2 * 4u, cache.SizeInBytes());
+
+  cache.Invalidate("bar", 2, 2);
+  EXPECT_EQ(0u, cache.SizeInBytes());
+}
+
+TEST_F(TestTextureCacheRetention, DisabledByDefault)
+{
+  ASSERT_EQ(0u, cache.RetentionBudget());
+  cache.FindTexture("foo", 8, 8, SizedTextureCallback);
+
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(0u, cache.RetainedBytes());
+}
+
+TEST_F(TestTextureCacheRetention, KeepsUnusedTexturesAlive)
+{
+  cache.SetRetentionBudget(8 * 8 * 4);
+  nux::BaseTexture* texture = cache.FindTexture("foo", 8, 8, SizedTextureCallback).GetPointer();
+
+  EXPECT_EQ(1u, cache.Size());
+  EXPECT_EQ(8 * 8 * 4u, cache.RetainedBytes());
+  EXPECT_EQ(texture, cache.FindTexture("foo", 8, 8, SizedTextureCallback).GetPointer());
+  EXPECT_EQ(stats.misses + 1, cache.GetStats().misses);
+  EXPECT_EQ(stats.hits + 1, cache.GetStats().hits);
+}
+
+TEST_F(TestTextureCacheRetention, EvictsLeastRecentlyUsed)
+{
+  cache.SetRetentionBudget(2 * 8 * 8 * 4);
+  cache.FindTexture("foo", 8, 8, SizedTextureCallback);
+  cache.FindTexture("bar", 8, 8, SizedTextureCallback);
+  cache.FindTexture("foo", 8, 8, SizedTextureCallback);
+  cache.FindTexture("baz", 8, 8, SizedTextureCallback);
+
+  EXPECT_EQ(2u, cache.Size());
+  EXPECT_EQ(2 * 8 * 8 * 4u, cache.RetainedBytes());
+  EXPECT_EQ(stats.evictions + 1, cache.GetStats().evictions);
+
+  TextureCallbackCounter counter;
+  TextureCache::CreateTextureCallback callback(sigc::mem_fun(counter, &TextureCallbackCounter::callback));
+  cache.FindTexture("foo", 8, 8, callback);
+  cache.FindTexture("baz", 8, 8, callback);
+  EXPECT_EQ(0, counter.count);
+}
+
+TEST_F(TestTextureCacheRetention, TooBigTexturesAreNotRetained)
+{
+  cache.SetRetentionBudget(8 * 8 * 4);
+  cache.FindTexture("foo", 16, 16, SizedTextureCallback);
+
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(0u, cache.RetainedBytes());
+}
+
+TEST_F(TestTextureCacheRetention, ShrinkingBudgetEvicts)
+{
+  cache.SetRetentionBudget(2 * 8 * 8 * 4);
+  cache.FindTexture("foo", 8, 8, SizedTextureCallback);
+  cache.FindTexture("bar", 8, 8, SizedTextureCallback);
+  ASSERT_EQ(2u, cache.Size());
+
+  cache.SetRetentionBudget(0);
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(0u, cache.RetainedBytes());
+  EXPECT_EQ(0u, cache.SizeInBytes());
+}
+
+TEST_F(TestTextureCacheRetention, InvalidateReleasesRetained)
+{
+  cache.SetRetentionBudget(8 * 8 * 4);
+  cache.FindTexture("foo", 8, 8, SizedTextureCallback);
+  cache.Invalidate("foo", 8, 8);
+
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(0u, cache.RetainedBytes());
+}
+
 }
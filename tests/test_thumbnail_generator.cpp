@@ -210,4 +210,85 @@ TEST(TestThumbnailGenerator, TestGetManyGIcon)
 }
 
 
+TEST(TestThumbnailGenerator, TestDeduplicatesRequests)
+{
+  ThumbnailGenerator thumbnail_generator;
+
+  LoadResult result1, result2;
+  ThumbnailNotifier::Ptr thumb1 = thumbnail_generator.GetThumbnail("file:///usr", 128);
+  ThumbnailNotifier::Ptr thumb2 = thumbnail_generator.GetThumbnail("file:///usr", 128);
+  ASSERT_NE(thumb1, thumb2);
+
+  thumb1->ready.connect(sigc::mem_fun(result1, &LoadResult::ThumbnailReady));
+  thumb2->ready.connect(sigc::mem_fun(result2, &LoadResult::ThumbnailReady));
+
+  Utils::WaitUntilMSec([&result1, &result2] { return result1.got_callback && result2.got_callback; }, true, 1500);
+
+  EXPECT_TRUE(result1.succeeded);
+  EXPECT_TRUE(result2.succeeded);
+  EXPECT_EQ(result1.return_string, result2.return_string);
+}
+
+TEST(TestThumbnailGenerator, TestCancelledRequestsAreNeverDelivered)
+{
+  ThumbnailGenerator thumbnail_generator;
+
+  const unsigned load_count = 50;
+  std::vector<LoadResult> results(load_count);
+  std::vector<ThumbnailNotifier::Ptr> notifiers(load_count);
+
+  for (unsigned i = 0; i < load_count; ++i)
+  {
+    notifiers[i] = thumbnail_generator.GetThumbnail("file:///usr", i + 1);
+    notifiers[i]->ready.connect(sigc::mem_fun(results[i], &LoadResult::ThumbnailReady));
+    notifiers[i]->error.connect(sigc::mem_fun(results[i], &LoadResult::ThumbnailFailed));
+  }
+
+  for (auto const& notifier : notifiers)
+    notifier->Cancel();
+
+  // Requests are started in order, so by now the cancelled ones were dropped
+  LoadResult last_result;
+  auto last = thumbnail_generator.GetThumbnail("file:///usr", load_count + 1);
+  last->ready.connect(sigc::mem_fun(last_result, &LoadResult::ThumbnailReady));
+  last->error.connect(sigc::mem_fun(last_result, &LoadResult::ThumbnailFailed));
+
+  Utils::WaitUntilMSec(last_result.got_callback, 3000);
+  Utils::WaitPendingEvents();
+
+  for (auto const& result : results)
+    EXPECT_FALSE(result.got_callback);
+}
+
+TEST(TestThumbnailGenerator, TestCancelAfterDestruction)
+{
+  ThumbnailNotifier::Ptr notifier;
+  bool cancelled = false;
+
+  {
+    ThumbnailGenerator thumbnail_generator;
+    notifier = thumbnail_generator.GetThumbnail("file:///usr", 1024);
+    notifier->cancelled.connect([&cancelled] { cancelled = true; });
+  }
+
+  notifier->Cancel();
+  EXPECT_TRUE(cancelled);
+  EXPECT_TRUE(notifier->IsCancelled());
+}
+
+TEST(TestThumbnailGenerator, TestLatencyStats)
+{
+  ThumbnailGenerator thumbnail_generator;
+
+  LoadResult load_result;
+  ThumbnailNotifier::Ptr thumb = thumbnail_generator.GetThumbnail("file:///bin/bash", 64);
+  thumb->ready.connect(sigc::mem_fun(load_result, &LoadResult::ThumbnailReady));
+
+  Utils::WaitUntilMSec(load_result.got_callback, 1500);
+
+  auto const& stats = thumbnail_generator.GetStats();
+  EXPECT_EQ(0u, stats.queued);
+  EXPECT_GE(stats.max_latency_ms, stats.average_latency_ms);
+}
+
 }
@@ -19,6 +19,8 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
 #include <time.h>
 #include "TimeUtil.h"
 #include "test_utils.h"
@@ -36,6 +38,73 @@ using namespace unity;
 namespace
 {
 
+// The UBusServer implementation before message names were interned
+namespace old
+{
+class UBusServer
+{
+public:
+  UBusServer() : last_id_(0) {}
+
+  unsigned RegisterInterest(std::string const& interest_name, UBusCallback const& slot)
+  {
+    unsigned connection_id = ++last_id_;
+    interests_.insert({interest_name, std::make_shared<Connection>(slot, connection_id)});
+    return connection_id;
+  }
+
+  void UnregisterInterest(unsigned connection_id)
+  {
+    auto it = std::find_if(interests_.begin(), interests_.end(),
+                           [connection_id] (std::pair<std::string, Connection::Ptr> const& p)
+                           { return p.second->id == connection_id; });
+    if (it != interests_.end()) interests_.erase(it);
+  }
+
+  void SendMessage(std::string const& message_name, glib::Variant const& args = glib::Variant())
+  {
+    msg_queue_.insert({0, std::make_pair(message_name, args)});
+  }
+
+  void DispatchMessages()
+  {
+    std::vector<std::pair<std::string, glib::Variant>> dispatched_msgs;
+    auto iterators = msg_queue_.equal_range(0);
+    for (auto it = iterators.first; it != iterators.second; ++it)
+      dispatched_msgs.push_back(it->second);
+
+    msg_queue_.erase(0);
+
+    for (auto const& msg : dispatched_msgs)
+    {
+      auto interest_it = interests_.find(msg.first);
+      while (interest_it != interests_.end())
+      {
+        Connection::Ptr connection(interest_it->second);
+        ++interest_it;
+        connection->slot(msg.second);
+
+        if (interest_it == interests_.end() || interest_it->first != msg.first)
+          break;
+      }
+    }
+  }
+
+private:
+  struct Connection
+  {
+    typedef std::shared_ptr<Connection> Ptr;
+    Connection(UBusCallback const& cb, unsigned connection_id) : slot(cb), id(connection_id) {}
+    UBusCallback slot;
+    unsigned id;
+  };
+
+  unsigned last_id_;
+  std::multimap<std::string, Connection::Ptr> interests_;
+  std::multimap<int, std::pair<std::string, glib::Variant>> msg_queue_;
+};
+}
+
 struct TestUBusServer : public testing::Test
 {
   UBusServer ubus_server;
@@ -245,6 +314,165 @@ TEST_F(TestUBusServer, DispatchesWithPriority)
   EXPECT_EQ(order, "45123");
 }
 
+TEST_F(TestUBusServer, UnregisterOtherInsideCallback)
+{
+  std::string order;
+  unsigned second_id = 0;
+
+  ubus_server.RegisterInterest(MESSAGE1, [&] (glib::Variant const&) {
+    order += "1";
+    ubus_server.UnregisterInterest(second_id);
+  });
+  second_id = ubus_server.RegisterInterest(MESSAGE1, [&order] (glib::Variant const&)
+      { order += "2"; });
+  ubus_server.RegisterInterest(MESSAGE1, [&order] (glib::Variant const&)
+      { order += "3"; });
+
+  ubus_server.SendMessage(MESSAGE1);
+  ubus_server.SendMessage(MESSAGE1);
+
+  ProcessMessages();
+  EXPECT_EQ(order, "1313");
+}
+
+TEST_F(TestUBusServer, RegisterInsideCallback)
+{
+  std::string order;
+
+  ubus_server.RegisterInterest(MESSAGE1, [&] (glib::Variant const&) {
+    order += "1";
+    ubus_server.RegisterInterest(MESSAGE1, [&order] (glib::Variant const&)
+      { order += "2"; });
+  });
+
+  ubus_server.SendMessage(MESSAGE1);
+  ProcessMessages();
+  EXPECT_EQ(order, "1");
+
+  ubus_server.SendMessage(MESSAGE1);
+  ProcessMessages();
+  EXPECT_EQ(order, "112");
+}
+
+TEST_F(TestUBusServer, UnregisterMany)
+{
+  std::vector<unsigned> ids;
+
+  for (unsigned i = 0; i < 100; ++i)
+    ids.push_back(ubus_server.RegisterInterest(MESSAGE1, sigc::mem_fun(this, &TestUBusServer::Callback)));
+
+  for (unsigned i = 0; i < ids.size(); i += 2)
+    ubus_server.UnregisterInterest(ids[i]);
+
+  ubus_server.SendMessage(MESSAGE1);
+  ProcessMessages();
+  EXPECT_EQ(callback_call_count, 50u);
+
+  for (unsigned i = 1; i < ids.size(); i += 2)
+    ubus_server.UnregisterInterest(ids[i]);
+
+  ubus_server.SendMessage(MESSAGE1);
+  ProcessMessages();
+  EXPECT_EQ(callback_call_count, 50u);
+}
+
+TEST_F(TestUBusServer, CoalescedMessages)
+{
+  ubus_server.RegisterInterest(MESSAGE1, sigc::mem_fun(this, &TestUBusServer::Callback));
+
+  for (auto const& data : {"foo", "bar", "baz"})
+    ubus_server.SendCoalescedMessage(MESSAGE1, glib::Variant(data), glib::Source::Priority::DEFAULT);
+
+  ProcessMessages();
+  EXPECT_EQ(callback_call_count, 1u);
+  EXPECT_EQ(last_msg_variant.GetString(), "baz");
+}
+
+TEST_F(TestUBusServer, CoalescedMessagesKeepOrder)
+{
+  std::string order;
+
+  ubus_server.RegisterInterest(MESSAGE1, [&order] (glib::Variant const& data)
+      { order += data.GetString(); });
+  ubus_server.RegisterInterest(MESSAGE2, [&order] (glib::Variant const&)
+      { order += "-"; });
+
+  ubus_server.SendCoalescedMessage(MESSAGE1, glib::Variant("1"), glib::Source::Priority::DEFAULT);
+  ubus_server.SendMessageFull(MESSAGE2, glib::Variant(), glib::Source::Priority::DEFAULT);
+  ubus_server.SendCoalescedMessage(MESSAGE1, glib::Variant("2"), glib::Source::Priority::DEFAULT);
+
+  ProcessMessages();
+  EXPECT_EQ(order, "2-");
+
+  // Once dispatched, a new message is queued again
+  ubus_server.SendCoalescedMessage(MESSAGE1, glib::Variant("3"), glib::Source::Priority::DEFAULT);
+  ProcessMessages();
+  EXPECT_EQ(order, "2-3");
+}
+
+TEST(TestUBusServerBenchmark, BENCHMARK_TEST(RegisterSendUnregister))
+{
+  const unsigned messages = 50;
+  const unsigned interests_per_message = 8;
+  std::vector<std::string> names;
+
+  for (unsigned i = 0; i < messages; ++i)
+    names.push_back("UBUS_BENCHMARK_MESSAGE_" + std::to_string(i));
+
+  unsigned calls = 0;
+  auto cb = [&calls] (glib::Variant const&) { ++calls; };
+
+  double old_usec = Utils::BenchmarkUSec([&] {
+    old::UBusServer server;
+    std::vector<unsigned> ids;
+
+    for (unsigned i = 0; i < interests_per_message; ++i)
+      for (auto const& name : names)
+        ids.push_back(server.RegisterInterest(name, cb));
+
+    for (unsigned i = 0; i < 10; ++i)
+    {
+      for (auto const& name : names)
+        server.SendMessage(name);
+
+      server.DispatchMessages();
+
+      bool dispatched = false;
+      glib::Idle idle([&dispatched] { dispatched = true; return false; }, glib::Source::Priority::LOW);
+      Utils::WaitUntilMSec(dispatched);
+    }
+
+    for (auto id : ids)
+      server.UnregisterInterest(id);
+  }, 20);
+
+  double new_usec = Utils::BenchmarkUSec([&] {
+    UBusServer server;
+    std::vector<unsigned> ids;
+
+    for (unsigned i = 0; i < interests_per_message; ++i)
+      for (auto const& name : names)
+        ids.push_back(server.RegisterInterest(name, cb));
+
+    for (unsigned i = 0; i < 10; ++i)
+    {
+      for (auto const& name : names)
+        server.SendMessage(name);
+
+      bool dispatched = false;
+      glib::Idle idle([&dispatched] { dispatched = true; return false; }, glib::Source::Priority::LOW);
+      Utils::WaitUntilMSec(dispatched);
+    }
+
+    for (auto id : ids)
+      server.UnregisterInterest(id);
+  }, 20);
+
+  EXPECT_EQ(calls, 2 * 20 * 10 * messages * interests_per_message);
+  RecordProperty("old_usec", std::to_string(old_usec));
+  RecordProperty("new_usec", std::to_string(new_usec));
+}
+
 TEST_F(TestUBusManager, RegisterAndSend)
 {
   ubus_manager.RegisterInterest(MESSAGE1, sigc::mem_fun(this, &TestUBusManager::Callback));
@@ -18,6 +18,10 @@
 #define TEST_EVALUATOR(prefix,test) TEST_PREFIX(prefix,test)
 #define UNSTABLE_TEST(test) TEST_EVALUATOR(UNSTABLE_PREFIX, test)
 
+// Benchmarks are not run by default, use --gtest_also_run_disabled_tests
+// (i.e. with --gtest_filter=*Benchmark*) to get their timings.
+#define BENCHMARK_TEST(test) TEST_PREFIX(DISABLED, test)
+
 namespace
 {
 
@@ -107,6 +111,17 @@ public:
     }
   }
 
+  // Average time in microseconds spent by func over the given iterations
+  static double BenchmarkUSec(std::function<void()> const& func, unsigned iterations = 100)
+  {
+    gint64 start_time = g_get_monotonic_time();
+
+    for (unsigned i = 0; i < iterations; ++i)
+      func();
+
+    return (g_get_monotonic_time() - start_time) / static_cast<double>(iterations);
+  }
+
 private:
   static gboolean TimeoutCallback(gpointer data)
   {
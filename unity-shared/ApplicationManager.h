@@ -43,6 +43,8 @@ typedef std::shared_ptr<ApplicationSubject> ApplicationSubjectPtr;
 
 typedef std::vector<ApplicationPtr> ApplicationList;
 typedef std::vector<ApplicationWindowPtr> WindowList;
+typedef std::shared_ptr<ApplicationList const> ApplicationListPtr;
+typedef std::shared_ptr<WindowList const> WindowListPtr;
 
 enum class ApplicationEventType
 {
@@ -221,8 +223,9 @@ public:
   virtual ApplicationPtr GetActiveApplication() const = 0;
   virtual ApplicationWindowPtr GetActiveWindow() const = 0;
   virtual ApplicationPtr GetApplicationForDesktopFile(std::string const& desktop_file) const = 0;
-  virtual ApplicationList GetRunningApplications() const = 0;
-  virtual WindowList GetWindowsForMonitor(int monitor = -1) const = 0;
+  // The returned lists are shared and never modified, new ones are returned on changes
+  virtual ApplicationListPtr GetRunningApplications() const = 0;
+  virtual WindowListPtr GetWindowsForMonitor(int monitor = -1) const = 0;
   virtual ApplicationPtr GetApplicationForWindow(Window xid) const = 0;
   virtual ApplicationWindowPtr GetWindowForId(Window xid) const = 0;
   virtual void FocusWindowGroup(WindowList const&, bool show_on_visible, int monitor) const = 0;
@@ -30,6 +30,11 @@ const int BLUR_RADIUS = 3;
 const float sigma_high = 5.0f;
 const float sigma_med = 3.0f;
 const float sigma_low = 1.0f;
+const float NOISE_FACTOR = 1.1f;
+
+// Above these we just re-blur the whole region
+const unsigned MAX_DIRTY_RECTS = 16;
+const float MAX_DIRTY_AREA_RATIO = 0.5f;
 }
 
 using namespace unity;
@@ -38,12 +43,12 @@ nux::Property<BlurType> BackgroundEffectHelper::blur_type(BLUR_ACTIVE);
 nux::Geometry BackgroundEffectHelper::monitor_rect_;
 std::list<BackgroundEffectHelper*> BackgroundEffectHelper::registered_list_;
 std::vector<nux::Geometry> BackgroundEffectHelper::blur_geometries_;
+BackgroundEffectHelper::BlurStats BackgroundEffectHelper::blur_stats_;
 sigc::signal<void, nux::Geometry const&> BackgroundEffectHelper::blur_region_needs_update_;
 
 BackgroundEffectHelper::BackgroundEffectHelper(nux::View* view)
   : owner(view)
   , enabled(false)
-  , cache_dirty(true)
 {
   enabled.changed.connect(sigc::mem_fun(this, &BackgroundEffectHelper::OnEnabledChanged));
   owner.changed.connect(sigc::mem_fun(this, &BackgroundEffectHelper::OnOwnerChanged));
@@ -163,14 +168,22 @@ void BackgroundEffectHelper::UpdateBlurGeometries()
 
 void BackgroundEffectHelper::ProcessDamage(nux::Geometry const& geo)
 {
+  if (registered_list_.empty())
+    return;
+
+  int radius = GetBlurRadius();
+
   for (BackgroundEffectHelper* bg_effect_helper : registered_list_)
   {
-    if (bg_effect_helper->cache_dirty)
+    if (bg_effect_helper->cache_state_.IsFullyDirty())
       continue;
 
-    if (geo.IsIntersecting(bg_effect_helper->requested_blur_geometry_))
+    auto const& blur_geo = bg_effect_helper->requested_blur_geometry_;
+
+    if (geo.IsIntersecting(blur_geo))
     {
-      bg_effect_helper->DirtyCache();
+      // The damage affects the blurred pixels up to a blur radius away
+      bg_effect_helper->DirtyRegion(geo.GetExpand(radius, radius).Intersect(blur_geo));
     }
   }
 }
@@ -194,15 +207,51 @@ int BackgroundEffectHelper::GetBlurRadius()
 
 std::vector<nux::Geometry> const& BackgroundEffectHelper::GetBlurGeometries()
 {
-  /* TODO: to reduce useless glCopyTexSubImage2D during paint we should return
-   * here only damaged geometries */
   return blur_geometries_;
 }
 
+std::vector<nux::Geometry> BackgroundEffectHelper::GetDirtyBlurGeometries()
+{
+  std::vector<nux::Geometry> dirty_geometries;
+  int radius = GetBlurRadius();
+
+  for (BackgroundEffectHelper* bg_effect_helper : registered_list_)
+  {
+    auto const& blur_geo = bg_effect_helper->requested_blur_geometry_;
+
+    if (blur_geo.IsNull())
+      continue;
+
+    Update update = bg_effect_helper->NextUpdate();
+
+    if (update == Update::FULL)
+    {
+      dirty_geometries.push_back(blur_geo.GetExpand(radius, radius));
+    }
+    else if (update == Update::PARTIAL)
+    {
+      for (auto const& dirty_rect : bg_effect_helper->cache_state_.DirtyRects())
+        dirty_geometries.push_back(dirty_rect.GetExpand(radius, radius));
+    }
+  }
+
+  return dirty_geometries;
+}
+
+BackgroundEffectHelper::BlurStats const& BackgroundEffectHelper::GetBlurStats()
+{
+  return blur_stats_;
+}
+
+void BackgroundEffectHelper::ResetBlurStats()
+{
+  blur_stats_ = BlurStats();
+}
+
 bool BackgroundEffectHelper::HasDirtyHelpers()
 {
   for (BackgroundEffectHelper* bg_effect_helper : registered_list_)
-    if (bg_effect_helper->cache_dirty)
+    if (bg_effect_helper->NextUpdate() != Update::NONE)
       return true;
 
   return false;
@@ -227,38 +276,188 @@ void BackgroundEffectHelper::Unregister(BackgroundEffectHelper* self)
   UpdateBlurGeometries();
 }
 
+nux::Geometry BackgroundEffectHelper::MonitorBlurGeometry() const
+{
+  nux::Geometry geo = requested_blur_geometry_;
+  geo.OffsetPosition(-monitor_rect_.x, -monitor_rect_.y);
+  return nux::Geometry(0, 0, monitor_rect_.width, monitor_rect_.height).Intersect(geo);
+}
+
+// Must match what GetBlurRegion and GetRegion do, as only the returned
+// parts of the backup texture are updated in the frame.
+BackgroundEffectHelper::Update BackgroundEffectHelper::NextUpdate() const
+{
+  bool cache_valid = blur_texture_.IsValid() &&
+                     blur_texture_->GetWidth() == blur_geometry_.width &&
+                     blur_texture_->GetHeight() == blur_geometry_.height;
+  auto const& geo = MonitorBlurGeometry();
+
+  /* Static blur: only update when the size changed */
+  if (blur_type == BLUR_STATIC && cache_valid && geo == blur_geometry_)
+    return Update::NONE;
+
+  Update update = cache_state_.NextUpdate(blur_geometry_, geo, cache_valid);
+
+  // Only the GLSL blur updates tiles, the plain region is always copied as a whole
+  if (update == Update::PARTIAL && blur_type == BLUR_NONE)
+    return Update::FULL;
+
+  return update;
+}
+
 void BackgroundEffectHelper::DirtyCache()
 {
-  if ((cache_dirty && blur_geometry_ == requested_blur_geometry_) || !owner())
+  if (!owner())
+    return;
+
+  if (cache_state_.Invalidate() == Update::NONE && blur_geometry_ == requested_blur_geometry_)
     return;
 
-  cache_dirty = true;
   owner()->QueueDraw();
 
   int radius = GetBlurRadius();
   blur_region_needs_update_.emit(requested_blur_geometry_.GetExpand(radius, radius));
 }
 
-nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetBlurRegion(bool force_update)
+void BackgroundEffectHelper::DirtyRegion(nux::Geometry const& rect)
 {
-  bool should_update = force_update || cache_dirty;
+  if (rect.IsNull() || !owner())
+    return;
 
-  /* Static blur: only update when the size changed */
-  if ((blur_type != BLUR_ACTIVE || !should_update)
-      && blur_texture_.IsValid()
-      && (requested_blur_geometry_ == blur_geometry_))
+  nux::GpuDevice* gpu_device = nux::GetGraphicsDisplay()->GetGpuDevice();
+  bool support_frag = gpu_device->GetGpuInfo().Support_ARB_Fragment_Shader();
+  bool support_vert = gpu_device->GetGpuInfo().Support_ARB_Vertex_Shader();
+
+  // Tiled updates are only implemented for the GLSL blur
+  if (!blur_texture_.IsValid() || !support_vert || !support_frag || gpu_device->GetOpenGLMajorVersion() < 2)
   {
-    return blur_texture_;
+    DirtyCache();
+    return;
+  }
+
+  Update update = cache_state_.Damage(rect, requested_blur_geometry_);
+
+  if (update == Update::NONE)
+    return;
+
+  owner()->QueueDraw();
+
+  if (update == Update::FULL)
+  {
+    int radius = GetBlurRadius();
+    blur_region_needs_update_.emit(requested_blur_geometry_.GetExpand(radius, radius));
+  }
+  else
+  {
+    blur_region_needs_update_.emit(rect);
+  }
+}
+
+void BackgroundEffectHelper::BlurDirtyTiles()
+{
+  nux::GraphicsEngine* graphics_engine = nux::GetGraphicsDisplay()->GetGraphicsEngine();
+  nux::GpuDevice* gpu_device = nux::GetGraphicsDisplay()->GetGpuDevice();
+
+  int monitor_width = BackgroundEffectHelper::monitor_rect_.width;
+  int monitor_height = BackgroundEffectHelper::monitor_rect_.height;
+  nux::Geometry monitor_geo(0, 0, monitor_width, monitor_height);
+
+  const int radius = GetBlurRadius();
+  float gaussian_sigma = GetBlurSigma();
+
+  nux::ObjectPtr<nux::CachedBaseTexture> noise_device_texture = graphics_engine->CacheResource(noise_texture_.GetPointer());
+  nux::ObjectPtr<nux::IOpenGLBaseTexture> noise_texture = noise_device_texture->m_Texture;
+
+  if (!tile_fbo_.IsValid())
+    tile_fbo_ = gpu_device->CreateFrameBufferObject();
+
+  for (auto const& dirty_rect : cache_state_.DirtyRects())
+  {
+    nux::Geometry tile = dirty_rect;
+    tile.OffsetPosition(-monitor_rect_.x, -monitor_rect_.y);
+    tile = tile.Intersect(blur_geometry_);
+
+    if (tile.IsNull())
+      continue;
+
+    // Blur a region larger than the tile, so that its borders are blurred as the whole
+    nux::Geometry larger_tile = tile.GetExpand(radius, radius).Intersect(monitor_geo);
+
+    graphics_engine->SetViewport(0, 0, larger_tile.width, larger_tile.height);
+    graphics_engine->SetScissor(0, 0, larger_tile.width, larger_tile.height);
+    graphics_engine->GetRenderStates().EnableScissor(false);
+
+    nux::TexCoordXForm texxform__bg;
+    texxform__bg.flip_v_coord = false;
+    texxform__bg.SetTexCoordType(nux::TexCoordXForm::OFFSET_COORD);
+    texxform__bg.uoffset = ((float) larger_tile.x) / monitor_width;
+    texxform__bg.voffset = ((float) monitor_height - larger_tile.y - larger_tile.height) / monitor_height;
+
+    tile_blur_fx_struct_.src_texture = gpu_device->backup_texture0_;
+    graphics_engine->QRP_GLSL_GetLSBlurFx(0, 0, larger_tile.width, larger_tile.height,
+                                          &tile_blur_fx_struct_, texxform__bg, nux::color::White,
+                                          gaussian_sigma);
+
+    nux::TexCoordXForm texxform;
+    nux::TexCoordXForm noise_texxform;
+
+    texxform.SetFilter(nux::TEXFILTER_NEAREST, nux::TEXFILTER_NEAREST);
+    texxform.SetTexCoordType(nux::TexCoordXForm::OFFSET_COORD);
+    texxform.uoffset = (tile.x - larger_tile.x) / (float) larger_tile.width;
+    texxform.voffset = (tile.y - larger_tile.y) / (float) larger_tile.height;
+
+    // Keep the noise pattern aligned to the one of the whole blur texture
+    noise_texxform.SetTexCoordType(nux::TexCoordXForm::OFFSET_COORD);
+    noise_texxform.SetWrap(nux::TEXWRAP_REPEAT, nux::TEXWRAP_REPEAT);
+    noise_texxform.SetFilter(nux::TEXFILTER_NEAREST, nux::TEXFILTER_NEAREST);
+    noise_texxform.uoffset = (tile.x - blur_geometry_.x) / (float) noise_texture->GetWidth();
+    noise_texxform.voffset = (tile.y - blur_geometry_.y) / (float) noise_texture->GetHeight();
+
+    nux::Color noise_color(NOISE_FACTOR * 1.0f/larger_tile.width,
+                           NOISE_FACTOR * 1.0f/larger_tile.height,
+                           1.0f, 1.0f);
+
+    tile_noise_fx_struct_.src_texture = tile_blur_fx_struct_.dst_texture;
+    graphics_engine->QRP_GLSL_GetDisturbedTextureFx(
+      0, 0, tile.width, tile.height,
+      noise_texture, noise_texxform, noise_color,
+      &tile_noise_fx_struct_, texxform, nux::color::White);
+
+    // Replace the tile in the cached blur texture
+    tile_fbo_->FormatFrameBufferObject(blur_geometry_.width, blur_geometry_.height, nux::BITFMT_R8G8B8A8);
+    tile_fbo_->SetTextureAttachment(0, blur_texture_, 0);
+    tile_fbo_->Activate();
+
+    graphics_engine->SetViewport(0, 0, blur_geometry_.width, blur_geometry_.height);
+    graphics_engine->Push2DWindow(blur_geometry_.width, blur_geometry_.height);
+    graphics_engine->GetRenderStates().SetBlend(false);
+
+    nux::TexCoordXForm tile_texxform;
+    graphics_engine->QRP_1Tex(tile.x - blur_geometry_.x, tile.y - blur_geometry_.y,
+                              tile.width, tile.height, tile_noise_fx_struct_.dst_texture,
+                              tile_texxform, nux::color::White);
+
+    gpu_device->DeactivateFrameBuffer();
+
+    blur_stats_.blurred_pixels += larger_tile.width * larger_tile.height;
   }
 
+  ++blur_stats_.partial_updates;
+}
+
+nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetBlurRegion()
+{
+  Update update = NextUpdate();
+
+  if (update == Update::NONE)
+    return blur_texture_;
+
   nux::GraphicsEngine* graphics_engine = nux::GetGraphicsDisplay()->GetGraphicsEngine();
 
   int monitor_width = BackgroundEffectHelper::monitor_rect_.width;
   int monitor_height = BackgroundEffectHelper::monitor_rect_.height;
 
-  nux::Geometry temp = requested_blur_geometry_;
-  temp.OffsetPosition(-monitor_rect_.x, -monitor_rect_.y);
-  blur_geometry_ = nux::Geometry(0, 0, monitor_width, monitor_height).Intersect(temp);
+  blur_geometry_ = MonitorBlurGeometry();
 
   nux::GpuDevice* gpu_device = nux::GetGraphicsDisplay()->GetGpuDevice();
   if (blur_geometry_.IsNull() || blur_type == BLUR_NONE || !gpu_device->backup_texture0_.IsValid())
@@ -266,6 +465,37 @@ nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetBlurRegion(bo
     return nux::ObjectPtr<nux::IOpenGLBaseTexture>();
   }
 
+  bool support_frag = gpu_device->GetGpuInfo().Support_ARB_Fragment_Shader();
+  bool support_vert = gpu_device->GetGpuInfo().Support_ARB_Vertex_Shader();
+  bool use_glsl = support_vert && support_frag && gpu_device->GetOpenGLMajorVersion() >= 2;
+
+  /* Only the dirty tiles need to be blurred again, if the cached texture is still
+   * valid for this geometry */
+  if (update == Update::PARTIAL && use_glsl)
+  {
+    nux::ObjectPtr<nux::IOpenGLFrameBufferObject> current_fbo = gpu_device->GetCurrentFrameBufferObject();
+    gpu_device->DeactivateFrameBuffer();
+
+    BlurDirtyTiles();
+
+    if (current_fbo.IsValid())
+    {
+      current_fbo->Activate(true);
+      graphics_engine->Push2DWindow(current_fbo->GetWidth(), current_fbo->GetHeight());
+      graphics_engine->GetRenderStates().EnableScissor(true);
+    }
+    else
+    {
+      graphics_engine->SetViewport(0, 0, monitor_width, monitor_height);
+      graphics_engine->Push2DWindow(monitor_width, monitor_height);
+
+      graphics_engine->ApplyClippingRectangle();
+    }
+
+    cache_state_.Clear();
+    return blur_texture_;
+  }
+
   const int radius = GetBlurRadius();
 
   // Define a larger region of that account for the blur radius
@@ -304,12 +534,8 @@ nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetBlurRegion(bo
   texxform__bg.uoffset = ((float) larger_blur_geometry.x) / monitor_width;
   texxform__bg.voffset = ((float) monitor_height - larger_blur_geometry.y - larger_blur_geometry.height) / monitor_height;
 
-  bool support_frag = gpu_device->GetGpuInfo().Support_ARB_Fragment_Shader();
-  bool support_vert = gpu_device->GetGpuInfo().Support_ARB_Vertex_Shader();
-
-  if (support_vert && support_frag && gpu_device->GetOpenGLMajorVersion() >= 2)
+  if (use_glsl)
   {
-    float noise_factor = 1.1f;
     float gaussian_sigma = GetBlurSigma();
 
     nux::ObjectPtr<nux::IOpenGLBaseTexture> device_texture = gpu_device->backup_texture0_;
@@ -335,8 +561,8 @@ nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetBlurRegion(bo
     noise_fx_struct_.src_texture = blur_fx_struct_.dst_texture;
 
     // Add Noise
-    nux::Color noise_color(noise_factor * 1.0f/buffer_width,
-                           noise_factor * 1.0f/buffer_height,
+    nux::Color noise_color(NOISE_FACTOR * 1.0f/buffer_width,
+                           NOISE_FACTOR * 1.0f/buffer_height,
                            1.0f, 1.0f);
 
     texxform.SetTexCoordType(nux::TexCoordXForm::OFFSET_COORD);
@@ -430,31 +656,24 @@ nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetBlurRegion(bo
     graphics_engine->ApplyClippingRectangle();
   }
 
-  cache_dirty = false;
+  blur_stats_.blurred_pixels += larger_blur_geometry.width * larger_blur_geometry.height;
+  ++blur_stats_.full_updates;
+
+  cache_state_.Clear();
   return blur_texture_;
 }
 
-nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetRegion(bool force_update)
+nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetRegion()
 {
-  bool should_update = force_update || cache_dirty;
-
-  /* Static blur: only update when the size changed */
-  if ((!should_update)
-      && blur_texture_.IsValid()
-      && (requested_blur_geometry_ == blur_geometry_))
-  {
+  if (NextUpdate() == Update::NONE)
     return blur_texture_;
-  }
 
   nux::GraphicsEngine* graphics_engine = nux::GetGraphicsDisplay()->GetGraphicsEngine();
 
   int monitor_width = BackgroundEffectHelper::monitor_rect_.width;
   int monitor_height = BackgroundEffectHelper::monitor_rect_.height;
 
-  nux::Geometry temp = requested_blur_geometry_;
-  temp.OffsetPosition(-monitor_rect_.x, -monitor_rect_.y);
-
-  blur_geometry_ =  nux::Geometry(0, 0, monitor_width, monitor_height).Intersect(temp);
+  blur_geometry_ = MonitorBlurGeometry();
 
   nux::GpuDevice* gpu_device = nux::GetGraphicsDisplay()->GetGpuDevice();
 
@@ -515,7 +734,83 @@ nux::ObjectPtr<nux::IOpenGLBaseTexture> BackgroundEffectHelper::GetRegion(bool f
     graphics_engine->ApplyClippingRectangle();
   }
 
-  cache_dirty = false;
+  cache_state_.Clear();
   return blur_texture_;
 }
 
+//
+// CacheState
+//
+
+BackgroundEffectHelper::CacheState::CacheState()
+  : dirty_(true)
+{}
+
+BackgroundEffectHelper::Update BackgroundEffectHelper::CacheState::Invalidate()
+{
+  if (IsFullyDirty())
+    return Update::NONE;
+
+  dirty_ = true;
+  dirty_rects_.clear();
+  return Update::FULL;
+}
+
+BackgroundEffectHelper::Update BackgroundEffectHelper::CacheState::Damage(nux::Geometry const& rect, nux::Geometry const& region)
+{
+  if (rect.IsNull() || IsFullyDirty())
+    return Update::NONE;
+
+  for (auto const& dirty_rect : dirty_rects_)
+  {
+    if (dirty_rect.Intersect(rect) == rect)
+      return Update::NONE;
+  }
+
+  dirty_ = true;
+  dirty_rects_.push_back(rect);
+
+  int dirty_area = 0;
+  for (auto const& dirty_rect : dirty_rects_)
+    dirty_area += dirty_rect.width * dirty_rect.height;
+
+  int region_area = region.width * region.height;
+
+  if (dirty_rects_.size() > MAX_DIRTY_RECTS || dirty_area > region_area * MAX_DIRTY_AREA_RATIO)
+  {
+    // Not worth tiling anymore, mark the whole cache as dirty
+    dirty_rects_.clear();
+    return Update::FULL;
+  }
+
+  return Update::PARTIAL;
+}
+
+void BackgroundEffectHelper::CacheState::Clear()
+{
+  dirty_ = false;
+  dirty_rects_.clear();
+}
+
+BackgroundEffectHelper::Update BackgroundEffectHelper::CacheState::NextUpdate(nux::Geometry const& cached_geo, nux::Geometry const& geo, bool cache_valid) const
+{
+  if (!cache_valid || cached_geo != geo || IsFullyDirty())
+    return Update::FULL;
+
+  return dirty_ ? Update::PARTIAL : Update::NONE;
+}
+
+bool BackgroundEffectHelper::CacheState::IsDirty() const
+{
+  return dirty_;
+}
+
+bool BackgroundEffectHelper::CacheState::IsFullyDirty() const
+{
+  return dirty_ && dirty_rects_.empty();
+}
+
+std::vector<nux::Geometry> const& BackgroundEffectHelper::CacheState::DirtyRects() const
+{
+  return dirty_rects_;
+}
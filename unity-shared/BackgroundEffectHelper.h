@@ -46,8 +46,8 @@ public:
   nux::Property<nux::View*> owner;
   nux::Property<bool> enabled;
 
-  nux::ObjectPtr<nux::IOpenGLBaseTexture> GetBlurRegion(bool force_update = false);
-  nux::ObjectPtr<nux::IOpenGLBaseTexture> GetRegion(bool force_update = false);
+  nux::ObjectPtr<nux::IOpenGLBaseTexture> GetBlurRegion();
+  nux::ObjectPtr<nux::IOpenGLBaseTexture> GetRegion();
   // We could add more functions here to get different types of effects based on the background texture
   // nux::ObjectPtr<nux::IOpenGLBaseTexture> GetPixelatedRegion(nux::Rect rect, int pixel_size, bool update);
 
@@ -56,10 +56,51 @@ public:
 
   void DirtyCache();
 
+  struct BlurStats
+  {
+    uint64_t blurred_pixels = 0;
+    unsigned full_updates = 0;
+    unsigned partial_updates = 0;
+  };
+
+  enum class Update
+  {
+    NONE,
+    PARTIAL,
+    FULL
+  };
+
+  // Tracks which parts of a cached texture are out of date, it doesn't need GL.
+  class CacheState
+  {
+  public:
+    CacheState();
+
+    // Both return the update that the change requires, NONE if already needed.
+    Update Invalidate();
+    Update Damage(nux::Geometry const& rect, nux::Geometry const& region);
+    void Clear();
+
+    // How a cached texture of cached_geo has to be updated to match geo.
+    Update NextUpdate(nux::Geometry const& cached_geo, nux::Geometry const& geo, bool cache_valid) const;
+
+    bool IsDirty() const;
+    bool IsFullyDirty() const;
+    std::vector<nux::Geometry> const& DirtyRects() const;
+
+  private:
+    bool dirty_;
+    // Sub-rects to update when the cache is partially dirty, empty means all of it
+    std::vector<nux::Geometry> dirty_rects_;
+  };
+
   static void ProcessDamage(nux::Geometry const& geo);
   static bool HasDirtyHelpers();
   static bool HasEnabledHelpers();
   static std::vector<nux::Geometry> const& GetBlurGeometries();
+  static std::vector<nux::Geometry> GetDirtyBlurGeometries();
+  static BlurStats const& GetBlurStats();
+  static void ResetBlurStats();
 
   static nux::Property<unity::BlurType> blur_type;
   static nux::Geometry monitor_rect_;
@@ -75,7 +116,12 @@ private:
   static int GetBlurRadius();
   static void UpdateBlurGeometries();
 
+  nux::Geometry MonitorBlurGeometry() const;
+  Update NextUpdate() const;
+
   void LoadTextures();
+  void DirtyRegion(nux::Geometry const&);
+  void BlurDirtyTiles();
   void OnEnabledChanged(bool value);
   void OnOwnerChanged(nux::View*);
   void SetupOwner(nux::View*);
@@ -87,15 +133,19 @@ private:
   nux::ObjectPtr<nux::IOpenGLBaseTexture> noisy_tmp_;
   nux::FxStructure blur_fx_struct_;
   nux::FxStructure noise_fx_struct_;
+  nux::FxStructure tile_blur_fx_struct_;
+  nux::FxStructure tile_noise_fx_struct_;
+  nux::ObjectPtr<nux::IOpenGLFrameBufferObject> tile_fbo_;
   nux::Geometry blur_geometry_;
   nux::Geometry requested_blur_geometry_;
   GeometryGetterFunc geo_getter_func_;
   connection::Manager connections_;
 
-  bool cache_dirty;
+  CacheState cache_state_;
 
   static std::list<BackgroundEffectHelper*> registered_list_;
   static std::vector<nux::Geometry> blur_geometries_;
+  static BlurStats blur_stats_;
 };
 
 }
@@ -40,6 +40,7 @@ namespace pool
 // We keep a cache on views here, it would be nice to clean these on BAMF reload
 std::unordered_map<BamfView*, ApplicationPtr> apps_;
 std::unordered_map<BamfView*, ApplicationWindowPtr> wins_;
+std::unordered_map<Window, ApplicationWindowPtr> xids_;
 
 ApplicationPtr EnsureApplication(ApplicationManager const& manager, BamfView* view)
 {
@@ -70,9 +71,28 @@ ApplicationWindowPtr EnsureWindow(ApplicationManager const& manager, BamfView* v
   glib::Object<BamfWindow> bamfwin(reinterpret_cast<BamfWindow*>(view), glib::AddRef());
   auto const& win = std::make_shared<AppWindow>(manager, bamfwin);
   wins_.insert({view, win});
+
+  if (Window xid = win->window_id())
+    xids_[xid] = win;
+
   return win;
 }
 
+void RemoveWindow(BamfView* view)
+{
+  auto it = wins_.find(view);
+
+  if (it == wins_.end())
+    return;
+
+  auto xid_it = xids_.find(it->second->window_id());
+
+  if (xid_it != xids_.end() && xid_it->second == it->second)
+    xids_.erase(xid_it);
+
+  wins_.erase(it);
+}
+
 } // pool namespace
 } // anonymous namespace
 
@@ -153,7 +173,7 @@ WindowBase::WindowBase(ApplicationManager const& manager,
   signals_.Add<void, BamfView*>(bamf_view_, "closed",
   [this] (BamfView* view) {
     this->closed.emit();
-    pool::wins_.erase(view);
+    pool::RemoveWindow(view);
   });
 }
 
@@ -609,6 +629,8 @@ Manager::Manager()
     sigc::mem_fun(this, &Manager::OnViewOpened));
   signals_.Add<void, BamfMatcher*, BamfView*> (matcher_, "view-closed",
     sigc::mem_fun(this, &Manager::OnViewClosed));
+  signals_.Add<void, BamfMatcher*>(matcher_, "stacking-order-changed",
+    [this] (BamfMatcher*) { windows_stack_.reset(); });
 
   signals_.Add<void, BamfMatcher*, BamfView*, BamfView*>(matcher_, "active-window-changed",
   [this](BamfMatcher*, BamfView* /* from */, BamfView* to) {
@@ -660,10 +682,10 @@ ApplicationWindowPtr Manager::GetActiveWindow() const
   // If the active window is a dock type, then we want the first visible, non-dock type.
   LOG_DEBUG(logger) << "Is a dock, looking at the window stack.";
 
-  auto const& wins = GetWindowsForMonitor();
+  WindowListPtr wins = GetWindowsForMonitor();
   WindowManager& wm = WindowManager::Default();
 
-  for (auto it = wins.rbegin(); it != wins.rend(); ++it)
+  for (auto it = wins->rbegin(); it != wins->rend(); ++it)
   {
     auto const& win = *it;
     auto xid = win->window_id();
@@ -697,11 +719,10 @@ ApplicationWindowPtr Manager::GetWindowForId(Window xid) const
   if (xid == 0)
     return nullptr;
 
-  for (auto const& win_pair : pool::wins_)
-  {
-    if (win_pair.second->window_id() == xid)
-      return win_pair.second;
-  }
+  auto it = pool::xids_.find(xid);
+
+  if (it != pool::xids_.end())
+    return it->second;
 
   if (BamfWindow* win = bamf_matcher_get_window_for_xid(matcher_, xid))
     return pool::EnsureWindow(*this, reinterpret_cast<BamfView*>(win));
@@ -725,9 +746,22 @@ ApplicationWindowPtr Manager::GetWindowForId(Window xid) const
   return nullptr;
 }
 
-ApplicationList Manager::GetRunningApplications() const
+ApplicationPtr Manager::EnsureApplication(BamfView* view) const
 {
-  ApplicationList result;
+  return pool::EnsureApplication(*this, view);
+}
+
+ApplicationWindowPtr Manager::EnsureWindow(BamfView* view) const
+{
+  return pool::EnsureWindow(*this, view);
+}
+
+ApplicationListPtr Manager::GetRunningApplications() const
+{
+  if (running_apps_)
+    return running_apps_;
+
+  auto result = std::make_shared<ApplicationList>();
   std::shared_ptr<GList> apps(bamf_matcher_get_applications(matcher_), g_list_free);
 
   for (GList *l = apps.get(); l; l = l->next)
@@ -738,15 +772,40 @@ ApplicationList Manager::GetRunningApplications() const
       continue;
     }
 
-    result.push_back(pool::EnsureApplication(*this, static_cast<BamfView*>(l->data)));
+    result->push_back(pool::EnsureApplication(*this, static_cast<BamfView*>(l->data)));
   }
-  return result;
+
+  running_apps_ = result;
+  return running_apps_;
 }
 
-WindowList Manager::GetWindowsForMonitor(int monitor) const
+WindowListPtr Manager::GetWindowsForMonitor(int monitor) const
 {
-  WindowList wins;
-  std::shared_ptr<GList> windows(bamf_matcher_get_window_stack_for_monitor(matcher_, monitor), g_list_free);
+  auto const& stack = GetWindowsStack();
+
+  if (monitor < 0)
+    return stack;
+
+  // Per-monitor stacks are just filtered from the whole one, as bamf does.
+  // They aren't cached, as windows can move to another monitor at any time.
+  auto wins = std::make_shared<WindowList>();
+
+  for (auto const& win : *stack)
+  {
+    if (win->monitor() == monitor)
+      wins->push_back(win);
+  }
+
+  return wins;
+}
+
+WindowListPtr const& Manager::GetWindowsStack() const
+{
+  if (windows_stack_)
+    return windows_stack_;
+
+  auto wins = std::make_shared<WindowList>();
+  std::shared_ptr<GList> windows(bamf_matcher_get_window_stack_for_monitor(matcher_, -1), g_list_free);
 
   for (GList *l = windows.get(); l; l = l->next)
   {
@@ -759,15 +818,27 @@ WindowList Manager::GetWindowsForMonitor(int monitor) const
     auto bamf_win = static_cast<BamfWindow*>(l->data);
 
     if (bamf_window_get_window_type(bamf_win) != BAMF_WINDOW_DOCK)
-      wins.push_back(pool::EnsureWindow(*this, static_cast<BamfView*>(l->data)));
+      wins->push_back(pool::EnsureWindow(*this, static_cast<BamfView*>(l->data)));
   }
 
-  return wins;
+  windows_stack_ = wins;
+  return windows_stack_;
+}
+
+void Manager::InvalidateCaches(BamfView* view)
+{
+  // The lists given away are never modified, we just drop our references
+  if (BAMF_IS_APPLICATION(view))
+    running_apps_.reset();
+  else if (BAMF_IS_WINDOW(view))
+    windows_stack_.reset();
 }
 
 void Manager::OnViewOpened(BamfMatcher* matcher, BamfView* view)
 {
   LOG_TRACE_BLOCK(logger);
+  InvalidateCaches(view);
+
   if (BAMF_IS_APPLICATION(view))
   {
     if (ApplicationPtr const& app = pool::EnsureApplication(*this, view))
@@ -783,6 +854,8 @@ void Manager::OnViewOpened(BamfMatcher* matcher, BamfView* view)
 void Manager::OnViewClosed(BamfMatcher* matcher, BamfView* view)
 {
   LOG_TRACE_BLOCK(logger);
+  InvalidateCaches(view);
+
   if (BAMF_IS_APPLICATION(view))
   {
     if (ApplicationPtr const& app = pool::EnsureApplication(*this, view))
@@ -168,8 +168,8 @@ public:
   ApplicationPtr GetActiveApplication() const override;
   ApplicationWindowPtr GetActiveWindow() const override;
   ApplicationPtr GetApplicationForDesktopFile(std::string const& desktop_file) const override;
-  ApplicationList GetRunningApplications() const override;
-  WindowList GetWindowsForMonitor(int monitor = -1) const override;
+  ApplicationListPtr GetRunningApplications() const override;
+  WindowListPtr GetWindowsForMonitor(int monitor = -1) const override;
   ApplicationPtr GetApplicationForWindow(Window xid) const override;
   ApplicationWindowPtr GetWindowForId(Window xid) const override;
 
@@ -181,10 +181,16 @@ public:
 private:
   void OnViewOpened(BamfMatcher* matcher, BamfView* view);
   void OnViewClosed(BamfMatcher* matcher, BamfView* view);
+  void InvalidateCaches(BamfView* view);
+  WindowListPtr const& GetWindowsStack() const;
 
 private:
   glib::Object<BamfMatcher> matcher_;
   glib::SignalManager signals_;
+
+  // Replaced on views changes, to avoid querying bamf on each request
+  mutable ApplicationListPtr running_apps_;
+  mutable WindowListPtr windows_stack_;
 };
 
 } // namespace bamf
@@ -38,6 +38,7 @@
 #include <UnityCore/GLibWrapper.h>
 
 #include "CairoTexture.h"
+#include "ExponentialBlur.h"
 #include "JSONParser.h"
 #include "TextureCache.h"
 #include "ThemeSettings.h"
@@ -504,145 +505,6 @@ void Style::RoundedRect(cairo_t* cr,
             270.0f * G_PI / 180.0f);
 }
 
-static inline void _blurinner(guchar* pixel,
-                              gint*   zR,
-                              gint*   zG,
-                              gint*   zB,
-                              gint*   zA,
-                              gint    alpha,
-                              gint    aprec,
-                              gint    zprec)
-{
-  gint   r;
-  gint   g;
-  gint   b;
-  guchar a;
-
-  r = *pixel;
-  g = *(pixel + 1);
-  b = *(pixel + 2);
-  a = *(pixel + 3);
-
-  *zR += (alpha * ((r << zprec) - *zR)) >> aprec;
-  *zG += (alpha * ((g << zprec) - *zG)) >> aprec;
-  *zB += (alpha * ((b << zprec) - *zB)) >> aprec;
-  *zA += (alpha * ((a << zprec) - *zA)) >> aprec;
-
-  *pixel       = *zR >> zprec;
-  *(pixel + 1) = *zG >> zprec;
-  *(pixel + 2) = *zB >> zprec;
-  *(pixel + 3) = *zA >> zprec;
-}
-
-static inline void _blurrow(guchar* pixels,
-                            gint    width,
-                            gint    height,
-                            gint    channels,
-                            gint    line,
-                            gint    alpha,
-                            gint    aprec,
-                            gint    zprec)
-{
-  gint    zR;
-  gint    zG;
-  gint    zB;
-  gint    zA;
-  gint    index;
-  guchar* scanline;
-
-  scanline = &(pixels[line * width * channels]);
-
-  zR = *scanline << zprec;
-  zG = *(scanline + 1) << zprec;
-  zB = *(scanline + 2) << zprec;
-  zA = *(scanline + 3) << zprec;
-
-  for (index = 0; index < width; index ++)
-    _blurinner(&scanline[index * channels], &zR, &zG, &zB, &zA, alpha, aprec,
-               zprec);
-
-  for (index = width - 2; index >= 0; index--)
-    _blurinner(&scanline[index * channels], &zR, &zG, &zB, &zA, alpha, aprec,
-               zprec);
-}
-
-static inline void _blurcol(guchar* pixels,
-                            gint    width,
-                            gint    height,
-                            gint    channels,
-                            gint    x,
-                            gint    alpha,
-                            gint    aprec,
-                            gint    zprec)
-{
-  gint zR;
-  gint zG;
-  gint zB;
-  gint zA;
-  gint index;
-  guchar* ptr;
-
-  ptr = pixels;
-
-  ptr += x * channels;
-
-  zR = *((guchar*) ptr    ) << zprec;
-  zG = *((guchar*) ptr + 1) << zprec;
-  zB = *((guchar*) ptr + 2) << zprec;
-  zA = *((guchar*) ptr + 3) << zprec;
-
-  for (index = width; index < (height - 1) * width; index += width)
-    _blurinner((guchar*) &ptr[index * channels], &zR, &zG, &zB, &zA, alpha,
-               aprec, zprec);
-
-  for (index = (height - 2) * width; index >= 0; index -= width)
-    _blurinner((guchar*) &ptr[index * channels], &zR, &zG, &zB, &zA, alpha,
-               aprec, zprec);
-}
-
-//
-// pixels   image-data
-// width    image-width
-// height   image-height
-// channels image-channels
-//
-// in-place blur of image 'img' with kernel of approximate radius 'radius'
-//
-// blurs with two sided exponential impulse response
-//
-// aprec = precision of alpha parameter in fixed-point format 0.aprec
-//
-// zprec = precision of state parameters zR,zG,zB and zA in fp format 8.zprec
-//
-void _expblur(guchar* pixels,
-              gint    width,
-              gint    height,
-              gint    channels,
-              gint    radius,
-              gint    aprec,
-              gint    zprec)
-{
-  gint alpha;
-  gint row = 0;
-  gint col = 0;
-
-  if (radius < 1)
-    return;
-
-  // calculate the alpha such that 90% of
-  // the kernel is within the radius.
-  // (Kernel extends to infinity)
-  alpha = (gint) ((1 << aprec) * (1.0f - expf (-2.3f / (radius + 1.f))));
-
-  for (; row < height; row++)
-    _blurrow(pixels, width, height, channels, row, alpha, aprec, zprec);
-
-  for(; col < width; col++)
-    _blurcol(pixels, width, height, channels, col, alpha, aprec, zprec);
-
-  return;
-}
-
 void Style::Blur(cairo_t* cr, int size)
 {
   pimpl->Blur(cr, size);
@@ -673,15 +535,15 @@ void Style::Impl::Blur(cairo_t* cr, int size)
   switch (format)
   {
   case CAIRO_FORMAT_ARGB32:
-    _expblur(pixels, width, height, 4, size, 16, 7);
+    graphics::ExponentialBlur(pixels, width, height, 4, size);
     break;
 
   case CAIRO_FORMAT_RGB24:
-    _expblur(pixels, width, height, 3, size, 16, 7);
+    graphics::ExponentialBlur(pixels, width, height, 3, size);
     break;
 
   case CAIRO_FORMAT_A8:
-    _expblur(pixels, width, height, 1, size, 16, 7);
+    graphics::ExponentialBlur(pixels, width, height, 1, size);
     break;
 
   default :
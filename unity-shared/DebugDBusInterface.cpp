@@ -19,9 +19,11 @@
  *              Marco Trevisan <marco.trevisan@canonical.com>
  */
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 #include <boost/algorithm/string.hpp>
 #include <NuxCore/Logger.h>
 #include <NuxCore/LoggingWriter.h>
@@ -31,6 +33,8 @@
 #include <dlfcn.h>
 
 #include "DebugDBusInterface.h"
+#include "DebugDBusInterfacePrivate.h"
+#include "FrameStats.h"
 #include "Introspectable.h"
 
 namespace unity
@@ -47,210 +51,297 @@ namespace local
   const std::string PROTOCOL_VERSION = "1.4";
   const std::string XPATH_SELECT_LIB = "libxpathselect.so.1.4";
 
-  class IntrospectableAdapter : public std::enable_shared_from_this<IntrospectableAdapter>, public xpathselect::Node
+  namespace xpathselect
   {
-  public:
-    typedef std::shared_ptr<IntrospectableAdapter const> Ptr;
-    IntrospectableAdapter(Introspectable* node, IntrospectableAdapter::Ptr const& parent = nullptr)
-      : node_(node)
-      , parent_(parent)
-      , full_path_((parent_ ? parent_->GetPath() : "") + "/" + GetName())
-    {}
-
-    int32_t GetId() const
-    {
-      return node_->GetIntrospectionId();
-    }
 
-    std::string GetName() const
+  struct NodeSelector
+  {
+    NodeSelector()
+      : driver_(dlopen(XPATH_SELECT_LIB.c_str(), RTLD_LAZY))
+      , node_selector_(driver_ ? reinterpret_cast<select_nodes_t>(dlsym(driver_, "SelectNodes")) : nullptr)
     {
-      return node_->GetName();
+      if (const char* err = dlerror())
+      {
+        LOG_WARNING(logger) << "Unable to load entry point in libxpathselect: " << err
+                            << " -- full D-Bus introspection will not be available";
+        Close();
+      }
     }
 
-    std::string GetPath() const
-    {
-      return full_path_;
-    }
+    ~NodeSelector() { Close(); }
+    bool IsAvailable() const { return driver_; }
+    operator bool() const { return IsAvailable(); }
 
-    Node::Ptr GetParent() const
+    ::xpathselect::NodeVector SelectNodes(::xpathselect::Node::Ptr const& root, std::string const& query)
     {
-      return parent_;
-    }
+      if (!IsAvailable())
+        return ::xpathselect::NodeVector();
 
-    bool MatchStringProperty(std::string const& name, std::string const& value) const
-    {
-      auto const& prop_value = GetPropertyValue(name);
+      return node_selector_(root, query);
+    }
 
-      if (prop_value)
+    private:
+      void Close()
       {
-        if (!g_variant_is_of_type(prop_value, G_VARIANT_TYPE_STRING))
+        if (driver_)
         {
-          LOG_WARNING(logger) << "Unable to match '"<< name << "', '" <<
-                                  prop_value << "' is not a string property.";
-          return false;
+          dlclose(driver_);
+          driver_ = nullptr;
         }
-
-        return (prop_value.GetString() == value);
       }
 
-      return false;
-    }
+      void* driver_;
+      typedef decltype(&::xpathselect::SelectNodes) select_nodes_t;
+      select_nodes_t node_selector_;
+  };
 
-    bool MatchBooleanProperty(std::string const& name, bool value) const
-    {
-      auto const& prop_value = GetPropertyValue(name);
+  NodeSelector& GetNodeSelector()
+  {
+    static NodeSelector selector;
+    return selector;
+  }
 
-      if (prop_value)
-      {
-        if (!g_variant_is_of_type(prop_value, G_VARIANT_TYPE_BOOLEAN))
-        {
-          LOG_WARNING(logger) << "Unable to match '"<< name << "', '" <<
-                                  prop_value << "' is not a boolean property.";
-          return false;
-        }
+  } // xpathselect namespace
 
-        return (prop_value.GetBool() == value);
-      }
+} // local namespace
+} // anonymous namespace
+
+namespace impl
+{
+
+IntrospectableAdapter::IntrospectableAdapter(Introspectable* node, IntrospectableAdapter::Ptr const& parent)
+  : node_(node)
+  , parent_(parent)
+  , full_path_((parent ? parent->GetPath() : "") + "/" + GetName())
+{}
+
+int32_t IntrospectableAdapter::GetId() const
+{
+  return node_->GetIntrospectionId();
+}
 
+std::string IntrospectableAdapter::GetName() const
+{
+  return node_->GetName();
+}
+
+std::string IntrospectableAdapter::GetPath() const
+{
+  return full_path_;
+}
+
+xpathselect::Node::Ptr IntrospectableAdapter::GetParent() const
+{
+  return parent_.lock();
+}
+
+bool IntrospectableAdapter::MatchStringProperty(std::string const& name, std::string const& value) const
+{
+  auto const& prop_value = GetPropertyValue(name);
+
+  if (prop_value)
+  {
+    if (!g_variant_is_of_type(prop_value, G_VARIANT_TYPE_STRING))
+    {
+      LOG_WARNING(logger) << "Unable to match '"<< name << "', '" <<
+                              prop_value << "' is not a string property.";
       return false;
     }
 
-    bool MatchIntegerProperty(std::string const& name, int32_t value) const
-    {
-      auto const& prop_value = GetPropertyValue(name);
+    return (prop_value.GetString() == value);
+  }
 
-      if (prop_value)
-      {
-        GVariantClass prop_val_type = g_variant_classify(prop_value);
-        // it'd be nice to be able to do all this with one method.
-        // I can't figure out how to group all the integer types together
-        switch (prop_val_type)
-        {
-          case G_VARIANT_CLASS_BYTE:
-            return static_cast<unsigned char>(value) == prop_value.GetByte();
-          case G_VARIANT_CLASS_INT16:
-            return value == prop_value.GetInt16();
-          case G_VARIANT_CLASS_UINT16:
-            return static_cast<uint16_t>(value) == prop_value.GetUInt16();
-          case G_VARIANT_CLASS_INT32:
-            return value == prop_value.GetInt32();
-          case G_VARIANT_CLASS_UINT32:
-            return static_cast<uint32_t>(value) == prop_value.GetUInt32();
-          case G_VARIANT_CLASS_INT64:
-            return value == prop_value.GetInt64();
-          case G_VARIANT_CLASS_UINT64:
-            return static_cast<uint64_t>(value) == prop_value.GetUInt64();
-        default:
-          LOG_WARNING(logger) << "Unable to match '"<< name << "', '" <<
-                                  prop_value << "' is not a known integer property.";
-        };
-      }
+  return false;
+}
+
+bool IntrospectableAdapter::MatchBooleanProperty(std::string const& name, bool value) const
+{
+  auto const& prop_value = GetPropertyValue(name);
 
+  if (prop_value)
+  {
+    if (!g_variant_is_of_type(prop_value, G_VARIANT_TYPE_BOOLEAN))
+    {
+      LOG_WARNING(logger) << "Unable to match '"<< name << "', '" <<
+                              prop_value << "' is not a boolean property.";
       return false;
     }
 
-    glib::Variant GetPropertyValue(std::string const& name) const
+    return (prop_value.GetBool() == value);
+  }
+
+  return false;
+}
+
+bool IntrospectableAdapter::MatchIntegerProperty(std::string const& name, int32_t value) const
+{
+  auto const& prop_value = GetPropertyValue(name);
+
+  if (prop_value)
+  {
+    GVariantClass prop_val_type = g_variant_classify(prop_value);
+    // it'd be nice to be able to do all this with one method.
+    // I can't figure out how to group all the integer types together
+    switch (prop_val_type)
     {
-      if (name == "id")
-        return glib::Variant(GetId());
+      case G_VARIANT_CLASS_BYTE:
+        return static_cast<unsigned char>(value) == prop_value.GetByte();
+      case G_VARIANT_CLASS_INT16:
+        return value == prop_value.GetInt16();
+      case G_VARIANT_CLASS_UINT16:
+        return static_cast<uint16_t>(value) == prop_value.GetUInt16();
+      case G_VARIANT_CLASS_INT32:
+        return value == prop_value.GetInt32();
+      case G_VARIANT_CLASS_UINT32:
+        return static_cast<uint32_t>(value) == prop_value.GetUInt32();
+      case G_VARIANT_CLASS_INT64:
+        return value == prop_value.GetInt64();
+      case G_VARIANT_CLASS_UINT64:
+        return static_cast<uint64_t>(value) == prop_value.GetUInt64();
+    default:
+      LOG_WARNING(logger) << "Unable to match '"<< name << "', '" <<
+                              prop_value << "' is not a known integer property.";
+    };
+  }
 
-      IntrospectionData introspection;
-      node_->AddProperties(introspection);
+  return false;
+}
 
-      glib::Variant value(g_variant_lookup_value(glib::Variant(introspection.Get()), name.c_str(), nullptr), glib::StealRef());
+glib::Variant IntrospectableAdapter::GetPropertyValue(std::string const& name) const
+{
+  if (name == "id")
+    return glib::Variant(GetId());
 
-      if (!value)
-        return nullptr;
+  auto const& properties = GetProperties();
+  auto it = properties.find(name);
 
-      if (!g_variant_is_of_type(value, G_VARIANT_TYPE_ARRAY) || g_variant_n_children(value) != 2)
-      {
-        LOG_ERROR(logger) << "Property value for '"<< name << "' should be a 2-sized array, got instead '" << value << "'";
-        return nullptr;
-      }
+  if (it == properties.end())
+    return nullptr;
 
-      glib::Variant child(g_variant_get_child_value(value, 1), glib::StealRef());
+  glib::Variant const& value = it->second;
 
-      if (g_variant_is_of_type(child, G_VARIANT_TYPE_VARIANT))
-        return child.GetVariant();
+  if (!g_variant_is_of_type(value, G_VARIANT_TYPE_ARRAY) || g_variant_n_children(value) != 2)
+  {
+    LOG_ERROR(logger) << "Property value for '"<< name << "' should be a 2-sized array, got instead '" << value << "'";
+    return nullptr;
+  }
 
-      return child;
-    }
+  glib::Variant child(g_variant_get_child_value(value, 1), glib::StealRef());
 
-    std::vector<xpathselect::Node::Ptr> Children() const
-    {
-      std::vector<xpathselect::Node::Ptr> children;
-      auto const& this_ptr = shared_from_this();
+  if (g_variant_is_of_type(child, G_VARIANT_TYPE_VARIANT))
+    return child.GetVariant();
 
-      for (auto* child : node_->GetIntrospectableChildren())
-      {
-        if (!child)
-          continue;
+  return child;
+}
 
-        children.push_back(std::make_shared<IntrospectableAdapter>(child, this_ptr));
-      }
+std::vector<xpathselect::Node::Ptr> IntrospectableAdapter::Children() const
+{
+  std::vector<Introspectable*> nodes;
 
-      return children;
-    }
+  for (auto* child : node_->GetIntrospectableChildren())
+  {
+    if (child)
+      nodes.push_back(child);
+  }
 
-    Introspectable* Node() const
-    {
-      return node_;
-    }
+  // Children might have been added or removed since the list was cached,
+  // the adapters of the ones that are still there are kept with their state.
+  if (nodes == children_nodes_)
+    return children_;
 
-  private:
-    Introspectable* node_;
-    IntrospectableAdapter::Ptr parent_;
-    std::string full_path_;
-  };
+  auto const& this_ptr = shared_from_this();
+  std::vector<xpathselect::Node::Ptr> children;
+  children.reserve(nodes.size());
 
-  namespace xpathselect
+  for (auto* child : nodes)
   {
+    auto it = std::find(children_nodes_.begin(), children_nodes_.end(), child);
 
-  struct NodeSelector
+    if (it != children_nodes_.end())
+      children.push_back(children_[it - children_nodes_.begin()]);
+    else
+      children.push_back(std::make_shared<IntrospectableAdapter>(child, this_ptr));
+  }
+
+  children_nodes_ = std::move(nodes);
+  children_ = std::move(children);
+
+  return children_;
+}
+
+glib::Variant const& IntrospectableAdapter::GetState() const
+{
+  if (!state_)
+    state_ = node_->Introspect();
+
+  return state_;
+}
+
+Introspectable* IntrospectableAdapter::Node() const
+{
+  return node_;
+}
+
+std::unordered_map<std::string, glib::Variant> const& IntrospectableAdapter::GetProperties() const
+{
+  if (properties_.empty())
   {
-    NodeSelector()
-      : driver_(dlopen(XPATH_SELECT_LIB.c_str(), RTLD_LAZY))
-      , node_selector_(driver_ ? reinterpret_cast<select_nodes_t>(dlsym(driver_, "SelectNodes")) : nullptr)
-    {
-      if (const char* err = dlerror())
-      {
-        LOG_WARNING(logger) << "Unable to load entry point in libxpathselect: " << err
-                            << " -- full D-Bus introspection will not be available";
-        Close();
-      }
-    }
+    GVariantIter iter;
+    gchar* name;
+    GVariant* value;
 
-    ~NodeSelector() { Close(); }
-    bool IsAvailable() const { return driver_; }
-    operator bool() const { return IsAvailable(); }
+    g_variant_iter_init(&iter, GetState());
 
-    ::xpathselect::NodeVector SelectNodes(::xpathselect::Node::Ptr const& root, std::string const& query)
-    {
-      if (!IsAvailable())
-        return ::xpathselect::NodeVector();
+    while (g_variant_iter_loop(&iter, "{sv}", &name, &value))
+      properties_.insert({name, glib::Variant(value)});
+  }
 
-      return node_selector_(root, query);
-    }
+  return properties_;
+}
 
-    private:
-      void Close()
-      {
-        if (driver_)
-        {
-          dlclose(driver_);
-          driver_ = nullptr;
-        }
-      }
+namespace
+{
+void AddQueryResults(GVariantBuilder* builder, IntrospectableAdapter::Ptr const& root, std::string const& query)
+{
+  for (auto const& n : local::xpathselect::GetNodeSelector().SelectNodes(root, query))
+  {
+    auto p = std::static_pointer_cast<IntrospectableAdapter const>(n);
+    if (p)
+      g_variant_builder_add(builder, "(sv)", p->GetPath().c_str(), static_cast<GVariant*>(p->GetState()));
+  }
+}
+}
 
-      void* driver_;
-      typedef decltype(&::xpathselect::SelectNodes) select_nodes_t;
-      select_nodes_t node_selector_;
-  };
+GVariant* GetState(Introspectable* root, std::string const& query)
+{
+  GVariantBuilder builder;
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sv)"));
 
-  } // xpathselect namespace
+  auto root_node = std::make_shared<IntrospectableAdapter>(root);
+  AddQueryResults(&builder, root_node, query);
 
-} // local namespace
-} // anonymous namespace
+  return g_variant_new("(a(sv))", &builder);
+}
+
+GVariant* GetStates(Introspectable* root, std::vector<std::string> const& queries)
+{
+  GVariantBuilder builder;
+  g_variant_builder_init(&builder, G_VARIANT_TYPE("aa(sv)"));
+
+  // All the queries share the same tree, so they see a consistent state
+  auto root_node = std::make_shared<IntrospectableAdapter>(root);
+
+  for (auto const& query : queries)
+  {
+    g_variant_builder_open(&builder, G_VARIANT_TYPE("a(sv)"));
+    AddQueryResults(&builder, root_node, query);
+    g_variant_builder_close(&builder);
+  }
+
+  return g_variant_new("(aa(sv))", &builder);
+}
+
+} // impl namespace
 
 namespace dbus
 {
@@ -272,6 +363,15 @@ const std::string INTROSPECTION_XML =
   ""
   "   </interface>"
   ""
+  "   <interface name='com.canonical.Unity.Debug.Introspection'>"
+  ""
+  "     <method name='GetStates'>"
+  "       <arg type='as' name='pieces' direction='in' />"
+  "       <arg type='aa(sv)' name='states' direction='out' />"
+  "     </method>"
+  ""
+  "   </interface>"
+  ""
   "   <interface name='com.canonical.Unity.Debug.Logging'>"
   ""
   "     <method name='StartLogToFile'>"
@@ -292,15 +392,32 @@ const std::string INTROSPECTION_XML =
   "     </method>"
   ""
   "   </interface>"
+  ""
+  "   <interface name='com.canonical.Unity.Debug.FrameStats'>"
+  ""
+  "     <method name='SetFrameStatsEnabled'>"
+  "       <arg type='b' name='enabled' direction='in' />"
+  "     </method>"
+  ""
+  "     <method name='ResetFrameStats'>"
+  "     </method>"
+  ""
+  "     <method name='DumpFrameStats'>"
+  "       <arg type='s' name='file_path' direction='in' />"
+  "       <arg type='b' name='success' direction='out' />"
+  "     </method>"
+  ""
+  "   </interface>"
   " </node>";
 }
 
 struct DebugDBusInterface::Impl
 {
-  Impl(Introspectable*);
+  Impl(Introspectable*, FrameStats*);
 
   GVariant* HandleDBusMethodCall(std::string const&, GVariant*);
   GVariant* GetState(std::string const&);
+  GVariant* GetStates(std::vector<std::string> const&);
 
   void StartLogToFile(std::string const&);
   void ResetLogging();
@@ -308,21 +425,22 @@ struct DebugDBusInterface::Impl
   void LogMessage(std::string const& severity, std::string const& message);
 
   Introspectable* introspection_root_;
-  local::xpathselect::NodeSelector xns_;
+  FrameStats* frame_stats_;
   glib::DBusServer::Ptr server_;
   std::ofstream output_file_;
 };
 
-DebugDBusInterface::DebugDBusInterface(Introspectable* root)
-  : impl_(new DebugDBusInterface::Impl(root))
+DebugDBusInterface::DebugDBusInterface(Introspectable* root, FrameStats* frame_stats)
+  : impl_(new DebugDBusInterface::Impl(root, frame_stats))
 {}
 
 DebugDBusInterface::~DebugDBusInterface()
 {}
 
-DebugDBusInterface::Impl::Impl(Introspectable* root)
+DebugDBusInterface::Impl::Impl(Introspectable* root, FrameStats* frame_stats)
   : introspection_root_(root)
-  , server_((introspection_root_ && xns_) ? std::make_shared<glib::DBusServer>(dbus::BUS_NAME) : nullptr)
+  , frame_stats_(frame_stats)
+  , server_((introspection_root_ && local::xpathselect::GetNodeSelector()) ? std::make_shared<glib::DBusServer>(dbus::BUS_NAME) : nullptr)
 {
   if (server_)
   {
@@ -342,6 +460,21 @@ GVariant* DebugDBusInterface::Impl::HandleDBusMethodCall(std::string const& meth
 
     return GetState(input);
   }
+  else if (method == "GetStates")
+  {
+    GVariantIter* iter;
+    const gchar* input;
+    std::vector<std::string> queries;
+
+    g_variant_get(parameters, "(as)", &iter);
+
+    while (g_variant_iter_loop(iter, "&s", &input))
+      queries.push_back(input);
+
+    g_variant_iter_free(iter);
+
+    return GetStates(queries);
+  }
   else if (method == "GetVersion")
   {
     return g_variant_new("(s)", local::PROTOCOL_VERSION.c_str());
@@ -373,24 +506,39 @@ GVariant* DebugDBusInterface::Impl::HandleDBusMethodCall(std::string const& meth
 
     LogMessage(severity, message);
   }
+  else if (method == "SetFrameStatsEnabled")
+  {
+    gboolean enabled;
+    g_variant_get(parameters, "(b)", &enabled);
+
+    if (frame_stats_)
+      frame_stats_->SetEnabled(enabled);
+  }
+  else if (method == "ResetFrameStats")
+  {
+    if (frame_stats_)
+      frame_stats_->Reset();
+  }
+  else if (method == "DumpFrameStats")
+  {
+    const gchar* file_path;
+    g_variant_get(parameters, "(&s)", &file_path);
+
+    bool success = frame_stats_ && frame_stats_->DumpChromeTrace(file_path);
+    return g_variant_new("(b)", success ? TRUE : FALSE);
+  }
 
   return nullptr;
 }
 
 GVariant* DebugDBusInterface::Impl::GetState(std::string const& query)
 {
-  GVariantBuilder builder;
-  g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sv)"));
-
-  auto root_node = std::make_shared<local::IntrospectableAdapter>(introspection_root_);
-  for (auto const& n : xns_.SelectNodes(root_node, query))
-  {
-    auto p = std::static_pointer_cast<local::IntrospectableAdapter const>(n);
-    if (p)
-      g_variant_builder_add(&builder, "(sv)", p->GetPath().c_str(), p->Node()->Introspect());
-  }
+  return impl::GetState(introspection_root_, query);
+}
 
-  return g_variant_new("(a(sv))", &builder);
+GVariant* DebugDBusInterface::Impl::GetStates(std::vector<std::string> const& queries)
+{
+  return impl::GetStates(introspection_root_, queries);
 }
 
 void DebugDBusInterface::Impl::StartLogToFile(std::string const& file_path)
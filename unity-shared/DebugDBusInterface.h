@@ -28,11 +28,12 @@ namespace unity
 namespace debug
 {
 class Introspectable;
+class FrameStats;
 
 class DebugDBusInterface
 {
 public:
-  DebugDBusInterface(Introspectable* root);
+  DebugDBusInterface(Introspectable* root, FrameStats* frame_stats = nullptr);
   ~DebugDBusInterface();
 
 private:
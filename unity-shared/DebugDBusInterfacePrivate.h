@@ -0,0 +1,88 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2010-2013 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_DEBUG_DBUS_INTERFACE_PRIVATE_H
+#define UNITY_DEBUG_DBUS_INTERFACE_PRIVATE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <UnityCore/GLibWrapper.h>
+#include <xpathselect/xpathselect.h>
+
+namespace unity
+{
+namespace debug
+{
+class Introspectable;
+
+namespace impl
+{
+
+/* The adapters tree is built lazily while a query is resolved, and it's
+ * kept alive by its root until the query (or the batch of queries) is done.
+ * So each node is introspected at most once per query, no matter how many
+ * times its properties or its children are checked by xpathselect. */
+class IntrospectableAdapter : public std::enable_shared_from_this<IntrospectableAdapter>, public xpathselect::Node
+{
+public:
+  typedef std::shared_ptr<IntrospectableAdapter const> Ptr;
+  IntrospectableAdapter(Introspectable* node, IntrospectableAdapter::Ptr const& parent = nullptr);
+
+  int32_t GetId() const;
+  std::string GetName() const;
+  std::string GetPath() const;
+  xpathselect::Node::Ptr GetParent() const;
+
+  bool MatchStringProperty(std::string const& name, std::string const& value) const;
+  bool MatchBooleanProperty(std::string const& name, bool value) const;
+  bool MatchIntegerProperty(std::string const& name, int32_t value) const;
+  glib::Variant GetPropertyValue(std::string const& name) const;
+
+  std::vector<xpathselect::Node::Ptr> Children() const;
+
+  // The full node state, as serialized by Introspectable::Introspect
+  glib::Variant const& GetState() const;
+  Introspectable* Node() const;
+
+private:
+  std::unordered_map<std::string, glib::Variant> const& GetProperties() const;
+
+  Introspectable* node_;
+  // Children own their parent through the tree root, so this must not be a strong ref
+  std::weak_ptr<IntrospectableAdapter const> parent_;
+  std::string full_path_;
+
+  mutable std::vector<Introspectable*> children_nodes_;
+  mutable std::vector<xpathselect::Node::Ptr> children_;
+  mutable glib::Variant state_;
+  mutable std::unordered_map<std::string, glib::Variant> properties_;
+};
+
+// Return the (a(sv)) states of the nodes matching the query
+GVariant* GetState(Introspectable* root, std::string const& query);
+// Resolves all the queries against the same adapters tree, returning an (aa(sv))
+GVariant* GetStates(Introspectable* root, std::vector<std::string> const& queries);
+
+} // namespace impl
+} // namespace debug
+} // namespace unity
+
+#endif
@@ -0,0 +1,386 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "ExponentialBlur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <glib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace unity
+{
+namespace graphics
+{
+namespace
+{
+const int TILE_SIZE = 32;
+const int MAX_WORKERS = 4;
+const int MIN_PARALLEL_PIXELS = 256 * 256;
+
+//
+// Worker pool
+//
+
+typedef std::function<void(int begin, int end)> RangeFunc;
+
+struct Job
+{
+  RangeFunc const* func;
+  int begin;
+  int end;
+
+  struct Sync
+  {
+    std::mutex mutex;
+    std::condition_variable cond;
+    int pending;
+  }* sync;
+};
+
+void RunJob(gpointer data, gpointer)
+{
+  Job* job = static_cast<Job*>(data);
+  (*job->func)(job->begin, job->end);
+
+  std::lock_guard<std::mutex> lock(job->sync->mutex);
+  if (--job->sync->pending == 0)
+    job->sync->cond.notify_one();
+}
+
+int WorkersCount()
+{
+  static int workers = std::max(1, std::min<int>(g_get_num_processors(), MAX_WORKERS));
+  return workers;
+}
+
+GThreadPool* WorkersPool()
+{
+  static GThreadPool* pool = g_thread_pool_new(RunJob, nullptr, WorkersCount() - 1, FALSE, nullptr);
+  return pool;
+}
+
+// Splits [0, count) in chunks, the calling thread takes care of the first one.
+void ParallelFor(int count, int cost_per_item, RangeFunc const& func)
+{
+  int chunks = std::min(count, WorkersCount());
+
+  if (chunks < 2 || count * cost_per_item < MIN_PARALLEL_PIXELS)
+  {
+    func(0, count);
+    return;
+  }
+
+  Job::Sync sync;
+  sync.pending = chunks - 1;
+  std::vector<Job> jobs(chunks);
+  int chunk_size = (count + chunks - 1) / chunks;
+
+  for (int i = 0; i < chunks; ++i)
+    jobs[i] = {&func, std::min(count, i * chunk_size), std::min(count, (i + 1) * chunk_size), &sync};
+
+  for (int i = 1; i < chunks; ++i)
+    g_thread_pool_push(WorkersPool(), &jobs[i], nullptr);
+
+  func(jobs[0].begin, jobs[0].end);
+
+  std::unique_lock<std::mutex> lock(sync.mutex);
+  sync.cond.wait(lock, [&sync] { return sync.pending == 0; });
+}
+
+//
+// Four channels kernel
+//
+
+struct Params
+{
+  int alpha;
+  int aprec;
+  int zprec;
+};
+
+#if defined(__SSE2__)
+// SSE2 has no _mm_mullo_epi32, but the low 32 bits of the product are the
+// same for signed and unsigned operands.
+inline __m128i MulLo32(__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+struct PixelState
+{
+  PixelState(uint32_t pixel, Params const& p)
+    : zero(_mm_setzero_si128())
+    , alpha(_mm_set1_epi32(p.alpha))
+    , aprec(_mm_cvtsi32_si128(p.aprec))
+    , zprec(_mm_cvtsi32_si128(p.zprec))
+    , z(_mm_sll_epi32(Unpack(pixel), zprec))
+  {}
+
+  inline __m128i Unpack(uint32_t pixel) const
+  {
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+  }
+
+  inline void Step(uint32_t& pixel)
+  {
+    __m128i delta = _mm_sub_epi32(_mm_sll_epi32(Unpack(pixel), zprec), z);
+    z = _mm_add_epi32(z, _mm_sra_epi32(MulLo32(alpha, delta), aprec));
+
+    __m128i value = _mm_sra_epi32(z, zprec);
+    value = _mm_packs_epi32(value, value);
+    pixel = _mm_cvtsi128_si32(_mm_packus_epi16(value, value));
+  }
+
+  const __m128i zero;
+  const __m128i alpha;
+  const __m128i aprec;
+  const __m128i zprec;
+  __m128i z;
+};
+#else
+struct PixelState
+{
+  PixelState(uint32_t pixel, Params const& p)
+    : params(p)
+  {
+    auto* channels = reinterpret_cast<unsigned char*>(&pixel);
+
+    for (int c = 0; c < 4; ++c)
+      z[c] = channels[c] << params.zprec;
+  }
+
+  inline void Step(uint32_t& pixel)
+  {
+    auto* channels = reinterpret_cast<unsigned char*>(&pixel);
+
+    for (int c = 0; c < 4; ++c)
+    {
+      z[c] += (params.alpha * ((channels[c] << params.zprec) - z[c])) >> params.aprec;
+      channels[c] = z[c] >> params.zprec;
+    }
+  }
+
+  Params const& params;
+  int z[4];
+};
+#endif
+
+// Rows are walked forward from the first pixel, while the original column
+// pass was starting from the second one and stopping before the last one.
+enum class LineType
+{
+  ROW,
+  COLUMN
+};
+
+void BlurLine(uint32_t* line, int size, LineType type, Params const& params)
+{
+  PixelState state(line[0], params);
+  int first = (type == LineType::ROW) ? 0 : 1;
+  int last = (type == LineType::ROW) ? size - 1 : size - 2;
+
+  for (int i = first; i <= last; ++i)
+    state.Step(line[i]);
+
+  for (int i = size - 2; i >= 0; --i)
+    state.Step(line[i]);
+}
+
+// Blurring some independent lines together hides the latency of the recursion
+const int INTERLEAVED_LINES = 4;
+
+void BlurLines(uint32_t* lines, int stride, int count, int size, LineType type, Params const& params)
+{
+  int l = 0;
+
+  for (; l + INTERLEAVED_LINES <= count; l += INTERLEAVED_LINES)
+  {
+    uint32_t* line0 = lines + l * stride;
+    uint32_t* line1 = line0 + stride;
+    uint32_t* line2 = line1 + stride;
+    uint32_t* line3 = line2 + stride;
+    PixelState state0(line0[0], params);
+    PixelState state1(line1[0], params);
+    PixelState state2(line2[0], params);
+    PixelState state3(line3[0], params);
+    int first = (type == LineType::ROW) ? 0 : 1;
+    int last = (type == LineType::ROW) ? size - 1 : size - 2;
+
+    for (int i = first; i <= last; ++i)
+    {
+      state0.Step(line0[i]);
+      state1.Step(line1[i]);
+      state2.Step(line2[i]);
+      state3.Step(line3[i]);
+    }
+
+    for (int i = size - 2; i >= 0; --i)
+    {
+      state0.Step(line0[i]);
+      state1.Step(line1[i]);
+      state2.Step(line2[i]);
+      state3.Step(line3[i]);
+    }
+  }
+
+  for (; l < count; ++l)
+    BlurLine(lines + l * stride, size, type, params);
+}
+
+// Transposes the rows [begin, end) of src (width x height) into dst (height x width)
+void Transpose(uint32_t const* src, uint32_t* dst, int width, int height, int begin, int end)
+{
+  for (int ty = begin; ty < end; ty += TILE_SIZE)
+  {
+    int y_end = std::min(end, ty + TILE_SIZE);
+
+    for (int tx = 0; tx < width; tx += TILE_SIZE)
+    {
+      int x_end = std::min(width, tx + TILE_SIZE);
+
+      for (int y = ty; y < y_end; ++y)
+        for (int x = tx; x < x_end; ++x)
+          dst[x * height + y] = src[y * width + x];
+    }
+  }
+}
+
+void ExponentialBlur4(uint32_t* pixels, int width, int height, Params const& params)
+{
+  ParallelFor(height, width, [=] (int begin, int end) {
+    BlurLines(pixels + begin * width, width, end - begin, width, LineType::ROW, params);
+  });
+
+  if (height < 2)
+    return;
+
+  std::vector<uint32_t> transposed(width * height);
+  uint32_t* columns = transposed.data();
+  int tiled_height = (height + TILE_SIZE - 1) / TILE_SIZE;
+  int tiled_width = (width + TILE_SIZE - 1) / TILE_SIZE;
+
+  ParallelFor(tiled_height, TILE_SIZE * width, [=] (int begin, int end) {
+    Transpose(pixels, columns, width, height, begin * TILE_SIZE, std::min(height, end * TILE_SIZE));
+  });
+
+  ParallelFor(width, height, [=] (int begin, int end) {
+    BlurLines(columns + begin * height, height, end - begin, height, LineType::COLUMN, params);
+  });
+
+  ParallelFor(tiled_width, TILE_SIZE * height, [=] (int begin, int end) {
+    Transpose(columns, pixels, height, width, begin * TILE_SIZE, std::min(width, end * TILE_SIZE));
+  });
+}
+
+//
+// Generic per-channel implementation, used for non four-channels images.
+//
+
+inline void BlurInner(unsigned char* pixel, int* zR, int* zG, int* zB, int* zA,
+                      int alpha, int aprec, int zprec)
+{
+  int r = *pixel;
+  int g = *(pixel + 1);
+  int b = *(pixel + 2);
+  unsigned char a = *(pixel + 3);
+
+  *zR += (alpha * ((r << zprec) - *zR)) >> aprec;
+  *zG += (alpha * ((g << zprec) - *zG)) >> aprec;
+  *zB += (alpha * ((b << zprec) - *zB)) >> aprec;
+  *zA += (alpha * ((a << zprec) - *zA)) >> aprec;
+
+  *pixel       = *zR >> zprec;
+  *(pixel + 1) = *zG >> zprec;
+  *(pixel + 2) = *zB >> zprec;
+  *(pixel + 3) = *zA >> zprec;
+}
+
+void BlurRow(unsigned char* pixels, int width, int channels, int line,
+             int alpha, int aprec, int zprec)
+{
+  unsigned char* scanline = &(pixels[line * width * channels]);
+
+  int zR = *scanline << zprec;
+  int zG = *(scanline + 1) << zprec;
+  int zB = *(scanline + 2) << zprec;
+  int zA = *(scanline + 3) << zprec;
+
+  for (int index = 0; index < width; index ++)
+    BlurInner(&scanline[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+
+  for (int index = width - 2; index >= 0; index--)
+    BlurInner(&scanline[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+}
+
+void BlurCol(unsigned char* pixels, int width, int height, int channels, int x,
+             int alpha, int aprec, int zprec)
+{
+  unsigned char* ptr = pixels + x * channels;
+
+  int zR = *(ptr    ) << zprec;
+  int zG = *(ptr + 1) << zprec;
+  int zB = *(ptr + 2) << zprec;
+  int zA = *(ptr + 3) << zprec;
+
+  for (int index = width; index < (height - 1) * width; index += width)
+    BlurInner(&ptr[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+
+  for (int index = (height - 2) * width; index >= 0; index -= width)
+    BlurInner(&ptr[index * channels], &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+}
+}
+
+void ExponentialBlur(unsigned char* pixels, int width, int height, int channels,
+                     int radius, int aprec, int zprec)
+{
+  if (radius < 1 || !pixels || width < 1 || height < 1)
+    return;
+
+  // calculate the alpha such that 90% of
+  // the kernel is within the radius.
+  // (Kernel extends to infinity)
+  int alpha = (int) ((1 << aprec) * (1.0f - expf(-2.3f / (radius + 1.f))));
+
+  if (channels == 4)
+  {
+    ExponentialBlur4(reinterpret_cast<uint32_t*>(pixels), width, height, {alpha, aprec, zprec});
+    return;
+  }
+
+  for (int row = 0; row < height; row++)
+    BlurRow(pixels, width, channels, row, alpha, aprec, zprec);
+
+  for (int col = 0; col < width; col++)
+    BlurCol(pixels, width, height, channels, col, alpha, aprec, zprec);
+}
+
+} // graphics namespace
+} // unity namespace
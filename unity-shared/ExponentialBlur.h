@@ -0,0 +1,46 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_EXPONENTIAL_BLUR_H
+#define UNITY_EXPONENTIAL_BLUR_H
+
+namespace unity
+{
+namespace graphics
+{
+
+//
+// In-place blur of 'pixels' with kernel of approximate radius 'radius'
+// using a two sided exponential impulse response.
+//
+// aprec = precision of alpha parameter in fixed-point format 0.aprec
+// zprec = precision of state parameters in fixed-point format 8.zprec
+//
+// Four channels images are blurred one pixel at time using SIMD, while the
+// column pass is done on a tiled transposition of the image, so that it only
+// walks contiguous memory. Big images are split between worker threads.
+// The result is the same of the plain per-channel implementation.
+//
+void ExponentialBlur(unsigned char* pixels, int width, int height, int channels,
+                     int radius, int aprec = 16, int zprec = 7);
+
+} // graphics namespace
+} // unity namespace
+
+#endif // UNITY_EXPONENTIAL_BLUR_H
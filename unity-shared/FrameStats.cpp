@@ -0,0 +1,313 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <NuxCore/Logger.h>
+
+namespace unity
+{
+namespace debug
+{
+DECLARE_LOGGER(logger, "unity.debug.framestats");
+
+namespace
+{
+const unsigned PHASES = unsigned(FrameStats::Phase::Size);
+
+void AddTraceEvent(std::ostringstream& json, bool& first, std::string const& name,
+                   gint64 ts, gint64 dur, std::string const& args)
+{
+  json << (first ? "" : ",\n") << "{\"name\":\"" << name << "\",\"cat\":\"unity\",\"ph\":\"X\""
+       << ",\"pid\":" << getpid() << ",\"tid\":1,\"ts\":" << ts << ",\"dur\":" << dur
+       << ",\"args\":{" << args << "}}";
+  first = false;
+}
+}
+
+FrameStats::ScopedPhase::ScopedPhase(FrameStats& stats, Phase phase)
+  : stats_(stats)
+  , phase_(phase)
+  , start_(stats_.current() ? g_get_monotonic_time() : 0)
+{}
+
+FrameStats::ScopedPhase::~ScopedPhase()
+{
+  if (start_)
+    stats_.AddPhaseTime(phase_, start_, g_get_monotonic_time() - start_);
+}
+
+FrameStats::FrameStats(unsigned capacity)
+  : enabled_(false)
+  , in_frame_(false)
+  , frames_(std::max(1u, capacity))
+  , head_(0)
+  , size_(0)
+  , sequence_(0)
+{}
+
+void FrameStats::SetEnabled(bool enabled)
+{
+  if (enabled_ == enabled)
+    return;
+
+  enabled_ = enabled;
+  in_frame_ = false;
+}
+
+bool FrameStats::IsEnabled() const
+{
+  return enabled_;
+}
+
+void FrameStats::BeginFrame()
+{
+  if (!enabled_)
+    return;
+
+  // A frame might have been aborted without reaching its end
+  if (in_frame_)
+    EndFrame();
+
+  Frame& frame = frames_[head_];
+  frame = Frame();
+  frame.sequence = ++sequence_;
+  frame.start = g_get_monotonic_time();
+  in_frame_ = true;
+}
+
+void FrameStats::EndFrame()
+{
+  if (!in_frame_)
+    return;
+
+  frames_[head_].end = g_get_monotonic_time();
+  head_ = (head_ + 1) % frames_.size();
+  size_ = std::min(size_ + 1, frames_.size());
+  in_frame_ = false;
+}
+
+FrameStats::Frame* FrameStats::current()
+{
+  return in_frame_ ? &frames_[head_] : nullptr;
+}
+
+void FrameStats::AddPhaseTime(Phase phase, gint64 start, gint64 duration)
+{
+  Frame* frame = current();
+
+  if (!frame || phase >= Phase::Size)
+    return;
+
+  PhaseTime& time = frame->phases[unsigned(phase)];
+
+  if (!time.start)
+    time.start = start;
+
+  time.duration += duration;
+  ++time.calls;
+}
+
+unsigned FrameStats::capacity() const
+{
+  return frames_.size();
+}
+
+std::size_t FrameStats::size() const
+{
+  return size_;
+}
+
+uint64_t FrameStats::total_frames() const
+{
+  return sequence_;
+}
+
+std::vector<FrameStats::Frame> FrameStats::Frames() const
+{
+  std::vector<Frame> frames;
+  frames.reserve(size_);
+
+  std::size_t first = (head_ + frames_.size() - size_) % frames_.size();
+
+  for (std::size_t i = 0; i < size_; ++i)
+    frames.push_back(frames_[(first + i) % frames_.size()]);
+
+  return frames;
+}
+
+void FrameStats::Reset()
+{
+  head_ = 0;
+  size_ = 0;
+  in_frame_ = false;
+}
+
+std::string FrameStats::PhaseName(Phase phase)
+{
+  switch (phase)
+  {
+    case Phase::PREPARE_PAINT:
+      return "prepare_paint";
+    case Phase::DAMAGE_CUTOFF:
+      return "damage_cutoff";
+    case Phase::GL_PAINT_OUTPUT:
+      return "gl_paint_output";
+    case Phase::PAINT_OUTPUT:
+      return "paint_output";
+    case Phase::DONE_PAINT:
+      return "done_paint";
+    default:
+      return "";
+  }
+}
+
+std::string FrameStats::ChromeTrace() const
+{
+  std::ostringstream json;
+  bool first = true;
+  json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  for (auto const& frame : Frames())
+  {
+    std::ostringstream args;
+    args << "\"sequence\":" << frame.sequence
+         << ",\"damage_cutoff_iterations\":" << frame.damage_cutoff_iterations
+         << ",\"damage_rects\":" << frame.damage_rects
+         << ",\"damage_area\":" << frame.damage_area
+         << ",\"presentation_list_size\":" << frame.presentation_list_size
+         << ",\"force_draw_countdown\":" << frame.force_draw_countdown
+         << ",\"blur_dirty\":" << (frame.blur_dirty ? "true" : "false")
+         << ",\"blurred_pixels\":" << frame.blurred_pixels
+         << ",\"blur_full_updates\":" << frame.blur_full_updates
+         << ",\"blur_partial_updates\":" << frame.blur_partial_updates;
+
+    AddTraceEvent(json, first, "frame", frame.start, frame.end - frame.start, args.str());
+
+    for (unsigned i = 0; i < PHASES; ++i)
+    {
+      auto const& phase = frame.phases[i];
+
+      if (!phase.calls)
+        continue;
+
+      auto const& calls = "\"calls\":" + std::to_string(phase.calls);
+      AddTraceEvent(json, first, PhaseName(Phase(i)), phase.start, phase.duration, calls);
+    }
+  }
+
+  json << "\n]}\n";
+  return json.str();
+}
+
+bool FrameStats::DumpChromeTrace(std::string const& path) const
+{
+  std::ofstream output(path);
+
+  if (!output.is_open())
+  {
+    LOG_ERROR(logger) << "Impossible to open file '" << path << "' for writing";
+    return false;
+  }
+
+  output << ChromeTrace();
+  return output.good();
+}
+
+//
+// Introspection
+//
+std::string FrameStats::GetName() const
+{
+  return "FrameStats";
+}
+
+void FrameStats::AddProperties(IntrospectionData& introspection)
+{
+  gint64 total_usec = 0;
+  gint64 max_usec = 0;
+  gint64 phase_total[PHASES] = {0};
+  gint64 phase_max[PHASES] = {0};
+  uint64_t iterations = 0;
+  unsigned max_iterations = 0;
+  unsigned blur_updates = 0;
+  unsigned blur_full_updates = 0;
+  unsigned blur_partial_updates = 0;
+  uint64_t blurred_pixels = 0;
+  uint64_t max_blurred_pixels = 0;
+  auto const& frames = Frames();
+
+  for (auto const& frame : frames)
+  {
+    gint64 usec = frame.end - frame.start;
+    total_usec += usec;
+    max_usec = std::max(max_usec, usec);
+    iterations += frame.damage_cutoff_iterations;
+    max_iterations = std::max(max_iterations, frame.damage_cutoff_iterations);
+    blur_updates += frame.blur_dirty ? 1 : 0;
+    blur_full_updates += frame.blur_full_updates;
+    blur_partial_updates += frame.blur_partial_updates;
+    blurred_pixels += frame.blurred_pixels;
+    max_blurred_pixels = std::max(max_blurred_pixels, frame.blurred_pixels);
+
+    for (unsigned i = 0; i < PHASES; ++i)
+    {
+      phase_total[i] += frame.phases[i].duration;
+      phase_max[i] = std::max(phase_max[i], frame.phases[i].duration);
+    }
+  }
+
+  double n_frames = std::max<std::size_t>(1, frames.size());
+  Frame const& last = frames.empty() ? Frame() : frames.back();
+
+  introspection
+  .add("enabled", enabled_)
+  .add("capacity", capacity())
+  .add("frames", frames.size())
+  .add("total_frames", total_frames())
+  .add("average_frame_usec", total_usec / n_frames)
+  .add("max_frame_usec", max_usec)
+  .add("average_damage_cutoff_iterations", iterations / n_frames)
+  .add("max_damage_cutoff_iterations", max_iterations)
+  .add("blur_updates", blur_updates)
+  .add("blur_full_updates", blur_full_updates)
+  .add("blur_partial_updates", blur_partial_updates)
+  .add("average_blurred_pixels", blurred_pixels / n_frames)
+  .add("max_blurred_pixels", max_blurred_pixels)
+  .add("last_damage_rects", last.damage_rects)
+  .add("last_damage_area", last.damage_area)
+  .add("last_presentation_list_size", last.presentation_list_size)
+  .add("last_force_draw_countdown", last.force_draw_countdown)
+  .add("last_blurred_pixels", last.blurred_pixels);
+
+  for (unsigned i = 0; i < PHASES; ++i)
+  {
+    auto const& name = PhaseName(Phase(i));
+    introspection
+    .add(name + "_average_usec", phase_total[i] / n_frames)
+    .add(name + "_max_usec", phase_max[i]);
+  }
+}
+
+} // debug namespace
+} // unity namespace
@@ -0,0 +1,135 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_FRAME_STATS_H
+#define UNITY_FRAME_STATS_H
+
+#include <glib.h>
+#include <string>
+#include <vector>
+
+#include "Introspectable.h"
+
+namespace unity
+{
+namespace debug
+{
+
+//
+// Fixed size ring buffer of per-frame compositor statistics.
+// It's disabled by default and it can be turned on via the debug D-Bus interface.
+// Recording a frame only costs a few monotonic clock reads, the collected data
+// can be queried via introspection or dumped to a Chrome trace JSON file
+// (to be loaded in chrome://tracing).
+//
+class FrameStats : public Introspectable
+{
+public:
+  enum class Phase : unsigned
+  {
+    PREPARE_PAINT = 0,
+    DAMAGE_CUTOFF,
+    GL_PAINT_OUTPUT,
+    PAINT_OUTPUT,
+    DONE_PAINT,
+    Size
+  };
+
+  struct PhaseTime
+  {
+    gint64 start = 0;    // Monotonic time of the first run in the frame, 0 if not run
+    gint64 duration = 0; // Total time spent in the phase during the frame
+    unsigned calls = 0;
+  };
+
+  struct Frame
+  {
+    uint64_t sequence = 0;
+    gint64 start = 0;
+    gint64 end = 0;
+    PhaseTime phases[unsigned(Phase::Size)];
+    unsigned damage_cutoff_iterations = 0;
+    unsigned damage_rects = 0;
+    uint64_t damage_area = 0;
+    unsigned presentation_list_size = 0;
+    unsigned force_draw_countdown = 0;
+    bool blur_dirty = false;
+    uint64_t blurred_pixels = 0;
+    unsigned blur_full_updates = 0;
+    unsigned blur_partial_updates = 0;
+  };
+
+  class ScopedPhase
+  {
+  public:
+    ScopedPhase(FrameStats&, Phase);
+    ~ScopedPhase();
+
+  private:
+    ScopedPhase(ScopedPhase const&) = delete;
+    ScopedPhase& operator=(ScopedPhase const&) = delete;
+
+    FrameStats& stats_;
+    Phase phase_;
+    gint64 start_;
+  };
+
+  static const unsigned DEFAULT_CAPACITY = 512;
+
+  FrameStats(unsigned capacity = DEFAULT_CAPACITY);
+
+  void SetEnabled(bool);
+  bool IsEnabled() const;
+
+  void BeginFrame();
+  void EndFrame();
+
+  // The frame being recorded, nullptr if there's none or if disabled.
+  Frame* current();
+  void AddPhaseTime(Phase, gint64 start, gint64 duration);
+
+  unsigned capacity() const;
+  std::size_t size() const;
+  uint64_t total_frames() const;
+
+  // Recorded frames, ordered from the oldest to the newest.
+  std::vector<Frame> Frames() const;
+  void Reset();
+
+  std::string ChromeTrace() const;
+  bool DumpChromeTrace(std::string const& path) const;
+
+  static std::string PhaseName(Phase);
+
+  std::string GetName() const;
+  void AddProperties(IntrospectionData&);
+
+private:
+  bool enabled_;
+  bool in_frame_;
+  std::vector<Frame> frames_;
+  std::size_t head_;
+  std::size_t size_;
+  uint64_t sequence_;
+};
+
+} // debug namespace
+} // unity namespace
+
+#endif // UNITY_FRAME_STATS_H
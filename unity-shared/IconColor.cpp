@@ -0,0 +1,262 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "IconColor.h"
+#include "ThemeSettings.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace unity
+{
+namespace icon_color
+{
+namespace
+{
+// The relevance of a pixel is 0.1 + 0.9 * (alpha / 255) * (saturation / 255),
+// we use it scaled by 255 * 255 * 10 so that it can be computed in integers.
+const uint32_t BASE_WEIGHT = 255 * 255;
+const uint32_t SATURATION_WEIGHT = 9;
+
+struct Totals
+{
+  uint64_t red = 0;
+  uint64_t green = 0;
+  uint64_t blue = 0;
+  uint64_t weight = 0;
+};
+
+inline void AccumulatePixel(uint32_t r, uint32_t g, uint32_t b, uint32_t a, Totals& totals)
+{
+  uint32_t saturation = std::max(r, std::max(g, b)) - std::min(r, std::min(g, b));
+  uint32_t weight = BASE_WEIGHT + SATURATION_WEIGHT * a * saturation;
+
+  totals.red += r * weight;
+  totals.green += g * weight;
+  totals.blue += b * weight;
+  totals.weight += weight;
+}
+
+void AccumulateRow(unsigned char const* row, unsigned width, unsigned n_channels, Totals& totals)
+{
+  if (n_channels == 4)
+  {
+    for (unsigned i = 0; i < width; ++i, row += 4)
+      AccumulatePixel(row[0], row[1], row[2], row[3], totals);
+  }
+  else
+  {
+    for (unsigned i = 0; i < width; ++i, row += n_channels)
+      AccumulatePixel(row[0], row[1], row[2], 255, totals);
+  }
+}
+
+#if defined(__SSE2__)
+inline uint64_t HorizontalSum(__m128i v)
+{
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), v);
+  return lanes[0] + lanes[1];
+}
+
+// Weighted sum of 4 RGBA pixels at time, each one in a 32 bit lane.
+// Products are widened to 64 bits via _mm_mul_epu32 on even and odd lanes.
+void AccumulateRowSSE2(unsigned char const* row, unsigned width, Totals& totals)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i byte_mask = _mm_set1_epi32(0xff);
+  const __m128i base_weight = _mm_set1_epi32(BASE_WEIGHT);
+
+  __m128i red = zero;
+  __m128i green = zero;
+  __m128i blue = zero;
+  __m128i weight = zero;
+  unsigned i = 0;
+
+  for (; i + 4 <= width; i += 4)
+  {
+    __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i * 4));
+    __m128i px_g = _mm_srli_epi32(px, 8);
+    __m128i px_b = _mm_srli_epi32(px, 16);
+
+    __m128i max = _mm_and_si128(_mm_max_epu8(px, _mm_max_epu8(px_g, px_b)), byte_mask);
+    __m128i min = _mm_and_si128(_mm_min_epu8(px, _mm_min_epu8(px_g, px_b)), byte_mask);
+    __m128i saturation = _mm_sub_epi32(max, min);
+    __m128i alpha = _mm_srli_epi32(px, 24);
+
+    // Both alpha and saturation fit in the low 16 bits, so madd is a plain multiply
+    __m128i as = _mm_madd_epi16(alpha, saturation);
+    __m128i w = _mm_add_epi32(base_weight, _mm_add_epi32(_mm_slli_epi32(as, 3), as));
+    __m128i w_odd = _mm_srli_epi64(w, 32);
+
+    __m128i r = _mm_and_si128(px, byte_mask);
+    __m128i g = _mm_and_si128(px_g, byte_mask);
+    __m128i b = _mm_and_si128(px_b, byte_mask);
+
+    red = _mm_add_epi64(red, _mm_add_epi64(_mm_mul_epu32(r, w), _mm_mul_epu32(_mm_srli_epi64(r, 32), w_odd)));
+    green = _mm_add_epi64(green, _mm_add_epi64(_mm_mul_epu32(g, w), _mm_mul_epu32(_mm_srli_epi64(g, 32), w_odd)));
+    blue = _mm_add_epi64(blue, _mm_add_epi64(_mm_mul_epu32(b, w), _mm_mul_epu32(_mm_srli_epi64(b, 32), w_odd)));
+    weight = _mm_add_epi64(weight, _mm_add_epi64(_mm_unpacklo_epi32(w, zero), _mm_unpackhi_epi32(w, zero)));
+  }
+
+  totals.red += HorizontalSum(red);
+  totals.green += HorizontalSum(green);
+  totals.blue += HorizontalSum(blue);
+  totals.weight += HorizontalSum(weight);
+
+  AccumulateRow(row + i * 4, width - i, 4, totals);
+}
+#endif
+
+nux::color::RedGreenBlue ComputeAverage(unsigned char const* pixels, unsigned width, unsigned height,
+                                        unsigned rowstride, unsigned n_channels, bool vectorize)
+{
+  if (!pixels || !width || !height || n_channels < 3)
+    return nux::color::RedGreenBlue(1.0f, 1.0f, 1.0f);
+
+  Totals totals;
+
+  for (unsigned j = 0; j < height; ++j)
+  {
+    unsigned char const* row = pixels + j * rowstride;
+
+#if defined(__SSE2__)
+    if (vectorize && n_channels == 4)
+    {
+      AccumulateRowSSE2(row, width, totals);
+      continue;
+    }
+#endif
+
+    AccumulateRow(row, width, n_channels, totals);
+  }
+
+  double total = static_cast<double>(totals.weight) * 255.0;
+
+  return nux::color::RedGreenBlue(totals.red / total,
+                                  totals.green / total,
+                                  totals.blue / total);
+}
+}
+
+nux::color::RedGreenBlue Average(unsigned char const* pixels, unsigned width, unsigned height,
+                                 unsigned rowstride, unsigned n_channels)
+{
+  return ComputeAverage(pixels, width, height, rowstride, n_channels, true);
+}
+
+nux::color::RedGreenBlue AverageUnvectorized(unsigned char const* pixels, unsigned width, unsigned height,
+                                             unsigned rowstride, unsigned n_channels)
+{
+  return ComputeAverage(pixels, width, height, rowstride, n_channels, false);
+}
+
+nux::color::RedGreenBlue Average(GdkPixbuf* pixbuf)
+{
+  if (!GDK_IS_PIXBUF(pixbuf) || gdk_pixbuf_get_bits_per_sample(pixbuf) != 8)
+    return nux::color::RedGreenBlue(1.0f, 1.0f, 1.0f);
+
+  return Average(gdk_pixbuf_get_pixels(pixbuf),
+                 gdk_pixbuf_get_width(pixbuf),
+                 gdk_pixbuf_get_height(pixbuf),
+                 gdk_pixbuf_get_rowstride(pixbuf),
+                 gdk_pixbuf_get_n_channels(pixbuf));
+}
+
+Colors FromAverage(nux::color::RedGreenBlue const& rgb)
+{
+  Colors colors;
+  nux::color::HueSaturationValue hsv(rgb);
+
+  if (hsv.saturation > 0.15f)
+    hsv.saturation = 0.65f;
+
+  hsv.value = 0.90f;
+  colors.background = nux::Color(nux::color::RedGreenBlue(hsv));
+
+  hsv.value = 1.0f;
+  colors.glow = nux::Color(nux::color::RedGreenBlue(hsv));
+
+  return colors;
+}
+
+Colors ForPixbuf(GdkPixbuf* pixbuf)
+{
+  return FromAverage(Average(pixbuf));
+}
+
+//
+// Cache
+//
+
+Cache& Cache::Get()
+{
+  static Cache cache;
+  return cache;
+}
+
+Cache::Cache(std::size_t max_size)
+  : max_size_(max_size)
+{
+  theme::Settings::Get()->icons_changed.connect(sigc::mem_fun(this, &Cache::Clear));
+}
+
+Colors Cache::ForPixbuf(std::string const& icon, std::string const& theme, GdkPixbuf* pixbuf)
+{
+  if (theme.empty() || !max_size_)
+    return icon_color::ForPixbuf(pixbuf);
+
+  auto key = theme + ":" + icon;
+  auto it = colors_.find(key);
+
+  if (it != colors_.end())
+  {
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+
+  if (colors_.size() >= max_size_)
+  {
+    colors_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+
+  entries_.emplace_front(key, icon_color::ForPixbuf(pixbuf));
+  colors_[key] = entries_.begin();
+
+  return entries_.front().second;
+}
+
+void Cache::Clear()
+{
+  colors_.clear();
+  entries_.clear();
+}
+
+std::size_t Cache::Size() const
+{
+  return colors_.size();
+}
+
+} // icon_color namespace
+} // unity namespace
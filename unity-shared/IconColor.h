@@ -0,0 +1,88 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_ICON_COLOR_H
+#define UNITY_ICON_COLOR_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <NuxCore/Color.h>
+#include <sigc++/trackable.h>
+
+namespace unity
+{
+namespace icon_color
+{
+
+struct Colors
+{
+  nux::Color background;
+  nux::Color glow;
+};
+
+// Average color of an RGB(A) buffer, where saturated and opaque pixels are
+// more relevant. The statistics are computed in fixed point, using SSE2 when
+// available, so results are identical between the vectorized and plain paths.
+nux::color::RedGreenBlue Average(unsigned char const* pixels, unsigned width, unsigned height,
+                                 unsigned rowstride, unsigned n_channels = 4);
+nux::color::RedGreenBlue Average(GdkPixbuf*);
+
+// Same as Average, but never vectorized.
+nux::color::RedGreenBlue AverageUnvectorized(unsigned char const* pixels, unsigned width, unsigned height,
+                                             unsigned rowstride, unsigned n_channels = 4);
+
+// Background and glow colors as used by the launcher and the HUD tiles.
+Colors FromAverage(nux::color::RedGreenBlue const&);
+Colors ForPixbuf(GdkPixbuf*);
+
+// Process-wide cache of the icon colors, so that rebuilding an icon texture
+// at a different size doesn't require to compute its statistics again.
+// Icons are identified by name and icon theme name, the least recently used
+// ones are dropped when the cache is full and it's cleared on theme changes.
+class Cache : public sigc::trackable
+{
+public:
+  static const std::size_t DEFAULT_MAX_SIZE = 256;
+
+  static Cache& Get();
+  Cache(std::size_t max_size = DEFAULT_MAX_SIZE);
+
+  // Icons not coming from a named theme are not cached
+  Colors ForPixbuf(std::string const& icon, std::string const& theme, GdkPixbuf*);
+
+  void Clear();
+  std::size_t Size() const;
+
+private:
+  Cache(Cache const&) = delete;
+  Cache& operator=(Cache const&) = delete;
+
+  typedef std::pair<std::string, Colors> Entry;
+
+  std::size_t max_size_;
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> colors_;
+};
+
+} // icon_color namespace
+} // unity namespace
+
+#endif // UNITY_ICON_COLOR_H
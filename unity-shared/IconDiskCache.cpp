@@ -0,0 +1,314 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "IconDiskCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <vector>
+#include <glib/gstdio.h>
+#include <NuxCore/Logger.h>
+
+namespace unity
+{
+DECLARE_LOGGER(logger, "unity.iconloader.diskcache");
+namespace
+{
+const char ENTRY_MAGIC[4] = {'U', 'I', 'C', 'N'};
+const guint32 ENTRY_VERSION = 1;
+const gsize PIXELS_ALIGNMENT = 16;
+const std::string FALLBACK_ICON_THEME = "hicolor";
+
+struct EntryHeader
+{
+  char magic[4];
+  guint32 version;
+  guint32 width;
+  guint32 height;
+  guint32 rowstride;
+  guint32 has_alpha;
+  guint32 key_length;
+  guint32 pixels_offset;
+};
+
+std::string Checksum(std::string const& str)
+{
+  return glib::String(g_compute_checksum_for_string(G_CHECKSUM_SHA1, str.c_str(), str.size())).Str();
+}
+
+// Calls the function for each entry of the directory, returns false if it can't be read
+bool ForEachFile(std::string const& directory, std::function<void(std::string const& path)> const& func)
+{
+  GDir* dir = g_dir_open(directory.c_str(), 0, nullptr);
+
+  if (!dir)
+    return false;
+
+  while (const gchar* name = g_dir_read_name(dir))
+    func(directory + G_DIR_SEPARATOR_S + name);
+
+  g_dir_close(dir);
+  return true;
+}
+
+void RemoveDirectory(std::string const& directory)
+{
+  ForEachFile(directory, [] (std::string const& path) { g_unlink(path.c_str()); });
+  g_rmdir(directory.c_str());
+}
+
+void UnrefMappedFile(guchar*, gpointer data)
+{
+  g_mapped_file_unref(static_cast<GMappedFile*>(data));
+}
+}
+
+IconDiskCache::IconDiskCache(std::string const& directory, std::string const& stamp, unsigned max_entries)
+  : max_entries_(max_entries)
+  , entries_(0)
+{
+  if (directory.empty())
+    return;
+
+  auto const& stamp_dir = Checksum(stamp);
+
+  // Entries of older stamps can't be valid anymore
+  ForEachFile(directory, [&stamp_dir] (std::string const& path) {
+    glib::String basename(g_path_get_basename(path.c_str()));
+
+    if (basename.Str() != stamp_dir && g_file_test(path.c_str(), G_FILE_TEST_IS_DIR))
+      RemoveDirectory(path);
+  });
+
+  auto const& cache_dir = directory + G_DIR_SEPARATOR_S + stamp_dir;
+
+  if (g_mkdir_with_parents(cache_dir.c_str(), 0700) < 0)
+  {
+    LOG_ERROR(logger) << "Impossible to create icons cache folder '" << cache_dir << "'";
+    return;
+  }
+
+  directory_ = cache_dir + G_DIR_SEPARATOR_S;
+
+  unsigned entries = 0;
+  ForEachFile(cache_dir, [&entries] (std::string const&) { ++entries; });
+  entries_ = entries;
+
+  if (entries > max_entries_)
+  {
+    LOG_INFO(logger) << "Icons cache has " << entries << " entries, clearing it";
+    Clear();
+  }
+}
+
+std::string const& IconDiskCache::directory() const
+{
+  return directory_;
+}
+
+std::string IconDiskCache::EntryPath(std::string const& key) const
+{
+  return directory_ + Checksum(key);
+}
+
+glib::Object<GdkPixbuf> IconDiskCache::Lookup(std::string const& key) const
+{
+  if (directory_.empty())
+    return glib::Object<GdkPixbuf>();
+
+  auto const& path = EntryPath(key);
+
+  // Writable mappings are private, so the pixbuf can be safely modified
+  GMappedFile* mapped = g_mapped_file_new(path.c_str(), TRUE, nullptr);
+
+  if (!mapped)
+    return glib::Object<GdkPixbuf>();
+
+  const gchar* contents = g_mapped_file_get_contents(mapped);
+  guint64 length = g_mapped_file_get_length(mapped);
+  EntryHeader header;
+
+  bool valid = contents && length >= sizeof(EntryHeader);
+
+  if (valid)
+  {
+    std::memcpy(&header, contents, sizeof(EntryHeader));
+    guint64 n_channels = header.has_alpha ? 4 : 3;
+    guint64 pixels_length = guint64(header.rowstride) * (header.height - 1) + header.width * n_channels;
+
+    valid = std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0 &&
+            header.version == ENTRY_VERSION &&
+            header.width > 0 && header.height > 0 &&
+            header.rowstride >= header.width * n_channels &&
+            header.pixels_offset % PIXELS_ALIGNMENT == 0 &&
+            header.pixels_offset >= sizeof(EntryHeader) + guint64(header.key_length) &&
+            guint64(header.pixels_offset) + pixels_length <= length &&
+            key.compare(0, std::string::npos, contents + sizeof(EntryHeader), header.key_length) == 0;
+  }
+
+  if (!valid)
+  {
+    LOG_DEBUG(logger) << "Ignoring invalid cache entry for " << key;
+    g_mapped_file_unref(mapped);
+
+    if (g_unlink(path.c_str()) == 0)
+    {
+      std::lock_guard<std::mutex> lock(entries_mutex_);
+
+      if (entries_ > 0)
+        --entries_;
+    }
+
+    return glib::Object<GdkPixbuf>();
+  }
+
+  auto* pixels = reinterpret_cast<guchar*>(g_mapped_file_get_contents(mapped) + header.pixels_offset);
+
+  // The pixbuf owns the mapping, so no pixel data is copied
+  return glib::Object<GdkPixbuf>(gdk_pixbuf_new_from_data(pixels, GDK_COLORSPACE_RGB, header.has_alpha, 8,
+                                                          header.width, header.height, header.rowstride,
+                                                          UnrefMappedFile, mapped));
+}
+
+bool IconDiskCache::Store(std::string const& key, GdkPixbuf* pixbuf) const
+{
+  if (directory_.empty() || !GDK_IS_PIXBUF(pixbuf))
+    return false;
+
+  if (gdk_pixbuf_get_colorspace(pixbuf) != GDK_COLORSPACE_RGB ||
+      gdk_pixbuf_get_bits_per_sample(pixbuf) != 8 ||
+      gdk_pixbuf_get_n_channels(pixbuf) != (gdk_pixbuf_get_has_alpha(pixbuf) ? 4 : 3))
+  {
+    return false;
+  }
+
+  EntryHeader header;
+  std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+  header.version = ENTRY_VERSION;
+  header.width = gdk_pixbuf_get_width(pixbuf);
+  header.height = gdk_pixbuf_get_height(pixbuf);
+  header.rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  header.has_alpha = gdk_pixbuf_get_has_alpha(pixbuf);
+  header.key_length = key.size();
+  header.pixels_offset = (sizeof(EntryHeader) + key.size() + PIXELS_ALIGNMENT - 1) / PIXELS_ALIGNMENT * PIXELS_ALIGNMENT;
+
+  std::string contents(reinterpret_cast<const char*>(&header), sizeof(EntryHeader));
+  contents.append(key);
+  contents.resize(header.pixels_offset, '\0');
+  contents.append(reinterpret_cast<const char*>(gdk_pixbuf_get_pixels(pixbuf)), gdk_pixbuf_get_byte_length(pixbuf));
+
+  glib::Error error;
+  auto const& path = EntryPath(key);
+  bool replacing = g_file_test(path.c_str(), G_FILE_TEST_EXISTS);
+
+  if (!g_file_set_contents(path.c_str(), contents.data(), contents.size(), &error))
+  {
+    LOG_WARNING(logger) << "Impossible to store cache entry for " << key << ": " << error;
+    return false;
+  }
+
+  if (!replacing && ++entries_ > max_entries_)
+  {
+    std::lock_guard<std::mutex> lock(entries_mutex_);
+
+    // Another thread might have already cleared it meanwhile
+    if (entries_ > max_entries_)
+    {
+      LOG_INFO(logger) << "Icons cache has more than " << max_entries_ << " entries, clearing it";
+      RemoveEntries(path);
+      entries_ = 1;
+    }
+  }
+
+  return true;
+}
+
+void IconDiskCache::RemoveEntries(std::string const& keep_path) const
+{
+  ForEachFile(directory_, [&keep_path] (std::string const& path) {
+    if (path != keep_path)
+      g_unlink(path.c_str());
+  });
+}
+
+void IconDiskCache::Clear()
+{
+  if (directory_.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(entries_mutex_);
+  RemoveEntries();
+  entries_ = 0;
+}
+
+std::string IconDiskCache::ThemeStamp(GtkIconTheme* theme)
+{
+  std::ostringstream stamp;
+  std::string theme_name;
+
+  if (GtkSettings* settings = gtk_settings_get_default())
+  {
+    glib::String name;
+    g_object_get(settings, "gtk-icon-theme-name", &name, nullptr);
+    theme_name = name.Str();
+    stamp << theme_name;
+  }
+
+  if (!theme)
+    return stamp.str();
+
+  gchar** search_paths = nullptr;
+  gint n_paths = 0;
+  gtk_icon_theme_get_search_path(theme, &search_paths, &n_paths);
+  gint64 max_mtime = 0;
+
+  auto update_mtime = [&max_mtime] (std::string const& path) {
+    GStatBuf buf;
+
+    if (g_stat(path.c_str(), &buf) == 0 && S_ISDIR(buf.st_mode))
+      max_mtime = std::max<gint64>(max_mtime, buf.st_mtime);
+  };
+
+  std::vector<std::string> themes = { FALLBACK_ICON_THEME };
+
+  if (!theme_name.empty() && theme_name != FALLBACK_ICON_THEME)
+    themes.push_back(theme_name);
+
+  /* Adding or removing an icon theme changes the modification time of its
+   * search path, while updating it replaces its icon-theme.cache, changing
+   * the modification time of the theme folder. So there's no need to check
+   * every file, just the folders of the current theme and of the fallback. */
+  for (gint i = 0; i < n_paths; ++i)
+  {
+    stamp << ":" << search_paths[i];
+    update_mtime(search_paths[i]);
+
+    for (auto const& name : themes)
+      update_mtime(std::string(search_paths[i]) + G_DIR_SEPARATOR_S + name);
+  }
+
+  g_strfreev(search_paths);
+  stamp << ":" << max_mtime;
+
+  return stamp.str();
+}
+
+} // unity namespace
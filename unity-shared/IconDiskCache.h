@@ -0,0 +1,79 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_ICON_DISK_CACHE_H
+#define UNITY_ICON_DISK_CACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <gtk/gtk.h>
+#include <UnityCore/GLibWrapper.h>
+
+namespace unity
+{
+
+//
+// Persistent cache of already scaled icon pixbufs.
+//
+// Each entry is a file containing the raw pixbuf pixels, named after the hash
+// of its key. Entries are stored under a directory named after the hash of the
+// stamp, so when the stamp changes (i.e. the icon theme has been changed or
+// updated) the old entries are just ignored and removed on next startup.
+// Lookups map the file in memory, so that the pixbuf uses the file pages as its
+// own pixels without any copy or decoding. When the entries exceed the maximum
+// number, the cache is cleared.
+//
+class IconDiskCache
+{
+public:
+  typedef std::shared_ptr<IconDiskCache> Ptr;
+
+  IconDiskCache(std::string const& directory, std::string const& stamp, unsigned max_entries = 4096);
+
+  std::string const& directory() const;
+
+  // Returns an empty object on miss or on invalid entries, which are removed.
+  // Thread safe, meant to be called from the loader worker thread.
+  glib::Object<GdkPixbuf> Lookup(std::string const& key) const;
+
+  // Thread safe, entries are atomically replaced
+  bool Store(std::string const& key, GdkPixbuf*) const;
+
+  void Clear();
+
+  // Stamp identifying the current icon theme and the modification time of the
+  // search paths and of the theme folders, so it changes when icons or themes
+  // are installed or removed. Only directories are checked.
+  static std::string ThemeStamp(GtkIconTheme*);
+
+private:
+  std::string EntryPath(std::string const& key) const;
+  void RemoveEntries(std::string const& keep_path = "") const;
+
+  std::string directory_;
+  unsigned max_entries_;
+  mutable std::atomic<unsigned> entries_;
+  mutable std::mutex entries_mutex_;
+};
+
+} // unity namespace
+
+#endif // UNITY_ICON_DISK_CACHE_H
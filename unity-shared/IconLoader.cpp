@@ -20,8 +20,10 @@
 #include "IconLoader.h"
 #include "config.h"
 
-#include <queue>
-#include <sstream>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <boost/algorithm/string.hpp>
 #include <unity-protocol.h>
 #include <pango/pango.h>
@@ -31,10 +33,12 @@
 #include <NuxCore/Logger.h>
 #include <NuxGraphics/CairoGraphics.h>
 #include <UnityCore/ConnectionManager.h>
+#include <UnityCore/DesktopUtilities.h>
 #include <UnityCore/GLibSource.h>
 #include <UnityCore/GLibWrapper.h>
 
-#include "unity-shared/Timer.h"
+#include "unity-shared/IconDiskCache.h"
+#include "unity-shared/IconPixbufCache.h"
 #include "unity-shared/ThemeSettings.h"
 #include "unity-shared/UnitySettings.h"
 
@@ -45,6 +49,9 @@ namespace
 {
 const int MIN_ICON_SIZE = 2;
 const int RIBBON_PADDING = 2;
+const unsigned MAX_WORKERS = 4;
+// Results are delivered to the clients at most once per frame
+const unsigned COALESCE_INTERVAL = 16;
 }
 
 class IconLoader::Impl
@@ -53,15 +60,18 @@ public:
   static const int FONT_SIZE = 8;
   static const int MIN_FONT_SIZE = 5;
 
-  Impl();
+  Impl(unsigned max_workers = 0, bool paused = false);
+  ~Impl();
 
-  Handle LoadFromIconName(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromGIconString(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromThemedFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromURI(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
+  Handle LoadFromIconName(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority);
+  Handle LoadFromGIconString(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority);
+  Handle LoadFromFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority);
+  Handle LoadFromThemedFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority);
+  Handle LoadFromURI(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority);
 
   void DisconnectHandle(Handle);
+  void SetWorkersPaused(bool);
+  void AddProperties(debug::IntrospectionData&);
 
   static void CalculateTextHeight(int* width, int* height);
 
@@ -74,38 +84,47 @@ private:
     REQUEST_TYPE_URI,
   };
 
-  struct IconLoaderTask
+  struct IconLoaderTask : std::enable_shared_from_this<IconLoaderTask>
   {
     typedef std::shared_ptr<IconLoaderTask> Ptr;
+    typedef std::pair<int, uint64_t> QueueKey;
 
     IconLoaderRequestType type;
     std::string data;
     int max_width;
     int max_height;
-    std::string key;
+    IconPixbufCache::Key key;
     IconLoaderCallback slot;
     Handle handle;
+    Priority priority;
     Impl* impl;
     glib::Object<GtkIconInfo> icon_info;
+    glib::Object<UnityProtocolAnnotatedIcon> annotated_icon;
+    IconDiskCache::Ptr disk_cache;
     bool no_cache;
+    bool disk_cache_hit;
+    bool annotating;
     Handle helper_handle;
     std::list<IconLoaderTask::Ptr> shadow_tasks;
     glib::Object<GdkPixbuf> result;
     glib::Error error;
-    glib::SourceManager idles;
+
+    // Protected by Impl::queue_mutex_
+    QueueKey queue_key;
 
     IconLoaderTask(IconLoaderRequestType type_,
                    std::string const& data_,
                    int max_width_,
                    int max_height_,
-                   std::string const& key_,
+                   IconPixbufCache::Key const& key_,
                    IconLoaderCallback const& slot_,
                    Handle handle_,
+                   Priority priority_,
                    Impl* self_)
       : type(type_), data(data_), max_width(max_width_)
       , max_height(max_height_), key(key_)
-      , slot(slot_), handle(handle_), impl(self_)
-      , no_cache(false), helper_handle(0)
+      , slot(slot_), handle(handle_), priority(priority_), impl(self_)
+      , no_cache(false), disk_cache_hit(false), annotating(false), helper_handle(0)
       {}
 
     ~IconLoaderTask()
@@ -134,92 +153,69 @@ private:
       shadow_tasks.clear();
     }
 
-    bool Process()
+    bool HasSlots() const
     {
-      // Check the cache again, as previous tasks might have wanted the same
-      if (impl->CacheLookup(key, data, max_width, max_height, slot))
+      if (slot)
         return true;
 
-      LOG_DEBUG(logger) << "Processing  " << data << " at size " << max_height;
+      for (auto const& shadow_task : shadow_tasks)
+      {
+        if (shadow_task->slot)
+          return true;
+      }
+
+      return false;
+    }
 
+    // GtkIconTheme is not thread safe, so the icon lookups happen in the
+    // main thread, while the workers only load and decode the found files.
+    // Returns false if there's nothing left to do for the workers.
+    bool Resolve()
+    {
       // Rely on the compiler to tell us if we miss a new type
       switch (type)
       {
         case REQUEST_TYPE_ICON_NAME:
-          return ProcessIconNameTask();
+          return ResolveIconName();
         case REQUEST_TYPE_GICON_STRING:
-          return ProcessGIconTask();
+          return ResolveGIcon();
         case REQUEST_TYPE_URI:
-          return ProcessURITask();
+          return true;
       }
 
-      LOG_WARNING(logger) << "Request type " << type
-                          << " is not supported (" << data
-                          << " " << max_width << "x" << max_height << ")";
-      result = nullptr;
-      InvokeSlot();
-
-      return true;
+      return false;
     }
 
-    bool ProcessIconNameTask()
+    // This is running in a worker thread, so it must not touch the Impl
+    // nor the icon theme.
+    void Run()
     {
-      int size = max_height < 0 ? max_width : (max_width < 0 ? max_height : MIN(max_height, max_width));
-      GtkIconInfo *info = ::gtk_icon_theme_lookup_icon(impl->theme_, data.c_str(),
-                                                       size, GTK_ICON_LOOKUP_FORCE_SIZE);
-      if (info)
-      {
-        icon_info = info;
-        PushSchedulerJob();
-
-        return false;
-      }
-      else
-      {
-        LOG_WARNING(logger) << "Unable to load icon " << data
-                            << " at size " << size;
-      }
+      if (type == REQUEST_TYPE_URI)
+        RunURITask();
+      else if (icon_info)
+        LoadIconInfo();
+    }
 
-      result = nullptr;
-      InvokeSlot();
+    int Size() const
+    {
+      return max_height < 0 ? max_width : (max_width < 0 ? max_height : MIN(max_height, max_width));
+    }
 
-      return true;
+    bool ResolveIconName()
+    {
+      icon_info = ::gtk_icon_theme_lookup_icon(impl->theme_, data.c_str(), Size(),
+                                               GTK_ICON_LOOKUP_FORCE_SIZE);
+      return icon_info;
     }
 
-    bool ProcessGIconTask()
+    bool ResolveGIcon()
     {
-      glib::Error error;
       glib::Object<GIcon> icon(::g_icon_new_for_string(data.c_str(), &error));
-      int size = max_height < 0 ? max_width : (max_width < 0 ? max_height : MIN(max_height, max_width));
 
       if (icon.IsType(UNITY_PROTOCOL_TYPE_ANNOTATED_ICON))
       {
-        glib::Object<UnityProtocolAnnotatedIcon> anno(glib::object_cast<UnityProtocolAnnotatedIcon>(icon));
-        GIcon* base_icon = unity_protocol_annotated_icon_get_icon(anno);
-        glib::String gicon_string(g_icon_to_string(base_icon));
-
-        // ensure that annotated icons aren't cached by the IconLoader
-        no_cache = true;
-
-        auto helper_slot = sigc::bind(sigc::mem_fun(this, &IconLoaderTask::BaseIconLoaded), anno);
-        int base_icon_width, base_icon_height;
-        if (unity_protocol_annotated_icon_get_use_small_icon(anno))
-        {
-          // FIXME: although this pretends to be generic, we're just making
-          // sure that icons requested to have 96px will be 64
-          base_icon_width = max_width > 0 ? max_width * 2 / 3 : max_width;
-          base_icon_height = max_height > 0 ? max_height * 2 / 3 : max_height;
-        }
-        else
-        {
-          base_icon_width = max_width > 0 ? max_width - RIBBON_PADDING * 2 : -1;
-          base_icon_height = base_icon_width < 0 ? max_height - RIBBON_PADDING *2 : max_height;
-        }
-        helper_handle = impl->LoadFromGIconString(gicon_string.Str(),
-                                                  base_icon_width,
-                                                  base_icon_height,
-                                                  helper_slot);
-
+        // The annotations are drawn in the main thread, see ProcessAnnotatedIcon
+        annotated_icon = glib::object_cast<UnityProtocolAnnotatedIcon>(icon);
         return false;
       }
       else if (icon.IsType(G_TYPE_FILE_ICON))
@@ -231,56 +227,104 @@ private:
         type = REQUEST_TYPE_URI;
         data = uri.Str();
 
-        return ProcessURITask();
+        return true;
       }
       else if (icon.IsType(G_TYPE_ICON))
       {
-        GtkIconInfo *info = ::gtk_icon_theme_lookup_by_gicon(impl->theme_, icon, size,
-                                                             GTK_ICON_LOOKUP_FORCE_SIZE);
-        if (info)
-        {
-          icon_info = info;
-          PushSchedulerJob();
+        icon_info = ::gtk_icon_theme_lookup_by_gicon(impl->theme_, icon, Size(),
+                                                     GTK_ICON_LOOKUP_FORCE_SIZE);
 
-          return false;
-        }
-        else
+        if (icon_info)
+          return true;
+
+        // There is some funkiness in some programs where they install
+        // their icon to /usr/share/icons/hicolor/apps/, but they
+        // name the Icon= key as `foo.$extension` which breaks loading
+        // So we can try and work around that here.
+
+        if (boost::iends_with(data, ".png") ||
+            boost::iends_with(data, ".xpm") ||
+            boost::iends_with(data, ".gif") ||
+            boost::iends_with(data, ".jpg"))
         {
-          // There is some funkiness in some programs where they install
-          // their icon to /usr/share/icons/hicolor/apps/, but they
-          // name the Icon= key as `foo.$extension` which breaks loading
-          // So we can try and work around that here.
-
-          if (boost::iends_with(data, ".png") ||
-              boost::iends_with(data, ".xpm") ||
-              boost::iends_with(data, ".gif") ||
-              boost::iends_with(data, ".jpg"))
-          {
-            data = data.substr(0, data.size() - 4);
-            return ProcessIconNameTask();
-          }
-          else
-          {
-            LOG_WARNING(logger) << "Unable to load icon " << data
-                                << " at size " << size;
-          }
+          data = data.substr(0, data.size() - 4);
+          return ResolveIconName();
         }
       }
-      else
+
+      return false;
+    }
+
+    void RunURITask()
+    {
+      glib::Object<GFile> file(::g_file_new_for_uri(data.c_str()));
+      glib::String contents;
+      gsize length = 0;
+
+      if (g_file_load_contents(file, nullptr, &contents, &length, nullptr, &error))
       {
-        LOG_WARNING(logger) << "Unable to load icon " << data
-                            << " at size " << size << ": " << error;
+        glib::Object<GInputStream> stream(
+            g_memory_input_stream_new_from_data(contents.Value(), length, nullptr));
+
+        result = gdk_pixbuf_new_from_stream_at_scale(stream,
+                                                     max_width,
+                                                     max_height,
+                                                     TRUE,
+                                                     nullptr,
+                                                     &error);
+        g_input_stream_close(stream, nullptr, nullptr);
       }
+    }
 
-      InvokeSlot();
-      return true;
+    void LoadIconInfo()
+    {
+      if (disk_cache)
+        result = disk_cache->Lookup(DiskCacheKey(key));
+
+      if (result)
+      {
+        disk_cache_hit = true;
+        return;
+      }
+
+      result = ::gtk_icon_info_load_icon(icon_info, &error);
+
+      if (result && disk_cache)
+        disk_cache->Store(DiskCacheKey(key), result);
     }
 
-    bool ProcessURITask()
+    void ProcessAnnotatedIcon()
     {
-      PushSchedulerJob();
+      GIcon* base_icon = unity_protocol_annotated_icon_get_icon(annotated_icon);
+      glib::String gicon_string(g_icon_to_string(base_icon));
 
-      return false;
+      // ensure that annotated icons aren't cached by the IconLoader
+      no_cache = true;
+      annotating = true;
+
+      auto helper_slot = sigc::bind(sigc::mem_fun(this, &IconLoaderTask::BaseIconLoaded), annotated_icon);
+      int base_icon_width, base_icon_height;
+      if (unity_protocol_annotated_icon_get_use_small_icon(annotated_icon))
+      {
+        // FIXME: although this pretends to be generic, we're just making
+        // sure that icons requested to have 96px will be 64
+        base_icon_width = max_width > 0 ? max_width * 2 / 3 : max_width;
+        base_icon_height = max_height > 0 ? max_height * 2 / 3 : max_height;
+      }
+      else
+      {
+        base_icon_width = max_width > 0 ? max_width - RIBBON_PADDING * 2 : -1;
+        base_icon_height = base_icon_width < 0 ? max_height - RIBBON_PADDING *2 : max_height;
+      }
+      helper_handle = impl->LoadFromGIconString(gicon_string.Str(),
+                                                base_icon_width,
+                                                base_icon_height,
+                                                helper_slot, priority);
+    }
+
+    void Complete()
+    {
+      impl->FinishTask(shared_from_this());
     }
 
     void CategoryIconLoaded(std::string const& base_icon_string,
@@ -503,7 +547,7 @@ private:
                              255); // src_alpha
       }
 
-      idles.AddIdle([this] { return LoadIconComplete(this) != FALSE; });
+      Complete();
     }
 
     glib::Object<GdkPixbuf> ColorizeIcon(glib::Object<GdkPixbuf> const& pixbuf,
@@ -585,7 +629,7 @@ private:
           // if the icon was requested to be smaller + colorized, we can cache
           no_cache = false;
           result = base_pixbuf;
-          idles.AddIdle([this] { return LoadIconComplete(this) != FALSE; });
+          Complete();
           return;
         }
 
@@ -628,24 +672,24 @@ private:
             break;
           case UNITY_PROTOCOL_CATEGORY_TYPE_APPLICATION:
             helper_handle =
-              impl->LoadFromThemedFilename("emblem_apps", -1, cat_size, helper_slot);
+              impl->LoadFromThemedFilename("emblem_apps", -1, cat_size, helper_slot, priority);
             break;
           case UNITY_PROTOCOL_CATEGORY_TYPE_BOOK:
             helper_handle =
-              impl->LoadFromThemedFilename("emblem_books", -1, cat_size, helper_slot);
+              impl->LoadFromThemedFilename("emblem_books", -1, cat_size, helper_slot, priority);
             break;
           case UNITY_PROTOCOL_CATEGORY_TYPE_MUSIC:
             helper_handle =
-              impl->LoadFromThemedFilename("emblem_music", -1, cat_size, helper_slot);
+              impl->LoadFromThemedFilename("emblem_music", -1, cat_size, helper_slot, priority);
             break;
           case UNITY_PROTOCOL_CATEGORY_TYPE_MOVIE:
             helper_handle =
-              impl->LoadFromThemedFilename("emblem_video", -1, cat_size, helper_slot);
+              impl->LoadFromThemedFilename("emblem_video", -1, cat_size, helper_slot, priority);
             break;
           case UNITY_PROTOCOL_CATEGORY_TYPE_CLOTHES:
           case UNITY_PROTOCOL_CATEGORY_TYPE_SHOES:
             helper_handle =
-              impl->LoadFromThemedFilename("emblem_clothes", -1, cat_size, helper_slot);
+              impl->LoadFromThemedFilename("emblem_clothes", -1, cat_size, helper_slot, priority);
             break;
           case UNITY_PROTOCOL_CATEGORY_TYPE_GAMES:
           case UNITY_PROTOCOL_CATEGORY_TYPE_ELECTRONICS:
@@ -668,174 +712,112 @@ private:
           case UNITY_PROTOCOL_CATEGORY_TYPE_CAR:
           default:
             helper_handle =
-              impl->LoadFromThemedFilename("emblem_others", -1, cat_size, helper_slot);
+              impl->LoadFromThemedFilename("emblem_others", -1, cat_size, helper_slot, priority);
             break;
         }
       }
       else
       {
         result = nullptr;
-        idles.AddIdle([this] { return LoadIconComplete(this) != FALSE; });
+        Complete();
       }
     }
-
-    void PushSchedulerJob()
-    {
-#if G_ENCODE_VERSION (GLIB_MAJOR_VERSION, GLIB_MINOR_VERSION) <= GLIB_VERSION_2_34
-      g_io_scheduler_push_job (LoaderJobFunc, this, nullptr, G_PRIORITY_HIGH_IDLE, nullptr);
-#else
-      glib::Object<GTask> task(g_task_new(nullptr, nullptr, [] (GObject*, GAsyncResult*, gpointer data) {
-        auto self = static_cast<IconLoaderTask*>(data);
-        self->LoadIconComplete(data);
-      }, this));
-
-      g_task_set_priority(task, G_PRIORITY_HIGH_IDLE);
-      g_task_set_task_data(task, this, nullptr);
-
-      g_task_run_in_thread(task, LoaderJobFunc);
-#endif
-    }
-
-    // Loading/rendering of pixbufs is done in a separate thread
-#if G_ENCODE_VERSION (GLIB_MAJOR_VERSION, GLIB_MINOR_VERSION) <= GLIB_VERSION_2_34
-    static gboolean LoaderJobFunc(GIOSchedulerJob* job, GCancellable *canc, gpointer data)
-#else
-    static void LoaderJobFunc(GTask* job, gpointer source_object, gpointer data, GCancellable* canc)
-#endif
-    {
-      auto task = static_cast<IconLoaderTask*>(data);
-
-      // careful here this is running in non-main thread
-      if (task->icon_info)
-      {
-        task->result = ::gtk_icon_info_load_icon(task->icon_info, &task->error);
-      }
-      else if (task->type == REQUEST_TYPE_URI)
-      {
-        glib::Object<GFile> file(::g_file_new_for_uri(task->data.c_str()));
-        glib::String contents;
-        gsize length = 0;
-
-        if (g_file_load_contents(file, canc, &contents, &length,
-                                 nullptr, &task->error))
-        {
-          glib::Object<GInputStream> stream(
-              g_memory_input_stream_new_from_data(contents.Value(), length, nullptr));
-
-          task->result = gdk_pixbuf_new_from_stream_at_scale(stream,
-                                                             task->max_width,
-                                                             task->max_height,
-                                                             TRUE,
-                                                             canc,
-                                                             &task->error);
-          g_input_stream_close(stream, canc, nullptr);
-        }
-      }
-
-#if G_ENCODE_VERSION (GLIB_MAJOR_VERSION, GLIB_MINOR_VERSION) <= GLIB_VERSION_2_34
-      g_io_scheduler_job_send_to_mainloop_async (job, LoadIconComplete, task, nullptr);
-      return FALSE;
-#endif
-    }
-
-    // this will be invoked back in the thread from which push_job was called
-    static gboolean LoadIconComplete(gpointer data)
-    {
-      auto task = static_cast<IconLoaderTask*>(data);
-      auto impl = task->impl;
-
-      if (task->result.IsType(GDK_TYPE_PIXBUF))
-      {
-        if (!task->no_cache) impl->cache_[task->key] = task->result;
-      }
-      else
-      {
-        if (task->result)
-          task->result = nullptr;
-
-        LOG_WARNING(logger) << "Unable to load icon " << task->data
-                            << " at size "
-                            << task->max_width << "x" << task->max_height
-                            << ": " << task->error;
-      }
-
-      impl->finished_tasks_.push_back(task);
-
-      if (!impl->coalesce_timeout_)
-      {
-        // we're using lower priority than the GIOSchedulerJob uses to deliver
-        // results to the mainloop
-        auto prio = static_cast<glib::Source::Priority>(glib::Source::Priority::DEFAULT_IDLE + 40);
-        impl->coalesce_timeout_.reset(new glib::Timeout(40, prio));
-        impl->coalesce_timeout_->Run(sigc::mem_fun(impl, &Impl::CoalesceTasksCb));
-      }
-
-      return FALSE;
-    }
   };
 
   Handle ReturnCachedOrQueue(std::string const& data,
                              int max_width,
                              int max_height,
                              IconLoaderCallback const& slot,
-                             IconLoaderRequestType type);
+                             IconLoaderRequestType type,
+                             Priority priority);
 
-  Handle QueueTask(std::string const& key,
+  Handle QueueTask(IconPixbufCache::Key const& key,
                    std::string const& data,
                    int max_width,
                    int max_height,
                    IconLoaderCallback const& slot,
-                   IconLoaderRequestType type);
+                   IconLoaderRequestType type,
+                   Priority priority);
 
-  std::string Hash(std::string const& data, int max_width, int max_height);
+  static IconPixbufCache::Pool PoolForRequest(std::string const& data, IconLoaderRequestType type);
+  static std::string DiskCacheKey(IconPixbufCache::Key const& key);
 
-  bool CacheLookup(std::string const& key,
+  bool CacheLookup(IconPixbufCache::Key const& key,
                    std::string const& data,
                    int max_width,
                    int max_height,
                    IconLoaderCallback const& slot);
 
-  // Looping idle callback function
-  bool Iteration();
+  void CancelTask(IconLoaderTask::Ptr const& task);
+  void QueueCompletion(IconLoaderTask::Ptr const& task);
+  void FinishTask(IconLoaderTask::Ptr const& task);
+  void RunWorker();
   bool CoalesceTasksCb();
 
 private:
-  std::unordered_map<std::string, glib::Object<GdkPixbuf>> cache_;
-  /* FIXME: the reference counting of IconLoaderTasks with shared pointers
-   * is currently somewhat broken, and the queued_tasks_ member is what keeps
-   * it from crashing randomly.
-   * The IconLoader instance is assuming that it is the only owner of the loader
-   * tasks, but when they are being completed in a worker thread, the thread
-   * should own them as well (yet it doesn't), this could cause trouble
-   * in the future... You've been warned! */
-  std::unordered_map<std::string, IconLoaderTask::Ptr> queued_tasks_;
-  std::queue<IconLoaderTask::Ptr> tasks_;
+  IconPixbufCache cache_;
+  IconDiskCache::Ptr disk_cache_;
+  std::size_t disk_cache_hits_;
+
+  // Main thread only
+  std::unordered_map<IconPixbufCache::Key, IconLoaderTask::Ptr, IconPixbufCache::KeyHash> queued_tasks_;
   std::unordered_map<Handle, IconLoaderTask::Ptr> task_map_;
-  std::vector<IconLoaderTask*> finished_tasks_;
+
+  /* Shared with the worker threads, ordered by priority first and then by
+   * arrival. Workers own the tasks they're running, until they're finished. */
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::map<IconLoaderTask::QueueKey, IconLoaderTask::Ptr> queue_;
+  std::vector<IconLoaderTask::Ptr> finished_tasks_;
+  glib::Source::UniquePtr coalesce_timeout_;
+  std::vector<std::thread> workers_;
+  unsigned max_workers_;
+  unsigned idle_workers_;
+  unsigned running_tasks_;
+  uint64_t sequence_;
+  bool stopping_;
+  bool paused_;
 
   bool no_load_;
   GtkIconTheme* theme_; // Not owned.
   Handle handle_counter_;
-  glib::Source::UniquePtr idle_;
-  glib::Source::UniquePtr coalesce_timeout_;
   connection::Wrapper theme_changed_;
 };
 
 
-IconLoader::Impl::Impl()
-  : // Option to disable loading, if you're testing performance of other things
-    no_load_(::getenv("UNITY_ICON_LOADER_DISABLE"))
+IconLoader::Impl::Impl(unsigned max_workers, bool paused)
+  : disk_cache_hits_(0)
+  , max_workers_(max_workers ? max_workers : std::min(MAX_WORKERS, std::max(1u, g_get_num_processors())))
+  , idle_workers_(0)
+  , running_tasks_(0)
+  , sequence_(0)
+  , stopping_(false)
+  , paused_(paused)
+    // Option to disable loading, if you're testing performance of other things
+  , no_load_(::getenv("UNITY_ICON_LOADER_DISABLE"))
   , theme_(::gtk_icon_theme_get_default())
   , handle_counter_(0)
 {
-  theme_changed_ = theme::Settings::Get()->icons_changed.connect([this] {
-    /* Since the theme has been changed we can clear the cache, however we
-     * could include two improvements here:
-     *  1) clear only the themed icons in cache
-     *  2) make the clients of this class to update their icons forcing them
-     *     to reload the pixbufs and erase the cached textures, to make this
-     *     apply immediately. */
-    cache_.clear();
+  auto setup_disk_cache = [this] {
+    if (no_load_ || ::getenv("UNITY_ICON_LOADER_NO_DISK_CACHE"))
+      return;
+
+    auto const& cache_dir = DesktopUtilities::GetUserCacheDirectory();
+
+    if (!cache_dir.empty())
+      disk_cache_ = std::make_shared<IconDiskCache>(cache_dir + "icons", IconDiskCache::ThemeStamp(theme_));
+  };
+
+  setup_disk_cache();
+
+  theme_changed_ = theme::Settings::Get()->icons_changed.connect([this, setup_disk_cache] {
+    /* Since the theme has been changed we can clear the themed icons from
+     * the cache, however we could also make the clients of this class to
+     * update their icons forcing them to reload the pixbufs and erase the
+     * cached textures, to make this apply immediately. */
+    cache_.Clear(IconPixbufCache::Pool::ICON_NAME);
+    cache_.Clear(IconPixbufCache::Pool::GICON_STRING);
+    setup_disk_cache();
   });
 
   // make sure the AnnotatedIcon type is registered, so we can deserialize it
@@ -849,7 +831,21 @@ IconLoader::Impl::Impl()
 #endif
 }
 
-IconLoader::Handle IconLoader::Impl::LoadFromIconName(std::string const& icon_name, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Impl::~Impl()
+{
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stopping_ = true;
+    queue_.clear();
+  }
+
+  queue_cond_.notify_all();
+
+  for (auto& worker : workers_)
+    worker.join();
+}
+
+IconLoader::Handle IconLoader::Impl::LoadFromIconName(std::string const& icon_name, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
   if (no_load_ || icon_name.empty() || !slot ||
       ((max_width >= 0 && max_width < MIN_ICON_SIZE) ||
@@ -859,14 +855,14 @@ IconLoader::Handle IconLoader::Impl::LoadFromIconName(std::string const& icon_na
   // We need to check this because of legacy desktop files
   if (icon_name[0] == '/')
   {
-    return LoadFromFilename(icon_name, max_width, max_height, slot);
+    return LoadFromFilename(icon_name, max_width, max_height, slot, priority);
   }
 
   return ReturnCachedOrQueue(icon_name, max_width, max_height, slot,
-                             REQUEST_TYPE_ICON_NAME);
+                             REQUEST_TYPE_ICON_NAME, priority);
 }
 
-IconLoader::Handle IconLoader::Impl::LoadFromGIconString(std::string const& gicon_string, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::Impl::LoadFromGIconString(std::string const& gicon_string, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
   if (no_load_ || gicon_string.empty() || !slot ||
       ((max_width >= 0 && max_width < MIN_ICON_SIZE) ||
@@ -874,10 +870,10 @@ IconLoader::Handle IconLoader::Impl::LoadFromGIconString(std::string const& gico
     return Handle();
 
   return ReturnCachedOrQueue(gicon_string, max_width, max_height, slot,
-                             REQUEST_TYPE_GICON_STRING);
+                             REQUEST_TYPE_GICON_STRING, priority);
 }
 
-IconLoader::Handle IconLoader::Impl::LoadFromFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::Impl::LoadFromFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
   if (no_load_ || filename.empty() || !slot ||
       ((max_width >= 0 && max_width < MIN_ICON_SIZE) ||
@@ -887,15 +883,15 @@ IconLoader::Handle IconLoader::Impl::LoadFromFilename(std::string const& filenam
   glib::Object<GFile> file(::g_file_new_for_path(filename.c_str()));
   glib::String uri(::g_file_get_uri(file));
 
-  return LoadFromURI(uri.Str(), max_width, max_height, slot);
+  return LoadFromURI(uri.Str(), max_width, max_height, slot, priority);
 }
 
-IconLoader::Handle IconLoader::Impl::LoadFromThemedFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::Impl::LoadFromThemedFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
-  return LoadFromFilename(theme::Settings::Get()->ThemedFilePath(filename, {PKGDATADIR}), max_width, max_height, slot);
+  return LoadFromFilename(theme::Settings::Get()->ThemedFilePath(filename, {PKGDATADIR}), max_width, max_height, slot, priority);
 }
 
-IconLoader::Handle IconLoader::Impl::LoadFromURI(std::string const& uri, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::Impl::LoadFromURI(std::string const& uri, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
   if (no_load_ || uri.empty() || !slot ||
       ((max_width >= 0 && max_width < MIN_ICON_SIZE) ||
@@ -903,17 +899,61 @@ IconLoader::Handle IconLoader::Impl::LoadFromURI(std::string const& uri, int max
     return Handle();
 
   return ReturnCachedOrQueue(uri, max_width, max_height, slot,
-                             REQUEST_TYPE_URI);
+                             REQUEST_TYPE_URI, priority);
 }
 
 void IconLoader::Impl::DisconnectHandle(Handle handle)
 {
   auto iter = task_map_.find(handle);
 
-  if (iter != task_map_.end())
+  if (iter == task_map_.end())
+    return;
+
+  auto task = iter->second;
+  task->slot = nullptr;
+
+  // Nobody is waiting for the icon anymore, so it can be dropped from the queue
+  auto queued = queued_tasks_.find(task->key);
+
+  if (queued != queued_tasks_.end() && !queued->second->HasSlots())
+    CancelTask(queued->second);
+}
+
+void IconLoader::Impl::SetWorkersPaused(bool paused)
+{
   {
-    iter->second->slot = nullptr;
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    paused_ = paused;
   }
+
+  queue_cond_.notify_all();
+}
+
+void IconLoader::Impl::AddProperties(debug::IntrospectionData& introspection)
+{
+  for (unsigned i = 0; i < unsigned(IconPixbufCache::Pool::Size); ++i)
+  {
+    auto pool = IconPixbufCache::Pool(i);
+    auto const& stats = cache_.GetStats(pool);
+    auto const& prefix = IconPixbufCache::PoolName(pool) + "_cache_";
+
+    introspection
+    .add(prefix + "hits", stats.hits)
+    .add(prefix + "misses", stats.misses)
+    .add(prefix + "evictions", stats.evictions)
+    .add(prefix + "entries", stats.entries)
+    .add(prefix + "bytes", stats.bytes)
+    .add(prefix + "budget", stats.budget);
+  }
+
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+
+  introspection
+  .add("disk_cache_enabled", bool(disk_cache_))
+  .add("disk_cache_hits", disk_cache_hits_)
+  .add("queued_tasks", queue_.size())
+  .add("running_tasks", running_tasks_)
+  .add("worker_threads", workers_.size());
 }
 
 void IconLoader::Impl::CalculateTextHeight(int* width, int* height)
@@ -950,24 +990,23 @@ void IconLoader::Impl::CalculateTextHeight(int* width, int* height)
 // Private Methods
 //
 
-IconLoader::Handle IconLoader::Impl::ReturnCachedOrQueue(std::string const& data, int max_width, int max_height, IconLoaderCallback const& slot, IconLoaderRequestType type)
+IconLoader::Handle IconLoader::Impl::ReturnCachedOrQueue(std::string const& data, int max_width, int max_height, IconLoaderCallback const& slot, IconLoaderRequestType type, Priority priority)
 {
-  std::string key(Hash(data, max_width, max_height));
+  IconPixbufCache::Key key(PoolForRequest(data, type), data, max_width, max_height);
 
-  if (!CacheLookup(key, data, max_width, max_height, slot))
-  {
-    return QueueTask(key, data, max_width, max_height, slot, type);
-  }
-  return Handle();
+  if (CacheLookup(key, data, max_width, max_height, slot))
+    return Handle();
+
+  return QueueTask(key, data, max_width, max_height, slot, type, priority);
 }
 
 
-IconLoader::Handle IconLoader::Impl::QueueTask(std::string const& key, std::string const& data, int max_width, int max_height, IconLoaderCallback const& slot, IconLoaderRequestType type)
+IconLoader::Handle IconLoader::Impl::QueueTask(IconPixbufCache::Key const& key, std::string const& data, int max_width, int max_height, IconLoaderCallback const& slot, IconLoaderRequestType type, Priority priority)
 {
   auto task = std::make_shared<IconLoaderTask>(type, data,
                                                max_width, max_height,
                                                key, slot,
-                                               ++handle_counter_, this);
+                                               ++handle_counter_, priority, this);
   auto iter = queued_tasks_.find(key);
 
   if (iter != queued_tasks_.end())
@@ -978,107 +1017,220 @@ IconLoader::Handle IconLoader::Impl::QueueTask(std::string const& key, std::stri
     // the parent task (which is in the queue) will handle it
     task_map_[task->handle] = task;
 
-    LOG_DEBUG(logger) << "Appending shadow task  " << data
-                      << ", queue size now at " << tasks_.size();
+    LOG_DEBUG(logger) << "Appending shadow task  " << data;
+
+    // A more important request for a queued icon makes it jump ahead
+    if (priority > running_task->priority)
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      auto queued = queue_.find(running_task->queue_key);
+
+      if (queued != queue_.end() && queued->second == running_task)
+      {
+        running_task->priority = priority;
+        running_task->queue_key.first = -static_cast<int>(priority);
+        queue_.erase(queued);
+        queue_.insert({running_task->queue_key, running_task});
+      }
+    }
 
     return task->handle;
   }
-  else
+
+  // Only themed icons are stored on disk, as they're invalidated with the theme
+  if (key.pool == IconPixbufCache::Pool::ICON_NAME || key.pool == IconPixbufCache::Pool::GICON_STRING)
+    task->disk_cache = disk_cache_;
+
+  queued_tasks_[key] = task;
+  task_map_[task->handle] = task;
+
+  bool needs_worker = task->Resolve();
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+
+  if (!needs_worker)
   {
-    queued_tasks_[key] = task;
+    // Not found in the theme, or an annotated icon: completed in the main loop
+    QueueCompletion(task);
+    return task->handle;
   }
 
-  tasks_.push(task);
-  task_map_[task->handle] = task;
+  task->queue_key = IconLoaderTask::QueueKey(-static_cast<int>(priority), ++sequence_);
+  queue_.insert({task->queue_key, task});
 
-  LOG_DEBUG(logger) << "Pushing task  " << data << " at size " 
+  LOG_DEBUG(logger) << "Pushing task  " << data << " at size "
                     << max_width << "x" << max_height
-                    << ", queue size now at " << tasks_.size();
+                    << ", queue size now at " << queue_.size();
 
-  if (!idle_)
+  if (idle_workers_ == 0 && workers_.size() < max_workers_)
+    workers_.push_back(std::thread(&Impl::RunWorker, this));
+  else
+    queue_cond_.notify_one();
+
+  return task->handle;
+}
+
+IconPixbufCache::Pool IconLoader::Impl::PoolForRequest(std::string const& data, IconLoaderRequestType type)
+{
+  switch (type)
   {
-    idle_.reset(new glib::Idle(sigc::mem_fun(this, &Impl::Iteration), glib::Source::Priority::LOW));
+    case REQUEST_TYPE_ICON_NAME:
+      return IconPixbufCache::Pool::ICON_NAME;
+    case REQUEST_TYPE_GICON_STRING:
+      return IconPixbufCache::Pool::GICON_STRING;
+    case REQUEST_TYPE_URI:
+      break;
   }
-  return task->handle;
+
+  return g_str_has_prefix(data.c_str(), "file://") ? IconPixbufCache::Pool::FILE : IconPixbufCache::Pool::URI;
 }
 
-std::string IconLoader::Impl::Hash(std::string const& data, int max_width, int max_height)
+std::string IconLoader::Impl::DiskCacheKey(IconPixbufCache::Key const& key)
 {
-  std::ostringstream sout;
-  sout << data << ":" << max_width << "x" << max_height;
-  return sout.str();
+  return std::to_string(unsigned(key.pool)) + ":" + key.data + ":" +
+         std::to_string(key.width) + "x" + std::to_string(key.height);
 }
 
-bool IconLoader::Impl::CacheLookup(std::string const& key,
+bool IconLoader::Impl::CacheLookup(IconPixbufCache::Key const& key,
                                    std::string const& data,
                                    int max_width,
                                    int max_height,
                                    IconLoaderCallback const& slot)
 {
-  auto iter = cache_.find(key);
-  bool found = iter != cache_.end();
+  glib::Object<GdkPixbuf> pixbuf(cache_.Lookup(key));
 
-  if (found && slot)
-  {
-    glib::Object<GdkPixbuf> const& pixbuf = iter->second;
+  if (!pixbuf)
+    return false;
+
+  if (slot)
     slot(data, max_width, max_height, pixbuf);
-  }
 
-  return found;
+  return true;
 }
 
-bool IconLoader::Impl::CoalesceTasksCb()
+void IconLoader::Impl::CancelTask(IconLoaderTask::Ptr const& task)
 {
-  for (auto task : finished_tasks_)
   {
-    task->InvokeSlot();
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    auto queued = queue_.find(task->queue_key);
 
-    // this was all async, we need to erase the task from the task_map
-    task_map_.erase(task->handle);
-    queued_tasks_.erase(task->key);
+    // Tasks that are already running will be completed anyway
+    if (queued == queue_.end() || queued->second != task)
+      return;
+
+    queue_.erase(queued);
   }
 
-  finished_tasks_.clear();
-  coalesce_timeout_.reset();
+  LOG_DEBUG(logger) << "Cancelled task  " << task->data;
 
-  return false;
+  for (auto const& shadow_task : task->shadow_tasks)
+    task_map_.erase(shadow_task->handle);
+
+  task_map_.erase(task->handle);
+  queued_tasks_.erase(task->key);
+}
+
+// Must be called with queue_mutex_ locked.
+void IconLoader::Impl::QueueCompletion(IconLoaderTask::Ptr const& task)
+{
+  finished_tasks_.push_back(task);
+
+  if (!coalesce_timeout_)
+    coalesce_timeout_.reset(new glib::Timeout(COALESCE_INTERVAL, sigc::mem_fun(this, &Impl::CoalesceTasksCb), glib::Source::Priority::LOW));
 }
 
-bool IconLoader::Impl::Iteration()
+void IconLoader::Impl::FinishTask(IconLoaderTask::Ptr const& task)
 {
-  static const int MAX_MICRO_SECS = 1000;
-  util::Timer timer;
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  QueueCompletion(task);
+}
 
-  bool queue_empty = tasks_.empty();
+void IconLoader::Impl::RunWorker()
+{
+  std::unique_lock<std::mutex> lock(queue_mutex_);
 
-  // always do at least one iteration if the queue isn't empty
-  while (!queue_empty)
+  while (true)
   {
-    IconLoaderTask::Ptr const& task = tasks_.front();
+    ++idle_workers_;
+    queue_cond_.wait(lock, [this] { return stopping_ || (!paused_ && !queue_.empty()); });
+    --idle_workers_;
 
-    if (task->Process())
-    {
-      task_map_.erase(task->handle);
-      queued_tasks_.erase(task->key);
-    }
+    if (stopping_)
+      return;
+
+    IconLoaderTask::Ptr task = queue_.begin()->second;
+    queue_.erase(queue_.begin());
+    ++running_tasks_;
+
+    lock.unlock();
+    /*********************************
+     * MUTEX UNLOCKED
+     *********************************/
 
-    tasks_.pop();
-    queue_empty = tasks_.empty();
+    task->Run();
 
-    if (timer.ElapsedMicroSeconds() >= MAX_MICRO_SECS) break;
+    lock.lock();
+    /*********************************
+     * MUTEX LOCKED
+     *********************************/
+
+    --running_tasks_;
+    QueueCompletion(task);
   }
+}
 
-  LOG_DEBUG(logger) << "Iteration done, queue size now at " << tasks_.size();
+bool IconLoader::Impl::CoalesceTasksCb()
+{
+  std::vector<IconLoaderTask::Ptr> finished_tasks;
 
-  if (queue_empty)
   {
-    if (task_map_.empty())
-      handle_counter_ = 0;
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    finished_tasks.swap(finished_tasks_);
+    coalesce_timeout_.reset();
+  }
 
-    idle_.reset();
+  for (auto const& task : finished_tasks)
+  {
+    if (task->annotated_icon && !task->annotating)
+    {
+      // The base icon is loaded as a new task, this one completes later
+      task->ProcessAnnotatedIcon();
+      continue;
+    }
+
+    if (GDK_IS_PIXBUF(task->result.RawPtr()))
+    {
+      if (!task->no_cache)
+        cache_.Insert(task->key, task->result);
+
+      if (task->disk_cache_hit)
+        ++disk_cache_hits_;
+    }
+    else
+    {
+      task->result = nullptr;
+
+      if (!task->annotated_icon)
+      {
+        LOG_WARNING(logger) << "Unable to load icon " << task->data
+                            << " at size " << task->max_width << "x" << task->max_height
+                            << ": " << task->error;
+      }
+    }
+
+    task->InvokeSlot();
+
+    // this was all async, we need to erase the task from the task_map
+    task_map_.erase(task->handle);
+
+    auto queued = queued_tasks_.find(task->key);
+    if (queued != queued_tasks_.end() && queued->second == task)
+      queued_tasks_.erase(queued);
   }
 
-  return !queue_empty;
+  if (task_map_.empty())
+    handle_counter_ = 0;
+
+  return false;
 }
 
 IconLoader::IconLoader()
@@ -1086,6 +1238,11 @@ IconLoader::IconLoader()
 {
 }
 
+IconLoader::IconLoader(unsigned max_workers, bool paused)
+  : pimpl(new Impl(max_workers, paused))
+{
+}
+
 IconLoader::~IconLoader()
 {
 }
@@ -1096,29 +1253,29 @@ IconLoader& IconLoader::GetDefault()
   return default_loader;
 }
 
-IconLoader::Handle IconLoader::LoadFromIconName(std::string const& icon_name, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::LoadFromIconName(std::string const& icon_name, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
-  return pimpl->LoadFromIconName(icon_name, max_width, max_height, slot);
+  return pimpl->LoadFromIconName(icon_name, max_width, max_height, slot, priority);
 }
 
-IconLoader::Handle IconLoader::LoadFromGIconString(std::string const& gicon_string, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::LoadFromGIconString(std::string const& gicon_string, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
-  return pimpl->LoadFromGIconString(gicon_string, max_width, max_height, slot);
+  return pimpl->LoadFromGIconString(gicon_string, max_width, max_height, slot, priority);
 }
 
-IconLoader::Handle IconLoader::LoadFromFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::LoadFromFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
-  return pimpl->LoadFromFilename(filename, max_width, max_height, slot);
+  return pimpl->LoadFromFilename(filename, max_width, max_height, slot, priority);
 }
 
-IconLoader::Handle IconLoader::LoadFromThemedFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::LoadFromThemedFilename(std::string const& filename, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
-  return pimpl->LoadFromThemedFilename(filename, max_width, max_height, slot);
+  return pimpl->LoadFromThemedFilename(filename, max_width, max_height, slot, priority);
 }
 
-IconLoader::Handle IconLoader::LoadFromURI(std::string const& uri, int max_width, int max_height, IconLoaderCallback const& slot)
+IconLoader::Handle IconLoader::LoadFromURI(std::string const& uri, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority)
 {
-  return pimpl->LoadFromURI(uri, max_width, max_height, slot);
+  return pimpl->LoadFromURI(uri, max_width, max_height, slot, priority);
 }
 
 void IconLoader::DisconnectHandle(Handle handle)
@@ -1126,5 +1283,20 @@ void IconLoader::DisconnectHandle(Handle handle)
   pimpl->DisconnectHandle(handle);
 }
 
+void IconLoader::SetWorkersPaused(bool paused)
+{
+  pimpl->SetWorkersPaused(paused);
+}
+
+std::string IconLoader::GetName() const
+{
+  return "IconLoader";
+}
+
+void IconLoader::AddProperties(debug::IntrospectionData& introspection)
+{
+  pimpl->AddProperties(introspection);
+}
+
 
 }
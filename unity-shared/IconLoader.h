@@ -26,16 +26,25 @@
 #include <gtk/gtk.h>
 #include <UnityCore/ActionHandle.h>
 #include <UnityCore/GLibWrapper.h>
+#include "Introspectable.h"
 
 namespace unity
 {
 
-class IconLoader : public boost::noncopyable
+class IconLoader : public boost::noncopyable, public debug::Introspectable
 {
 public:
   typedef action::handle Handle;
   typedef std::function<void(std::string const&, int, int, glib::Object<GdkPixbuf> const&)> IconLoaderCallback;
 
+  // Icons are decoded in worker threads, the most important requests first
+  enum class Priority
+  {
+    BACKGROUND = 0,
+    PRELOAD,
+    VISIBLE
+  };
+
   IconLoader();
   ~IconLoader();
 
@@ -43,17 +52,27 @@ public:
 
   /**
    * Each of the Load functions return an opaque handle.  The sole use for
-   * this is to disconnect the callback slot.
+   * this is to disconnect the callback slot; disconnecting an icon that is
+   * still queued cancels its loading.
    */
 
-  Handle LoadFromIconName(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromGIconString(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromThemedFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
-  Handle LoadFromURI(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot);
+  Handle LoadFromIconName(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority = Priority::VISIBLE);
+  Handle LoadFromGIconString(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority = Priority::VISIBLE);
+  Handle LoadFromFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority = Priority::VISIBLE);
+  Handle LoadFromThemedFilename(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority = Priority::VISIBLE);
+  Handle LoadFromURI(std::string const&, int max_width, int max_height, IconLoaderCallback const& slot, Priority priority = Priority::VISIBLE);
 
   void DisconnectHandle(Handle handle);
 
+protected:
+  // For testing purposes: workers don't run any queued task while paused
+  IconLoader(unsigned max_workers, bool paused);
+  void SetWorkersPaused(bool);
+
+  // Introspectable methods
+  std::string GetName() const;
+  void AddProperties(debug::IntrospectionData&);
+
 private:
   class Impl;
   std::unique_ptr<Impl> pimpl;
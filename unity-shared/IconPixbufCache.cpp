@@ -0,0 +1,194 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include "IconPixbufCache.h"
+
+namespace unity
+{
+namespace
+{
+// Stolen from boost
+template <class T>
+inline std::size_t hash_combine(std::size_t seed, T const& v)
+{
+  return seed ^ (std::hash<T>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+}
+
+//
+// Key
+//
+
+IconPixbufCache::Key::Key(Pool pool_, std::string const& data_, int width_, int height_)
+  : pool(pool_)
+  , data(data_)
+  , width(width_)
+  , height(height_)
+{}
+
+bool IconPixbufCache::Key::operator==(Key const& other) const
+{
+  return pool == other.pool && width == other.width && height == other.height && data == other.data;
+}
+
+bool IconPixbufCache::Key::operator!=(Key const& other) const
+{
+  return !(*this == other);
+}
+
+std::size_t IconPixbufCache::KeyHash::operator()(Key const& key) const
+{
+  std::size_t seed = std::hash<std::string>()(key.data);
+  seed = hash_combine(seed, unsigned(key.pool));
+  seed = hash_combine(seed, key.width);
+  return hash_combine(seed, key.height);
+}
+
+//
+// IconPixbufCache
+//
+
+const std::size_t IconPixbufCache::DEFAULT_POOL_BUDGET;
+
+IconPixbufCache::IconPixbufCache()
+{
+  for (auto& pool : pools_)
+    pool.stats.budget = DEFAULT_POOL_BUDGET;
+}
+
+IconPixbufCache::PoolData& IconPixbufCache::GetPool(Pool pool)
+{
+  return pools_[unsigned(pool) % unsigned(Pool::Size)];
+}
+
+glib::Object<GdkPixbuf> IconPixbufCache::Lookup(Key const& key)
+{
+  auto& pool = GetPool(key.pool);
+  auto it = pool.entries.find(key);
+
+  if (it == pool.entries.end())
+  {
+    ++pool.stats.misses;
+    return glib::Object<GdkPixbuf>();
+  }
+
+  ++pool.stats.hits;
+  pool.lru.splice(pool.lru.begin(), pool.lru, it->second.lru_it);
+
+  return it->second.pixbuf;
+}
+
+void IconPixbufCache::Insert(Key const& key, glib::Object<GdkPixbuf> const& pixbuf)
+{
+  if (!pixbuf)
+    return;
+
+  auto& pool = GetPool(key.pool);
+  std::size_t bytes = PixbufBytes(pixbuf);
+  auto it = pool.entries.find(key);
+
+  if (it != pool.entries.end())
+  {
+    pool.stats.bytes -= it->second.bytes;
+    pool.stats.bytes += bytes;
+    it->second.pixbuf = pixbuf;
+    it->second.bytes = bytes;
+    pool.lru.splice(pool.lru.begin(), pool.lru, it->second.lru_it);
+  }
+  else
+  {
+    pool.lru.push_front(key);
+    pool.entries.insert({key, {pixbuf, bytes, pool.lru.begin()}});
+    pool.stats.bytes += bytes;
+  }
+
+  pool.stats.entries = pool.entries.size();
+  Evict(pool);
+}
+
+void IconPixbufCache::Evict(PoolData& pool)
+{
+  // The most recent entry is always kept, even if it's bigger than the budget
+  while (pool.stats.bytes > pool.stats.budget && pool.lru.size() > 1)
+  {
+    auto it = pool.entries.find(pool.lru.back());
+    pool.stats.bytes -= it->second.bytes;
+    pool.entries.erase(it);
+    pool.lru.pop_back();
+    ++pool.stats.evictions;
+  }
+
+  pool.stats.entries = pool.entries.size();
+}
+
+void IconPixbufCache::Clear(Pool pool_id)
+{
+  auto& pool = GetPool(pool_id);
+  pool.entries.clear();
+  pool.lru.clear();
+  pool.stats.entries = 0;
+  pool.stats.bytes = 0;
+}
+
+void IconPixbufCache::Clear()
+{
+  for (unsigned i = 0; i < unsigned(Pool::Size); ++i)
+    Clear(Pool(i));
+}
+
+void IconPixbufCache::SetBudget(Pool pool_id, std::size_t bytes)
+{
+  auto& pool = GetPool(pool_id);
+  pool.stats.budget = bytes;
+  Evict(pool);
+}
+
+IconPixbufCache::Stats const& IconPixbufCache::GetStats(Pool pool) const
+{
+  return pools_[unsigned(pool) % unsigned(Pool::Size)].stats;
+}
+
+std::string IconPixbufCache::PoolName(Pool pool)
+{
+  switch (pool)
+  {
+    case Pool::ICON_NAME:
+      return "icon_name";
+    case Pool::GICON_STRING:
+      return "gicon_string";
+    case Pool::FILE:
+      return "file";
+    case Pool::URI:
+      return "uri";
+    case Pool::Size:
+      break;
+  }
+
+  return "";
+}
+
+std::size_t IconPixbufCache::PixbufBytes(GdkPixbuf* pixbuf)
+{
+  if (!pixbuf)
+    return 0;
+
+  return std::size_t(gdk_pixbuf_get_rowstride(pixbuf)) * gdk_pixbuf_get_height(pixbuf);
+}
+
+} // unity namespace
@@ -0,0 +1,122 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITY_ICON_PIXBUF_CACHE_H
+#define UNITY_ICON_PIXBUF_CACHE_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <UnityCore/GLibWrapper.h>
+
+namespace unity
+{
+
+//
+// In-memory cache of the pixbufs loaded by the IconLoader.
+//
+// Entries are split in pools depending on where the icon comes from, each one
+// with its own LRU list and bytes budget, so that loading many thumbnails
+// can't evict the themed icons, and so that a theme change only needs to drop
+// the pools depending on the theme.
+//
+class IconPixbufCache
+{
+public:
+  enum class Pool : unsigned
+  {
+    ICON_NAME = 0,
+    GICON_STRING,
+    FILE,
+    URI,
+    Size
+  };
+
+  struct Key
+  {
+    Key(Pool pool_, std::string const& data_, int width_, int height_);
+
+    bool operator==(Key const&) const;
+    bool operator!=(Key const&) const;
+
+    Pool pool;
+    std::string data;
+    int width;
+    int height;
+  };
+
+  struct KeyHash
+  {
+    std::size_t operator()(Key const&) const;
+  };
+
+  struct Stats
+  {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t budget = 0;
+  };
+
+  static const std::size_t DEFAULT_POOL_BUDGET = 16 * 1024 * 1024;
+
+  IconPixbufCache();
+
+  // Returns an empty object on miss
+  glib::Object<GdkPixbuf> Lookup(Key const&);
+  void Insert(Key const&, glib::Object<GdkPixbuf> const&);
+
+  void Clear(Pool);
+  void Clear();
+
+  void SetBudget(Pool, std::size_t bytes);
+  Stats const& GetStats(Pool) const;
+
+  static std::string PoolName(Pool);
+  static std::size_t PixbufBytes(GdkPixbuf*);
+
+private:
+  typedef std::list<Key> LRU;
+
+  struct Entry
+  {
+    glib::Object<GdkPixbuf> pixbuf;
+    std::size_t bytes;
+    LRU::iterator lru_it;
+  };
+
+  struct PoolData
+  {
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    LRU lru;
+    Stats stats;
+  };
+
+  PoolData& GetPool(Pool);
+  void Evict(PoolData&);
+
+  PoolData pools_[unsigned(Pool::Size)];
+};
+
+} // unity namespace
+
+#endif // UNITY_ICON_PIXBUF_CACHE_H
@@ -25,6 +25,7 @@
 #include <X11/extensions/XInput2.h>
 #include <UnityCore/GLibSource.h>
 #include <unordered_set>
+#include <vector>
 #include <gdk/gdkx.h>
 #include <glib.h>
 
@@ -40,6 +41,7 @@ Monitor* instance_ = nullptr;
 
 const unsigned XINPUT_MAJOR_VERSION = 2;
 const unsigned XINPUT_MINOR_VERSION = 3;
+const gint64 EVENT_RATE_INTERVAL = G_USEC_PER_SEC;
 
 bool operator&(Events l, Events r)
 {
@@ -100,9 +102,9 @@ void initialize_event<XMotionEvent>(XEvent* ev, XIDeviceEvent* xiev)
   initialize_event_common(mev, xiev);
   mev->is_hint = NotifyNormal;
 
-  for (int i = 0; i < xiev->buttons.mask_len * 8; ++i)
+  for (int i = 0; i < xiev->buttons.mask_len; ++i)
   {
-    if (XIMaskIsSet(xiev->buttons.mask, i))
+    if (xiev->buttons.mask[i])
     {
       mev->is_hint = NotifyHint;
       break;
@@ -131,10 +133,93 @@ struct Monitor::Impl
   using EventCallbackSet = std::unordered_set<EventCallback, std::hash<sigc::slot_base>>;
 #endif
 
+  // The registered callbacks of an event type. The set is used to lookup the
+  // clients, while events are dispatched walking a flat copy of it, that is
+  // only rebuilt when the set has changed. Each dispatch holds a reference to
+  // the list it walks, so a nested dispatch can safely replace it.
+  struct Clients
+  {
+    typedef std::shared_ptr<std::vector<EventCallback>> List;
+
+    Clients() : dirty(false) {}
+
+    bool Add(EventCallback const& cb)
+    {
+      if (!set.insert(cb).second)
+        return false;
+
+      dirty = true;
+      return true;
+    }
+
+    bool Remove(EventCallback const& cb)
+    {
+      if (!set.erase(cb))
+        return false;
+
+      dirty = true;
+      return true;
+    }
+
+    bool Contains(EventCallback const& cb) const
+    {
+      return set.find(cb) != set.end();
+    }
+
+    bool RemoveEmpty()
+    {
+      bool removed = false;
+
+      for (auto it = set.begin(); it != set.end();)
+      {
+        if (it->empty())
+        {
+          it = set.erase(it);
+          removed = true;
+          continue;
+        }
+
+        ++it;
+      }
+
+      dirty = dirty || removed;
+      return removed;
+    }
+
+    void Clear()
+    {
+      dirty = dirty || !set.empty();
+      set.clear();
+    }
+
+    bool empty() const { return set.empty(); }
+    std::size_t size() const { return set.size(); }
+
+    List const& GetList()
+    {
+      if (dirty || !list)
+      {
+        list = std::make_shared<List::element_type>(set.begin(), set.end());
+        dirty = false;
+      }
+
+      return list;
+    }
+
+    EventCallbackSet set;
+    List list;
+    bool dirty;
+  };
+
   Impl()
     : xi_opcode_(0)
     , event_filter_set_(false)
-    , invoking_callbacks_(false)
+    , selected_events_(Events::NONE)
+    , event_monitor_updates_(0)
+    , events_(0)
+    , rate_start_time_(0)
+    , rate_events_(0)
+    , event_rate_(0)
   {
     Display *dpy = gdk_x11_get_default_xdisplay();
     int event_base, error_base;
@@ -158,11 +243,13 @@ struct Monitor::Impl
 
   ~Impl()
   {
-    if (event_filter_set_)
+    update_idle_.reset();
+
+    if (event_filter_set_ || selected_events_ != Events::NONE)
     {
-      pointer_callbacks_.clear();
-      key_callbacks_.clear();
-      barrier_callbacks_.clear();
+      pointer_callbacks_.Clear();
+      key_callbacks_.Clear();
+      barrier_callbacks_.Clear();
       UpdateEventMonitor();
     }
   }
@@ -172,37 +259,31 @@ struct Monitor::Impl
     bool added = false;
 
     if (type & Events::POINTER)
-      added = pointer_callbacks_.insert(cb).second || added;
+      added = pointer_callbacks_.Add(cb) || added;
 
     if (type & Events::KEYS)
-      added = key_callbacks_.insert(cb).second || added;
+      added = key_callbacks_.Add(cb) || added;
 
     if (type & Events::BARRIER)
-      added = barrier_callbacks_.insert(cb).second || added;
+      added = barrier_callbacks_.Add(cb) || added;
 
     if (added)
-      UpdateEventMonitor();
+      QueueEventMonitorUpdate();
 
     return added;
   }
 
   bool UnregisterClient(EventCallback const& cb)
   {
-    if (invoking_callbacks_)
-    {
-      // Delay the event removal if we're currently invoking a callback
-      // not to break the callbacks loop
-      removal_queue_.insert(cb);
-      return false;
-    }
-
+    // Callbacks are invoked from a copy of the clients, so they can be
+    // safely removed even while we're dispatching an event
     bool removed = false;
-    removed = pointer_callbacks_.erase(cb) > 0 || removed;
-    removed = key_callbacks_.erase(cb) > 0 || removed;
-    removed = barrier_callbacks_.erase(cb) > 0 || removed;
+    removed = pointer_callbacks_.Remove(cb) || removed;
+    removed = key_callbacks_.Remove(cb) || removed;
+    removed = barrier_callbacks_.Remove(cb) || removed;
 
     if (removed)
-      UpdateEventMonitor();
+      QueueEventMonitorUpdate();
 
     return removed;
   }
@@ -211,58 +292,96 @@ struct Monitor::Impl
   {
     Events events = Events::NONE;
 
-    if (pointer_callbacks_.find(cb) != end(pointer_callbacks_))
+    if (pointer_callbacks_.Contains(cb))
       events |= Events::POINTER;
 
-    if (key_callbacks_.find(cb) != end(key_callbacks_))
+    if (key_callbacks_.Contains(cb))
       events |= Events::KEYS;
 
-    if (barrier_callbacks_.find(cb) != end(barrier_callbacks_))
+    if (barrier_callbacks_.Contains(cb))
       events |= Events::BARRIER;
 
     return events;
   }
 
+  Events WantedEvents() const
+  {
+    Events events = Events::NONE;
+
+    if (!pointer_callbacks_.empty())
+      events |= Events::POINTER;
+
+    if (!key_callbacks_.empty())
+      events |= Events::KEYS;
+
+    if (!barrier_callbacks_.empty())
+      events |= Events::BARRIER;
+
+    return events;
+  }
+
+  void QueueEventMonitorUpdate()
+  {
+    // Clients are often registered and unregistered in a row (i.e. when
+    // switching menus), so we only update the X selection once per iteration.
+    if (update_idle_ && update_idle_->IsRunning())
+      return;
+
+    update_idle_.reset(new glib::Idle([this] {
+      UpdateEventMonitor();
+      return false;
+    }, glib::Source::Priority::HIGH));
+  }
+
   void UpdateEventMonitor()
   {
     auto* nux_dpy = nux::GetGraphicsDisplay();
     auto* dpy = nux_dpy ? nux_dpy->GetX11Display() : gdk_x11_get_default_xdisplay();
-    Window root = DefaultRootWindow(dpy);
-
-    unsigned char master_dev_bits[XIMaskLen(XI_LASTEVENT)] = { 0 };
-    XIEventMask master_dev = { XIAllMasterDevices, sizeof(master_dev_bits), master_dev_bits };
+    Events events = WantedEvents();
 
-    if (!barrier_callbacks_.empty())
+    if (events != selected_events_)
     {
-      XISetMask(master_dev.mask, XI_BarrierHit);
-      XISetMask(master_dev.mask, XI_BarrierLeave);
-    }
+      Window root = DefaultRootWindow(dpy);
 
-    unsigned char all_devs_bits[XIMaskLen(XI_LASTEVENT)] = { 0 };
-    XIEventMask all_devs = { XIAllDevices, sizeof(all_devs_bits), all_devs_bits };
+      unsigned char master_dev_bits[XIMaskLen(XI_LASTEVENT)] = { 0 };
+      XIEventMask master_dev = { XIAllMasterDevices, sizeof(master_dev_bits), master_dev_bits };
 
-    if (!pointer_callbacks_.empty())
-    {
-      XISetMask(all_devs.mask, XI_Motion);
-      XISetMask(all_devs.mask, XI_ButtonPress);
-      XISetMask(all_devs.mask, XI_ButtonRelease);
-    }
+      if (events & Events::BARRIER)
+      {
+        XISetMask(master_dev.mask, XI_BarrierHit);
+        XISetMask(master_dev.mask, XI_BarrierLeave);
+      }
 
-    if (!key_callbacks_.empty())
-    {
-      XISetMask(all_devs.mask, XI_KeyPress);
-      XISetMask(all_devs.mask, XI_KeyRelease);
-    }
+      unsigned char all_devs_bits[XIMaskLen(XI_LASTEVENT)] = { 0 };
+      XIEventMask all_devs = { XIAllDevices, sizeof(all_devs_bits), all_devs_bits };
+
+      if (events & Events::POINTER)
+      {
+        XISetMask(all_devs.mask, XI_Motion);
+        XISetMask(all_devs.mask, XI_ButtonPress);
+        XISetMask(all_devs.mask, XI_ButtonRelease);
+      }
+
+      if (events & Events::KEYS)
+      {
+        XISetMask(all_devs.mask, XI_KeyPress);
+        XISetMask(all_devs.mask, XI_KeyRelease);
+      }
 
-    XIEventMask selected[] = {master_dev, all_devs};
-    XISelectEvents(dpy, root, selected, G_N_ELEMENTS(selected));
-    XSync(dpy, False);
+      // No need to wait for the server here, the request just needs to be sent
+      XIEventMask selected[] = {master_dev, all_devs};
+      XISelectEvents(dpy, root, selected, G_N_ELEMENTS(selected));
+      XFlush(dpy);
+
+      selected_events_ = events;
+      ++event_monitor_updates_;
+    }
 
     LOG_DEBUG(logger) << "Pointer clients: " << pointer_callbacks_.size() << ", "
                       << "Key clients: " << key_callbacks_.size() << ", "
                       << "Barrier clients: " << barrier_callbacks_.size();
 
-    if (!pointer_callbacks_.empty() || !key_callbacks_.empty() || !barrier_callbacks_.empty())
+    if (events != Events::NONE)
     {
       if (!event_filter_set_ && nux_dpy)
       {
@@ -282,6 +401,13 @@ struct Monitor::Impl
       event_filter_set_ = false;
       LOG_DEBUG(logger) << "Event filter disabled";
     }
+
+    // Don't keep the copies of the removed clients around
+    for (auto* clients : {&pointer_callbacks_, &key_callbacks_, &barrier_callbacks_})
+    {
+      if (clients->empty())
+        clients->list.reset();
+    }
   }
 
   bool HandleEvent(XEvent& event)
@@ -314,66 +440,125 @@ struct Monitor::Impl
   }
 
   template <typename EVENT_TYPE, typename NATIVE_TYPE = XIDeviceEvent>
-  bool InvokeCallbacks(EventCallbackSet& callbacks, XEvent& xiev)
+  bool InvokeCallbacks(Clients& clients, XEvent& xiev)
   {
+    if (clients.empty())
+      return false;
+
     XGenericEventCookie *cookie = &xiev.xcookie;
 
     if (!XGetEventData(xiev.xany.display, cookie))
       return false;
 
+    // The event is converted once, and shared by all the clients
     XEvent event;
     initialize_event<EVENT_TYPE>(&event, reinterpret_cast<NATIVE_TYPE*>(cookie->data));
-    invoking_callbacks_ = true;
+    CountEvent();
+
+    bool changed = Dispatch(clients, event);
+    XFreeEventData(xiev.xany.display, cookie);
+
+    return !changed && !clients.empty();
+  }
+
+  bool Dispatch(Events type, XEvent const& event)
+  {
+    bool changed = false;
+
+    if (type & Events::POINTER)
+      changed = Dispatch(pointer_callbacks_, event) || changed;
 
-    for (auto it = callbacks.begin(); it != callbacks.end();)
+    if (type & Events::KEYS)
+      changed = Dispatch(key_callbacks_, event) || changed;
+
+    if (type & Events::BARRIER)
+      changed = Dispatch(barrier_callbacks_, event) || changed;
+
+    return changed;
+  }
+
+  bool Dispatch(Clients& clients, XEvent const& event)
+  {
+    // Callbacks might run nested loops that dispatch other events, so we keep
+    // a reference to the list we're walking, in case it gets rebuilt meanwhile.
+    auto list = clients.GetList();
+    bool has_empty = false;
+
+    for (auto const& cb : *list)
     {
-      if (it->empty())
+      if (cb.empty())
       {
-        it = callbacks.erase(it);
+        has_empty = true;
         continue;
       }
 
-      (*it)(event);
-      ++it;
+      // A previous callback might have unregistered this one
+      if ((clients.dirty || list != clients.list) && !clients.Contains(cb))
+        continue;
+
+      cb(event);
     }
 
-    XFreeEventData(xiev.xany.display, cookie);
-    invoking_callbacks_ = false;
+    bool changed = clients.dirty || list != clients.list;
 
-    // A callback might unregister itself on the event callback, causing the
-    // above callbacks loop to crash, so in this case we save the event in the
-    // removal queue and eventually we unregistered these callbacks.
-    bool update_event_monitor = false;
-    for (auto it = removal_queue_.begin(); it != removal_queue_.end(); it = removal_queue_.erase(it))
+    if (has_empty && clients.RemoveEmpty())
     {
-      auto const& cb = *it;
-      pointer_callbacks_.erase(cb);
-      key_callbacks_.erase(cb);
-      barrier_callbacks_.erase(cb);
-      update_event_monitor = true;
+      QueueEventMonitorUpdate();
+      changed = true;
     }
 
-    if (callbacks.empty() || update_event_monitor)
+    return changed;
+  }
+
+  void CountEvent()
+  {
+    gint64 now = g_get_monotonic_time();
+    ++events_;
+    ++rate_events_;
+
+    if (now - rate_start_time_ >= EVENT_RATE_INTERVAL)
     {
-      idle_removal_.reset(new glib::Idle([this] {
-        UpdateEventMonitor();
-        return false;
-      }));
+      if (rate_start_time_)
+        event_rate_ = rate_events_ * G_USEC_PER_SEC / double(now - rate_start_time_);
 
-      return false;
+      rate_start_time_ = now;
+      rate_events_ = 0;
     }
+  }
+
+  double EventRate() const
+  {
+    // Nothing happened recently, so the last rate is not valid anymore
+    if (g_get_monotonic_time() - rate_start_time_ >= EVENT_RATE_INTERVAL * 2)
+      return 0;
+
+    return event_rate_;
+  }
 
-    return true;
+  void AddProperties(debug::IntrospectionData& introspection)
+  {
+    introspection
+    .add("pointer_clients", pointer_callbacks_.size())
+    .add("key_clients", key_callbacks_.size())
+    .add("barrier_clients", barrier_callbacks_.size())
+    .add("event_filter_set", event_filter_set_)
+    .add("event_monitor_updates", event_monitor_updates_)
+    .add("events", events_)
+    .add("event_rate", EventRate());
   }
 
   int xi_opcode_;
   bool event_filter_set_;
-  bool invoking_callbacks_;
-  glib::Source::UniquePtr idle_removal_;
-  EventCallbackSet pointer_callbacks_;
-  EventCallbackSet key_callbacks_;
-  EventCallbackSet barrier_callbacks_;
-  EventCallbackSet removal_queue_;
+  Events selected_events_;
+  unsigned event_monitor_updates_;
+  uint64_t events_;
+  gint64 rate_start_time_;
+  unsigned rate_events_;
+  double event_rate_;
+  glib::Source::UniquePtr update_idle_;
+  Clients pointer_callbacks_;
+  Clients key_callbacks_;
+  Clients barrier_callbacks_;
 };
 
 Monitor::Monitor()
@@ -419,5 +604,21 @@ Events Monitor::RegisteredEvents(EventCallback const& cb) const
   return impl_->RegisteredEvents(cb);
 }
 
+void Monitor::Dispatch(Events type, XEvent const& event)
+{
+  impl_->Dispatch(type, event);
+}
+
+std::string Monitor::GetName() const
+{
+  return "InputMonitor";
+}
+
+void Monitor::AddProperties(debug::IntrospectionData& introspection)
+{
+  if (impl_)
+    impl_->AddProperties(introspection);
+}
+
 } // input namespace
 } // unity namespace
@@ -24,6 +24,8 @@
 #include <sigc++/slot.h>
 #include <memory>
 
+#include "Introspectable.h"
+
 namespace unity
 {
 namespace input
@@ -38,7 +40,7 @@ enum class Events : unsigned
   ALL = POINTER | KEYS | BARRIER
 };
 
-class Monitor : public sigc::trackable
+class Monitor : public sigc::trackable, public debug::Introspectable
 {
 public:
   typedef sigc::slot<void, XEvent const&> EventCallback;
@@ -53,6 +55,14 @@ public:
 
   Events RegisteredEvents(EventCallback const&) const;
 
+protected:
+  // Invokes the clients of the given events, as if event came from the server
+  void Dispatch(Events, XEvent const&);
+
+  // Introspectable methods
+  std::string GetName() const;
+  void AddProperties(debug::IntrospectionData&);
+
 private:
   Monitor(Monitor const&) = delete;
   Monitor& operator=(Monitor const&) = delete;
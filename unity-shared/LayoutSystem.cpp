@@ -19,8 +19,34 @@
 
 #include "LayoutSystem.h"
 
+#include <unordered_map>
+
 namespace unity {
 namespace ui {
+namespace
+{
+const unsigned MAX_CACHED_LAYOUTS = 8;
+const unsigned ROW_ASPECT_SEARCH_STEPS = 24;
+
+unsigned CountRows(LayoutWindow::Vector const& windows, float max_row_aspect)
+{
+  unsigned rows = 1;
+  float row_aspect = 0;
+
+  for (LayoutWindow::Ptr const& window : windows)
+  {
+    if (row_aspect > 0 && row_aspect + window->aspect_ratio > max_row_aspect)
+    {
+      ++rows;
+      row_aspect = 0;
+    }
+
+    row_aspect += window->aspect_ratio;
+  }
+
+  return rows;
+}
+}
 
 LayoutSystem::LayoutSystem()
   : spacing(8)
@@ -32,7 +58,15 @@ void LayoutSystem::LayoutWindows(LayoutWindow::Vector const& windows, nux::Geome
   if (windows.empty())
     return;
 
-  LayoutGridWindows(windows, GetRows(windows, max_bounds), max_bounds, final_bounds);
+  if (CachedLayout const* cached = GetCachedLayout(false, windows, max_bounds))
+  {
+    ApplyCachedLayout(*cached, windows, final_bounds);
+    return;
+  }
+
+  std::vector<LayoutWindow::Vector> const& rows = GetRows(windows, max_bounds);
+  LayoutGridWindows(windows, rows, max_bounds, final_bounds);
+  CacheLayout(false, windows, windows, rows, max_bounds, final_bounds);
 }
 
 void LayoutSystem::LayoutWindowsNearest(LayoutWindow::Vector& windows, nux::Geometry const& max_bounds, nux::Geometry& final_bounds)
@@ -40,6 +74,14 @@ void LayoutSystem::LayoutWindowsNearest(LayoutWindow::Vector& windows, nux::Geom
   if (windows.empty())
     return;
 
+  if (CachedLayout const* cached = GetCachedLayout(true, windows, max_bounds))
+  {
+    windows = ApplyCachedLayout(*cached, windows, final_bounds);
+    return;
+  }
+
+  LayoutWindow::Vector const input_windows = windows;
+
   std::stable_sort(windows.begin(), windows.end(), [](LayoutWindow::Ptr const& a, LayoutWindow::Ptr const& b) {
     return a->geo.y < b->geo.y;
   });
@@ -58,6 +100,7 @@ void LayoutSystem::LayoutWindowsNearest(LayoutWindow::Vector& windows, nux::Geom
   }
 
   LayoutGridWindows(ordered_windows, rows, max_bounds, final_bounds);
+  CacheLayout(true, input_windows, ordered_windows, rows, max_bounds, final_bounds);
   windows = ordered_windows;
 }
 
@@ -166,6 +209,12 @@ nux::Geometry LayoutSystem::LayoutRow(LayoutWindow::Vector const& row, nux::Geom
 
 std::vector<int> LayoutSystem::GetRowSizes(LayoutWindow::Vector const& windows, nux::Geometry const& max_bounds) const
 {
+  for (auto const& cached : cache_)
+  {
+    if (Matches(cached, false, windows, max_bounds))
+      return cached.row_sizes;
+  }
+
   std::vector<LayoutWindow::Vector> const& rows = GetRows(windows, max_bounds);
   std::vector<int> row_sizes;
 
@@ -179,82 +228,150 @@ std::vector<LayoutWindow::Vector> LayoutSystem::GetRows(LayoutWindow::Vector con
 {
   std::vector<LayoutWindow::Vector> rows;
 
-  int size = (int)windows.size();
-
   float total_aspect = 0;
+  float max_aspect = 0;
   for (LayoutWindow::Ptr const& window : windows)
   {
     total_aspect += window->aspect_ratio;
+    max_aspect = std::max(window->aspect_ratio, max_aspect);
   }
 
   if (total_aspect < 1.8f * ((float)max_bounds.width / max_bounds.height))
   {
     // If the total aspect ratio is < 1.8 the max, we fairly safely assume a double row configuration wont be better
     rows.push_back(windows);
+    return rows;
   }
-  else
-  {
-    nux::Size const& grid_size = GridSizeForWindows(windows, max_bounds);
 
-    int width = grid_size.width;
-    int height = grid_size.height;
+  nux::Size const& grid_size = GridSizeForWindows(windows, max_bounds);
+  unsigned n_rows = std::min<unsigned>(grid_size.height, windows.size());
 
-    float row_height = std::min (max_bounds.height / height, max_row_height());
-    float ideal_aspect = (float)max_bounds.width / row_height;
+  // Split the windows (keeping their order) in the grid rows, so that the
+  // widest row is as narrow as possible: as all the rows have the same height,
+  // this gives the biggest scale to the windows. The minimum row aspect that
+  // allows to fit the windows in the rows is found with a binary search.
+  float min_row_aspect = max_aspect;
+  float max_row_aspect = total_aspect;
 
-    int x = 0;
-    int y = 0;
+  for (unsigned i = 0; i < ROW_ASPECT_SEARCH_STEPS && min_row_aspect < max_row_aspect; ++i)
+  {
+    float row_aspect = (min_row_aspect + max_row_aspect) / 2.0f;
+
+    if (CountRows(windows, row_aspect) <= n_rows)
+      max_row_aspect = row_aspect;
+    else
+      min_row_aspect = row_aspect;
+  }
+
+  LayoutWindow::Vector row_accum;
+  float row_aspect = 0.0f;
 
-    int spare_slots = (width * height) - size;
+  for (unsigned i = 0; i < windows.size(); ++i)
+  {
+    LayoutWindow::Ptr const& window = windows[i];
 
-    float row_aspect = 0.0f;
+    // Each of the remaining rows needs at least one window
+    bool fill_rows = (windows.size() - i) < (n_rows - rows.size());
 
-    LayoutWindow::Vector row_accum;
-    
-    int i;
-    for (i = 0; i < size; ++i)
+    if (!row_accum.empty() && (row_aspect + window->aspect_ratio > max_row_aspect || fill_rows))
     {
-      LayoutWindow::Ptr window = windows[i];
-
-      row_accum.push_back (window);
-      row_aspect += window->aspect_ratio;
-      
-      ++x;
-      if (x == width - 1 && spare_slots)
-      {
-        bool skip = false;
-
-        if (spare_slots == height - y)
-          skip = true;
-        else if (i < size - 1)
-          skip = row_aspect + windows[i+1]->aspect_ratio >= ideal_aspect;
-
-        if (skip)
-        {
-          ++x;
-          spare_slots--;
-        }
-      }
-
-      if (x >= width)
-      {
-        // end of row
-        x = 0;
-        ++y;
-        row_aspect = 0;
-
-        rows.push_back(row_accum);
-        row_accum.clear ();
-      }
+      rows.push_back(row_accum);
+      row_accum.clear();
+      row_aspect = 0;
     }
 
-    if (!row_accum.empty())
-      rows.push_back(row_accum);
+    row_accum.push_back(window);
+    row_aspect += window->aspect_ratio;
   }
 
+  rows.push_back(row_accum);
+
   return rows;
 }
 
+bool LayoutSystem::Matches(CachedLayout const& cached, bool nearest, LayoutWindow::Vector const& windows, nux::Geometry const& max_bounds) const
+{
+  if (cached.nearest != nearest || cached.max_bounds != max_bounds ||
+      cached.spacing != spacing() || cached.max_row_height != max_row_height() ||
+      cached.xids.size() != windows.size())
+  {
+    return false;
+  }
+
+  for (unsigned i = 0; i < windows.size(); ++i)
+  {
+    if (cached.xids[i] != windows[i]->xid || cached.geometries[i] != windows[i]->geo)
+      return false;
+  }
+
+  return true;
+}
+
+LayoutSystem::CachedLayout const* LayoutSystem::GetCachedLayout(bool nearest, LayoutWindow::Vector const& windows, nux::Geometry const& max_bounds)
+{
+  for (auto it = cache_.begin(); it != cache_.end(); ++it)
+  {
+    if (Matches(*it, nearest, windows, max_bounds))
+    {
+      cache_.splice(cache_.begin(), cache_, it);
+      return &cache_.front();
+    }
+  }
+
+  return nullptr;
+}
+
+LayoutWindow::Vector LayoutSystem::ApplyCachedLayout(CachedLayout const& cached, LayoutWindow::Vector const& windows, nux::Geometry& final_bounds) const
+{
+  LayoutWindow::Vector ordered_windows;
+  ordered_windows.reserve(windows.size());
+
+  for (unsigned i = 0; i < cached.order.size(); ++i)
+  {
+    LayoutWindow::Ptr const& window = windows[cached.order[i]];
+    window->result = cached.results[i];
+    window->scale = cached.scales[i];
+    ordered_windows.push_back(window);
+  }
+
+  final_bounds = cached.final_bounds;
+
+  return ordered_windows;
+}
+
+void LayoutSystem::CacheLayout(bool nearest, LayoutWindow::Vector const& windows, LayoutWindow::Vector const& ordered_windows, std::vector<LayoutWindow::Vector> const& rows, nux::Geometry const& max_bounds, nux::Geometry const& final_bounds)
+{
+  if (cache_.size() >= MAX_CACHED_LAYOUTS)
+    cache_.pop_back();
+
+  cache_.push_front(CachedLayout());
+  CachedLayout& cached = cache_.front();
+  cached.nearest = nearest;
+  cached.max_bounds = max_bounds;
+  cached.spacing = spacing();
+  cached.max_row_height = max_row_height();
+  cached.final_bounds = final_bounds;
+
+  std::unordered_map<LayoutWindow*, unsigned> indexes;
+
+  for (unsigned i = 0; i < windows.size(); ++i)
+  {
+    cached.xids.push_back(windows[i]->xid);
+    cached.geometries.push_back(windows[i]->geo);
+    indexes[windows[i].get()] = i;
+  }
+
+  for (LayoutWindow::Ptr const& window : ordered_windows)
+  {
+    cached.order.push_back(indexes[window.get()]);
+    cached.results.push_back(window->result);
+    cached.scales.push_back(window->scale);
+  }
+
+  for (auto const& row : rows)
+    cached.row_sizes.push_back(row.size());
+}
+
 void LayoutSystem::LayoutGridWindows(LayoutWindow::Vector const& windows, std::vector<LayoutWindow::Vector> const& rows, nux::Geometry const& max_bounds, nux::Geometry& final_bounds)
 {
   int height = rows.size();
@@ -318,6 +435,13 @@ void LayoutWindow::ComputeDecorationHeight()
   }
 }
 
+void LayoutWindow::RefreshGeometry()
+{
+  geo = WindowManager::Default().GetWindowGeometry(xid);
+  decoration_height = 0;
+  aspect_ratio = geo.width / static_cast<float>(geo.height);
+}
+
 // Introspectable methods
 std::string LayoutWindow::GetName() const
 {
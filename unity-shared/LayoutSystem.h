@@ -20,6 +20,7 @@
 #ifndef UNITYSHELL_LAYOUTSYSTEM_H
 #define UNITYSHELL_LAYOUTSYSTEM_H
 
+#include <list>
 #include <memory>
 #include <sigc++/sigc++.h>
 #include <Nux/Nux.h>
@@ -39,6 +40,8 @@ public:
   LayoutWindow(Window xid);
 
   void ComputeDecorationHeight();
+  // Fetches again the window geometry, dropping the computed decoration
+  void RefreshGeometry();
 
   Window xid;
 
@@ -80,6 +83,32 @@ protected:
   std::vector<LayoutWindow::Vector> GetRows(LayoutWindow::Vector const& windows, nux::Geometry const& max_bounds) const;
 
   nux::Geometry ScaleBoxIntoBox(nux::Geometry const& bounds, nux::Geometry const& box);
+
+private:
+  // The result of a previous layout, valid for the same windows geometries,
+  // bounds and layout parameters.
+  struct CachedLayout
+  {
+    bool nearest;
+    std::vector<Window> xids;
+    std::vector<nux::Geometry> geometries;
+    nux::Geometry max_bounds;
+    int spacing;
+    int max_row_height;
+
+    std::vector<unsigned> order;
+    std::vector<nux::Geometry> results;
+    std::vector<float> scales;
+    std::vector<int> row_sizes;
+    nux::Geometry final_bounds;
+  };
+
+  bool Matches(CachedLayout const&, bool nearest, LayoutWindow::Vector const&, nux::Geometry const& max_bounds) const;
+  CachedLayout const* GetCachedLayout(bool nearest, LayoutWindow::Vector const&, nux::Geometry const& max_bounds);
+  LayoutWindow::Vector ApplyCachedLayout(CachedLayout const&, LayoutWindow::Vector const&, nux::Geometry& final_bounds) const;
+  void CacheLayout(bool nearest, LayoutWindow::Vector const& windows, LayoutWindow::Vector const& ordered_windows, std::vector<LayoutWindow::Vector> const& rows, nux::Geometry const& max_bounds, nux::Geometry const& final_bounds);
+
+  std::list<CachedLayout> cache_;
 };
 
 }
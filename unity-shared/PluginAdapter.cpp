@@ -84,6 +84,8 @@ PluginAdapter::PluginAdapter(CompScreen* screen)
   , _grab_hide_action(nullptr)
   , _grab_toggle_action(nullptr)
   , _last_focused_window(nullptr)
+  , _stacking_valid(false)
+  , _client_stacking_valid(false)
 {}
 
 PluginAdapter::~PluginAdapter()
@@ -127,18 +129,64 @@ void PluginAdapter::OnScreenUngrabbed()
   screen_ungrabbed.emit();
 }
 
+void PluginAdapter::InvalidateStacking()
+{
+  _stacking_valid = false;
+  _client_stacking_valid = false;
+}
+
+StackingSnapshot const& PluginAdapter::GetStackingSnapshot() const
+{
+  if (_stacking_valid)
+    return _stacking_snapshot;
+
+  int intersect_types = CompWindowTypeNormalMask | CompWindowTypeDialogMask |
+                        CompWindowTypeModalDialogMask | CompWindowTypeUtilMask;
+
+  _stacking_snapshot.Clear();
+
+  for (CompWindow* window : m_Screen->windows())
+  {
+    unsigned flags = 0;
+    bool visible = window->isMapped() && window->isViewable();
+
+    if (visible && (window->type() & intersect_types) && !(window->state() & CompWindowStateHiddenMask))
+      flags |= StackingSnapshot::INTERSECTS;
+
+    if (visible && !window->minimized() && (window->state() & MAXIMIZE_STATE) == MAXIMIZE_STATE)
+      flags |= StackingSnapshot::OBSCURES;
+
+    if (window->inShowDesktopMode())
+      flags |= StackingSnapshot::SHOW_DESKTOP;
+
+    CompRect const& rect = window->borderRect();
+    CompPoint const& vp = window->defaultViewport();
+    _stacking_snapshot.Add(window->id(), nux::Geometry(rect.x(), rect.y(), rect.width(), rect.height()),
+                           nux::Point(vp.x(), vp.y()), flags);
+  }
+
+  _stacking_snapshot.Build(nux::Geometry(0, 0, m_Screen->width(), m_Screen->height()));
+  _stacking_valid = true;
+
+  return _stacking_snapshot;
+}
+
 void PluginAdapter::NotifyResized(CompWindow* window, int x, int y, int w, int h)
 {
+  InvalidateStacking();
   window_resized.emit(window->id());
 }
 
 void PluginAdapter::NotifyMoved(CompWindow* window, int x, int y)
 {
+  InvalidateStacking();
   window_moved.emit(window->id());
 }
 
 void PluginAdapter::NotifyStateChange(CompWindow* window, unsigned int state, unsigned int last_state)
 {
+  InvalidateStacking();
+
   if (!((last_state & MAXIMIZE_STATE) == MAXIMIZE_STATE)
       && ((state & MAXIMIZE_STATE) == MAXIMIZE_STATE))
   {
@@ -163,6 +211,9 @@ void PluginAdapter::NotifyStateChange(CompWindow* window, unsigned int state, un
 
 void PluginAdapter::Notify(CompWindow* window, CompWindowNotify notify)
 {
+  // Any notification (restack, map, minimize...) might change the stacking
+  InvalidateStacking();
+
   switch (notify)
   {
     case CompWindowNotifyMinimize:
@@ -192,6 +243,9 @@ void PluginAdapter::Notify(CompWindow* window, CompWindowNotify notify)
     case CompWindowNotifyFocusChange:
       window_focus_changed.emit(window->id());
       break;
+    case CompWindowNotifyRestack:
+      window_restacked.emit(window->id());
+      break;
     default:
       break;
   }
@@ -201,6 +255,8 @@ void PluginAdapter::NotifyCompizEvent(const char* plugin,
                                       const char* event,
                                       CompOption::Vector& option)
 {
+  InvalidateStacking();
+
   if (g_strcmp0(event, "start_viewport_switch") == 0)
   {
     _vp_switch_started = true;
@@ -463,14 +519,19 @@ Window PluginAdapter::GetActiveWindow() const
 
 std::vector<Window> PluginAdapter::GetWindowsInStackingOrder() const
 {
-  bool stacking_order = true;
-  auto const& windows = m_Screen->clientList(stacking_order);
+  if (!_client_stacking_valid)
+  {
+    bool stacking_order = true;
+    auto const& windows = m_Screen->clientList(stacking_order);
 
-  std::vector<Window> ret;
-  for (auto const& window : windows)
-    ret.push_back(window->id());
+    _client_stacking.clear();
+    for (auto const& window : windows)
+      _client_stacking.push_back(window->id());
 
-  return ret;
+    _client_stacking_valid = true;
+  }
+
+  return _client_stacking;
 }
 
 int PluginAdapter::MonitorGeometryIn(nux::Geometry const& geo) const
@@ -601,28 +662,8 @@ bool PluginAdapter::IsWindowObscured(Window window_id) const
   if (_spread_state)
     return false;
 
-  if (CompWindow* window = m_Screen->findWindow(window_id))
-  {
-    if (window->inShowDesktopMode())
-      return true;
-
-    CompPoint window_vp = window->defaultViewport();
-    // Check if any windows above this one are blocking it
-    for (CompWindow* sibling = window->serverNext; sibling != NULL; sibling = sibling->serverNext)
-    {
-      if (sibling->defaultViewport() == window_vp
-          && !sibling->minimized()
-          && sibling->isMapped()
-          && sibling->isViewable()
-          && (sibling->state() & MAXIMIZE_STATE) == MAXIMIZE_STATE
-          && sibling->borderRect().intersects(window->borderRect()))
-      {
-        return true;
-      }
-    }
-  }
-
-  return false;
+  // Checks if any maximized window above this one in the same viewport is blocking it
+  return GetStackingSnapshot().IsObscured(window_id);
 }
 
 bool PluginAdapter::IsWindowMapped(Window window_id) const
@@ -1212,7 +1253,7 @@ bool PluginAdapter::CheckWindowIntersection(nux::Geometry const& region, CompWin
       window->state() & CompWindowStateHiddenMask)
     return false;
 
-  if (CompRegion(window->borderRect()).intersects(CompRect(region.x, region.y, region.width, region.height)))
+  if (window->borderRect().intersects(CompRect(region.x, region.y, region.width, region.height)))
     return true;
 
   return false;
@@ -1224,8 +1265,6 @@ void PluginAdapter::CheckWindowIntersections(nux::Geometry const& region, bool &
   active = false;
   any = false;
 
-  CompWindowList window_list = m_Screen->windows();
-  CompWindowList::iterator it;
   CompWindow* window = NULL;
   CompWindow* parent = NULL;
   int type_dialogs = CompWindowTypeDialogMask | CompWindowTypeModalDialogMask
@@ -1244,14 +1283,7 @@ void PluginAdapter::CheckWindowIntersections(nux::Geometry const& region, bool &
   }
   else
   {
-    for (it = window_list.begin(); it != window_list.end(); ++it)
-    {
-      if (CheckWindowIntersection(region, *it))
-      {
-        any = true;
-        break;
-      }
-    }
+    any = GetStackingSnapshot().Intersects(region, StackingSnapshot::INTERSECTS);
   }
 }
 
@@ -27,6 +27,7 @@
 
 #include <NuxCore/Property.h>
 
+#include "StackingSnapshot.h"
 #include "XWindowManager.h"
 
 namespace unity
@@ -210,6 +211,9 @@ private:
 
   bool CheckWindowIntersection(nux::Geometry const& region, CompWindow* window) const;
 
+  void InvalidateStacking();
+  StackingSnapshot const& GetStackingSnapshot() const;
+
   Window GetTopMostWindowInMonitor(int monitor) const;
   Window GetTopMostValidWindowInViewport() const;
   bool IsCurrentViewportEmpty() const;
@@ -231,6 +235,12 @@ private:
   CompAction* _grab_hide_action;
   CompAction* _grab_toggle_action;
   CompWindow* _last_focused_window;
+
+  // Rebuilt on demand after any window notification
+  mutable StackingSnapshot _stacking_snapshot;
+  mutable std::vector<Window> _client_stacking;
+  mutable bool _stacking_valid;
+  mutable bool _client_stacking_valid;
 };
 
 }
@@ -19,11 +19,11 @@
 
 #include "SpreadFilter.h"
 
+#include <algorithm>
 #include <Nux/HLayout.h>
 #include <UnityCore/GLibWrapper.h>
 
 #include "AnimationUtils.h"
-#include "ApplicationManager.h"
 #include "SearchBar.h"
 #include "UnitySettings.h"
 #include "WindowManager.h"
@@ -46,6 +46,17 @@ std::string casefold_copy(std::string const& str)
 {
   return glib::String(g_utf8_casefold(str.c_str(), -1)).Str();
 }
+
+// Titles are indexed by their (casefolded) byte trigrams, so that a title can
+// only contain the search if it contains all its trigrams.
+const unsigned TRIGRAM_SIZE = 3;
+
+uint32_t trigram_at(std::string const& str, std::size_t pos)
+{
+  return (static_cast<uint8_t>(str[pos]) << 16) |
+         (static_cast<uint8_t>(str[pos + 1]) << 8) |
+          static_cast<uint8_t>(str[pos + 2]);
+}
 }
 
 Filter::Filter()
@@ -114,7 +125,32 @@ Filter::Filter()
     fade_animator_.SetDuration(low_gfx ? 0 : FADE_DURATION);
   }, *this));
 
-  ApplicationManager::Default().window_opened.connect(sigc::hide(sigc::mem_fun(this, &Filter::OnWindowChanged)));
+  auto& app_manager = ApplicationManager::Default();
+
+  auto const& apps = app_manager.GetRunningApplications();
+
+  for (auto const& app : *apps)
+    app_titles_[app.get()] = AddTitle(app, nullptr, app->title());
+
+  auto const& windows = app_manager.GetWindowsForMonitor(-1);
+
+  for (auto const& win : *windows)
+    window_titles_[win->window_id()] = AddTitle(nullptr, win, win->title());
+
+  app_manager.application_started.connect(sigc::mem_fun(this, &Filter::OnApplicationStarted));
+
+  app_manager.application_stopped.connect(sigc::track_obj([this] (ApplicationPtr const& app) {
+    auto it = app_titles_.find(app.get());
+
+    if (it != app_titles_.end())
+    {
+      RemoveTitle(it->second);
+      app_titles_.erase(it);
+    }
+  }, *this));
+
+  app_manager.window_opened.connect(sigc::mem_fun(this, &Filter::OnWindowOpened));
+  app_manager.window_closed.connect(sigc::mem_fun(this, &Filter::OnWindowClosed));
 }
 
 bool Filter::Visible() const
@@ -132,41 +168,238 @@ std::set<uint64_t> const& Filter::FilteredWindows() const
   return filtered_windows_;
 }
 
-void Filter::UpdateFilteredWindows()
+unsigned Filter::AddTitle(ApplicationPtr const& app, ApplicationWindowPtr const& window, std::string const& title)
 {
-  auto const& lower_search = casefold_copy(text());
-  filtered_windows_.clear();
-  title_connections_.Clear();
+  unsigned id = titles_.size();
+
+  if (!free_title_ids_.empty())
+  {
+    id = free_title_ids_.back();
+    free_title_ids_.pop_back();
+  }
+  else
+  {
+    titles_.emplace_back();
+  }
 
-  if (lower_search.empty())
+  titles_[id].reset(new IndexedTitle());
+  auto& entry = *titles_[id];
+  entry.app = app;
+  entry.window = window;
+
+  nux::ROProperty<std::string>& title_property = app ? app->title : window->title;
+  entry.title_connection = title_property.changed.connect([this, id] (std::string const& new_title) {
+    OnTitleChanged(id, new_title);
+  });
+
+  IndexTitle(id, title);
+
+  return id;
+}
+
+void Filter::RemoveTitle(unsigned id)
+{
+  UnindexTitle(id);
+  titles_[id].reset();
+  free_title_ids_.push_back(id);
+
+  auto it = std::find(last_matches_.begin(), last_matches_.end(), id);
+  if (it != last_matches_.end())
+    last_matches_.erase(it);
+}
+
+void Filter::IndexTitle(unsigned id, std::string const& title)
+{
+  auto& entry = *titles_[id];
+  entry.title = casefold_copy(title);
+
+  for (std::size_t i = 0; i + TRIGRAM_SIZE <= entry.title.size(); ++i)
+    trigrams_[trigram_at(entry.title, i)].insert(id);
+}
+
+void Filter::UnindexTitle(unsigned id)
+{
+  auto const& title = titles_[id]->title;
+
+  for (std::size_t i = 0; i + TRIGRAM_SIZE <= title.size(); ++i)
+  {
+    auto it = trigrams_.find(trigram_at(title, i));
+
+    if (it == trigrams_.end())
+      continue;
+
+    it->second.erase(id);
+
+    if (it->second.empty())
+      trigrams_.erase(it);
+  }
+}
+
+void Filter::OnTitleChanged(unsigned id, std::string const& title)
+{
+  UnindexTitle(id);
+  IndexTitle(id, title);
+
+  if (last_search_.empty())
+    return;
+
+  bool matches = MatchesLastSearch(id);
+  auto it = std::find(last_matches_.begin(), last_matches_.end(), id);
+
+  if (matches == (it != last_matches_.end()))
     return;
 
-  auto update_cb = sigc::hide(sigc::mem_fun(this, &Filter::OnWindowChanged));
+  if (matches)
+    last_matches_.push_back(id);
+  else
+    last_matches_.erase(it);
+
+  auto old_filtered_windows = filtered_windows_;
+  UpdateFilteredWindowsFromMatches();
 
-  for (auto const& app : ApplicationManager::Default().GetRunningApplications())
+  if (filtered_windows_ != old_filtered_windows)
+    text.changed.emit(text());
+}
+
+bool Filter::MatchesLastSearch(unsigned id) const
+{
+  return !last_search_.empty() && titles_[id]->title.find(last_search_) != std::string::npos;
+}
+
+void Filter::OnApplicationStarted(ApplicationPtr const& app)
+{
+  if (app_titles_.find(app.get()) != app_titles_.end())
+    return;
+
+  unsigned id = AddTitle(app, nullptr, app->title());
+  app_titles_[app.get()] = id;
+
+  if (!MatchesLastSearch(id))
+    return;
+
+  last_matches_.push_back(id);
+
+  auto old_filtered_windows = filtered_windows_;
+  UpdateFilteredWindowsFromMatches();
+
+  if (filtered_windows_ != old_filtered_windows)
+    text.changed.emit(text());
+}
+
+void Filter::OnWindowOpened(ApplicationWindowPtr const& win)
+{
+  if (window_titles_.find(win->window_id()) != window_titles_.end())
+    return;
+
+  unsigned id = AddTitle(nullptr, win, win->title());
+  window_titles_[win->window_id()] = id;
+
+  if (last_search_.empty())
+    return;
+
+  // Only the new window needs to be checked, by its title or its application one
+  bool matches = MatchesLastSearch(id);
+
+  if (matches)
   {
-    title_connections_.Add(app->title.changed.connect(update_cb));
+    last_matches_.push_back(id);
+  }
+  else
+  {
+    auto it = app_titles_.find(win->application().get());
+    matches = (it != app_titles_.end() && MatchesLastSearch(it->second));
+  }
 
-    if (casefold_copy(app->title()).find(lower_search) != std::string::npos)
-    {
-      for (auto const& win : app->GetWindows())
-        filtered_windows_.insert(win->window_id());
-    }
+  if (matches && filtered_windows_.insert(win->window_id()).second && Visible())
+    text.changed.emit(text());
+}
+
+void Filter::OnWindowClosed(ApplicationWindowPtr const& win)
+{
+  auto it = window_titles_.find(win->window_id());
+
+  if (it != window_titles_.end())
+  {
+    RemoveTitle(it->second);
+    window_titles_.erase(it);
   }
 
-  for (auto const& win : ApplicationManager::Default().GetWindowsForMonitor(-1))
+  filtered_windows_.erase(win->window_id());
+}
+
+std::vector<unsigned> Filter::MatchTitles(std::string const& search) const
+{
+  std::vector<unsigned> matches;
+
+  if (search.empty())
+    return matches;
+
+  auto check_title = [this, &search, &matches] (unsigned id) {
+    if (titles_[id] && titles_[id]->title.find(search) != std::string::npos)
+      matches.push_back(id);
+  };
+
+  if (!last_search_.empty() && search.find(last_search_) != std::string::npos)
+  {
+    // The search has been narrowed, only the previous matches can still match
+    for (unsigned id : last_matches_)
+      check_title(id);
+  }
+  else if (search.size() >= TRIGRAM_SIZE)
   {
-    title_connections_.Add(win->title.changed.connect(update_cb));
+    // We only need to check the titles sharing the least common search trigram
+    std::unordered_set<unsigned> const* candidates = nullptr;
+
+    for (std::size_t i = 0; i + TRIGRAM_SIZE <= search.size(); ++i)
+    {
+      auto it = trigrams_.find(trigram_at(search, i));
+
+      if (it == trigrams_.end())
+        return matches;
 
-    if (casefold_copy(win->title()).find(lower_search) != std::string::npos)
-      filtered_windows_.insert(win->window_id());
+      if (!candidates || it->second.size() < candidates->size())
+        candidates = &it->second;
+    }
+
+    for (unsigned id : *candidates)
+      check_title(id);
   }
+  else
+  {
+    for (unsigned id = 0; id < titles_.size(); ++id)
+      check_title(id);
+  }
+
+  return matches;
+}
+
+void Filter::UpdateFilteredWindows()
+{
+  auto const& lower_search = casefold_copy(text());
+  last_matches_ = MatchTitles(lower_search);
+  last_search_ = lower_search;
+
+  UpdateFilteredWindowsFromMatches();
 }
 
-void Filter::OnWindowChanged()
+void Filter::UpdateFilteredWindowsFromMatches()
 {
-  UpdateFilteredWindows();
-  text.changed.emit(text);
+  filtered_windows_.clear();
+
+  for (unsigned id : last_matches_)
+  {
+    auto const& entry = *titles_[id];
+
+    if (entry.app)
+    {
+      for (auto const& win : entry.app->GetWindows())
+        filtered_windows_.insert(win->window_id());
+    }
+    else
+    {
+      filtered_windows_.insert(entry.window->window_id());
+    }
+  }
 }
 
 //
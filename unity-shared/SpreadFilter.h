@@ -21,11 +21,14 @@
 #define UNITYSHELL_SPREAD_FILTER_H
 
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <Nux/Nux.h>
 #include <Nux/BaseWindow.h>
 #include <NuxCore/Animation.h>
 #include <UnityCore/ConnectionManager.h>
+#include "ApplicationManager.h"
 #include "Introspectable.h"
 
 namespace unity
@@ -55,14 +58,43 @@ protected:
   void AddProperties(debug::IntrospectionData&);
 
 private:
-  void OnWindowChanged();
+  friend class TestSpreadFilterIndex;
+
+  // An application or window title, casefolded and indexed by its trigrams
+  struct IndexedTitle
+  {
+    std::string title;
+    ApplicationPtr app;
+    ApplicationWindowPtr window;
+    connection::Wrapper title_connection;
+  };
+
+  void OnApplicationStarted(ApplicationPtr const&);
+  void OnWindowOpened(ApplicationWindowPtr const&);
+  void OnWindowClosed(ApplicationWindowPtr const&);
   void UpdateFilteredWindows();
+  void UpdateFilteredWindowsFromMatches();
+
+  unsigned AddTitle(ApplicationPtr const&, ApplicationWindowPtr const&, std::string const& title);
+  void RemoveTitle(unsigned id);
+  void IndexTitle(unsigned id, std::string const& title);
+  void UnindexTitle(unsigned id);
+  void OnTitleChanged(unsigned id, std::string const& title);
+  bool MatchesLastSearch(unsigned id) const;
+  std::vector<unsigned> MatchTitles(std::string const& search) const;
 
   nux::ObjectPtr<SearchBar> search_bar_;
   nux::ObjectPtr<nux::BaseWindow> view_window_;
   nux::animation::AnimateValue<double> fade_animator_;
   std::set<uint64_t> filtered_windows_;
-  connection::Manager title_connections_;
+
+  std::vector<std::unique_ptr<IndexedTitle>> titles_;
+  std::vector<unsigned> free_title_ids_;
+  std::unordered_map<uint32_t, std::unordered_set<unsigned>> trigrams_;
+  std::unordered_map<Application*, unsigned> app_titles_;
+  std::unordered_map<uint64_t, unsigned> window_titles_;
+  std::string last_search_;
+  std::vector<unsigned> last_matches_;
 };
 
 } // namespace spread
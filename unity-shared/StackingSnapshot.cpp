@@ -0,0 +1,190 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#include <algorithm>
+
+#include "StackingSnapshot.h"
+
+namespace unity
+{
+namespace
+{
+inline bool intersects(nux::Geometry const& a, nux::Geometry const& b)
+{
+  return (a.width > 0 && a.height > 0 && b.width > 0 && b.height > 0 &&
+          a.x < b.x + b.width && b.x < a.x + a.width &&
+          a.y < b.y + b.height && b.y < a.y + a.height);
+}
+}
+
+StackingSnapshot::StackingSnapshot(int cell_size)
+  : cell_size_(std::max(1, cell_size))
+  , cols_(0)
+  , rows_(0)
+{}
+
+void StackingSnapshot::Clear()
+{
+  cols_ = rows_ = 0;
+  entries_.clear();
+  indexes_.clear();
+  cell_offsets_.clear();
+  cell_entries_.clear();
+}
+
+void StackingSnapshot::Add(Window xid, nux::Geometry const& geo, nux::Point const& viewport, unsigned flags)
+{
+  indexes_[xid] = entries_.size();
+  entries_.push_back({xid, geo, viewport, flags});
+}
+
+std::size_t StackingSnapshot::size() const
+{
+  return entries_.size();
+}
+
+bool StackingSnapshot::empty() const
+{
+  return entries_.empty();
+}
+
+bool StackingSnapshot::GetCells(nux::Geometry const& geo, Cells& cells) const
+{
+  if (geo.width <= 0 || geo.height <= 0 || cols_ <= 0 || rows_ <= 0)
+    return false;
+
+  // Areas out of the bounds go in the border cells, so they are still found
+  auto const& clamp = [] (int value, int max) { return std::max(0, std::min(value, max)); };
+  cells.x1 = clamp((geo.x - bounds_.x) / cell_size_, cols_ - 1);
+  cells.y1 = clamp((geo.y - bounds_.y) / cell_size_, rows_ - 1);
+  cells.x2 = clamp((geo.x + geo.width - 1 - bounds_.x) / cell_size_, cols_ - 1);
+  cells.y2 = clamp((geo.y + geo.height - 1 - bounds_.y) / cell_size_, rows_ - 1);
+
+  return true;
+}
+
+void StackingSnapshot::Build(nux::Geometry const& bounds)
+{
+  bounds_ = bounds;
+  cols_ = std::max(1, (bounds.width + cell_size_ - 1) / cell_size_);
+  rows_ = std::max(1, (bounds.height + cell_size_ - 1) / cell_size_);
+  cell_offsets_.assign(cols_ * rows_ + 1, 0);
+
+  // First we count the entries of each cell, then we fill them in stacking order
+  Cells cells;
+  for (auto const& entry : entries_)
+  {
+    if (!entry.flags || !GetCells(entry.geo, cells))
+      continue;
+
+    for (int y = cells.y1; y <= cells.y2; ++y)
+      for (int x = cells.x1; x <= cells.x2; ++x)
+        ++cell_offsets_[y * cols_ + x + 1];
+  }
+
+  for (unsigned i = 1; i < cell_offsets_.size(); ++i)
+    cell_offsets_[i] += cell_offsets_[i - 1];
+
+  cell_entries_.resize(cell_offsets_.back());
+  cell_fill_.assign(cell_offsets_.begin(), cell_offsets_.end() - 1);
+
+  for (unsigned i = 0; i < entries_.size(); ++i)
+  {
+    if (!entries_[i].flags || !GetCells(entries_[i].geo, cells))
+      continue;
+
+    for (int y = cells.y1; y <= cells.y2; ++y)
+      for (int x = cells.x1; x <= cells.x2; ++x)
+        cell_entries_[cell_fill_[y * cols_ + x]++] = i;
+  }
+}
+
+bool StackingSnapshot::Intersects(nux::Geometry const& region, unsigned flags) const
+{
+  Cells cells;
+
+  if (!GetCells(region, cells))
+    return false;
+
+  for (int y = cells.y1; y <= cells.y2; ++y)
+  {
+    for (int x = cells.x1; x <= cells.x2; ++x)
+    {
+      unsigned cell = y * cols_ + x;
+
+      for (unsigned i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i)
+      {
+        Entry const& entry = entries_[cell_entries_[i]];
+
+        if ((entry.flags & flags) == flags && intersects(entry.geo, region))
+          return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool StackingSnapshot::IsObscured(Window xid) const
+{
+  auto it = indexes_.find(xid);
+
+  if (it == indexes_.end())
+    return false;
+
+  unsigned index = it->second;
+  Entry const& window = entries_[index];
+
+  if (window.flags & SHOW_DESKTOP)
+    return true;
+
+  Cells cells;
+
+  if (!GetCells(window.geo, cells))
+    return false;
+
+  for (int y = cells.y1; y <= cells.y2; ++y)
+  {
+    for (int x = cells.x1; x <= cells.x2; ++x)
+    {
+      unsigned cell = y * cols_ + x;
+
+      // Entries are sorted by stacking, so we start from the end of the cell
+      for (unsigned i = cell_offsets_[cell + 1]; i > cell_offsets_[cell]; --i)
+      {
+        unsigned sibling_index = cell_entries_[i - 1];
+
+        if (sibling_index <= index)
+          break;
+
+        Entry const& sibling = entries_[sibling_index];
+
+        if ((sibling.flags & OBSCURES) && sibling.viewport == window.viewport &&
+            intersects(sibling.geo, window.geo))
+        {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+} // namespace unity
@@ -0,0 +1,90 @@
+// -*- Mode: C++; indent-tabs-mode: nil; tab-width: 2 -*-
+/*
+ * Copyright (C) 2016 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Marco Trevisan <marco.trevisan@canonical.com>
+ */
+
+#ifndef UNITYSHARED_STACKING_SNAPSHOT_H
+#define UNITYSHARED_STACKING_SNAPSHOT_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "unity-shared/WindowManager.h"
+
+namespace unity
+{
+
+/* The windows stacking order with their geometries, indexed in a grid of
+ * cells, so that intersection queries only check the windows near to the
+ * requested area. Windows must be added from the bottom to the top one,
+ * then the snapshot must be built before doing any query.
+ * Rebuilding it reuses the memory of the previous state. */
+class StackingSnapshot
+{
+public:
+  enum Flags
+  {
+    // The window can be checked for intersections
+    INTERSECTS = 1 << 0,
+    // The window hides the windows below it in the same viewport
+    OBSCURES = 1 << 1,
+    // The window is hidden by show desktop
+    SHOW_DESKTOP = 1 << 2
+  };
+
+  StackingSnapshot(int cell_size = 128);
+
+  void Clear();
+  void Add(Window xid, nux::Geometry const& geo, nux::Point const& viewport, unsigned flags);
+  void Build(nux::Geometry const& bounds);
+
+  std::size_t size() const;
+  bool empty() const;
+
+  bool Intersects(nux::Geometry const& region, unsigned flags = INTERSECTS) const;
+  bool IsObscured(Window xid) const;
+
+private:
+  struct Entry
+  {
+    Window xid;
+    nux::Geometry geo;
+    nux::Point viewport;
+    unsigned flags;
+  };
+
+  struct Cells
+  {
+    int x1, y1, x2, y2;
+  };
+
+  bool GetCells(nux::Geometry const& geo, Cells& cells) const;
+
+  int cell_size_;
+  int cols_;
+  int rows_;
+  nux::Geometry bounds_;
+  std::vector<Entry> entries_;
+  std::unordered_map<Window, unsigned> indexes_;
+  std::vector<unsigned> cell_offsets_;
+  std::vector<unsigned> cell_entries_;
+  std::vector<unsigned> cell_fill_;
+};
+
+} // namespace unity
+
+#endif // UNITYSHARED_STACKING_SNAPSHOT_H
@@ -273,9 +273,9 @@ int main(int argc, char* argv[])
   dump_app(terminal);
   connect_events(terminal);
 
-  ApplicationList apps = manager.GetRunningApplications();
+  ApplicationListPtr apps = manager.GetRunningApplications();
 
-  for (auto const& app : apps)
+  for (auto const& app : *apps)
   {
     dump_app(app);
     connect_events(app);
@@ -381,7 +381,10 @@ void StandaloneWindowManager::Lower(Window window_id)
   });
 
   if (window != end)
+  {
     standalone_windows_.splice(begin, standalone_windows_, window);
+    window_restacked.emit(window_id);
+  }
 }
 
 void StandaloneWindowManager::Raise(Window window_id)
@@ -392,7 +395,10 @@ void StandaloneWindowManager::Raise(Window window_id)
   });
 
   if (window != end)
+  {
     standalone_windows_.splice(end, standalone_windows_, window);
+    window_restacked.emit(window_id);
+  }
 }
 
 void StandaloneWindowManager::RestackBelow(Window window_id, Window sibiling_id)
@@ -408,7 +414,10 @@ void StandaloneWindowManager::RestackBelow(Window window_id, Window sibiling_id)
   });
 
   if (window != end && sibiling != end)
+  {
     standalone_windows_.splice(sibiling, standalone_windows_, window);
+    window_restacked.emit(window_id);
+  }
 }
 
 void StandaloneWindowManager::TerminateScale()
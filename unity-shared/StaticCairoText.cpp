@@ -32,6 +32,10 @@
 
 #include <pango/pangocairo.h>
 
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
 #include <UnityCore/GLibWrapper.h>
 #include <UnityCore/ConnectionManager.h>
 
@@ -43,6 +47,27 @@ using namespace nux;
 
 namespace unity
 {
+namespace
+{
+const std::size_t LAYOUT_CACHE_MAX_ENTRIES = 256;
+const std::size_t LAYOUT_CACHE_MAX_BYTES = 16 * 1024 * 1024;
+
+// Textures are rendered in white, so that they can be shared by texts with
+// different colors. They used to be rendered in the text color (clamped by
+// cairo) and then modulated again by it when drawn: the tint keeps the very
+// same result.
+Color TextTint(Color const& color)
+{
+  auto const& clamp = [] (float value) { return std::max(0.0f, std::min(value, 1.0f)); };
+  float alpha = clamp(color.alpha);
+
+  return Color(clamp(color.red) * color.red * alpha,
+               clamp(color.green) * color.green * alpha,
+               clamp(color.blue) * color.blue * alpha,
+               alpha * color.alpha);
+}
+}
+
 struct StaticCairoText::Impl : sigc::trackable
 {
   Impl(StaticCairoText* parent, std::string const& text);
@@ -64,15 +89,59 @@ struct StaticCairoText::Impl : sigc::trackable
     unsigned start_index;
     unsigned length;
     unsigned height;
+  };
+
+  // A laid out text, split in the textures needed to draw it
+  struct Layout
+  {
+    typedef std::shared_ptr<Layout> Ptr;
+    Layout()
+    : baseline(0)
+    , lines(0)
+    , bytes(0)
+    {}
 
-    std::shared_ptr<CairoGraphics> cr;
+    Size extent;
+    int baseline;
+    int lines;
+    std::size_t bytes;
+    std::list<CacheTexture::Ptr> splits;
+    std::list<BaseTexturePtr> textures;
+  };
+
+  class LayoutCache
+  {
+  public:
+    static LayoutCache& Get();
+
+    Layout::Ptr Find(std::string const& key);
+    void Add(std::string const& key, Layout::Ptr const&);
+    void Clear();
+
+    LayoutCacheStats GetStats() const;
+
+  private:
+    struct Entry
+    {
+      Layout::Ptr layout;
+      std::list<std::string>::iterator lru_it;
+    };
+
+    void Evict();
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;
+    LayoutCacheStats stats_;
   };
 
   void UpdateBaseSize();
   Size GetTextExtents() const;
 
+  std::string GetLayoutKey() const;
+  Layout::Ptr CreateLayout() const;
+
   void SetAttributes(PangoLayout* layout);
-  void DrawText(CacheTexture::Ptr const& cached_texture);
+  BaseTexturePtr DrawText(CacheTexture::Ptr const& cached_texture);
 
   void UpdateTexture();
   void OnFontChanged();
@@ -84,7 +153,7 @@ struct StaticCairoText::Impl : sigc::trackable
   mutable Size cached_extent_;
   mutable Size cached_base_;
   mutable int baseline_;
-  mutable std::list<CacheTexture::Ptr> cache_textures_;
+  mutable Layout::Ptr layout_;
 
   std::string text_;
   Color text_color_;
@@ -189,12 +258,14 @@ StaticCairoText::~StaticCairoText()
 void StaticCairoText::SetTextEllipsize(EllipsizeState state)
 {
   pimpl->ellipsize_ = state;
+  pimpl->need_new_extent_cache_ = true;
   NeedRedraw();
 }
 
 void StaticCairoText::SetTextAlignment(AlignState state)
 {
   pimpl->align_ = state;
+  pimpl->need_new_extent_cache_ = true;
   NeedRedraw();
 }
 
@@ -207,6 +278,7 @@ void StaticCairoText::SetTextVerticalAlignment(AlignState state)
 void StaticCairoText::SetLines(int lines)
 {
   pimpl->lines_ = lines;
+  pimpl->need_new_extent_cache_ = true;
   pimpl->UpdateTexture();
   QueueDraw();
 }
@@ -214,6 +286,7 @@ void StaticCairoText::SetLines(int lines)
 void StaticCairoText::SetLineSpacing(float line_spacing)
 {
   pimpl->line_spacing_ = line_spacing;
+  pimpl->need_new_extent_cache_ = true;
   pimpl->UpdateTexture();
   QueueDraw();
 }
@@ -307,6 +380,8 @@ void StaticCairoText::Draw(GraphicsEngine& gfxContext, bool forceDraw)
     current_y += base.height - pimpl->cached_extent_.height;
   }
 
+  Color const& tint = TextTint(pimpl->text_color_);
+
   for (BaseTexturePtr tex : pimpl->textures2D_)
   {
     nux::ObjectPtr<nux::IOpenGLBaseTexture> text_tex = tex->GetDeviceTexture();
@@ -319,7 +394,7 @@ void StaticCairoText::Draw(GraphicsEngine& gfxContext, bool forceDraw)
                     text_tex->GetHeight(),
                     text_tex,
                     texxform,
-                    pimpl->text_color_);
+                    tint);
 
     current_y += text_tex->GetHeight();
   }
@@ -353,7 +428,6 @@ void StaticCairoText::SetTextAlpha(unsigned int alpha)
   if (pimpl->text_color_.alpha != alpha)
   {
     pimpl->text_color_.alpha = alpha;
-    pimpl->UpdateTexture();
     QueueDraw();
   }
 }
@@ -401,7 +475,6 @@ void StaticCairoText::SetTextColor(Color const& textColor)
   if (pimpl->text_color_ != textColor)
   {
     pimpl->text_color_ = textColor;
-    pimpl->UpdateTexture();
     QueueDraw();
 
     sigTextColorChanged.emit(this);
@@ -508,8 +581,12 @@ std::vector<unsigned> StaticCairoText::GetTextureStartIndices()
   pimpl->GetTextExtents();
 
   std::vector<unsigned> list;
-  auto iter = pimpl->cache_textures_.begin();
-  for (; iter != pimpl->cache_textures_.end(); ++iter)
+
+  if (!pimpl->layout_)
+    return list;
+
+  auto iter = pimpl->layout_->splits.begin();
+  for (; iter != pimpl->layout_->splits.end(); ++iter)
   {
     Impl::CacheTexture::Ptr const& cached_texture = *iter;
     list.push_back(cached_texture->start_index);
@@ -522,8 +599,12 @@ std::vector<unsigned> StaticCairoText::GetTextureEndIndices()
   pimpl->GetTextExtents();
 
   std::vector<unsigned> list;
-  auto iter = pimpl->cache_textures_.begin();
-  for (; iter != pimpl->cache_textures_.end(); ++iter)
+
+  if (!pimpl->layout_)
+    return list;
+
+  auto iter = pimpl->layout_->splits.begin();
+  for (; iter != pimpl->layout_->splits.end(); ++iter)
   {
     Impl::CacheTexture::Ptr const& cached_texture = *iter;
     if (cached_texture->length == (unsigned)std::string::npos)
@@ -541,6 +622,11 @@ std::vector<unsigned> StaticCairoText::GetTextureEndIndices()
   return list;
 }
 
+std::vector<nux::ObjectPtr<nux::BaseTexture>> StaticCairoText::GetTextures() const
+{
+  return std::vector<BaseTexturePtr>(pimpl->textures2D_.begin(), pimpl->textures2D_.end());
+}
+
 std::string StaticCairoText::GetName() const
 {
   return "StaticCairoText";
@@ -552,6 +638,16 @@ void StaticCairoText::AddProperties(debug::IntrospectionData& introspection)
                .add("text", pimpl->text_);
 }
 
+StaticCairoText::LayoutCacheStats StaticCairoText::GetLayoutCacheStats()
+{
+  return Impl::LayoutCache::Get().GetStats();
+}
+
+void StaticCairoText::ClearLayoutCache()
+{
+  Impl::LayoutCache::Get().Clear();
+}
+
 std::string StaticCairoText::Impl::GetEffectiveFont() const
 {
   if (font_.empty())
@@ -560,7 +656,124 @@ std::string StaticCairoText::Impl::GetEffectiveFont() const
   return font_;
 }
 
+StaticCairoText::Impl::LayoutCache& StaticCairoText::Impl::LayoutCache::Get()
+{
+  // Never destroyed at exit, as the display owning the textures is gone by then
+  static LayoutCache* cache = new LayoutCache();
+  return *cache;
+}
+
+StaticCairoText::Impl::Layout::Ptr StaticCairoText::Impl::LayoutCache::Find(std::string const& key)
+{
+  auto it = entries_.find(key);
+
+  if (it == entries_.end())
+  {
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+  ++stats_.hits;
+
+  return it->second.layout;
+}
+
+void StaticCairoText::Impl::LayoutCache::Add(std::string const& key, Layout::Ptr const& layout)
+{
+  auto it = entries_.find(key);
+
+  if (it != entries_.end())
+  {
+    stats_.bytes -= it->second.layout->bytes;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+  }
+
+  lru_.push_front(key);
+  entries_[key] = {layout, lru_.begin()};
+  stats_.bytes += layout->bytes;
+  Evict();
+}
+
+void StaticCairoText::Impl::LayoutCache::Evict()
+{
+  // Texts still using an evicted layout keep it alive until they change
+  while (entries_.size() > 1 &&
+         (entries_.size() > LAYOUT_CACHE_MAX_ENTRIES || stats_.bytes > LAYOUT_CACHE_MAX_BYTES))
+  {
+    auto it = entries_.find(lru_.back());
+    stats_.bytes -= it->second.layout->bytes;
+    entries_.erase(it);
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+void StaticCairoText::Impl::LayoutCache::Clear()
+{
+  entries_.clear();
+  lru_.clear();
+  stats_ = LayoutCacheStats();
+}
+
+StaticCairoText::LayoutCacheStats StaticCairoText::Impl::LayoutCache::GetStats() const
+{
+  LayoutCacheStats stats = stats_;
+  stats.entries = entries_.size();
+  return stats;
+}
+
+std::string StaticCairoText::Impl::GetLayoutKey() const
+{
+  GdkScreen* screen = gdk_screen_get_default();    // is not ref'ed
+
+  // Neither the font nor the numeric values can contain a nul character, so
+  // the text can safely be the last part of the key
+  std::string key = GetEffectiveFont();
+  key += '\0';
+  key += std::to_string(font_size_) + '|' + std::to_string(font_weight_) + '|' +
+         std::to_string(parent_->GetMaximumWidth()) + '|' + std::to_string(lines_) + '|' +
+         std::to_string(line_spacing_) + '|' + std::to_string(ellipsize_) + '|' +
+         std::to_string(align_) + '|' + std::to_string(underline_) + '|' +
+         std::to_string(scale_) + '|' + std::to_string(Settings::Instance().font_scaling()) + '|' +
+         std::to_string(cairo_font_options_hash(gdk_screen_get_font_options(screen)));
+  key += '\0';
+  key += text_;
+
+  return key;
+}
+
 Size StaticCairoText::Impl::GetTextExtents() const
+{
+  if (!need_new_extent_cache_)
+  {
+    return cached_extent_;
+  }
+
+  auto& cache = LayoutCache::Get();
+  std::string const& key = GetLayoutKey();
+  Layout::Ptr layout = cache.Find(key);
+
+  if (!layout)
+  {
+    layout = CreateLayout();
+
+    if (!layout)
+      return nux::Size(0, 0);
+
+    cache.Add(key, layout);
+  }
+
+  layout_ = layout;
+  cached_extent_ = layout->extent;
+  baseline_ = layout->baseline;
+  need_new_extent_cache_ = false;
+
+  return cached_extent_;
+}
+
+StaticCairoText::Impl::Layout::Ptr StaticCairoText::Impl::CreateLayout() const
 {
   cairo_surface_t*      surface  = NULL;
   cairo_t*              cr       = NULL;
@@ -569,10 +782,9 @@ Size StaticCairoText::Impl::GetTextExtents() const
   PangoContext*         pangoCtx = NULL;
   GdkScreen*            screen   = gdk_screen_get_default();    // is not ref'ed
 
-  if (!need_new_extent_cache_)
-  {
-    return cached_extent_;
-  }
+  const int max_height = GetGraphicsDisplay()->GetGpuDevice()->GetGpuInfo().GetMaxTextureSize();
+  if (max_height < 0)
+    return nullptr;
 
   Size result;
   std::string const& font = GetEffectiveFont();
@@ -630,16 +842,12 @@ Size StaticCairoText::Impl::GetTextExtents() const
     result.height = std::ceil(result.height * scale_);
   }
 
-  cached_extent_ = result;
-  baseline_ = pango_layout_get_baseline(layout) / PANGO_SCALE;
-  need_new_extent_cache_ = false;
+  auto text_layout = std::make_shared<Layout>();
+  text_layout->extent = result;
+  text_layout->baseline = pango_layout_get_baseline(layout) / PANGO_SCALE;
 
-  cache_textures_.clear();
   PangoLayoutIter* iter = pango_layout_get_iter(layout);
   CacheTexture::Ptr current_tex(new CacheTexture());
-  const int max_height = GetGraphicsDisplay()->GetGpuDevice()->GetGpuInfo().GetMaxTextureSize();
-  if (max_height < 0)
-    return nux::Size(0, 0);
 
   do
   {
@@ -663,7 +871,7 @@ Size StaticCairoText::Impl::GetTextExtents() const
         current_tex->length = line_start_index - current_tex->start_index;
       else
         current_tex->length = 0;
-      cache_textures_.push_back(current_tex);
+      text_layout->splits.push_back(current_tex);
 
       // new texture.
       current_tex.reset(new CacheTexture());
@@ -674,7 +882,10 @@ Size StaticCairoText::Impl::GetTextExtents() const
   }
   while(pango_layout_iter_next_line(iter));
   
-  if (current_tex) { cache_textures_.push_back(current_tex); }
+  if (current_tex) { text_layout->splits.push_back(current_tex); }
+
+  // Each texture is as big as the whole text
+  text_layout->bytes = text_layout->splits.size() * result.width * result.height * 4;
 
   pango_layout_iter_free(iter);
 
@@ -683,7 +894,7 @@ Size StaticCairoText::Impl::GetTextExtents() const
   g_object_unref(layout);
   cairo_destroy(cr);
   cairo_surface_destroy(surface);
-  return result;
+  return text_layout;
 }
 
 void StaticCairoText::Impl::SetAttributes(PangoLayout *layout)
@@ -717,15 +928,12 @@ void StaticCairoText::Impl::SetAttributes(PangoLayout *layout)
   pango_layout_set_attributes(layout, attr_list);
 }
 
-void StaticCairoText::Impl::DrawText(CacheTexture::Ptr const& texture)
+BaseTexturePtr StaticCairoText::Impl::DrawText(CacheTexture::Ptr const& texture)
 {
-  if (!texture)
-    return;
-
   nux::Size layout_size(-1, lines_ < 0 ? lines_ : std::numeric_limits<int>::min());
-  texture->cr.reset(new CairoGraphics(CAIRO_FORMAT_ARGB32, cached_extent_.width, cached_extent_.height));
-  cairo_surface_set_device_scale(texture->cr->GetSurface(), scale_, scale_);
-  cairo_t* cr = texture->cr->GetInternalContext();
+  CairoGraphics cairo_graphics(CAIRO_FORMAT_ARGB32, cached_extent_.width, cached_extent_.height);
+  cairo_surface_set_device_scale(cairo_graphics.GetSurface(), scale_, scale_);
+  cairo_t* cr = cairo_graphics.GetInternalContext();
 
   PangoLayout*          layout     = NULL;
   PangoFontDescription* desc       = NULL;
@@ -777,7 +985,7 @@ void StaticCairoText::Impl::DrawText(CacheTexture::Ptr const& texture)
   cairo_paint(cr);
 
   cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-  cairo_set_source_rgba(cr, text_color_.red, text_color_.green, text_color_.blue, text_color_.alpha);
+  cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
 
   cairo_move_to(cr, 0.0f, 0.0f);
   pango_cairo_show_layout(cr, layout);
@@ -787,6 +995,8 @@ void StaticCairoText::Impl::DrawText(CacheTexture::Ptr const& texture)
   // clean up
   pango_font_description_free(desc);
   g_object_unref(layout);
+
+  return texture_ptr_from_cairo_graphics(cairo_graphics);
 }
 
 void StaticCairoText::Impl::UpdateBaseSize()
@@ -800,12 +1010,23 @@ void StaticCairoText::Impl::UpdateTexture()
   UpdateBaseSize();
 
   textures2D_.clear();
-  for (auto const& texture : cache_textures_)
+
+  if (!layout_)
+    return;
+
+  // The layout textures are only rendered by the first text using them
+  if (layout_->textures.size() != layout_->splits.size())
   {
-    DrawText(texture);
+    layout_->textures.clear();
+
+    for (auto const& texture : layout_->splits)
+      layout_->textures.push_back(DrawText(texture));
 
-    textures2D_.push_back(texture_ptr_from_cairo_graphics(*texture->cr));
+    layout_->lines = actual_lines_;
   }
+
+  actual_lines_ = layout_->lines;
+  textures2D_ = layout_->textures;
 }
 
 void StaticCairoText::Impl::OnFontChanged()
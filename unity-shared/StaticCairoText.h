@@ -116,12 +116,29 @@ public:
 
   static std::string GetEscapedText(std::string const& text);
 
+  // Text layouts and their textures are shared by all the texts with the same
+  // contents, font and size constraints.
+  struct LayoutCacheStats
+  {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+  };
+
+  static LayoutCacheStats GetLayoutCacheStats();
+  // The cached textures belong to the current display: clear them before
+  // destroying its window thread.
+  static void ClearLayoutCache();
+
 protected:
   // Key navigation
   virtual bool AcceptKeyNavFocus();
 
   std::vector<unsigned> GetTextureStartIndices();
   std::vector<unsigned> GetTextureEndIndices();
+  std::vector<nux::ObjectPtr<nux::BaseTexture>> GetTextures() const;
 
   // From debug::Introspectable
   std::string GetName() const;
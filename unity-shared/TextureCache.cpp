@@ -40,6 +40,13 @@ inline std::size_t Hash(std::string const& id, int width, int height)
   return hash_combine(hash_combine(std::hash<std::string>()(id), width), height);
 }
 
+inline std::size_t texture_bytes(nux::BaseTexture* texture)
+{
+  auto format = texture->GetFormat();
+  std::size_t bpp = (format != nux::BITFMT_UNKNOWN) ? nux::GPixelFormats[format].BlockBytes : 4;
+  return std::size_t(std::max(0, texture->GetWidth())) * std::max(0, texture->GetHeight()) * bpp;
+}
+
 inline nux::BaseTexture* create_2d_texture(std::string const& name, int w, int h)
 {
   int size = std::max(w, h);
@@ -54,6 +61,9 @@ TextureCache& TextureCache::GetDefault()
 }
 
 TextureCache::TextureCache()
+  : bytes_(0)
+  , retention_budget_(0)
+  , retained_bytes_(0)
 {
   theme::Settings::Get()->theme.changed.connect(sigc::mem_fun(this, &TextureCache::OnThemeChanged));
 }
@@ -74,7 +84,7 @@ nux::BaseTexture* TextureCache::ThemedLoader(std::string const& name, int w, int
 void TextureCache::OnThemeChanged(std::string const&)
 {
   for (auto texture_key : themed_files_)
-    cache_.erase(texture_key);
+    Erase(texture_key);
 
   themed_files_.clear();
   themed_invalidated.emit();
@@ -90,10 +100,16 @@ TextureCache::BaseTexturePtr TextureCache::FindTexture(std::string const& textur
   auto key = Hash(texture_id, width, height);
   auto texture_it = cache_.find(key);
 
-  BaseTexturePtr texture(texture_it != cache_.end() ? texture_it->second : nullptr);
+  BaseTexturePtr texture(texture_it != cache_.end() ? texture_it->second.texture : nullptr);
 
-  if (!texture)
+  if (texture)
   {
+    ++stats_.hits;
+    Retain(key, texture, texture_it->second.bytes);
+  }
+  else
+  {
+    ++stats_.misses;
     texture.Adopt(factory(texture_id, width, height));
 
     if (!texture)
@@ -116,9 +132,14 @@ TextureCache::BaseTexturePtr TextureCache::FindTexture(std::string const& textur
     // are destroyed first, then the sigc::trackable disconnects all methods
     // created using mem_fun.
 
-    cache_.insert({key, texture.GetPointer()});
+    auto bytes = texture_bytes(texture.GetPointer());
+    cache_.insert({key, {texture.GetPointer(), bytes}});
+    bytes_ += bytes;
+
     auto on_destroy = sigc::mem_fun(this, &TextureCache::OnDestroyNotify);
     texture->OnDestroyed.connect(sigc::bind(on_destroy, key));
+
+    Retain(key, texture, bytes);
   }
 
   return texture;
@@ -126,12 +147,94 @@ TextureCache::BaseTexturePtr TextureCache::FindTexture(std::string const& textur
 
 void TextureCache::Invalidate(std::string const& texture_id, int width, int height)
 {
-  cache_.erase(Hash(texture_id, width, height));
+  Erase(Hash(texture_id, width, height));
+}
+
+void TextureCache::Erase(std::size_t key)
+{
+  auto it = cache_.find(key);
+
+  if (it == cache_.end())
+    return;
+
+  bytes_ -= it->second.bytes;
+  cache_.erase(it);
+  Release(key);
 }
 
 void TextureCache::OnDestroyNotify(nux::Trackable* Object, std::size_t key)
 {
-  cache_.erase(key);
+  auto it = cache_.find(key);
+
+  // The key might have been invalidated and reused by a newer texture
+  if (it != cache_.end() && static_cast<nux::Trackable*>(it->second.texture) == Object)
+  {
+    bytes_ -= it->second.bytes;
+    cache_.erase(it);
+  }
+}
+
+void TextureCache::Retain(std::size_t key, BaseTexturePtr const& texture, std::size_t bytes)
+{
+  if (!retention_budget_ || bytes > retention_budget_)
+    return;
+
+  auto it = retained_.find(key);
+
+  if (it != retained_.end())
+  {
+    retained_lru_.splice(retained_lru_.begin(), retained_lru_, it->second.lru_it);
+    return;
+  }
+
+  retained_lru_.push_front(key);
+  retained_.insert({key, {texture, bytes, retained_lru_.begin()}});
+  retained_bytes_ += bytes;
+
+  EvictRetained();
+}
+
+void TextureCache::Release(std::size_t key)
+{
+  auto it = retained_.find(key);
+
+  if (it == retained_.end())
+    return;
+
+  retained_bytes_ -= it->second.bytes;
+  retained_lru_.erase(it->second.lru_it);
+  retained_.erase(it);
+}
+
+void TextureCache::EvictRetained()
+{
+  while (retained_bytes_ > retention_budget_ && !retained_lru_.empty())
+  {
+    // Releasing the last reference would call OnDestroyNotify for this key
+    ++stats_.evictions;
+    Release(retained_lru_.back());
+  }
+}
+
+void TextureCache::SetRetentionBudget(std::size_t bytes)
+{
+  retention_budget_ = bytes;
+  EvictRetained();
+}
+
+std::size_t TextureCache::RetentionBudget() const
+{
+  return retention_budget_;
+}
+
+std::size_t TextureCache::RetainedBytes() const
+{
+  return retained_bytes_;
+}
+
+TextureCache::Stats const& TextureCache::GetStats() const
+{
+  return stats_;
 }
 
 // Return the current size of the cache.
@@ -140,4 +243,9 @@ std::size_t TextureCache::Size() const
   return cache_.size();
 }
 
+std::size_t TextureCache::SizeInBytes() const
+{
+  return bytes_;
+}
+
 } // namespace unity
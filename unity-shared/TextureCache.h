@@ -21,6 +21,7 @@
 #ifndef UNITY_TEXTURECACHE_H
 #define UNITY_TEXTURECACHE_H
 
+#include <list>
 #include <string>
 #include <unordered_map>
 
@@ -30,7 +31,10 @@
 /* A simple texture cache system, you ask the cache for a texture by id if the
  * texture does not exist it calls the callback function you provide it with
  * to create the texture, then returns it.  you should remember to ref/unref
- * the textures yourself however
+ * the textures yourself however.
+ *
+ * Optionally the cache can keep alive the most recently used textures even if
+ * nobody else references them anymore, up to a given amount of bytes.
  */
 namespace unity
 {
@@ -54,17 +58,57 @@ public:
 
   // Return the current size of the cache.
   std::size_t Size() const;
+  // Return the bytes used by the textures in the cache.
+  std::size_t SizeInBytes() const;
+
+  // Bytes of unused textures to keep alive, 0 (the default) disables retention.
+  void SetRetentionBudget(std::size_t bytes);
+  std::size_t RetentionBudget() const;
+  std::size_t RetainedBytes() const;
+
+  struct Stats
+  {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+  };
+
+  Stats const& GetStats() const;
 
   sigc::signal<void> themed_invalidated;
 
 private:
   TextureCache();
 
+  struct Entry
+  {
+    nux::BaseTexture* texture;
+    std::size_t bytes;
+  };
+
+  struct RetainedEntry
+  {
+    BaseTexturePtr texture;
+    std::size_t bytes;
+    std::list<std::size_t>::iterator lru_it;
+  };
+
   void OnDestroyNotify(nux::Trackable* Object, std::size_t key);
   void OnThemeChanged(std::string const&);
+  void Erase(std::size_t key);
+  void Retain(std::size_t key, BaseTexturePtr const&, std::size_t bytes);
+  void Release(std::size_t key);
+  void EvictRetained();
 
-  std::unordered_map<std::size_t, nux::BaseTexture*> cache_;
+  std::unordered_map<std::size_t, Entry> cache_;
   std::vector<std::size_t> themed_files_;
+  std::size_t bytes_;
+
+  std::unordered_map<std::size_t, RetainedEntry> retained_;
+  std::list<std::size_t> retained_lru_;
+  std::size_t retention_budget_;
+  std::size_t retained_bytes_;
+  Stats stats_;
 };
 
 }
@@ -43,9 +43,11 @@ struct Settings::Impl
     : parent_(parent)
     , theme_setting_("gtk-theme-name")
     , font_setting_("gtk-font-name")
+    , icon_theme_setting_("gtk-icon-theme-name")
   {
     parent_->theme = theme_setting_();
     parent_->font = font_setting_();
+    parent_->icon_theme = icon_theme_setting_();
 
     connections_.Add(theme_setting_.changed.connect([this] (std::string const& theme) {
       parent_->theme = theme;
@@ -57,6 +59,11 @@ struct Settings::Impl
       LOG_INFO(logger) << "gtk-font-name changed to " << parent_->font();
     }));
 
+    connections_.Add(icon_theme_setting_.changed.connect([this] (std::string const& icon_theme) {
+      parent_->icon_theme = icon_theme;
+      LOG_INFO(logger) << "gtk-icon-theme-name changed to " << parent_->icon_theme();
+    }));
+
     unity_icon_theme_ = gtk_icon_theme_new();
     gtk_icon_theme_set_custom_theme(unity_icon_theme_, UNITY_THEME_NAME.c_str());
 
@@ -127,6 +134,7 @@ struct Settings::Impl
   FontSettings font_settings_;
   gtk::Setting<std::string> theme_setting_;
   gtk::Setting<std::string> font_setting_;
+  gtk::Setting<std::string> icon_theme_setting_;
   glib::Signal<void, GtkIconTheme*> icon_theme_changed_;
   glib::Object<GtkIconTheme> unity_icon_theme_;
   connection::Manager connections_;
@@ -155,5 +163,16 @@ GtkIconTheme* Settings::UnityIconTheme() const
   return impl_->unity_icon_theme_;
 }
 
+std::string Settings::IconThemeName(GtkIconTheme* theme) const
+{
+  if (theme == impl_->unity_icon_theme_)
+    return UNITY_THEME_NAME;
+
+  if (theme == gtk_icon_theme_get_default())
+    return icon_theme();
+
+  return std::string();
+}
+
 } // theme namespace
 } // unity namespace
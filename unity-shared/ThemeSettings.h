@@ -40,9 +40,12 @@ public:
 
   nux::Property<std::string> theme;
   nux::Property<std::string> font;
+  nux::Property<std::string> icon_theme;
 
   std::string ThemedFilePath(std::string const& basename, std::vector<std::string> const& extra_folders = {}, std::vector<std::string> const& extra_extensions = {}) const;
   _GtkIconTheme* UnityIconTheme() const;
+  // Name of the default or of the unity icon theme, empty for any other theme
+  std::string IconThemeName(_GtkIconTheme*) const;
 
   sigc::signal<void> icons_changed;
 
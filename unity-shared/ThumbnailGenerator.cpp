@@ -19,12 +19,19 @@
  *
  */
 
-#include <pthread.h>
 #include <NuxCore/Logger.h>
+#include "UnityCore/ConnectionManager.h"
 #include "UnityCore/GLibSource.h"
 #include "UnityCore/DesktopUtilities.h"
 #include "ThumbnailGenerator.h"
 #include <glib/gstdio.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 
 #include "TextureThumbnailProvider.h"
@@ -46,32 +53,51 @@ namespace
   static std::multimap<std::string, std::string> thumbnail_content_map;
   static std::map<std::string, Thumbnailer::Ptr> thumbnailers_;
 
-  pthread_mutex_t thumbnailers_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  std::mutex thumbnailers_mutex_;
 
   static std::string get_preview_dir()
   {
     return DesktopUtilities::GetUserDataDirectory().append("/previews");
   }
+
+  static std::string get_preview_file(std::string const& uri, unsigned int size)
+  {
+    // The size is part of the name, so that workers never write the same file
+    return get_preview_dir() + "/" + std::to_string(std::hash<std::string>()(uri)) +
+           "-" + std::to_string(size) + ".png";
+  }
+
+  // Previews used to be saved as "<uri hash>.png", without any size.
+  static bool is_unsized_preview_file(std::string const& basename)
+  {
+    auto extension = basename.rfind(".png");
+
+    if (extension == 0 || extension == std::string::npos || extension != basename.size() - 4)
+      return false;
+
+    return std::all_of(basename.begin(), basename.begin() + extension, [] (char c) { return g_ascii_isdigit(c); });
+  }
 }
 
 
 class Thumbnail
 {
 public:
-  typedef std::shared_ptr<Thumbnail> Ptr;
-
-  Thumbnail(std::string const& uri, unsigned int size, ThumbnailNotifier::Ptr const& notifier);
+  Thumbnail(std::string const& uri, unsigned int size);
 
   std::string Generate(std::string& error_hint);
 
   std::string const uri_;
   unsigned int size_;
-  ThumbnailNotifier::Ptr notifier_;
 };
 
 void ThumbnailNotifier::Cancel()
 {
+  if (cancel_.IsCancelled())
+    return;
+
   cancel_.Cancel();
+  cancelled.emit();
 }
 
 bool ThumbnailNotifier::IsCancelled() const
@@ -79,77 +105,112 @@ bool ThumbnailNotifier::IsCancelled() const
   return cancel_.IsCancelled();
 }
 
+/* A request for a (uri, size) pair, shared by all the notifiers asking for it.
+   The queue is ordered by arrival. */
+struct ThumbnailJob
+{
+  typedef std::shared_ptr<ThumbnailJob> Ptr;
+
+  std::string key;
+  std::string uri;
+  unsigned int size;
+  uint64_t sequence;
+  gint64 queued_time;
+  bool running;
+  std::vector<ThumbnailNotifier::Ptr> notifiers;
+
+  // Only used in the main thread
+  std::vector<connection::handle> cancel_connections;
+};
+
 class ThumbnailGeneratorImpl
 {
 public:
   ThumbnailGeneratorImpl(ThumbnailGenerator* parent)
   : parent_(parent)
-  , thumbnails_mutex_(PTHREAD_MUTEX_INITIALIZER)
-  , thumbnail_thread_is_running_(false)
-  , thumbnail_thread_(0)
+  , max_workers_(std::max(1u, g_get_num_processors()))
+  , idle_workers_(0)
+  , stopping_(false)
+  , sequence_(0)
+  , management_thread_is_running_(false)
+  , total_latency_ms_(0)
   {}
 
   ~ThumbnailGeneratorImpl()
   {
-    pthread_join(thumbnail_thread_, NULL);
+    cancel_connections_.Clear();
+
+    {
+      std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+      stopping_ = true;
+    }
+
+    queue_cond_.notify_all();
+
+    for (auto& worker : workers_)
+      worker.join();
+
+    if (management_thread_.joinable())
+      management_thread_.join();
   }
 
   ThumbnailNotifier::Ptr GetThumbnail(std::string const& uri, int size);
+  ThumbnailGenerator::Stats GetStats() const;
   void DoCleanup();
 
   bool OnThumbnailComplete();
 
   static std::list<Thumbnailer::Ptr> GetThumbnailers(std::string const& content_type, std::string& error_hint);
 
-  void RunGenerate();
+  void RunWorker();
   void RunManagement();
 
 private:
   void StartCleanupTimer();
+  void CancelRequest(ThumbnailJob::Ptr const& job, ThumbnailNotifier* notifier);
+  void DisconnectJob(ThumbnailJob::Ptr const& job);
+  void QueueCompletion(ThumbnailJob::Ptr const& job, std::string const& uri, std::string const& error_hint);
 
 private:
   ThumbnailGenerator* parent_;
 
-  glib::Source::UniquePtr thread_create_timer_;
-  glib::Source::UniquePtr thread_return_timer_;
-
   /* Our mutex used when accessing data shared between the main thread and the
-   thumbnail thread, i.e. the thumbnail_thread_is_running flag and the
-   thumbnails_to_make list. */
-  pthread_mutex_t thumbnails_mutex_;
+   worker threads, i.e. the queue, the pending requests and the completed ones. */
+  mutable std::mutex thumbnails_mutex_;
+  std::condition_variable queue_cond_;
 
-  /* A flag to indicate whether a thumbnail thread is running, so we don't
-   start more than one. Lock thumbnails_mutex when accessing this. */
-  volatile bool thumbnail_thread_is_running_;
-  pthread_t thumbnail_thread_;
+  std::vector<std::thread> workers_;
+  unsigned max_workers_;
+  unsigned idle_workers_;
+  bool stopping_;
+  uint64_t sequence_;
 
-  volatile bool management_thread_is_running_;
-  pthread_t management_thread_;
+  std::map<uint64_t, ThumbnailJob::Ptr> queue_;
+  std::unordered_map<std::string, ThumbnailJob::Ptr> pending_;
 
-  glib::Source::UniquePtr cleanup_timer_;
+  std::atomic<bool> management_thread_is_running_;
+  std::thread management_thread_;
 
-  std::queue<Thumbnail::Ptr> thumbnails_;
+  glib::Source::UniquePtr thread_return_idle_;
+  glib::Source::UniquePtr cleanup_timer_;
+  connection::Manager cancel_connections_;
 
   struct CompleteThumbnail
   {
     std::string thubnail_uri;
     std::string error_hint;
-    ThumbnailNotifier::Ptr notifier;
+    ThumbnailJob::Ptr job;
   };
   std::list<CompleteThumbnail> complete_thumbnails_;
-};
 
-static void* thumbnail_thread_start (void* data)
-{
-  ((ThumbnailGeneratorImpl*)data)->RunGenerate();
-  return NULL;
-}
+  ThumbnailGenerator::Stats stats_;
+  double total_latency_ms_;
+};
 
-bool CheckCache(std::string const& uri_in, std::string& filename_out)
+bool CheckCache(std::string const& uri_in, unsigned int size, std::string& filename_out)
 {
   // Check Cache.
-  filename_out = get_preview_dir() + "/";
-  filename_out += std::to_string(std::hash<std::string>()(uri_in)) + ".png";
+  filename_out = get_preview_file(uri_in, size);
 
   glib::Object<GFile> cache_file(g_file_new_for_path(filename_out.c_str()));
   return g_file_query_exists(cache_file, NULL);
@@ -157,149 +218,215 @@ bool CheckCache(std::string const& uri_in, std::string& filename_out)
 
 ThumbnailNotifier::Ptr ThumbnailGeneratorImpl::GetThumbnail(std::string const& uri, int size)
 {
+  auto notifier = std::make_shared<ThumbnailNotifier>();
   std::string cache_filename;
-  if (CheckCache(uri, cache_filename))
-  {
-    pthread_mutex_lock (&thumbnails_mutex_);
 
-    CompleteThumbnail complete_thumb;
-    complete_thumb.thubnail_uri = cache_filename;
-    complete_thumb.notifier = std::make_shared<ThumbnailNotifier>();
-    complete_thumbnails_.push_back(complete_thumb);
+  if (CheckCache(uri, size, cache_filename))
+  {
+    auto job = std::make_shared<ThumbnailJob>();
+    job->queued_time = g_get_monotonic_time();
+    job->notifiers.push_back(notifier);
 
     // Delay the thumbnail update until after this method has returned with the notifier
-    if (!thread_return_timer_)
-    {
-      thread_return_timer_.reset(new glib::Timeout(0, sigc::mem_fun(this, &ThumbnailGeneratorImpl::OnThumbnailComplete), glib::Source::Priority::LOW));
-    }
-
-    pthread_mutex_unlock (&thumbnails_mutex_);
-
+    std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+    QueueCompletion(job, cache_filename, "");
     StartCleanupTimer();
 
-    return complete_thumb.notifier;
+    return notifier;
   }
 
-  pthread_mutex_lock (&thumbnails_mutex_);
+  std::string key = uri + "\n" + std::to_string(size);
+
+  std::unique_lock<std::mutex> lock(thumbnails_mutex_);
   /*********************************
    * MUTEX LOCKED
    *********************************/
 
-  if (!thread_create_timer_ && thumbnail_thread_is_running_ == false)
+  ThumbnailJob::Ptr job;
+  auto pending_it = pending_.find(key);
+
+  if (pending_it != pending_.end())
   {
-    thread_create_timer_.reset(new glib::Timeout(0, [this]()
-    {
-      thumbnail_thread_is_running_ = true;
-      pthread_create (&thumbnail_thread_, NULL, thumbnail_thread_start, this);
-      thread_create_timer_.reset();
-      return false;
-    }, glib::Source::Priority::LOW));
+    job = pending_it->second;
+    ++stats_.deduplicated;
+  }
+  else
+  {
+    job = std::make_shared<ThumbnailJob>();
+    job->key = key;
+    job->uri = uri;
+    job->size = size;
+    job->sequence = ++sequence_;
+    job->queued_time = g_get_monotonic_time();
+    job->running = false;
+
+    pending_.insert({key, job});
+    queue_.insert({job->sequence, job});
+
+    if (idle_workers_ == 0 && workers_.size() < max_workers_)
+      workers_.push_back(std::thread(&ThumbnailGeneratorImpl::RunWorker, this));
+    else
+      queue_cond_.notify_one();
   }
 
-  auto notifier = std::make_shared<ThumbnailNotifier>();
-  auto thumb = std::make_shared<Thumbnail>(uri, size, notifier);
-  thumbnails_.push(thumb);
+  job->notifiers.push_back(notifier);
 
-  pthread_mutex_unlock (&thumbnails_mutex_);
-  /*********************************
-   * MUTEX UNLOCKED
-   *********************************/
+  lock.unlock();
 
-  StartCleanupTimer();
+  // Disconnected when the job is done or on destruction, so that cancelling
+  // a notifier which outlives us doesn't call into a dead generator.
+  std::weak_ptr<ThumbnailJob> weak_job = job;
+  ThumbnailNotifier* notifier_ptr = notifier.get();
+  job->cancel_connections.push_back(cancel_connections_.Add(notifier->cancelled.connect([this, weak_job, notifier_ptr] {
+    if (auto const& job = weak_job.lock())
+      CancelRequest(job, notifier_ptr);
+  })));
 
+  StartCleanupTimer();
 
   return notifier;
 }
 
+void ThumbnailGeneratorImpl::CancelRequest(ThumbnailJob::Ptr const& job, ThumbnailNotifier* notifier)
+{
+  {
+    std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+
+    auto& notifiers = job->notifiers;
+    notifiers.erase(std::remove_if(notifiers.begin(), notifiers.end(), [notifier] (ThumbnailNotifier::Ptr const& n) {
+      return n.get() == notifier;
+    }), notifiers.end());
+
+    if (!notifiers.empty())
+      return;
+
+    // Nobody is waiting for this anymore, so we can drop it from the queue
+    auto queued = queue_.find(job->sequence);
+    if (!job->running && queued != queue_.end() && queued->second == job)
+    {
+      queue_.erase(queued);
+      pending_.erase(job->key);
+      ++stats_.cancelled;
+    }
+  }
+
+  DisconnectJob(job);
+}
+
+void ThumbnailGeneratorImpl::DisconnectJob(ThumbnailJob::Ptr const& job)
+{
+  for (auto const& handle : job->cancel_connections)
+    cancel_connections_.Remove(handle);
+
+  job->cancel_connections.clear();
+}
+
 void ThumbnailGeneratorImpl::StartCleanupTimer()
 {
   if (!cleanup_timer_)
       cleanup_timer_.reset(new glib::Timeout(CLEANUP_DURATION, [this]() { DoCleanup(); return false; }));
 }
 
+// Must be called with thumbnails_mutex_ locked.
+void ThumbnailGeneratorImpl::QueueCompletion(ThumbnailJob::Ptr const& job, std::string const& uri, std::string const& error_hint)
+{
+  complete_thumbnails_.push_back({uri, error_hint, job});
 
-void ThumbnailGeneratorImpl::RunGenerate()
+  if (!thread_return_idle_)
+    thread_return_idle_.reset(new glib::Idle(sigc::mem_fun(this, &ThumbnailGeneratorImpl::OnThumbnailComplete), glib::Source::Priority::LOW));
+}
+
+void ThumbnailGeneratorImpl::RunWorker()
 {
-  for (;;)
+  std::unique_lock<std::mutex> lock(thumbnails_mutex_);
+
+  while (true)
   {
-    /*********************************
-     * MUTEX LOCKED
-     *********************************/
-    pthread_mutex_lock (&thumbnails_mutex_);
+    ++idle_workers_;
+    queue_cond_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    --idle_workers_;
 
-    if (thumbnails_.empty())
-    {
-      thumbnail_thread_is_running_ = FALSE;
-      pthread_mutex_unlock (&thumbnails_mutex_);
-      pthread_exit (NULL);
-    }
+    if (stopping_)
+      return;
 
-    Thumbnail::Ptr thumb = thumbnails_.front();
-    thumbnails_.pop();
+    ThumbnailJob::Ptr job = queue_.begin()->second;
+    queue_.erase(queue_.begin());
+    job->running = true;
+    ++stats_.running;
 
-    pthread_mutex_unlock (&thumbnails_mutex_);
+    lock.unlock();
     /*********************************
      * MUTEX UNLOCKED
      *********************************/
 
-    if (thumb->notifier_->IsCancelled())
-      continue;
-
+    Thumbnail thumb(job->uri, job->size);
     std::string error_hint;
-    std::string uri_result = thumb->Generate(error_hint);
+    std::string uri_result = thumb.Generate(error_hint);
 
+    lock.lock();
     /*********************************
      * MUTEX LOCKED
      *********************************/
-    pthread_mutex_lock (&thumbnails_mutex_);
 
-    CompleteThumbnail complete_thumb;
-    complete_thumb.thubnail_uri = uri_result;
-    complete_thumb.error_hint = error_hint;
-    complete_thumb.notifier = thumb->notifier_;
+    --stats_.running;
+    ++stats_.completed;
+    job->running = false;
+    pending_.erase(job->key);
 
-    complete_thumbnails_.push_back(complete_thumb);
+    double latency = (g_get_monotonic_time() - job->queued_time) / 1000.0;
+    total_latency_ms_ += latency;
+    stats_.max_latency_ms = std::max(stats_.max_latency_ms, latency);
 
-    if (!thread_return_timer_)
-    {
-      thread_return_timer_.reset(new glib::Timeout(0, sigc::mem_fun(this, &ThumbnailGeneratorImpl::OnThumbnailComplete), glib::Source::Priority::LOW));
-    }
-
-    pthread_mutex_unlock (&thumbnails_mutex_);
-    /*********************************
-     * MUTEX UNLOCKED
-     *********************************/
-   }
+    if (!job->notifiers.empty())
+      QueueCompletion(job, uri_result, error_hint);
+  }
 }
 
 bool ThumbnailGeneratorImpl::OnThumbnailComplete()
 {
-  for (;;)
+  std::list<CompleteThumbnail> complete_thumbnails;
+
   {
-    pthread_mutex_lock (&thumbnails_mutex_);
+    std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+    complete_thumbnails.swap(complete_thumbnails_);
+    thread_return_idle_.reset();
+  }
 
-    if (complete_thumbnails_.empty())
-    {
-      thread_return_timer_.reset();
-      pthread_mutex_unlock (&thumbnails_mutex_);
-      return false;
-    }
-    CompleteThumbnail complete_thumbnail = complete_thumbnails_.front();
-    complete_thumbnails_.pop_front();
+  for (auto const& complete_thumbnail : complete_thumbnails)
+  {
+    // Copy, as the handlers could cancel other notifiers of this job
+    auto notifiers = complete_thumbnail.job->notifiers;
 
-    pthread_mutex_unlock (&thumbnails_mutex_);
+    for (auto const& notifier : notifiers)
+    {
+      if (notifier->IsCancelled())
+        continue;
 
-    if (complete_thumbnail.notifier->IsCancelled())
-      continue;
+      if (complete_thumbnail.error_hint.empty())
+        notifier->ready.emit(complete_thumbnail.thubnail_uri);
+      else
+        notifier->error.emit(complete_thumbnail.error_hint);
+    }
 
-    if (complete_thumbnail.error_hint.empty())
-      complete_thumbnail.notifier->ready.emit(complete_thumbnail.thubnail_uri);
-    else
-      complete_thumbnail.notifier->error.emit(complete_thumbnail.error_hint);
+    DisconnectJob(complete_thumbnail.job);
   }
+
   return false;
 }
 
+ThumbnailGenerator::Stats ThumbnailGeneratorImpl::GetStats() const
+{
+  std::lock_guard<std::mutex> lock(thumbnails_mutex_);
+
+  ThumbnailGenerator::Stats stats = stats_;
+  stats.queued = queue_.size();
+
+  if (stats.completed)
+    stats.average_latency_ms = total_latency_ms_ / stats.completed;
+
+  return stats;
+}
+
 std::list<Thumbnailer::Ptr> ThumbnailGeneratorImpl::GetThumbnailers(std::string const& content_type, std::string& error_hint)
 {
   std::list<Thumbnailer::Ptr> thumbnailer_list;
@@ -336,7 +463,7 @@ std::list<Thumbnailer::Ptr> ThumbnailGeneratorImpl::GetThumbnailers(std::string
     /*********************************
      * FIND THUMBNAILER
      *********************************/
-    pthread_mutex_lock (&thumbnailers_mutex_);
+    std::lock_guard<std::mutex> lock(thumbnailers_mutex_);
 
     // have already got this content type?
     auto range = thumbnail_content_map.equal_range(ss_content_type.str());
@@ -350,26 +477,22 @@ std::list<Thumbnailer::Ptr> ThumbnailGeneratorImpl::GetThumbnailers(std::string
         thumbnailer_list.push_back(iter_tumbnailers->second);
       }
     }
-    pthread_mutex_unlock (&thumbnailers_mutex_);
   }
 
   return thumbnailer_list;
 }
 
-static void* management_thread_start (void* data)
-{
-  ((ThumbnailGeneratorImpl*)data)->RunManagement();
-  return NULL;
-}
-
 void ThumbnailGeneratorImpl::DoCleanup()
 {
   cleanup_timer_.reset();
 
   if (!management_thread_is_running_)
   {
+    if (management_thread_.joinable())
+      management_thread_.join();
+
     management_thread_is_running_ = true;
-    pthread_create (&management_thread_, NULL, management_thread_start, this);
+    management_thread_ = std::thread(&ThumbnailGeneratorImpl::RunManagement, this);
   }
 }
 
@@ -383,6 +506,7 @@ void ThumbnailGeneratorImpl::RunManagement()
   if (err)
   {
     LOG_ERROR(logger) << "Impossible to open directory: " << err;
+    management_thread_is_running_ = false;
     return;
   }
 
@@ -398,18 +522,19 @@ void ThumbnailGeneratorImpl::RunManagement()
     if (err)
     {
       LOG_ERROR(logger) << "Impossible to get file info: " << err;
-      return;
+      break;
     }
 
     guint64 mtime = g_file_info_get_attribute_uint64(file_info, G_FILE_ATTRIBUTE_TIME_CREATED);
 
-    if (mtime < time)
+    if (mtime < time || is_unsized_preview_file(file_basename))
     {
       g_unlink(filename.c_str());
     }
   }
 
-  thumbnail_thread_is_running_ = false;
+  g_dir_close(thumbnailer_dir);
+  management_thread_is_running_ = false;
 }
 
 ThumbnailGenerator::ThumbnailGenerator()
@@ -454,9 +579,14 @@ ThumbnailNotifier::Ptr ThumbnailGenerator::GetThumbnail(std::string const& uri,
   return pimpl->GetThumbnail(uri, size);
 }
 
+ThumbnailGenerator::Stats ThumbnailGenerator::GetStats() const
+{
+  return pimpl->GetStats();
+}
+
 void ThumbnailGenerator::RegisterThumbnailer(std::list<std::string> mime_types, Thumbnailer::Ptr const& thumbnailer)
 {
-  pthread_mutex_lock (&thumbnailers_mutex_);
+  std::lock_guard<std::mutex> lock(thumbnailers_mutex_);
 
   thumbnailers_[thumbnailer->GetName()] = thumbnailer;
 
@@ -464,8 +594,6 @@ void ThumbnailGenerator::RegisterThumbnailer(std::list<std::string> mime_types,
   {
     thumbnail_content_map.insert(std::pair<std::string,std::string>(mime_type, thumbnailer->GetName()));
   }
-
-  pthread_mutex_unlock (&thumbnailers_mutex_);
 }
 
 void ThumbnailGenerator::DoCleanup()
@@ -473,10 +601,9 @@ void ThumbnailGenerator::DoCleanup()
   pimpl->DoCleanup();
 }
 
-Thumbnail::Thumbnail(std::string const& uri, unsigned int size, ThumbnailNotifier::Ptr const& notifier)
+Thumbnail::Thumbnail(std::string const& uri, unsigned int size)
 : uri_(uri)
 , size_(size)
-, notifier_(notifier)
 {}
 
 std::string Thumbnail::Generate(std::string& error_hint)
@@ -498,8 +625,7 @@ std::string Thumbnail::Generate(std::string& error_hint)
 
   std::list<Thumbnailer::Ptr> const& thumbnailers = ThumbnailGeneratorImpl::GetThumbnailers(file_type, error_hint);
 
-  std::string output_file = get_preview_dir() + "/";
-  output_file += std::to_string(std::hash<std::string>()(uri_)) + ".png";
+  std::string output_file = get_preview_file(uri_, size_);
 
   for (Thumbnailer::Ptr const& thumbnailer : thumbnailers)
   {
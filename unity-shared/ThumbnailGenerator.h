@@ -22,6 +22,7 @@
 #ifndef UNITYSHARED_THUMBNAILGENERATOR_H
 #define UNITYSHARED_THUMBNAILGENERATOR_H
 
+#include <list>
 #include <memory>
 #include "UnityCore/GLibWrapper.h"
 
@@ -50,6 +51,7 @@ public:
 
   sigc::signal<void, std::string> ready;
   sigc::signal<void, std::string> error;
+  sigc::signal<void> cancelled;
 
 private:
   glib::Cancellable cancel_;
@@ -70,6 +72,19 @@ public:
 
   ThumbnailNotifier::Ptr GetThumbnail(std::string const& uri, int size);
 
+  struct Stats
+  {
+    std::size_t queued = 0;
+    std::size_t running = 0;
+    std::size_t completed = 0;
+    std::size_t cancelled = 0;
+    std::size_t deduplicated = 0;
+    double average_latency_ms = 0;
+    double max_latency_ms = 0;
+  };
+
+  Stats GetStats() const;
+
   void DoCleanup();
 
 protected:
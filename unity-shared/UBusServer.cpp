@@ -16,8 +16,6 @@
  * Authored by: Michal Hruby <michal.hruby@canonical.com>
  */
 
-#include <algorithm>
-
 #include "UBusServer.h"
 
 namespace unity
@@ -27,25 +25,94 @@ UBusServer::UBusServer()
   : last_id_(0)
 {}
 
+unsigned UBusServer::InternMessage(std::string const& message_name)
+{
+  auto it = message_ids_.find(message_name);
+
+  if (it != message_ids_.end())
+    return it->second;
+
+  unsigned interest_id = interests_.size();
+  interests_.emplace_back();
+  message_ids_.insert({message_name, interest_id});
+
+  return interest_id;
+}
+
 unsigned UBusServer::RegisterInterest(std::string const& interest_name,
                                       UBusCallback const& slot)
 {
   if (!slot || interest_name.empty())
     return 0;
 
+  unsigned interest_id = InternMessage(interest_name);
   unsigned connection_id = ++last_id_;
-  auto connection = std::make_shared<UBusConnection>(slot, connection_id);
-  interests_.insert(std::pair<std::string, UBusConnection::Ptr>(interest_name, connection));
+
+  // We use a deque, so adding connections during a dispatch is safe
+  auto& connections = interests_[interest_id].connections;
+  connections_[connection_id] = {interest_id, connections.size()};
+  connections.emplace_back(slot, connection_id);
 
   return connection_id;
 }
 
 void UBusServer::UnregisterInterest(unsigned connection_id)
 {
-  auto it = std::find_if(interests_.begin(), interests_.end(),
-                         [connection_id] (std::pair<std::string, UBusConnection::Ptr> const& p)
-                         { return p.second->id == connection_id; });
-  if (it != interests_.end()) interests_.erase(it);
+  auto it = connections_.find(connection_id);
+
+  if (it == connections_.end())
+    return;
+
+  unsigned interest_id = it->second.interest;
+  Interest& interest = interests_[interest_id];
+  UBusConnection& connection = interest.connections[it->second.index];
+
+  // Just mark the connection as unregistered, so that it gets ignored by an
+  // ongoing dispatch, the slot will be released once that is finished.
+  connection.id = 0;
+  ++interest.unregistered;
+
+  if (interest.dispatching)
+  {
+    interest.released.push_back(it->second.index);
+    connections_.erase(it);
+    return;
+  }
+
+  connection.slot = nullptr;
+  connections_.erase(it);
+  CleanupInterest(interest_id);
+}
+
+void UBusServer::CleanupInterest(unsigned interest_id)
+{
+  Interest& interest = interests_[interest_id];
+
+  if (interest.dispatching)
+    return;
+
+  for (auto index : interest.released)
+    interest.connections[index].slot = nullptr;
+
+  interest.released.clear();
+
+  // Compacting is linear, so only do it once half of the connections are gone
+  if (!interest.unregistered || interest.unregistered * 2 < interest.connections.size())
+    return;
+
+  std::deque<UBusConnection> connections;
+
+  for (auto& connection : interest.connections)
+  {
+    if (!connection.id)
+      continue;
+
+    connections_[connection.id].index = connections.size();
+    connections.push_back(std::move(connection));
+  }
+
+  interest.connections.swap(connections);
+  interest.unregistered = 0;
 }
 
 void UBusServer::SendMessage(std::string const& message_name,
@@ -58,58 +125,81 @@ void UBusServer::SendMessageFull(std::string const& message_name,
                                   glib::Variant const& args,
                                   glib::Source::Priority prio)
 {
+  QueueMessage(message_name, args, prio, false);
+}
+
+void UBusServer::SendCoalescedMessage(std::string const& message_name,
+                                      glib::Variant const& args,
+                                      glib::Source::Priority prio)
+{
+  QueueMessage(message_name, args, prio, true);
+}
+
+void UBusServer::QueueMessage(std::string const& message_name,
+                              glib::Variant const& args,
+                              glib::Source::Priority prio,
+                              bool coalesce)
+{
+  unsigned interest_id = InternMessage(message_name);
+  MessageQueue& queue = msg_queues_[static_cast<int>(prio)];
+
+  if (coalesce)
+  {
+    auto it = queue.coalesced.find(interest_id);
+
+    if (it != queue.coalesced.end())
+    {
+      queue.messages[it->second].args = args;
+      return;
+    }
+
+    queue.coalesced[interest_id] = queue.messages.size();
+  }
+
   // queue the message
-  msg_queue_.insert(std::pair<int, std::pair<std::string, glib::Variant>>(prio, std::make_pair(message_name, args)));
+  queue.messages.push_back({interest_id, args});
 
   // start the source (if not already running)
   auto src_nick = std::to_string(static_cast<int>(prio));
-  auto src_ptr = source_manager_.GetSource(src_nick);
-  if (!src_ptr)
+  if (!source_manager_.GetSource(src_nick))
   {
     source_manager_.Add(new glib::Idle([this, prio] ()
     {
       return DispatchMessages(prio);
-    }, prio));
+    }, prio), src_nick);
   }
 }
 
 bool UBusServer::DispatchMessages(glib::Source::Priority prio)
 {
-  // copy messages we are about to dispatch to a separate container
-  std::vector<std::pair<std::string, glib::Variant> > dispatched_msgs;
+  // move the messages we are about to dispatch to a separate container
+  std::vector<Message> dispatched_msgs;
+  MessageQueue& queue = msg_queues_[static_cast<int>(prio)];
+  dispatched_msgs.swap(queue.messages);
+  queue.coalesced.clear();
 
-  auto iterators = msg_queue_.equal_range(prio);
-  for (auto it = iterators.first; it != iterators.second; ++it)
+  for (auto const& msg : dispatched_msgs)
   {
-    dispatched_msgs.push_back((*it).second);
-  }
+    Interest& interest = interests_[msg.interest];
 
-  // remove the messages from the queue
-  msg_queue_.erase(prio);
+    // Connections added by the slots won't get this message
+    std::size_t size = interest.connections.size();
+    ++interest.dispatching;
 
-  for (unsigned i = 0; i < dispatched_msgs.size(); i++)
-  {
-    // invoke callbacks for this message_name
-    std::string const& message_name = dispatched_msgs[i].first;
-    glib::Variant const& msg_args = dispatched_msgs[i].second;
-    auto interest_it = interests_.find(message_name);
-    while (interest_it != interests_.end())
+    for (std::size_t i = 0; i < size; ++i)
     {
-      // add a reference to make sure we don't crash if the slot unregisters itself
-      UBusConnection::Ptr connection((*interest_it).second);
-      interest_it++;
-      // invoke the slot
-      // FIXME: what if this slot unregisters the next? We should mark the interests map dirty in UnregisterInterest
-      connection->slot(msg_args);
-
-      if (interest_it == interests_.end() || 
-          (*interest_it).first != message_name)
-        break;
+      UBusConnection& connection = interest.connections[i];
+
+      if (connection.id)
+        connection.slot(msg.args);
     }
+
+    --interest.dispatching;
+    CleanupInterest(msg.interest);
   }
 
   // return true if there are new queued messages with this prio
-  return msg_queue_.find(prio) != msg_queue_.end();
+  return !queue.messages.empty();
 }
 
 }
@@ -20,9 +20,12 @@
 #ifndef UNITY_UBUS_SERVER_H
 #define UNITY_UBUS_SERVER_H
 
+#include <deque>
+#include <map>
 #include <memory>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include <UnityCore/Variant.h>
 #include <UnityCore/GLibSource.h>
@@ -46,23 +49,61 @@ public:
                        glib::Variant const& args,
                        glib::Source::Priority prio);
 
+  // For messages where only the latest payload matters: if a message with the
+  // same name and priority is still queued, only its payload is replaced.
+  void SendCoalescedMessage(std::string const& message_name,
+                            glib::Variant const& args,
+                            glib::Source::Priority prio);
+
 private:
   struct UBusConnection
   {
-    typedef std::shared_ptr<UBusConnection> Ptr;
-
     UBusCallback slot;
-    unsigned id;
+    unsigned id; // 0 once unregistered
 
     UBusConnection(UBusCallback const& cb, unsigned connection_id)
       : slot(cb), id(connection_id) {}
   };
 
+  struct Interest
+  {
+    Interest() : dispatching(0), unregistered(0) {}
+
+    std::deque<UBusConnection> connections;
+    std::vector<std::size_t> released;
+    unsigned dispatching;
+    unsigned unregistered;
+  };
+
+  struct ConnectionLocation
+  {
+    unsigned interest;
+    std::size_t index;
+  };
+
+  struct Message
+  {
+    unsigned interest;
+    glib::Variant args;
+  };
+
+  struct MessageQueue
+  {
+    std::vector<Message> messages;
+    std::unordered_map<unsigned, std::size_t> coalesced;
+  };
+
+  unsigned InternMessage(std::string const& message_name);
+  void QueueMessage(std::string const& message_name, glib::Variant const& args,
+                    glib::Source::Priority prio, bool coalesce);
+  void CleanupInterest(unsigned interest_id);
   bool DispatchMessages(glib::Source::Priority);
 
   unsigned last_id_;
-  std::multimap<std::string, UBusConnection::Ptr> interests_;
-  std::multimap<int, std::pair<std::string, glib::Variant> > msg_queue_;
+  std::unordered_map<std::string, unsigned> message_ids_;
+  std::deque<Interest> interests_;
+  std::unordered_map<unsigned, ConnectionLocation> connections_;
+  std::map<int, MessageQueue> msg_queues_;
   glib::SourceManager source_manager_;
 };
 
@@ -66,4 +66,11 @@ void UBusManager::SendMessage(std::string const& message_name,
   server->SendMessageFull(message_name, args, prio);
 }
 
+void UBusManager::SendCoalescedMessage(std::string const& message_name,
+                                       glib::Variant const& args,
+                                       glib::Source::Priority prio)
+{
+  server->SendCoalescedMessage(message_name, args, prio);
+}
+
 }
@@ -44,6 +44,9 @@ public:
   static void SendMessage(std::string const& message_name,
                           glib::Variant const& args = glib::Variant(),
                           glib::Source::Priority prio = glib::Source::Priority::DEFAULT);
+  static void SendCoalescedMessage(std::string const& message_name,
+                                   glib::Variant const& args,
+                                   glib::Source::Priority prio = glib::Source::Priority::DEFAULT);
 
 private:
   static std::unique_ptr<UBusServer> server;
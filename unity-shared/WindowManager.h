@@ -196,6 +196,7 @@ public:
   sigc::signal<void, Window> window_resized;
   sigc::signal<void, Window> window_moved;
   sigc::signal<void, Window> window_focus_changed;
+  sigc::signal<void, Window> window_restacked;
 
   sigc::signal<void> show_desktop_changed;
 